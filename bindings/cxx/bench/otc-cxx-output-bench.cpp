@@ -0,0 +1,202 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CSV export through the C++ API. Compares the string which receive()
+ * returns per packet, with a reused buffer, and with writes to a file
+ * descriptor. Fails when the ways don't produce the same text.
+ *
+ * Usage: otc-cxx-output-bench [-n packets] [-s samples] [-r rounds]
+ */
+
+#include <libopentracecapturecxx/libopentracecapturecxx.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+using namespace opentrace;
+
+static unsigned int num_packets = 256;
+static size_t packet_samples = 16 * 1024;
+static unsigned int rounds = 3;
+
+typedef std::chrono::steady_clock bench_clock;
+
+enum bench_mode {
+	MODE_STRING,
+	MODE_BUFFER,
+	MODE_FD,
+};
+
+static const char *mode_names[] = { "string", "buffer", "fd" };
+
+/* FNV-1a, to compare the text of the modes without keeping it. */
+static uint64_t hash_text(uint64_t hash, const char *text, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)text[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static uint64_t hash_fd(int fd)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	char block[64 * 1024];
+	ssize_t len;
+
+	lseek(fd, 0, SEEK_SET);
+	while ((len = read(fd, block, sizeof(block))) > 0)
+		hash = hash_text(hash, block, len);
+
+	return hash;
+}
+
+/* A counter with a glitch now and then, which keeps rows distinct. */
+static std::vector<uint8_t> make_logic(void)
+{
+	std::vector<uint8_t> data(packet_samples);
+	uint32_t seed = 1;
+
+	for (size_t i = 0; i < packet_samples; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (i >> 2) ^ ((seed >> 16) % 100 ? 0 : 0x80);
+	}
+
+	return data;
+}
+
+static int run(std::shared_ptr<Context> context,
+	std::shared_ptr<UserDevice> device, std::shared_ptr<Packet> header,
+	std::vector<uint8_t> &data, enum bench_mode mode, int fd,
+	double *seconds, size_t *bytes, uint64_t *hash)
+{
+	auto format = context->output_formats()["csv"];
+	auto output = format->create_output(device);
+	auto logic = context->create_logic_packet(data.data(), data.size(), 1);
+	auto end = context->create_end_packet();
+	std::string buffer;
+
+	*hash = 0xcbf29ce484222325ull;
+	*bytes = 0;
+	if (ftruncate(fd, 0) < 0 || lseek(fd, 0, SEEK_SET) < 0)
+		return 1;
+
+	auto start = bench_clock::now();
+	for (unsigned int i = 0; i < num_packets + 2; i++) {
+		auto packet = i == 0 ? header : i <= num_packets ? logic : end;
+		switch (mode) {
+		case MODE_STRING: {
+			std::string text = output->receive(packet);
+			*bytes += text.size();
+			*hash = hash_text(*hash, text.data(), text.size());
+			break;
+		}
+		case MODE_BUFFER:
+			buffer.clear();
+			output->receive(packet, buffer);
+			*bytes += buffer.size();
+			*hash = hash_text(*hash, buffer.data(), buffer.size());
+			break;
+		case MODE_FD:
+			output->receive(packet, fd);
+			break;
+		}
+	}
+	*seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+	if (mode == MODE_FD) {
+		*bytes = lseek(fd, 0, SEEK_END);
+		*hash = hash_fd(fd);
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	char path[] = "/tmp/otc-cxx-output-bench.XXXXXX";
+	uint64_t hashes[3];
+	size_t bytes[3];
+	double seconds, best;
+	int fd;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (!strcmp(argv[i], "-n")) {
+			num_packets = strtoul(argv[i + 1], NULL, 0);
+		} else if (!strcmp(argv[i], "-s")) {
+			packet_samples = strtoull(argv[i + 1], NULL, 0);
+		} else if (!strcmp(argv[i], "-r")) {
+			rounds = strtoul(argv[i + 1], NULL, 0);
+		} else {
+			fprintf(stderr, "Usage: %s [-n packets] [-s samples] "
+				"[-r rounds]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	auto context = Context::create();
+	auto device = context->create_user_device("Bench", "CSV", "1");
+	for (unsigned int i = 0; i < 8; i++)
+		device->add_channel(i, ChannelType::LOGIC, "D" + std::to_string(i));
+	std::vector<uint8_t> data = make_logic();
+	/* One start time for all runs, it is part of the CSV header. */
+	auto header = context->create_header_packet(Glib::DateTime::create_now_utc());
+
+	/* Written to a file, so that the text can be compared. */
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	unlink(path);
+
+	for (int mode = MODE_STRING; mode <= MODE_FD; mode++) {
+		best = 1e9;
+		for (unsigned int r = 0; r < rounds; r++) {
+			if (run(context, device, header, data,
+					(enum bench_mode)mode, fd, &seconds,
+					&bytes[mode], &hashes[mode])) {
+				perror("Cannot reset output file");
+				return 1;
+			}
+			best = std::min(best, seconds);
+		}
+		printf("csv %-8s %8.1f Msps  %8.1f MB/s  (%zu bytes)\n",
+			mode_names[mode],
+			num_packets * packet_samples / best / 1e6,
+			bytes[mode] / best / 1e6, bytes[mode]);
+	}
+	close(fd);
+
+	if (hashes[MODE_BUFFER] != hashes[MODE_STRING]
+			|| hashes[MODE_FD] != hashes[MODE_STRING]) {
+		fprintf(stderr, "Mismatch: the modes produced different text.\n");
+		return 1;
+	}
+
+	return 0;
+}
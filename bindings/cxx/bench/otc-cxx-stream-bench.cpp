@@ -0,0 +1,190 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Session::stream() through the C++ API. Each round opens and drops a
+ * number of streams, then feeds binary input into the session with two
+ * streams left. Both have to receive all data, as the same retained
+ * packets, and get closed by remove_datafeed_callbacks(). The next round
+ * uses the same session, its streams have to receive data again. Fails
+ * when streams miss data, or don't share the retained packets the way
+ * a single datafeed callback for all streams does.
+ *
+ * Usage: otc-cxx-stream-bench [-n packets] [-s samples] [-k dropped]
+ *                             [-r rounds]
+ */
+
+#include <libopentracecapturecxx/libopentracecapturecxx.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+using namespace opentrace;
+
+static unsigned int num_packets = 1024;
+static size_t packet_samples = 4096;
+static unsigned int num_dropped = 1000;
+static unsigned int rounds = 3;
+
+typedef std::chrono::steady_clock bench_clock;
+
+struct received {
+	unsigned int packets;
+	uint64_t bytes;
+};
+
+static std::shared_ptr<Input> open_input(std::shared_ptr<Context> context)
+{
+	auto format = context->input_formats()["binary"];
+	std::map<std::string, Glib::VariantBase> options;
+
+	options["numchannels"] = Glib::Variant<gint32>::create(16);
+
+	return format->create_input(options);
+}
+
+/* Pops both streams in step, they have to see the same packets. */
+static bool drain(std::shared_ptr<PacketStream> a,
+	std::shared_ptr<PacketStream> b, struct received *r)
+{
+	std::shared_ptr<Packet> pa, pb;
+
+	memset(r, 0, sizeof(*r));
+	while ((pa = a->try_pop())) {
+		pb = b->try_pop();
+		if (pa != pb) {
+			fprintf(stderr, "Streams got different packets.\n");
+			return false;
+		}
+		if (pa->type() != PacketType::LOGIC)
+			continue;
+		auto logic = std::dynamic_pointer_cast<Logic>(pa->payload());
+		r->packets++;
+		r->bytes += logic->data_length();
+	}
+	if (b->try_pop()) {
+		fprintf(stderr, "Second stream got more packets.\n");
+		return false;
+	}
+
+	return true;
+}
+
+static bool run(std::shared_ptr<Context> context,
+	std::shared_ptr<Session> session, const std::vector<uint8_t> &data,
+	double *seconds)
+{
+	std::shared_ptr<PacketStream> a, b;
+	struct received r;
+	bool ok;
+
+	auto input = open_input(context);
+	/* The first chunk only sets up the device, it gets sent later. */
+	input->send((void *)data.data(), data.size());
+	session->add_device(input->device());
+
+	for (unsigned int i = 0; i < num_dropped; i++)
+		session->stream(1, StreamOverflow::DROP_NEWEST);
+	a = session->stream(num_packets + 8, StreamOverflow::DROP_NEWEST);
+	b = session->stream(num_packets + 8, StreamOverflow::DROP_NEWEST);
+
+	auto start = bench_clock::now();
+	for (unsigned int i = 1; i < num_packets; i++)
+		input->send((void *)data.data(), data.size());
+	input->end();
+	auto end = bench_clock::now();
+	*seconds = std::chrono::duration<double>(end - start).count();
+
+	ok = drain(a, b, &r);
+	if (ok && (a->dropped() || b->dropped())) {
+		fprintf(stderr, "Streams dropped packets.\n");
+		ok = false;
+	}
+	if (ok && r.bytes != (uint64_t)num_packets * data.size()) {
+		fprintf(stderr, "Streams got %llu bytes, expected %llu.\n",
+			(unsigned long long)r.bytes,
+			(unsigned long long)num_packets * data.size());
+		ok = false;
+	}
+
+	session->remove_datafeed_callbacks();
+	if (ok && (!a->is_closed() || !b->is_closed())) {
+		fprintf(stderr, "Streams were not closed.\n");
+		ok = false;
+	}
+	session->remove_devices();
+
+	return ok;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n packets] [-s samples] [-k dropped] "
+		"[-r rounds]\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	double seconds, best;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:k:r:")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_packets = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			packet_samples = strtoull(optarg, NULL, 0);
+			break;
+		case 'k':
+			num_dropped = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			rounds = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (num_packets < 2 || !packet_samples || !rounds)
+		usage(argv[0]);
+
+	auto context = Context::create();
+	auto session = context->create_session();
+	std::vector<uint8_t> data(packet_samples * 2);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = i * 7;
+
+	best = 0;
+	for (unsigned int round = 0; round < rounds; round++) {
+		if (!run(context, session, data, &seconds))
+			return 1;
+		if (!round || seconds < best)
+			best = seconds;
+	}
+	printf("%u dropped streams, 2 streams %8.1f kpackets/s\n",
+		num_dropped, num_packets / best / 1e3);
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmark of the sample views against the raw pointer loops
+ * which consumers write by hand. Also checks that both agree, and
+ * fails when they don't. Analog::view() gets checked on packets with
+ * one and two channels, it has to cover all interleaved values.
+ *
+ * Usage: otc-cxx-views-bench [-n samples] [-r rounds]
+ */
+
+#include <libopentracecapturecxx/libopentracecapturecxx.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace opentrace;
+
+static size_t num_samples = 16 * 1024 * 1024;
+static unsigned int rounds = 5;
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double seconds_since(bench_clock::time_point start)
+{
+	return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+static void report(const char *name, size_t samples, double raw_s,
+	double view_s)
+{
+	printf("%-24s raw %8.1f Msps  view %8.1f Msps  (x%.2f)\n", name,
+		samples / raw_s / 1e6, samples / view_s / 1e6, raw_s / view_s);
+}
+
+/*
+ * A counter which advances every 16 samples, with rare glitches. Bit n
+ * of each byte changes every 2^(n+4) samples.
+ */
+static std::vector<uint8_t> make_logic(unsigned int unit_size)
+{
+	std::vector<uint8_t> data(num_samples * unit_size);
+	uint32_t seed = 1;
+	uint8_t glitch;
+
+	for (size_t i = 0; i < num_samples; i++) {
+		seed = seed * 1103515245 + 12345;
+		glitch = (seed >> 16) % 1000 ? 0 : 0xff;
+		for (unsigned int b = 0; b < unit_size; b++)
+			data[i * unit_size + b] = ((i >> 4) & 0xff) ^ glitch;
+	}
+
+	return data;
+}
+
+static int bench_logic(unsigned int unit_size, unsigned int channel)
+{
+	std::vector<uint8_t> data = make_logic(unit_size);
+	const uint8_t *p = data.data();
+	size_t raw_count = 0, view_count = 0, raw_edges = 0, view_edges = 0;
+	double raw_s = 1e9, view_s = 1e9;
+	char name[64];
+
+	for (unsigned int r = 0; r < rounds; r++) {
+		auto start = bench_clock::now();
+		raw_count = 0;
+		for (size_t i = 0; i < num_samples; i++)
+			raw_count += (p[i * unit_size + channel / 8] >> (channel % 8)) & 1;
+		raw_s = std::min(raw_s, seconds_since(start));
+
+		start = bench_clock::now();
+		ChannelView view(p, data.size(), unit_size, channel);
+		view_count = view.count();
+		view_s = std::min(view_s, seconds_since(start));
+	}
+	snprintf(name, sizeof(name), "count u%u ch%u", unit_size, channel);
+	report(name, num_samples, raw_s, view_s);
+
+	raw_s = view_s = 1e9;
+	for (unsigned int r = 0; r < rounds; r++) {
+		auto start = bench_clock::now();
+		raw_edges = 0;
+		int prev = p[channel / 8] >> (channel % 8) & 1;
+		for (size_t i = 1; i < num_samples; i++) {
+			int cur = (p[i * unit_size + channel / 8] >> (channel % 8)) & 1;
+			raw_edges += cur != prev;
+			prev = cur;
+		}
+		raw_s = std::min(raw_s, seconds_since(start));
+
+		start = bench_clock::now();
+		ChannelView view(p, data.size(), unit_size, channel);
+		view_edges = 0;
+		for (size_t i = view.find_next_edge(0); i < view.size();
+				i = view.find_next_edge(i))
+			view_edges++;
+		view_s = std::min(view_s, seconds_since(start));
+	}
+	snprintf(name, sizeof(name), "edges u%u ch%u", unit_size, channel);
+	report(name, num_samples, raw_s, view_s);
+
+	if (raw_count != view_count || raw_edges != view_edges) {
+		fprintf(stderr, "Mismatch: count %zu/%zu, edges %zu/%zu.\n",
+			raw_count, view_count, raw_edges, view_edges);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int bench_analog(void)
+{
+	std::vector<int16_t> data(num_samples);
+	std::vector<float> floats;
+	const float scale = 0.001f, offset = -1.5f;
+	double raw_sum = 0, view_sum = 0;
+	double raw_s = 1e9, view_s = 1e9;
+
+	for (size_t i = 0; i < num_samples; i++)
+		data[i] = (int16_t)(i * 7);
+
+	for (unsigned int r = 0; r < rounds; r++) {
+		/* What get_data_as_float() users do: convert, then iterate. */
+		auto start = bench_clock::now();
+		floats.resize(num_samples);
+		for (size_t i = 0; i < num_samples; i++)
+			floats[i] = data[i] * scale + offset;
+		raw_sum = 0;
+		for (float value : floats)
+			raw_sum += value;
+		raw_s = std::min(raw_s, seconds_since(start));
+		floats.clear();
+		floats.shrink_to_fit();
+
+		start = bench_clock::now();
+		AnalogView<int16_t> view(data.data(), data.size(), scale, offset);
+		view_sum = 0;
+		for (float value : view)
+			view_sum += value;
+		view_s = std::min(view_s, seconds_since(start));
+	}
+	report("analog int16 sum", num_samples, raw_s, view_s);
+
+	if (raw_sum != view_sum) {
+		fprintf(stderr, "Mismatch: sum %f/%f.\n", raw_sum, view_sum);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int check_analog_packet(std::shared_ptr<Context> context,
+	unsigned int num_channels)
+{
+	const unsigned int samples = 1000;
+	std::vector<std::shared_ptr<Channel> > channels;
+	std::vector<float> data(samples * num_channels);
+	double raw_sum = 0, view_sum = 0;
+
+	auto device = context->create_user_device("Bench", "Views", "1");
+	for (unsigned int i = 0; i < num_channels; i++)
+		channels.push_back(device->add_channel(i, ChannelType::ANALOG,
+			"A" + std::to_string(i)));
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = i * 0.5f;
+		raw_sum += data[i];
+	}
+
+	auto packet = context->create_analog_packet(channels, data.data(),
+		samples, Quantity::VOLTAGE, Unit::VOLT, {});
+	auto analog = std::dynamic_pointer_cast<Analog>(packet->payload());
+	auto view = analog->view<float>();
+	for (float value : view)
+		view_sum += value;
+
+	if (view.size() != data.size() || raw_sum != view_sum) {
+		fprintf(stderr, "Mismatch: %u channel view has %zu/%zu values, "
+			"sum %f/%f.\n", num_channels, view.size(), data.size(),
+			raw_sum, view_sum);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int ret = 0;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (!strcmp(argv[i], "-n")) {
+			num_samples = strtoull(argv[i + 1], NULL, 0);
+		} else if (!strcmp(argv[i], "-r")) {
+			rounds = strtoul(argv[i + 1], NULL, 0);
+		} else {
+			fprintf(stderr, "Usage: %s [-n samples] [-r rounds]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+
+	ret |= bench_logic(1, 3);
+	ret |= bench_logic(2, 11);
+	ret |= bench_logic(4, 0);
+	ret |= bench_logic(3, 20);
+	ret |= bench_analog();
+
+	auto context = Context::create();
+	ret |= check_analog_packet(context, 1);
+	ret |= check_analog_packet(context, 2);
+
+	return ret;
+}
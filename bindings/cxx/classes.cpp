@@ -26,6 +26,7 @@
 #include <config.h>
 #include <libopentracecapturecxx/libopentracecapturecxx.hpp>
 
+#include <algorithm>
 #include <sstream>
 #include <cmath>
 
@@ -218,6 +219,9 @@ map<string, shared_ptr<OutputFormat>> Context::output_formats()
 
 Context::~Context()
 {
+	/* The log thread must not call into the destroyed callback. */
+	if (_log_callback)
+		otc_log_callback_set_default();
 	check(otc_exit(_structure));
 }
 
@@ -260,6 +264,16 @@ void Context::set_log_callback_default()
 	_log_callback = nullptr;
 }
 
+void Context::set_log_async(bool enable)
+{
+	check(otc_log_async_set(enable));
+}
+
+uint64_t Context::log_dropped() const
+{
+	return otc_log_dropped_get();
+}
+
 void Context::set_resource_reader(ResourceReader *reader)
 {
 	if (reader) {
@@ -273,6 +287,11 @@ void Context::set_resource_reader(ResourceReader *reader)
 	}
 }
 
+void Context::set_usb_event_thread(bool enable)
+{
+	check(otc_usb_event_thread_set(_structure, enable));
+}
+
 shared_ptr<Session> Context::create_session()
 {
 	return shared_ptr<Session>{new Session{shared_from_this()},
@@ -387,6 +406,37 @@ shared_ptr<Packet> Context::create_end_packet()
 		default_delete<Packet>{}};
 }
 
+shared_ptr<PacketBuilder> Context::create_logic_packet_builder(
+	unsigned int unit_size)
+{
+	auto builder = otc_packet_builder_logic_new(unit_size);
+	if (!builder)
+		throw Error(OTC_ERR_ARG);
+	return shared_ptr<PacketBuilder>{
+		new PacketBuilder{builder, vector<shared_ptr<Channel> >{}},
+		default_delete<PacketBuilder>{}};
+}
+
+shared_ptr<PacketBuilder> Context::create_analog_packet_builder(
+	vector<shared_ptr<Channel> > channels, const Quantity *mq,
+	const Unit *unit, vector<const QuantityFlag *> mqflags)
+{
+	GSList *list = nullptr;
+	for (const auto &channel : channels)
+		list = g_slist_append(list, channel->_structure);
+	auto builder = otc_packet_builder_analog_new(list,
+		static_cast<otc_mq>(mq->id()),
+		static_cast<otc_unit>(unit->id()),
+		static_cast<otc_mqflag>(QuantityFlag::mask_from_flags(move(mqflags))),
+		nullptr);
+	g_slist_free(list);
+	if (!builder)
+		throw Error(OTC_ERR_ARG);
+	return shared_ptr<PacketBuilder>{
+		new PacketBuilder{builder, move(channels)},
+		default_delete<PacketBuilder>{}};
+}
+
 shared_ptr<Session> Context::load_session(string filename)
 {
 	return shared_ptr<Session>{
@@ -898,16 +948,45 @@ float TriggerMatch::value() const
 DatafeedCallbackData::DatafeedCallbackData(Session *session,
 		DatafeedCallbackFunction callback) :
 	_callback(move(callback)),
-	_session(session)
+	_session(session),
+	_sdi(nullptr),
+	_device(nullptr),
+	_devices_version(0)
+{
+}
+
+DatafeedCallbackData::DatafeedCallbackData(Session *session,
+		DatafeedViewCallbackFunction callback) :
+	_view_callback(move(callback)),
+	_session(session),
+	_sdi(nullptr),
+	_device(nullptr),
+	_devices_version(0)
 {
 }
 
 void DatafeedCallbackData::run(const struct otc_dev_inst *sdi,
 	const struct otc_datafeed_packet *pkt)
 {
-	auto device = _session->get_device(sdi);
-	shared_ptr<Packet> packet {new Packet{device, pkt}, default_delete<Packet>{}};
-	_callback(move(device), move(packet));
+	if (!_view_callback) {
+		auto device = _session->get_device(sdi);
+		shared_ptr<Packet> packet {new Packet{device, pkt}, default_delete<Packet>{}};
+		_callback(move(device), move(packet));
+		return;
+	}
+
+	/*
+	 * Keep a plain pointer, a shared pointer would keep the session
+	 * alive. The session's device maps own the devices, their contents
+	 * only change along with the devices version.
+	 */
+	if (!_device || sdi != _sdi ||
+			_devices_version != _session->_devices_version) {
+		_device = _session->get_device(sdi).get();
+		_sdi = sdi;
+		_devices_version = _session->_devices_version;
+	}
+	_view_callback(PacketView{_session, sdi, *_device, pkt});
 }
 
 SessionDevice::SessionDevice(struct otc_dev_inst *structure) :
@@ -926,18 +1005,26 @@ shared_ptr<Device> SessionDevice::get_shared_from_this()
 
 Session::Session(shared_ptr<Context> context) :
 	_structure(nullptr),
-	_context(move(context))
+	_context(move(context)),
+	_devices_version(0),
+	_streams_callback(false),
+	_packet_pool(nullptr)
 {
 	check(otc_session_new(_context->_structure, &_structure));
+	_packet_pool = otc_packet_pool_new(0);
 	_context->_session = this;
 }
 
 Session::Session(shared_ptr<Context> context, string filename) :
 	_structure(nullptr),
 	_context(move(context)),
+	_devices_version(0),
+	_streams_callback(false),
+	_packet_pool(nullptr),
 	_filename(move(filename))
 {
 	check(otc_session_load(_context->_structure, _filename.c_str(), &_structure));
+	_packet_pool = otc_packet_pool_new(0);
 	GSList *dev_list;
 	check(otc_session_dev_list(_structure, &dev_list));
 	for (GSList *dev = dev_list; dev; dev = dev->next) {
@@ -951,6 +1038,9 @@ Session::Session(shared_ptr<Context> context, string filename) :
 
 Session::~Session()
 {
+	close_streams();
+	/* Retained packets keep the pool alive until they are released. */
+	otc_packet_pool_free(_packet_pool);
 	check(otc_session_destroy(_structure));
 }
 
@@ -970,6 +1060,7 @@ void Session::add_device(shared_ptr<Device> device)
 	const auto dev_struct = device->_structure;
 	check(otc_session_dev_add(_structure, dev_struct));
 	_other_devices[dev_struct] = move(device);
+	_devices_version++;
 }
 
 vector<shared_ptr<Device>> Session::devices()
@@ -988,6 +1079,7 @@ vector<shared_ptr<Device>> Session::devices()
 void Session::remove_devices()
 {
 	_other_devices.clear();
+	_devices_version++;
 	check(otc_session_dev_remove_all(_structure));
 }
 
@@ -1001,6 +1093,175 @@ void Session::run()
 	check(otc_session_run(_structure));
 }
 
+void Session::set_device_threads(bool enable)
+{
+	check(otc_session_device_threads_set(_structure, enable));
+}
+
+void Session::set_stats_enabled(bool enable)
+{
+	check(otc_session_stats_set(_structure, enable));
+}
+
+SessionStats Session::stats()
+{
+	struct otc_session_stats *structure;
+	check(otc_session_stats_get(_structure, &structure));
+	const unique_ptr<struct otc_session_stats,
+		decltype(&otc_session_stats_free)>
+		owner{structure, &otc_session_stats_free};
+	return SessionStats{shared_from_this(), structure};
+}
+
+StatsHistogram::StatsHistogram(const struct otc_stats_histogram &structure) :
+	_structure(structure)
+{
+}
+
+uint64_t StatsHistogram::count() const
+{
+	return _structure.count;
+}
+
+uint64_t StatsHistogram::sum() const
+{
+	return _structure.sum;
+}
+
+uint64_t StatsHistogram::min() const
+{
+	return _structure.min;
+}
+
+uint64_t StatsHistogram::max() const
+{
+	return _structure.max;
+}
+
+uint64_t StatsHistogram::percentile(double percentile) const
+{
+	return otc_stats_histogram_percentile(&_structure, percentile);
+}
+
+DeviceStats::DeviceStats(shared_ptr<Session> session,
+		const struct otc_stats_device &structure) :
+	_session(move(session)),
+	_structure(structure)
+{
+}
+
+shared_ptr<Device> DeviceStats::device() const
+{
+	return _session->get_device(_structure.sdi);
+}
+
+uint64_t DeviceStats::packets() const
+{
+	return _structure.packets;
+}
+
+uint64_t DeviceStats::bytes() const
+{
+	return _structure.bytes;
+}
+
+double DeviceStats::packets_per_sec() const
+{
+	return _structure.packets_per_sec;
+}
+
+double DeviceStats::bytes_per_sec() const
+{
+	return _structure.bytes_per_sec;
+}
+
+uint64_t DeviceStats::feed_queue_flushes() const
+{
+	return _structure.feed_queue_flushes;
+}
+
+uint64_t DeviceStats::feed_queue_samples() const
+{
+	return _structure.feed_queue_samples;
+}
+
+uint64_t DeviceStats::trigger_samples() const
+{
+	return _structure.trigger_samples;
+}
+
+StatsHistogram DeviceStats::trigger_scan() const
+{
+	return StatsHistogram{_structure.trigger_scan};
+}
+
+uint64_t DeviceStats::queued_packets() const
+{
+	return _structure.queued_packets;
+}
+
+uint64_t DeviceStats::max_queued_packets() const
+{
+	return _structure.max_queued_packets;
+}
+
+uint64_t DeviceStats::overruns() const
+{
+	return _structure.overruns;
+}
+
+uint64_t DeviceStats::buffer_full() const
+{
+	return _structure.buffer_full;
+}
+
+uint64_t DeviceStats::max_buffer_fill() const
+{
+	return _structure.max_buffer_fill;
+}
+
+SessionStats::SessionStats(shared_ptr<Session> session,
+		const struct otc_session_stats *structure) :
+	_elapsed_us(structure->elapsed_us),
+	_transform(structure->transform),
+	_callbacks(structure->callbacks),
+	_usb_resubmit(structure->usb_resubmit),
+	_output(structure->output)
+{
+	for (unsigned int i = 0; i < structure->num_devices; i++)
+		_devices.push_back(DeviceStats{session, structure->devices[i]});
+}
+
+uint64_t SessionStats::elapsed_us() const
+{
+	return _elapsed_us;
+}
+
+const vector<DeviceStats> &SessionStats::devices() const
+{
+	return _devices;
+}
+
+const StatsHistogram &SessionStats::transform() const
+{
+	return _transform;
+}
+
+const StatsHistogram &SessionStats::callbacks() const
+{
+	return _callbacks;
+}
+
+const StatsHistogram &SessionStats::usb_resubmit() const
+{
+	return _usb_resubmit;
+}
+
+const StatsHistogram &SessionStats::output() const
+{
+	return _output;
+}
+
 void Session::stop()
 {
 	check(otc_session_stop(_structure));
@@ -1014,18 +1275,26 @@ bool Session::is_running() const
 	return (ret != 0);
 }
 
-static void session_stopped_callback(void *data) noexcept
+void Session::stopped_callback(void *data) noexcept
 {
-	auto *const callback = static_cast<SessionStoppedCallback*>(data);
-	(*callback)();
+	auto *const session = static_cast<Session *>(data);
+	session->close_streams();
+	if (session->_stopped_callback)
+		session->_stopped_callback();
 }
 
 void Session::set_stopped_callback(SessionStoppedCallback callback)
 {
+	bool streams;
+
+	{
+		lock_guard<mutex> lock(_streams_mutex);
+		streams = !_streams.empty();
+	}
 	_stopped_callback = move(callback);
-	if (_stopped_callback)
+	if (_stopped_callback || streams)
 		check(otc_session_stopped_callback_set(_structure,
-				&session_stopped_callback, &_stopped_callback));
+				&Session::stopped_callback, this));
 	else
 		check(otc_session_stopped_callback_set(_structure,
 				nullptr, nullptr));
@@ -1047,10 +1316,92 @@ void Session::add_datafeed_callback(DatafeedCallbackFunction callback)
 	_datafeed_callbacks.push_back(move(cb_data));
 }
 
+void Session::add_datafeed_view_callback(DatafeedViewCallbackFunction callback)
+{
+	unique_ptr<DatafeedCallbackData> cb_data
+		{new DatafeedCallbackData{this, move(callback)}};
+	check(otc_session_datafeed_callback_add(_structure,
+			&datafeed_callback, cb_data.get()));
+	_datafeed_callbacks.push_back(move(cb_data));
+}
+
 void Session::remove_datafeed_callbacks()
 {
 	check(otc_session_datafeed_callback_remove_all(_structure));
 	_datafeed_callbacks.clear();
+	_streams_callback = false;
+	close_streams();
+}
+
+shared_ptr<PacketStream> Session::stream(size_t depth,
+	StreamOverflow overflow)
+{
+	if (!depth)
+		throw Error(OTC_ERR_ARG);
+	shared_ptr<PacketStream> stream {new PacketStream{depth, overflow},
+		default_delete<PacketStream>{}};
+
+	/*
+	 * The consumer owns the stream, packets for a dropped one get lost.
+	 * One callback serves all streams, registering one per stream would
+	 * keep them around until remove_datafeed_callbacks().
+	 */
+	if (!_streams_callback) {
+		add_datafeed_view_callback([this](const PacketView &view) {
+			push_streams(view);
+		});
+		_streams_callback = true;
+	}
+
+	{
+		lock_guard<mutex> lock(_streams_mutex);
+		_streams.erase(remove_if(_streams.begin(), _streams.end(),
+			[](const weak_ptr<PacketStream> &s) {
+				return s.expired();
+			}), _streams.end());
+		_streams.push_back(stream);
+	}
+	check(otc_session_stopped_callback_set(_structure,
+			&Session::stopped_callback, this));
+
+	return stream;
+}
+
+/*
+ * Runs on the session's thread. Pushes outside of the lock, a blocking
+ * stream must not hold up stream() calls on the consumer's thread. All
+ * streams share one retained copy.
+ */
+void Session::push_streams(const PacketView &view)
+{
+	vector<shared_ptr<PacketStream> > targets;
+	shared_ptr<Packet> packet;
+
+	{
+		lock_guard<mutex> lock(_streams_mutex);
+		for (const auto &entry : _streams)
+			if (auto stream = entry.lock())
+				if (!stream->is_closed())
+					targets.push_back(move(stream));
+	}
+	if (targets.empty())
+		return;
+	packet = view.retain();
+	for (const auto &stream : targets)
+		stream->push(packet);
+}
+
+void Session::close_streams()
+{
+	vector<weak_ptr<PacketStream> > streams;
+
+	{
+		lock_guard<mutex> lock(_streams_mutex);
+		streams.swap(_streams);
+	}
+	for (const auto &entry : streams)
+		if (auto stream = entry.lock())
+			stream->close();
 }
 
 shared_ptr<Trigger> Session::trigger()
@@ -1081,6 +1432,7 @@ shared_ptr<Context> Session::context()
 Packet::Packet(shared_ptr<Device> device,
 	const struct otc_datafeed_packet *structure) :
 	_structure(structure),
+	_copy(nullptr),
 	_device(move(device))
 {
 	switch (structure->type)
@@ -1110,6 +1462,8 @@ Packet::Packet(shared_ptr<Device> device,
 
 Packet::~Packet()
 {
+	_payload.reset();
+	otc_packet_pool_release(_copy);
 }
 
 const PacketType *Packet::type() const
@@ -1125,6 +1479,269 @@ shared_ptr<PacketPayload> Packet::payload()
 		throw Error(OTC_ERR_NA);
 }
 
+PacketBuilder::PacketBuilder(struct otc_packet_builder *structure,
+		vector<shared_ptr<Channel> > channels) :
+	_structure(structure, otc_packet_builder_free),
+	_channels(move(channels))
+{
+}
+
+PacketBuilder::~PacketBuilder()
+{
+}
+
+shared_ptr<Packet> PacketBuilder::share(
+	const struct otc_datafeed_packet *structure)
+{
+	if (!structure)
+		throw Error(OTC_ERR_NA);
+	/* The structure stays the same, only its payload gets updated. */
+	if (!_packet) {
+		_packet = shared_ptr<Packet>{new Packet{nullptr, structure},
+			default_delete<Packet>{}};
+		_packet->_builder = _structure;
+	}
+	return _packet;
+}
+
+shared_ptr<Packet> PacketBuilder::logic(const void *data_pointer,
+	size_t data_length)
+{
+	return share(otc_packet_builder_logic(_structure.get(),
+		data_pointer, data_length));
+}
+
+shared_ptr<Packet> PacketBuilder::analog(const float *data_pointer,
+	unsigned int num_samples)
+{
+	return share(otc_packet_builder_analog(_structure.get(),
+		data_pointer, num_samples));
+}
+
+PacketView::PacketView(Session *session, const struct otc_dev_inst *sdi,
+		Device &device, const struct otc_datafeed_packet *structure) :
+	_session(session),
+	_sdi(sdi),
+	_device(device),
+	_structure(structure)
+{
+}
+
+const PacketType *PacketView::type() const
+{
+	return PacketType::get(_structure->type);
+}
+
+Device &PacketView::device() const
+{
+	return _device;
+}
+
+const struct otc_datafeed_logic *PacketView::logic() const
+{
+	if (_structure->type != OTC_DF_LOGIC)
+		throw Error(OTC_ERR_NA);
+	return static_cast<const struct otc_datafeed_logic *>(
+		_structure->payload);
+}
+
+const struct otc_datafeed_analog *PacketView::analog() const
+{
+	if (_structure->type != OTC_DF_ANALOG)
+		throw Error(OTC_ERR_NA);
+	return static_cast<const struct otc_datafeed_analog *>(
+		_structure->payload);
+}
+
+Span<const uint8_t> PacketView::logic_data() const
+{
+	const auto logic = this->logic();
+	return Span<const uint8_t>{
+		static_cast<const uint8_t *>(logic->data), logic->length};
+}
+
+unsigned int PacketView::unit_size() const
+{
+	return logic()->unitsize;
+}
+
+Span<const uint8_t> PacketView::analog_data() const
+{
+	const auto analog = this->analog();
+	/* Samples of all the packet's channels, interleaved. */
+	const size_t num_channels =
+		max(g_slist_length(analog->meaning->channels), 1u);
+	return Span<const uint8_t>{static_cast<const uint8_t *>(analog->data),
+		size_t{analog->num_samples} * num_channels * analog->encoding->unitsize};
+}
+
+unsigned int PacketView::num_samples() const
+{
+	return analog()->num_samples;
+}
+
+shared_ptr<Packet> PacketView::retain() const
+{
+	struct otc_datafeed_packet *copy;
+	check(otc_packet_pool_copy(_session->_packet_pool, _structure, &copy));
+	unique_ptr<struct otc_datafeed_packet, void (*)(struct otc_datafeed_packet *)>
+		guard{copy, &otc_packet_pool_release};
+	shared_ptr<Packet> packet {new Packet{_session->get_device(_sdi), copy},
+		default_delete<Packet>{}};
+	packet->_copy = guard.release();
+	return packet;
+}
+
+PacketStream::PacketStream(size_t depth, StreamOverflow overflow) :
+	_slots(depth),
+	_head(0),
+	_count(0),
+	_overflow(overflow),
+	_closed(false),
+	_pushed(0),
+	_dropped(0),
+	_overflows(0),
+	_max_size(0)
+{
+}
+
+PacketStream::~PacketStream()
+{
+}
+
+void PacketStream::push(shared_ptr<Packet> packet)
+{
+	function<void()> ready;
+	{
+		unique_lock<mutex> lock(_mutex);
+		if (_count == _slots.size()) {
+			_overflows++;
+			switch (_overflow) {
+			case StreamOverflow::BLOCK:
+				_writable.wait(lock, [this]() {
+					return _closed || _count < _slots.size();
+				});
+				break;
+			case StreamOverflow::DROP_NEWEST:
+				_dropped++;
+				return;
+			case StreamOverflow::DROP_OLDEST:
+				_dropped++;
+				_slots[_head].reset();
+				_head = (_head + 1) % _slots.size();
+				_count--;
+				break;
+			}
+		}
+		if (_closed)
+			return;
+		_slots[(_head + _count) % _slots.size()] = move(packet);
+		_count++;
+		_pushed++;
+		_max_size = max(_max_size, _count);
+		ready = move(_ready_callback);
+		_ready_callback = nullptr;
+	}
+	_readable.notify_one();
+	if (ready)
+		ready();
+}
+
+/* Called with the mutex held, and at least one packet queued. */
+shared_ptr<Packet> PacketStream::take()
+{
+	shared_ptr<Packet> packet = move(_slots[_head]);
+	_head = (_head + 1) % _slots.size();
+	_count--;
+	_writable.notify_one();
+	return packet;
+}
+
+shared_ptr<Packet> PacketStream::pop()
+{
+	unique_lock<mutex> lock(_mutex);
+	_readable.wait(lock, [this]() { return _count || _closed; });
+	return _count ? take() : nullptr;
+}
+
+shared_ptr<Packet> PacketStream::pop_for(chrono::milliseconds timeout)
+{
+	unique_lock<mutex> lock(_mutex);
+	_readable.wait_for(lock, timeout, [this]() { return _count || _closed; });
+	return _count ? take() : nullptr;
+}
+
+shared_ptr<Packet> PacketStream::try_pop()
+{
+	lock_guard<mutex> lock(_mutex);
+	return _count ? take() : nullptr;
+}
+
+void PacketStream::close()
+{
+	function<void()> ready;
+	{
+		lock_guard<mutex> lock(_mutex);
+		_closed = true;
+		ready = move(_ready_callback);
+		_ready_callback = nullptr;
+	}
+	_readable.notify_all();
+	_writable.notify_all();
+	if (ready)
+		ready();
+}
+
+bool PacketStream::is_closed() const
+{
+	lock_guard<mutex> lock(_mutex);
+	return _closed;
+}
+
+size_t PacketStream::size() const
+{
+	lock_guard<mutex> lock(_mutex);
+	return _count;
+}
+
+size_t PacketStream::capacity() const
+{
+	return _slots.size();
+}
+
+uint64_t PacketStream::pushed() const
+{
+	lock_guard<mutex> lock(_mutex);
+	return _pushed;
+}
+
+uint64_t PacketStream::dropped() const
+{
+	lock_guard<mutex> lock(_mutex);
+	return _dropped;
+}
+
+uint64_t PacketStream::overflows() const
+{
+	lock_guard<mutex> lock(_mutex);
+	return _overflows;
+}
+
+size_t PacketStream::max_size() const
+{
+	lock_guard<mutex> lock(_mutex);
+	return _max_size;
+}
+
+bool PacketStream::notify_when_ready(function<void()> callback)
+{
+	lock_guard<mutex> lock(_mutex);
+	if (_count || _closed)
+		return false;
+	_ready_callback = move(callback);
+	return true;
+}
+
 PacketPayload::PacketPayload()
 {
 }
@@ -1645,7 +2262,8 @@ Output::Output(shared_ptr<OutputFormat> format,
 		map_to_hash_variant(options), device->_structure, nullptr)),
 	_format(move(format)),
 	_device(move(device)),
-	_options(move(options))
+	_options(move(options)),
+	_buffer(g_string_sized_new(64 * 1024))
 {
 }
 
@@ -1655,12 +2273,14 @@ Output::Output(string filename, shared_ptr<OutputFormat> format,
 		map_to_hash_variant(options), device->_structure, filename.c_str())),
 	_format(move(format)),
 	_device(move(device)),
-	_options(move(options))
+	_options(move(options)),
+	_buffer(g_string_sized_new(64 * 1024))
 {
 }
 
 Output::~Output()
 {
+	g_string_free(_buffer, true);
 	check(otc_output_free(_structure));
 }
 
@@ -1669,17 +2289,51 @@ shared_ptr<OutputFormat> Output::format()
 	return _format;
 }
 
+const GString *Output::format_packet(const struct otc_datafeed_packet *packet)
+{
+	g_string_truncate(_buffer, 0);
+	check(otc_output_send_append(_structure, packet, _buffer));
+	return _buffer;
+}
+
 string Output::receive(shared_ptr<Packet> packet)
 {
-	GString *out;
-	check(otc_output_send(_structure, packet->_structure, &out));
-	if (out) {
-		auto result = string(out->str, out->str + out->len);
-		g_string_free(out, true);
-		return result;
-	} else {
-		return string();
-	}
+	auto text = format_packet(packet->_structure);
+	return string(text->str, text->len);
+}
+
+void Output::receive(shared_ptr<Packet> packet, string &buffer)
+{
+	auto text = format_packet(packet->_structure);
+	buffer.append(text->str, text->len);
+}
+
+void Output::receive(const PacketView &packet, string &buffer)
+{
+	auto text = format_packet(packet._structure);
+	buffer.append(text->str, text->len);
+}
+
+void Output::receive(shared_ptr<Packet> packet, ostream &stream)
+{
+	auto text = format_packet(packet->_structure);
+	stream.write(text->str, text->len);
+}
+
+void Output::receive(const PacketView &packet, ostream &stream)
+{
+	auto text = format_packet(packet._structure);
+	stream.write(text->str, text->len);
+}
+
+void Output::receive(shared_ptr<Packet> packet, int fd)
+{
+	check(otc_output_send_fd(_structure, packet->_structure, fd));
+}
+
+void Output::receive(const PacketView &packet, int fd)
+{
+	check(otc_output_send_fd(_structure, packet._structure, fd));
 }
 
 }
@@ -72,6 +72,7 @@ raised, which provides access to the error code and description.
 
 #include <opentracecapture/libopentracecapture.h>
 #include "libopentracecapturecxx/export.hpp"
+#include "libopentracecapturecxx/views.hpp"
 
 /* Undefine Windows macros that conflict with C++ enum member names */
 #if defined(_WIN32)
@@ -89,8 +90,14 @@ G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 #include <glibmm.h>
 G_GNUC_END_IGNORE_DEPRECATIONS
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <iosfwd>
+#include <mutex>
 #include <stdexcept>
+#include <type_traits>
 #include <memory>
 #include <vector>
 #include <map>
@@ -107,6 +114,9 @@ class OTCCXX_API Device;
 class OTCCXX_API HardwareDevice;
 class OTCCXX_API Channel;
 class OTCCXX_API Session;
+class OTCCXX_API SessionStats;
+class OTCCXX_API DeviceStats;
+class OTCCXX_API StatsHistogram;
 class OTCCXX_API ConfigKey;
 class OTCCXX_API Capability;
 class OTCCXX_API InputFormat;
@@ -120,6 +130,9 @@ class OTCCXX_API TriggerMatch;
 class OTCCXX_API TriggerMatchType;
 class OTCCXX_API ChannelType;
 class OTCCXX_API Packet;
+class OTCCXX_API PacketView;
+class OTCCXX_API PacketBuilder;
+class OTCCXX_API PacketStream;
 class OTCCXX_API PacketPayload;
 class OTCCXX_API PacketType;
 class OTCCXX_API Quantity;
@@ -280,9 +293,18 @@ public:
 	void set_log_callback(LogCallbackFunction callback);
 	/** Set the log callback to the default handler. */
 	void set_log_callback_default();
+	/** Pass log messages on from a background thread. The log callback
+	 * then gets called on that thread.
+	 * @param enable Whether to use the background thread. */
+	void set_log_async(bool enable);
+	/** Number of log messages which the background thread dropped. */
+	uint64_t log_dropped() const;
 	/** Install a delegate for reading resource files.
 	 * @param reader The resource reader delegate, or nullptr to unset. */
 	void set_resource_reader(ResourceReader *reader);
+	/** Handle USB events on a dedicated thread in future acquisitions.
+	 * @param enable Whether to use the event thread. */
+	void set_usb_event_thread(bool enable);
 	/** Create a new session. */
 	std::shared_ptr<Session> create_session();
 	/** Create a new user device. */
@@ -303,6 +325,19 @@ public:
 		const Unit *unit, std::vector<const QuantityFlag *> mqflags);
 	/** Create an end packet. */
 	std::shared_ptr<Packet> create_end_packet();
+	/** Create a builder of logic packets, see PacketBuilder.
+	 * @param unit_size Size of each sample in bytes. */
+	std::shared_ptr<PacketBuilder> create_logic_packet_builder(
+		unsigned int unit_size);
+	/** Create a builder of analog packets with float samples, see
+	 * PacketBuilder.
+	 * @param channels Channels which the packets carry samples of.
+	 * @param mq Measured quantity.
+	 * @param unit Unit of the values.
+	 * @param mqflags Flags of the measured quantity. */
+	std::shared_ptr<PacketBuilder> create_analog_packet_builder(
+		std::vector<std::shared_ptr<Channel> > channels, const Quantity *mq,
+		const Unit *unit, std::vector<const QuantityFlag *> mqflags);
 	/** Load a saved session.
 	 * @param filename File name string. */
 	std::shared_ptr<Session> load_session(std::string filename);
@@ -605,6 +640,10 @@ typedef std::function<void()> SessionStoppedCallback;
 typedef std::function<void(std::shared_ptr<Device>, std::shared_ptr<Packet>)>
 	DatafeedCallbackFunction;
 
+/** Type of datafeed callback which receives packet views */
+typedef std::function<void(const PacketView &)>
+	DatafeedViewCallbackFunction;
+
 /* Data required for C callback function to call a C++ datafeed callback */
 class OTC_PRIV DatafeedCallbackData
 {
@@ -613,9 +652,16 @@ public:
 		const struct otc_datafeed_packet *pkt);
 private:
 	DatafeedCallbackFunction _callback;
+	DatafeedViewCallbackFunction _view_callback;
 	DatafeedCallbackData(Session *session,
 		DatafeedCallbackFunction callback);
+	DatafeedCallbackData(Session *session,
+		DatafeedViewCallbackFunction callback);
 	Session *_session;
+	/* Device of the previous packet, see Session::_devices_version. */
+	const struct otc_dev_inst *_sdi;
+	Device *_device;
+	unsigned int _devices_version;
 	friend class Session;
 };
 
@@ -633,6 +679,111 @@ private:
 	friend struct std::default_delete<SessionDevice>;
 };
 
+/** What a packet stream does with packets when it is full */
+enum class StreamOverflow
+{
+	/** Wait for the consumer, which holds up the acquisition. */
+	BLOCK,
+	/** Discard the new packet. */
+	DROP_NEWEST,
+	/** Discard the oldest queued packet. */
+	DROP_OLDEST,
+};
+
+/** Distribution of durations in nanoseconds, see Session::stats(). */
+class OTCCXX_API StatsHistogram
+{
+public:
+	/** Number of recorded durations. */
+	uint64_t count() const;
+	/** Sum of all recorded durations. */
+	uint64_t sum() const;
+	/** Shortest recorded duration, 0 when none. */
+	uint64_t min() const;
+	/** Longest recorded duration. */
+	uint64_t max() const;
+	/** Get a percentile of the durations.
+	 * @param percentile The percentile, from 0 to 100. */
+	uint64_t percentile(double percentile) const;
+private:
+	explicit StatsHistogram(const struct otc_stats_histogram &structure);
+	struct otc_stats_histogram _structure;
+
+	friend class SessionStats;
+	friend class DeviceStats;
+};
+
+/** Statistics of a device in a session, see Session::stats(). */
+class OTCCXX_API DeviceStats
+{
+public:
+	/** The device. Like Session::devices(), call this on the thread
+	 * which uses the session. */
+	std::shared_ptr<Device> device() const;
+	/** Number of datafeed packets the device sent. */
+	uint64_t packets() const;
+	/** Bytes of sample data in the device's logic and analog packets. */
+	uint64_t bytes() const;
+	/** Packets per second, since the previous snapshot. */
+	double packets_per_sec() const;
+	/** Bytes per second, since the previous snapshot. */
+	double bytes_per_sec() const;
+	/** Number of flushes of the device's feed queues. */
+	uint64_t feed_queue_flushes() const;
+	/** Number of samples which the feed queues flushed. */
+	uint64_t feed_queue_samples() const;
+	/** Number of samples which the soft trigger scanned. */
+	uint64_t trigger_samples() const;
+	/** Time of each soft trigger scan. */
+	StatsHistogram trigger_scan() const;
+	/** Packets queued for the session, with device threads. */
+	uint64_t queued_packets() const;
+	/** Largest number of packets which were queued at a time. */
+	uint64_t max_queued_packets() const;
+	/** Number of times the device lost samples, as the host fell behind. */
+	uint64_t overruns() const;
+	/** Number of times the device's sample buffer had no space left. */
+	uint64_t buffer_full() const;
+	/** Most bytes which waited in the device's sample buffer at a time. */
+	uint64_t max_buffer_fill() const;
+private:
+	DeviceStats(std::shared_ptr<Session> session,
+		const struct otc_stats_device &structure);
+	std::shared_ptr<Session> _session;
+	struct otc_stats_device _structure;
+
+	friend class SessionStats;
+};
+
+/** Snapshot of the statistics of a session, see Session::stats(). */
+class OTCCXX_API SessionStats
+{
+public:
+	/** Time since the statistics started, in microseconds. */
+	uint64_t elapsed_us() const;
+	/** Statistics of each device. */
+	const std::vector<DeviceStats> &devices() const;
+	/** Time of all transforms, per packet. */
+	const StatsHistogram &transform() const;
+	/** Time of all datafeed callbacks, per packet. */
+	const StatsHistogram &callbacks() const;
+	/** Time from the completion of a USB transfer to its resubmission. */
+	const StatsHistogram &usb_resubmit() const;
+	/** Time of each packet in output modules. */
+	const StatsHistogram &output() const;
+private:
+	SessionStats(std::shared_ptr<Session> session,
+		const struct otc_session_stats *structure);
+	uint64_t _elapsed_us;
+	std::vector<DeviceStats> _devices;
+	StatsHistogram _transform;
+	StatsHistogram _callbacks;
+	StatsHistogram _usb_resubmit;
+	StatsHistogram _output;
+
+	friend class Session;
+};
+
 /** A sigrok session */
 class OTCCXX_API Session : public UserOwned<Session>
 {
@@ -651,8 +802,29 @@ public:
 	/** Add a datafeed callback to this session.
 	 * @param callback Callback of the form callback(Device, Packet). */
 	void add_datafeed_callback(DatafeedCallbackFunction callback);
-	/** Remove all datafeed callbacks from this session. */
+	/** Add a datafeed callback which receives packet views.
+	 * Unlike add_datafeed_callback(), this does not allocate per packet.
+	 * @param callback Callback of the form callback(PacketView). */
+	void add_datafeed_view_callback(DatafeedViewCallbackFunction callback);
+	/** Remove all datafeed callbacks from this session.
+	 * This also closes all packet streams. */
 	void remove_datafeed_callbacks();
+	/** Stream the datafeed into a bounded queue, for consumers on other
+	 * threads. The stream gets closed when the session stops. All streams
+	 * share one datafeed callback, dropped or closed streams cost nothing.
+	 * @param depth Maximum number of queued packets.
+	 * @param overflow What to do with packets when the queue is full. */
+	std::shared_ptr<PacketStream> stream(size_t depth = 64,
+		StreamOverflow overflow = StreamOverflow::BLOCK);
+	/** Set whether each device acquires on its own thread.
+	 * @param enable Whether to use device threads. */
+	void set_device_threads(bool enable);
+	/** Set whether the session collects performance statistics.
+	 * @param enable Whether to collect statistics. */
+	void set_stats_enabled(bool enable);
+	/** Take a snapshot of the session's statistics. May be called on
+	 * any thread, throws unless statistics are enabled. */
+	SessionStats stats();
 	/** Start the session. */
 	void start();
 	/** Run the session event loop. */
@@ -677,17 +849,31 @@ private:
 	Session(std::shared_ptr<Context> context, std::string filename);
 	~Session();
 	std::shared_ptr<Device> get_device(const struct otc_dev_inst *sdi);
+	void close_streams();
+	void push_streams(const PacketView &view);
+	static void stopped_callback(void *data) noexcept;
 	struct otc_session *_structure;
 	const std::shared_ptr<Context> _context;
 	std::map<const struct otc_dev_inst *, std::unique_ptr<SessionDevice> > _owned_devices;
 	std::map<const struct otc_dev_inst *, std::shared_ptr<Device> > _other_devices;
 	std::vector<std::unique_ptr<DatafeedCallbackData> > _datafeed_callbacks;
+	/* Changes whenever devices are added or removed. */
+	unsigned int _devices_version;
 	SessionStoppedCallback _stopped_callback;
+	/* Guards the list, the session's thread pushes to the streams. */
+	std::mutex _streams_mutex;
+	std::vector<std::weak_ptr<PacketStream> > _streams;
+	/* Whether push_streams() is among the datafeed callbacks. */
+	bool _streams_callback;
+	/* Pool of the copies which PacketView::retain() makes. */
+	struct otc_packet_pool *_packet_pool;
 	std::string _filename;
 	std::shared_ptr<Trigger> _trigger;
 
 	friend class Context;
 	friend class DatafeedCallbackData;
+	friend class DeviceStats;
+	friend class PacketView;
 	friend class SessionDevice;
 	friend struct std::default_delete<Session>;
 };
@@ -705,12 +891,18 @@ private:
 		const struct otc_datafeed_packet *structure);
 	~Packet();
 	const struct otc_datafeed_packet *_structure;
+	/* Pooled copy which this packet owns, see PacketView::retain(). */
+	struct otc_datafeed_packet *_copy;
+	/* Builder which owns the structure, see PacketBuilder. */
+	std::shared_ptr<struct otc_packet_builder> _builder;
 	std::shared_ptr<Device> _device;
 	std::unique_ptr<PacketPayload> _payload;
 
 	friend class Session;
 	friend class Output;
 	friend class DatafeedCallbackData;
+	friend class PacketView;
+	friend class PacketBuilder;
 	friend class Header;
 	friend class Meta;
 	friend class Logic;
@@ -719,6 +911,154 @@ private:
 	friend struct std::default_delete<Packet>;
 };
 
+/**
+ * Non-owning view of a packet on the session datafeed.
+ *
+ * Views are only valid during the datafeed callback which receives them.
+ * Use retain() for a packet which can be kept beyond that.
+ */
+class OTCCXX_API PacketView
+{
+public:
+	PacketView(const PacketView &) = delete;
+	PacketView &operator=(const PacketView &) = delete;
+	/** Type of this packet. */
+	const PacketType *type() const;
+	/** Device which sent this packet. */
+	Device &device() const;
+	/** Logic sample data, throws unless this is a logic packet. */
+	Span<const uint8_t> logic_data() const;
+	/** Size of each logic sample in bytes. */
+	unsigned int unit_size() const;
+	/** Raw analog sample data, throws unless this is an analog packet.
+	 * Holds num_samples() samples of each of the packet's channels,
+	 * interleaved. */
+	Span<const uint8_t> analog_data() const;
+	/** Number of analog samples per channel. */
+	unsigned int num_samples() const;
+	/** Copy this packet into an owning Packet. */
+	std::shared_ptr<Packet> retain() const;
+private:
+	PacketView(Session *session, const struct otc_dev_inst *sdi,
+		Device &device, const struct otc_datafeed_packet *structure);
+	const struct otc_datafeed_logic *logic() const;
+	const struct otc_datafeed_analog *analog() const;
+
+	Session *_session;
+	const struct otc_dev_inst *_sdi;
+	Device &_device;
+	const struct otc_datafeed_packet *_structure;
+
+	friend class DatafeedCallbackData;
+	friend class Output;
+};
+
+/**
+ * Reusable packet for sample data which the application generates.
+ *
+ * The channels, encoding and meaning are set up once. Each call then
+ * returns the same packet, pointed to the caller's data, which does not
+ * get copied. The packet is only valid until the next call, and as long
+ * as the data is.
+ */
+class OTCCXX_API PacketBuilder : public UserOwned<PacketBuilder>
+{
+public:
+	/** Logic packet of the caller's samples.
+	 * @param data_pointer Sample data.
+	 * @param data_length Length of the data in bytes. */
+	std::shared_ptr<Packet> logic(const void *data_pointer,
+		size_t data_length);
+	/** Analog packet of the caller's samples.
+	 * @param data_pointer Sample values, interleaved for multiple
+	 *        channels.
+	 * @param num_samples Number of samples. */
+	std::shared_ptr<Packet> analog(const float *data_pointer,
+		unsigned int num_samples);
+private:
+	PacketBuilder(struct otc_packet_builder *structure,
+		std::vector<std::shared_ptr<Channel> > channels);
+	~PacketBuilder();
+	std::shared_ptr<Packet> share(const struct otc_datafeed_packet *structure);
+
+	std::shared_ptr<struct otc_packet_builder> _structure;
+	const std::vector<std::shared_ptr<Channel> > _channels;
+	std::shared_ptr<Packet> _packet;
+
+	friend class Context;
+	friend struct std::default_delete<PacketBuilder>;
+};
+
+/**
+ * Bounded queue of retained packets, see Session::stream().
+ *
+ * The session's thread pushes packets, any other thread can pop them.
+ */
+class OTCCXX_API PacketStream : public UserOwned<PacketStream>
+{
+public:
+	PacketStream(const PacketStream &) = delete;
+	PacketStream &operator=(const PacketStream &) = delete;
+	/** Wait for the next packet.
+	 * @return The packet, or nullptr when the stream was closed and is
+	 *         empty. */
+	std::shared_ptr<Packet> pop();
+	/** Wait for the next packet, for a limited time.
+	 * @return The packet, or nullptr on timeout, or when the stream was
+	 *         closed and is empty. */
+	std::shared_ptr<Packet> pop_for(std::chrono::milliseconds timeout);
+	/** Get the next packet if there is one, don't wait.
+	 * @return The packet, or nullptr. */
+	std::shared_ptr<Packet> try_pop();
+	/** Stop queueing packets. Queued packets can still be popped, a
+	 * session thread which waits for space continues. */
+	void close();
+	/** Whether the stream was closed. */
+	bool is_closed() const;
+	/** Number of queued packets. */
+	size_t size() const;
+	/** Maximum number of queued packets. */
+	size_t capacity() const;
+	/** Number of packets which were queued. */
+	uint64_t pushed() const;
+	/** Number of packets which were discarded since the queue was full. */
+	uint64_t dropped() const;
+	/** Number of times a packet found the queue full. */
+	uint64_t overflows() const;
+	/** Highest number of queued packets so far. */
+	size_t max_size() const;
+	/**
+	 * Arrange for a callback when a packet can be popped, or the stream
+	 * gets closed. The callback runs on the thread which pushes or
+	 * closes, at most once. Only one callback can wait at a time.
+	 * @return False when a packet is available already, or the stream
+	 *         is closed. The callback is not kept then.
+	 */
+	bool notify_when_ready(std::function<void()> callback);
+private:
+	PacketStream(size_t depth, StreamOverflow overflow);
+	~PacketStream();
+	void push(std::shared_ptr<Packet> packet);
+	std::shared_ptr<Packet> take();
+
+	mutable std::mutex _mutex;
+	std::condition_variable _readable;
+	std::condition_variable _writable;
+	std::vector<std::shared_ptr<Packet> > _slots;
+	size_t _head;
+	size_t _count;
+	StreamOverflow _overflow;
+	bool _closed;
+	std::function<void()> _ready_callback;
+	uint64_t _pushed;
+	uint64_t _dropped;
+	uint64_t _overflows;
+	size_t _max_size;
+
+	friend class Session;
+	friend struct std::default_delete<PacketStream>;
+};
+
 /** Abstract base class for datafeed packet payloads */
 class OTCCXX_API PacketPayload
 {
@@ -784,6 +1124,27 @@ public:
 	size_t data_length() const;
 	/* Size of each sample in bytes. */
 	unsigned int unit_size() const;
+	/** Samples of a single channel.
+	 * @param channel Index of the channel within the samples. */
+	ChannelView channel_view(unsigned int channel) const
+	{
+		return ChannelView(_structure->data, _structure->length,
+			_structure->unitsize, channel);
+	}
+	/** Samples as unsigned integers, sizeof(T) must match unit_size().
+	 * Throws when the size or the data's alignment does not fit T. */
+	template <typename T>
+	Span<const T> samples() const
+	{
+		static_assert(std::is_integral<T>::value &&
+			std::is_unsigned<T>::value,
+			"Logic samples are unsigned integers");
+		if (_structure->unitsize != sizeof(T) ||
+				reinterpret_cast<uintptr_t>(_structure->data) % alignof(T))
+			throw Error(OTC_ERR_ARG);
+		return Span<const T>(static_cast<const T *>(_structure->data),
+			_structure->length / sizeof(T));
+	}
 private:
 	explicit Logic(const struct otc_datafeed_logic *structure);
 	~Logic();
@@ -880,6 +1241,36 @@ public:
 	 */
 	std::shared_ptr<Logic> get_logic_via_schmitt_trigger(float lo_thr,
 		float hi_thr, uint8_t *state, uint8_t *data_ptr=nullptr) const;
+	/**
+	 * Samples in their native encoding, without conversion to float.
+	 * Throws when T does not match the encoding, or the data's alignment
+	 * does not fit T. Scale and offset get applied on access. Covers the
+	 * samples of all the packet's channels, interleaved.
+	 */
+	template <typename T>
+	AnalogView<T> view() const
+	{
+		static_assert(std::is_arithmetic<T>::value,
+			"Analog samples are numbers");
+		const struct otc_analog_encoding *encoding = _structure->encoding;
+		const uint16_t probe = 1;
+		const bool host_bigendian =
+			*reinterpret_cast<const uint8_t *>(&probe) == 0;
+		if (encoding->unitsize != sizeof(T) ||
+				!encoding->is_float != !std::is_floating_point<T>::value ||
+				(!std::is_floating_point<T>::value &&
+				 !encoding->is_signed != !std::is_signed<T>::value) ||
+				(sizeof(T) > 1 &&
+				 !encoding->is_bigendian != !host_bigendian) ||
+				reinterpret_cast<uintptr_t>(_structure->data) % alignof(T))
+			throw Error(OTC_ERR_NA);
+		const size_t num_channels = std::max(
+			g_slist_length(_structure->meaning->channels), 1u);
+		return AnalogView<T>(static_cast<const T *>(_structure->data),
+			size_t{_structure->num_samples} * num_channels,
+			float(encoding->scale.p) / float(encoding->scale.q),
+			float(encoding->offset.p) / float(encoding->offset.q));
+	}
 private:
 	explicit Analog(const struct otc_datafeed_analog *structure);
 	~Analog();
@@ -1059,6 +1450,37 @@ public:
 	/** Update output with data from the given packet.
 	 * @param packet Packet to handle. */
 	std::string receive(std::shared_ptr<Packet> packet);
+	/** Update output with data from the given packet, and append the
+	 * output to a buffer. Reusing the buffer for the packets of a stream
+	 * saves an allocation per packet.
+	 * @param packet Packet to handle.
+	 * @param buffer String to append to. */
+	void receive(std::shared_ptr<Packet> packet, std::string &buffer);
+	/** Update output with data from the given packet, and append the
+	 * output to a buffer.
+	 * @param packet Packet to handle.
+	 * @param buffer String to append to. */
+	void receive(const PacketView &packet, std::string &buffer);
+	/** Update output with data from the given packet, and write the
+	 * output to a stream, e.g. a std::ofstream.
+	 * @param packet Packet to handle.
+	 * @param stream Stream to write to. */
+	void receive(std::shared_ptr<Packet> packet, std::ostream &stream);
+	/** Update output with data from the given packet, and write the
+	 * output to a stream.
+	 * @param packet Packet to handle.
+	 * @param stream Stream to write to. */
+	void receive(const PacketView &packet, std::ostream &stream);
+	/** Update output with data from the given packet, and write the
+	 * output to a file descriptor.
+	 * @param packet Packet to handle.
+	 * @param fd File descriptor to write to. */
+	void receive(std::shared_ptr<Packet> packet, int fd);
+	/** Update output with data from the given packet, and write the
+	 * output to a file descriptor.
+	 * @param packet Packet to handle.
+	 * @param fd File descriptor to write to. */
+	void receive(const PacketView &packet, int fd);
 	/** Output format in use for this output */
 	std::shared_ptr<OutputFormat> format();
 private:
@@ -1068,11 +1490,14 @@ private:
 	Output(std::string filename, std::shared_ptr<OutputFormat> format,
 		std::shared_ptr<Device> device, std::map<std::string, Glib::VariantBase> options);
 	~Output();
+	const GString *format_packet(const struct otc_datafeed_packet *packet);
 
 	const struct otc_output *_structure;
 	const std::shared_ptr<OutputFormat> _format;
 	const std::shared_ptr<Device> _device;
 	const std::map<std::string, Glib::VariantBase> _options;
+	/* Text of the last packet, reused for all packets. */
+	GString *_buffer;
 
 	friend class OutputFormat;
 	friend struct std::default_delete<Output>;
@@ -1127,4 +1552,42 @@ private:
 
 }
 
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+
+namespace opentrace
+{
+
+/**
+ * Awaitable which yields the next packet of a stream, or nullptr when
+ * the stream was closed. The coroutine resumes on the session's thread,
+ * only one coroutine can await a stream at a time.
+ */
+class PacketAwaiter
+{
+public:
+	explicit PacketAwaiter(std::shared_ptr<PacketStream> stream) :
+		_stream(std::move(stream)) {}
+	bool await_ready() const { return _stream->size() || _stream->is_closed(); }
+	bool await_suspend(std::coroutine_handle<> handle)
+	{
+		return _stream->notify_when_ready([handle]() { handle.resume(); });
+	}
+	std::shared_ptr<Packet> await_resume() { return _stream->try_pop(); }
+private:
+	std::shared_ptr<PacketStream> _stream;
+};
+
+/** co_await next_packet(stream) for the stream's next packet. */
+inline PacketAwaiter next_packet(std::shared_ptr<PacketStream> stream)
+{
+	return PacketAwaiter(std::move(stream));
+}
+
+}
+
+#endif
+#endif
+
 #endif
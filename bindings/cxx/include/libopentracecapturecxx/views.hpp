@@ -0,0 +1,303 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Zero-copy views of datafeed sample data. They point into packets and
+ * are only valid as long as the packet is.
+ *
+ * Logic samples are little-endian, channel n is bit (n % 8) of byte
+ * (n / 8) of each sample. The loops are instantiated per unit size, so
+ * that the compiler sees a constant stride and can vectorize them.
+ */
+
+#ifndef LIBOPENTRACECAPTURECXX_VIEWS_HPP
+#define LIBOPENTRACECAPTURECXX_VIEWS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace opentrace
+{
+
+/** Contiguous range of objects which is owned elsewhere */
+template <typename T>
+class Span
+{
+public:
+	Span() : _data(nullptr), _size(0) {}
+	Span(T *data, size_t size) : _data(data), _size(size) {}
+	/** Pointer to the first element. */
+	T *data() const { return _data; }
+	/** Number of elements. */
+	size_t size() const { return _size; }
+	/** Whether the range has no elements. */
+	bool empty() const { return _size == 0; }
+	T *begin() const { return _data; }
+	T *end() const { return _data + _size; }
+	T &operator[](size_t index) const { return _data[index]; }
+private:
+	T *_data;
+	size_t _size;
+};
+
+namespace views
+{
+
+static inline unsigned int popcount64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(value);
+#else
+	value = value - ((value >> 1) & 0x5555555555555555ull);
+	value = (value & 0x3333333333333333ull) +
+		((value >> 2) & 0x3333333333333333ull);
+	value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return (value * 0x0101010101010101ull) >> 56;
+#endif
+}
+
+/* Load 8 bytes in memory order, independent of the alignment. */
+static inline uint64_t load64(const uint8_t *p)
+{
+	uint64_t value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+} /* namespace views */
+
+/**
+ * Samples of a single logic channel, as a range of bools.
+ */
+class ChannelView
+{
+public:
+	class iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef bool value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const bool *pointer;
+		typedef bool reference;
+
+		iterator(const ChannelView *view, size_t index) :
+			_view(view), _index(index) {}
+		bool operator*() const { return (*_view)[_index]; }
+		iterator &operator++() { _index++; return *this; }
+		iterator operator++(int) { iterator prev = *this; _index++; return prev; }
+		bool operator==(const iterator &other) const { return _index == other._index; }
+		bool operator!=(const iterator &other) const { return _index != other._index; }
+		/** Sample index this iterator points to. */
+		size_t index() const { return _index; }
+	private:
+		const ChannelView *_view;
+		size_t _index;
+	};
+
+	/**
+	 * @param data Logic sample data.
+	 * @param length Data length in bytes.
+	 * @param unit_size Size of each sample in bytes.
+	 * @param channel Index of the channel within the samples.
+	 */
+	ChannelView(const void *data, size_t length, unsigned int unit_size,
+			unsigned int channel) :
+		_data(static_cast<const uint8_t *>(data)),
+		_size(unit_size ? length / unit_size : 0),
+		_stride(unit_size),
+		_byte(channel / 8),
+		_bit(channel % 8)
+	{
+		if (_byte >= unit_size)
+			_size = 0;
+	}
+
+	/** Number of samples. */
+	size_t size() const { return _size; }
+	/** State of the channel at a sample. */
+	bool operator[](size_t index) const
+	{
+		return (_data[index * _stride + _byte] >> _bit) & 1;
+	}
+	iterator begin() const { return iterator(this, 0); }
+	iterator end() const { return iterator(this, _size); }
+
+	/** Number of samples in which the channel is high. */
+	size_t count() const
+	{
+		switch (_stride) {
+		case 1: return count_impl<1>();
+		case 2: return count_impl<2>();
+		case 4: return count_impl<4>();
+		case 8: return count_impl<8>();
+		default: return count_impl<0>();
+		}
+	}
+
+	/**
+	 * Find the next change of the channel's state.
+	 *
+	 * @param from Sample index to start at.
+	 *
+	 * @return The smallest index greater than from, whose sample differs
+	 *         from its predecessor, or size() when there is none.
+	 */
+	size_t find_next_edge(size_t from) const
+	{
+		switch (_stride) {
+		case 1: return find_next_edge_impl<1>(from);
+		case 2: return find_next_edge_impl<2>(from);
+		case 4: return find_next_edge_impl<4>(from);
+		case 8: return find_next_edge_impl<8>(from);
+		default: return find_next_edge_impl<0>(from);
+		}
+	}
+
+private:
+	/*
+	 * Unit sizes which divide 8 process 8 / Stride samples per 64 bit
+	 * word, with a mask which selects the channel's bit of each sample.
+	 * Stride 0 is for unit sizes which are only known at runtime.
+	 */
+	template <unsigned int Stride>
+	uint64_t word_mask() const
+	{
+		uint8_t bytes[8];
+		for (unsigned int i = 0; i < 8; i++)
+			bytes[i] = (Stride && i % Stride == _byte) ? 1 << _bit : 0;
+		return views::load64(bytes);
+	}
+
+	template <unsigned int Stride>
+	size_t count_impl() const
+	{
+		const size_t stride = Stride ? Stride : _stride;
+		size_t total = 0, i = 0;
+
+		/* Wider samples count faster in the vectorized loop below. */
+		if (Stride == 1) {
+			const uint64_t mask = word_mask<1>();
+			for (; i + 8 <= _size; i += 8)
+				total += views::popcount64(
+					views::load64(&_data[i]) & mask);
+		}
+		for (; i < _size; i++)
+			total += (_data[i * stride + _byte] >> _bit) & 1;
+
+		return total;
+	}
+
+	template <unsigned int Stride>
+	size_t find_next_edge_impl(size_t from) const
+	{
+		const size_t stride = Stride ? Stride : _stride;
+		size_t i;
+
+		if (from >= _size)
+			return _size;
+
+		const uint8_t state = _data[from * stride + _byte] & (1 << _bit);
+		i = from + 1;
+
+		/* Skip words in which all samples equal the current state. */
+		if (Stride && Stride < 8) {
+			const uint64_t mask = word_mask<Stride>();
+			const uint64_t expect = state ? mask : 0;
+			for (; i + 8 / Stride <= _size; i += 8 / Stride) {
+				if ((views::load64(&_data[i * Stride]) & mask) != expect)
+					break;
+			}
+		}
+		for (; i < _size; i++) {
+			if ((_data[i * stride + _byte] & (1 << _bit)) != state)
+				return i;
+		}
+
+		return _size;
+	}
+
+	const uint8_t *_data;
+	size_t _size;
+	size_t _stride;
+	unsigned int _byte;
+	unsigned int _bit;
+};
+
+/**
+ * Analog samples in their native encoding, with the packet's scale and
+ * offset applied on access.
+ */
+template <typename T>
+class AnalogView
+{
+public:
+	class iterator
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef float value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const float *pointer;
+		typedef float reference;
+
+		iterator(const AnalogView *view, size_t index) :
+			_view(view), _index(index) {}
+		float operator*() const { return (*_view)[_index]; }
+		iterator &operator++() { _index++; return *this; }
+		iterator operator++(int) { iterator prev = *this; _index++; return prev; }
+		bool operator==(const iterator &other) const { return _index == other._index; }
+		bool operator!=(const iterator &other) const { return _index != other._index; }
+	private:
+		const AnalogView *_view;
+		size_t _index;
+	};
+
+	AnalogView(const T *data, size_t size, float scale, float offset) :
+		_raw(data, size), _scale(scale), _offset(offset) {}
+
+	/** Number of samples. */
+	size_t size() const { return _raw.size(); }
+	/** Sample values as they were sent, without scale and offset. */
+	Span<const T> raw() const { return _raw; }
+	/** Factor which gets applied to raw values. */
+	float scale() const { return _scale; }
+	/** Offset which gets added to scaled values. */
+	float offset() const { return _offset; }
+	/** Whether raw values need no conversion. */
+	bool is_identity() const { return _scale == 1.0f && _offset == 0.0f; }
+	/** Value of a sample, with scale and offset applied. */
+	float operator[](size_t index) const
+	{
+		return static_cast<float>(_raw[index]) * _scale + _offset;
+	}
+	iterator begin() const { return iterator(this, 0); }
+	iterator end() const { return iterator(this, size()); }
+
+private:
+	Span<const T> _raw;
+	float _scale;
+	float _offset;
+};
+
+}
+
+#endif
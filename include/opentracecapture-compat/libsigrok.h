@@ -1269,6 +1269,41 @@ enum otc_configkey {
 	 */
 	OTC_CONF_GATE_TIME,
 
+	/**
+	 * Flood mode. Generate data as fast as the session consumes it,
+	 * instead of pacing it at the samplerate.
+	 * @arg type: uint64_t
+	 * @arg get: get the current flood mode
+	 * @arg set: 0 paces the data, 1 generates unpaced data in the
+	 *      session thread, larger values set the number of worker
+	 *      threads which generate unpaced data
+	 */
+	OTC_CONF_FLOOD,
+
+	/**
+	 * The size of the USB transfers which the driver currently uses.
+	 * @arg type: uint64_t
+	 * @arg get: get the transfer size in bytes
+	 */
+	OTC_CONF_TRANSFER_SIZE,
+
+	/**
+	 * The number of USB transfers which the driver currently keeps
+	 * in flight.
+	 * @arg type: uint64_t
+	 * @arg get: get the number of transfers
+	 */
+	OTC_CONF_TRANSFER_COUNT,
+
+	/**
+	 * The number of times the host did not keep up with the device's
+	 * data stream during the last acquisition, and data may have been
+	 * lost.
+	 * @arg type: uint64_t
+	 * @arg get: get the number of overflows
+	 */
+	OTC_CONF_OVERFLOW_COUNT,
+
 	/* Update otc_key_info_config[] (hwdriver.c) upon changes! */
 };
 
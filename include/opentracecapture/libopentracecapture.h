@@ -638,6 +638,91 @@ struct otc_resource {
 	int type;
 };
 
+/** Number of buckets of a struct otc_stats_histogram. */
+#define OTC_STATS_HISTOGRAM_BUCKETS 272
+
+/**
+ * Distribution of durations, in nanoseconds.
+ *
+ * Buckets are log-linear: each power of two is split into 8 buckets of
+ * equal width, so that a bucket is at most 12.5% wide, relative to its
+ * values. Durations of 2^36 ns (about 69 s) and more all count into the
+ * last bucket.
+ * Use otc_stats_histogram_percentile() to read them.
+ *
+ * @since 0.6.0
+ */
+struct otc_stats_histogram {
+	/** Number of recorded durations. */
+	uint64_t count;
+	/** Sum of all recorded durations. */
+	uint64_t sum;
+	/** Shortest recorded duration, 0 when none. */
+	uint64_t min;
+	/** Longest recorded duration. */
+	uint64_t max;
+	/** Number of durations per bucket. */
+	uint64_t buckets[OTC_STATS_HISTOGRAM_BUCKETS];
+};
+
+/**
+ * Statistics of a device in a session.
+ *
+ * @since 0.6.0
+ */
+struct otc_stats_device {
+	/** The device. */
+	const struct otc_dev_inst *sdi;
+	/** Number of datafeed packets the device sent. */
+	uint64_t packets;
+	/** Bytes of sample data in the device's logic and analog packets. */
+	uint64_t bytes;
+	/** Packets per second, since the previous snapshot. */
+	double packets_per_sec;
+	/** Bytes per second, since the previous snapshot. */
+	double bytes_per_sec;
+	/** Number of flushes of the device's feed queues. */
+	uint64_t feed_queue_flushes;
+	/** Number of samples which the feed queues flushed. */
+	uint64_t feed_queue_samples;
+	/** Number of samples which the soft trigger scanned. */
+	uint64_t trigger_samples;
+	/** Time of each soft trigger scan. */
+	struct otc_stats_histogram trigger_scan;
+	/** Packets queued for the session, with device threads. */
+	uint64_t queued_packets;
+	/** Largest number of packets which were queued at a time. */
+	uint64_t max_queued_packets;
+	/** Number of times the device lost samples, as the host fell behind. */
+	uint64_t overruns;
+	/** Number of times the device's sample buffer had no space left. */
+	uint64_t buffer_full;
+	/** Most bytes which waited in the device's sample buffer at a time. */
+	uint64_t max_buffer_fill;
+};
+
+/**
+ * Snapshot of the statistics of a session.
+ *
+ * @since 0.6.0
+ */
+struct otc_session_stats {
+	/** Time since the statistics started, in microseconds. */
+	uint64_t elapsed_us;
+	/** Number of entries in @ref devices. */
+	unsigned int num_devices;
+	/** Statistics of each device. */
+	struct otc_stats_device *devices;
+	/** Time of all transforms, per packet. */
+	struct otc_stats_histogram transform;
+	/** Time of all datafeed callbacks, per packet. */
+	struct otc_stats_histogram callbacks;
+	/** Time from the completion of a USB transfer to its resubmission. */
+	struct otc_stats_histogram usb_resubmit;
+	/** Time of each packet in output modules. */
+	struct otc_stats_histogram output;
+};
+
 /** Output module flags. */
 enum otc_output_flag {
 	/** If set, this output module writes the output itself. */
@@ -648,6 +733,8 @@ struct otc_input;
 struct otc_input_module;
 struct otc_output;
 struct otc_output_module;
+struct otc_packet_builder;
+struct otc_packet_pool;
 struct otc_transform;
 struct otc_transform_module;
 
@@ -1291,6 +1378,41 @@ enum otc_configkey {
 	 */
 	OTC_CONF_GATE_TIME,
 
+	/**
+	 * Flood mode. Generate data as fast as the session consumes it,
+	 * instead of pacing it at the samplerate.
+	 * @arg type: uint64_t
+	 * @arg get: get the current flood mode
+	 * @arg set: 0 paces the data, 1 generates unpaced data in the
+	 *      session thread, larger values set the number of worker
+	 *      threads which generate unpaced data
+	 */
+	OTC_CONF_FLOOD,
+
+	/**
+	 * The size of the USB transfers which the driver currently uses.
+	 * @arg type: uint64_t
+	 * @arg get: get the transfer size in bytes
+	 */
+	OTC_CONF_TRANSFER_SIZE,
+
+	/**
+	 * The number of USB transfers which the driver currently keeps
+	 * in flight.
+	 * @arg type: uint64_t
+	 * @arg get: get the number of transfers
+	 */
+	OTC_CONF_TRANSFER_COUNT,
+
+	/**
+	 * The number of times the host did not keep up with the device's
+	 * data stream during the last acquisition, and data may have been
+	 * lost.
+	 * @arg type: uint64_t
+	 * @arg get: get the number of overflows
+	 */
+	OTC_CONF_OVERFLOW_COUNT,
+
 	/* Update otc_key_info_config[] (hwdriver.c) upon changes! */
 };
 
@@ -68,6 +68,8 @@ OTC_API int otc_log_loglevel_get(void);
 OTC_API int otc_log_callback_set(otc_log_callback cb, void *cb_data);
 OTC_API int otc_log_callback_set_default(void);
 OTC_API int otc_log_callback_get(otc_log_callback *cb, void **cb_data);
+OTC_API int otc_log_async_set(gboolean enable);
+OTC_API uint64_t otc_log_dropped_get(void);
 
 /*--- device.c --------------------------------------------------------------*/
 
@@ -105,6 +107,9 @@ OTC_API int otc_driver_init(struct otc_context *ctx,
 		struct otc_dev_driver *driver);
 OTC_API GArray *otc_driver_scan_options_list(const struct otc_dev_driver *driver);
 OTC_API GSList *otc_driver_scan(struct otc_dev_driver *driver, GSList *options);
+OTC_API int otc_driver_scan_timeout_set(struct otc_context *ctx,
+		uint64_t timeout_ms);
+OTC_API uint64_t otc_driver_scan_timeout_get(const struct otc_context *ctx);
 OTC_API int otc_config_get(const struct otc_dev_driver *driver,
 		const struct otc_dev_inst *sdi,
 		const struct otc_channel_group *cg,
@@ -153,11 +158,48 @@ OTC_API int otc_session_stop(struct otc_session *session);
 OTC_API int otc_session_is_running(struct otc_session *session);
 OTC_API int otc_session_stopped_callback_set(struct otc_session *session,
 		otc_session_stopped_callback cb, void *cb_data);
+OTC_API int otc_session_device_threads_set(struct otc_session *session,
+		gboolean enable);
 
 OTC_API int otc_packet_copy(const struct otc_datafeed_packet *packet,
 		struct otc_datafeed_packet **copy);
 OTC_API void otc_packet_free(struct otc_datafeed_packet *packet);
 
+/*--- session_stats.c -------------------------------------------------------*/
+
+OTC_API int otc_session_stats_set(struct otc_session *session,
+		gboolean enable);
+OTC_API int otc_session_stats_get(struct otc_session *session,
+		struct otc_session_stats **stats);
+OTC_API void otc_session_stats_free(struct otc_session_stats *stats);
+OTC_API uint64_t otc_stats_histogram_percentile(
+		const struct otc_stats_histogram *hist, double percentile);
+
+/*--- packet_builder.c ------------------------------------------------------*/
+
+OTC_API struct otc_packet_builder *otc_packet_builder_logic_new(
+		unsigned int unitsize);
+OTC_API struct otc_packet_builder *otc_packet_builder_analog_new(
+		GSList *channels, enum otc_mq mq, enum otc_unit unit,
+		enum otc_mqflag mqflags,
+		const struct otc_analog_encoding *encoding);
+OTC_API void otc_packet_builder_free(struct otc_packet_builder *builder);
+OTC_API const struct otc_datafeed_packet *otc_packet_builder_logic(
+		struct otc_packet_builder *builder, const void *data,
+		uint64_t length);
+OTC_API const struct otc_datafeed_packet *otc_packet_builder_analog(
+		struct otc_packet_builder *builder, const void *data,
+		uint32_t num_samples);
+
+/*--- packet_pool.c ---------------------------------------------------------*/
+
+OTC_API struct otc_packet_pool *otc_packet_pool_new(size_t max_cached);
+OTC_API void otc_packet_pool_free(struct otc_packet_pool *pool);
+OTC_API int otc_packet_pool_copy(struct otc_packet_pool *pool,
+		const struct otc_datafeed_packet *packet,
+		struct otc_datafeed_packet **copy);
+OTC_API void otc_packet_pool_release(struct otc_datafeed_packet *packet);
+
 /*--- input/input.c ---------------------------------------------------------*/
 
 OTC_API const struct otc_input_module **otc_input_list(void);
@@ -198,6 +240,10 @@ OTC_API gboolean otc_output_test_flag(const struct otc_output_module *omod,
 		uint64_t flag);
 OTC_API int otc_output_send(const struct otc_output *o,
 		const struct otc_datafeed_packet *packet, GString **out);
+OTC_API int otc_output_send_append(const struct otc_output *o,
+		const struct otc_datafeed_packet *packet, GString *out);
+OTC_API int otc_output_send_fd(const struct otc_output *o,
+		const struct otc_datafeed_packet *packet, int fd);
 OTC_API int otc_output_free(const struct otc_output *o);
 
 /*--- transform/transform.c -------------------------------------------------*/
@@ -226,6 +272,10 @@ OTC_API int otc_trigger_match_add(struct otc_trigger_stage *stage,
 OTC_API GSList *otc_serial_list(const struct otc_dev_driver *driver);
 OTC_API void otc_serial_free(struct otc_serial_port *serial);
 
+/*--- usb.c -----------------------------------------------------------------*/
+
+OTC_API int otc_usb_event_thread_set(struct otc_context *ctx, gboolean enable);
+
 /*--- resource.c ------------------------------------------------------------*/
 
 typedef int (*otc_resource_open_callback)(struct otc_resource *res,
@@ -673,6 +673,7 @@ OTC_API int otc_exit(struct otc_context *ctx)
 	hid_exit();
 #endif
 #ifdef HAVE_LIBUSB_1_0
+	otc_usb_events_free(ctx);
 	libusb_exit(ctx->libusb_ctx);
 #endif
 
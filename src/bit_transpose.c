@@ -0,0 +1,362 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * Channel-major to sample-major bit matrix transposition
+ *
+ * Several logic analyzers send a "batch" of sample data as one word per
+ * enabled channel, each word holding 8, 16 or 32 consecutive samples of
+ * that channel. Session feeds expect sample-major data, where each
+ * sample is a unit of bits, one bit per channel. The helpers here keep
+ * the state of partially received batches across USB transfers, and
+ * convert complete batches with a bit matrix transpose.
+ *
+ * The transpose handles up to 32 channel words per batch. Bytes of
+ * several channels' words get gathered into a vector register, and
+ * movemask instructions pick one bit position of all of them at once
+ * (32 channels per step with AVX2, 16 with SSE2). Without SIMD support
+ * a portable 8x8 bit matrix transpose on 64bit integers is used.
+ * Arbitrary channel subsets get mapped to their logic bits by means of
+ * lookup tables. Those are skipped when the words map to adjacent logic
+ * bits in ascending order, which only takes a shift.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "libopentracecapture-internal.h"
+
+#define LOG_PREFIX "bit_transpose"
+
+#define XPOSE_MAX_CHANNELS	32
+#define XPOSE_MAX_WORD_BYTES	4
+
+struct otc_bit_transpose {
+	size_t word_bytes;
+	size_t word_bits;
+	gboolean msb_first;
+	size_t unitsize;
+	size_t channel_count;
+	size_t channel_index;
+	gboolean contiguous;
+	size_t shift;
+	uint8_t words[XPOSE_MAX_CHANNELS * XPOSE_MAX_WORD_BYTES];
+	uint32_t lut[XPOSE_MAX_CHANNELS / 8][256];
+};
+
+/**
+ * Allocate a bit matrix transposer.
+ *
+ * @param[in] word_bits The number of samples in a channel word: 8, 16,
+ *   or 32. Words are stored in little endian byte order.
+ * @param[in] msb_first Whether the word's most significant bit holds
+ *   the first sample (otherwise the least significant bit does).
+ * @param[in] unitsize The number of bytes per output sample (1 to 4).
+ * @param[in] channel_masks The logic bits for each of the batch's words,
+ *   in the order the device sends them.
+ * @param[in] channel_count The number of words per batch (1 to 32).
+ *
+ * @return The transposer, or #NULL upon invalid arguments.
+ */
+OTC_PRIV struct otc_bit_transpose *otc_bit_transpose_new(size_t word_bits,
+	gboolean msb_first, size_t unitsize,
+	const uint32_t *channel_masks, size_t channel_count)
+{
+	struct otc_bit_transpose *xp;
+	size_t ch, group, idx, lowest;
+	uint32_t first_mask;
+
+	if (word_bits != 8 && word_bits != 16 && word_bits != 32)
+		return NULL;
+	if (!unitsize || unitsize > sizeof(uint32_t))
+		return NULL;
+	if (!channel_masks || !channel_count)
+		return NULL;
+	if (channel_count > XPOSE_MAX_CHANNELS)
+		return NULL;
+
+	xp = g_malloc0(sizeof(*xp));
+	xp->word_bits = word_bits;
+	xp->word_bytes = word_bits / 8;
+	xp->msb_first = msb_first;
+	xp->unitsize = unitsize;
+	xp->channel_count = channel_count;
+
+	/*
+	 * Words which map to adjacent logic bits in ascending order only
+	 * need a shift. That includes all channel subsets which start at
+	 * any channel and have no gaps.
+	 */
+	first_mask = channel_masks[0];
+	xp->contiguous = first_mask && !(first_mask & (first_mask - 1));
+	while (xp->contiguous && !(first_mask & (1UL << xp->shift)))
+		xp->shift++;
+	if (xp->shift + channel_count > 32)
+		xp->contiguous = FALSE;
+	for (ch = 0; xp->contiguous && ch < channel_count; ch++) {
+		if (channel_masks[ch] != (uint32_t)(1UL << (xp->shift + ch)))
+			xp->contiguous = FALSE;
+	}
+
+	/* Entries combine the entry without the lowest bit, and that bit's mask. */
+	for (group = 0; group < ARRAY_SIZE(xp->lut); group++) {
+		for (idx = 1; idx < ARRAY_SIZE(xp->lut[0]); idx++) {
+			lowest = 0;
+			while (!(idx & (1UL << lowest)))
+				lowest++;
+			ch = group * 8 + lowest;
+			xp->lut[group][idx] = xp->lut[group][idx & (idx - 1)];
+			if (ch < channel_count)
+				xp->lut[group][idx] |= channel_masks[ch];
+		}
+	}
+
+	return xp;
+}
+
+/**
+ * Release a bit matrix transposer.
+ *
+ * @param[in] xp The transposer to release. Can be #NULL.
+ */
+OTC_PRIV void otc_bit_transpose_free(struct otc_bit_transpose *xp)
+{
+	g_free(xp);
+}
+
+/**
+ * Discard a partially received batch.
+ *
+ * @param[in] xp The transposer to reset.
+ */
+OTC_PRIV void otc_bit_transpose_reset(struct otc_bit_transpose *xp)
+{
+	if (!xp)
+		return;
+
+	xp->channel_index = 0;
+	memset(xp->words, 0, sizeof(xp->words));
+}
+
+/**
+ * Get the number of samples which one complete batch yields.
+ *
+ * @param[in] xp The transposer.
+ *
+ * @return The number of samples per batch, or 0 upon invalid arguments.
+ */
+OTC_PRIV size_t otc_bit_transpose_batch_samples(const struct otc_bit_transpose *xp)
+{
+	return xp ? xp->word_bits : 0;
+}
+
+/* Map a bit position within a channel word to the batch's sample index. */
+static inline size_t xpose_sample_index(const struct otc_bit_transpose *xp,
+	size_t bit_pos)
+{
+	return xp->msb_first ? xp->word_bits - 1 - bit_pos : bit_pos;
+}
+
+#if !defined(__AVX2__) && !defined(__SSE2__)
+/*
+ * Transpose an 8x8 bit matrix held in a 64bit integer, byte N is row N.
+ * See "Hacker's Delight", section 7-3.
+ */
+static inline uint64_t xpose_8x8(uint64_t x)
+{
+	uint64_t t;
+
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x = x ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x = x ^ t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x = x ^ t ^ (t << 28);
+
+	return x;
+}
+#endif
+
+/*
+ * Transpose one complete batch of channel words into per-sample
+ * "compact" values, where bit N corresponds to the batch's word N.
+ */
+static void xpose_batch(const struct otc_bit_transpose *xp,
+	const uint8_t *words, uint32_t *compact)
+{
+	size_t lane, first, ch, bit;
+	uint8_t gather[XPOSE_MAX_CHANNELS];
+	uint32_t bits;
+#if defined(__AVX2__)
+	__m256i v;
+	const size_t group_size = 32;
+#elif defined(__SSE2__)
+	__m128i v;
+	const size_t group_size = 16;
+#else
+	uint64_t v;
+	const size_t group_size = 8;
+#endif
+
+	memset(compact, 0, xp->word_bits * sizeof(compact[0]));
+	memset(gather, 0, sizeof(gather));
+	for (first = 0; first < xp->channel_count; first += group_size) {
+		for (lane = 0; lane < xp->word_bytes; lane++) {
+			for (ch = 0; ch < group_size; ch++) {
+				if (first + ch >= xp->channel_count) {
+					gather[ch] = 0;
+					continue;
+				}
+				gather[ch] = words[(first + ch) * xp->word_bytes + lane];
+			}
+#if defined(__AVX2__)
+			v = _mm256_loadu_si256((const __m256i *)gather);
+			for (bit = 8; bit--; ) {
+				bits = (uint32_t)_mm256_movemask_epi8(v);
+				compact[xpose_sample_index(xp, lane * 8 + bit)] |= bits << first;
+				v = _mm256_add_epi8(v, v);
+			}
+#elif defined(__SSE2__)
+			v = _mm_loadu_si128((const __m128i *)gather);
+			for (bit = 8; bit--; ) {
+				bits = (uint32_t)_mm_movemask_epi8(v);
+				compact[xpose_sample_index(xp, lane * 8 + bit)] |= bits << first;
+				v = _mm_add_epi8(v, v);
+			}
+#else
+			memcpy(&v, gather, sizeof(v));
+			v = GUINT64_FROM_LE(v);
+			v = xpose_8x8(v);
+			for (bit = 0; bit < 8; bit++) {
+				bits = (v >> (bit * 8)) & 0xff;
+				compact[xpose_sample_index(xp, lane * 8 + bit)] |= bits << first;
+			}
+#endif
+		}
+	}
+}
+
+/* Map compact values to logic bits, and write the batch's samples. */
+static void xpose_emit(const struct otc_bit_transpose *xp,
+	const uint32_t *compact, uint8_t *dst)
+{
+	size_t idx, group, groups;
+	uint32_t value, logic;
+
+	groups = (xp->channel_count + 7) / 8;
+	for (idx = 0; idx < xp->word_bits; idx++) {
+		value = compact[idx];
+		if (xp->contiguous) {
+			logic = value << xp->shift;
+		} else {
+			logic = 0;
+			for (group = 0; group < groups; group++)
+				logic |= xp->lut[group][(value >> (group * 8)) & 0xff];
+		}
+		switch (xp->unitsize) {
+		case 1:
+			write_u8(dst, logic);
+			break;
+		case 2:
+			write_u16le(dst, logic);
+			break;
+		case 3:
+			write_u24le(dst, logic);
+			break;
+		default:
+			write_u32le(dst, logic);
+			break;
+		}
+		dst += xp->unitsize;
+	}
+}
+
+/**
+ * Convert channel-major sample data to sample-major logic data.
+ *
+ * Consumes complete channel words from the input. Partial batches are
+ * kept until subsequent calls complete them. Each complete batch emits
+ * its samples to the output buffer.
+ *
+ * @param[in] xp The transposer.
+ * @param[in] src The received channel words.
+ * @param[in] src_len The number of bytes in the input buffer. Trailing
+ *   bytes which don't form a complete word are ignored.
+ * @param[out] dst The output buffer for logic data.
+ * @param[in] dst_len The size of the output buffer in bytes.
+ *
+ * @return The number of samples written to the output buffer. Stops
+ *   (and discards the remaining input) when the output buffer is full.
+ */
+OTC_PRIV size_t otc_bit_transpose_run(struct otc_bit_transpose *xp,
+	const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len)
+{
+	uint32_t compact[XPOSE_MAX_WORD_BYTES * 8];
+	size_t batch_bytes, out_bytes, copy_len, samples;
+
+	if (!xp || !src || !dst)
+		return 0;
+
+	batch_bytes = xp->channel_count * xp->word_bytes;
+	out_bytes = xp->word_bits * xp->unitsize;
+	src_len -= src_len % xp->word_bytes;
+	samples = 0;
+
+	while (src_len) {
+		if (dst_len < out_bytes) {
+			otc_err("Conversion buffer too small!");
+			break;
+		}
+
+		/* Transpose complete batches in place, when aligned. */
+		if (!xp->channel_index && src_len >= batch_bytes) {
+			xpose_batch(xp, src, compact);
+			src += batch_bytes;
+			src_len -= batch_bytes;
+		} else {
+			copy_len = batch_bytes - xp->channel_index * xp->word_bytes;
+			copy_len = MIN(copy_len, src_len);
+			memcpy(&xp->words[xp->channel_index * xp->word_bytes],
+				src, copy_len);
+			src += copy_len;
+			src_len -= copy_len;
+			xp->channel_index += copy_len / xp->word_bytes;
+			if (xp->channel_index < xp->channel_count)
+				break;
+			xpose_batch(xp, xp->words, compact);
+			xp->channel_index = 0;
+		}
+
+		xpose_emit(xp, compact, dst);
+		dst += out_bytes;
+		dst_len -= out_bytes;
+		samples += xp->word_bits;
+	}
+
+	return samples;
+}
@@ -0,0 +1,470 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * Byte ring buffer helper functions
+ *
+ * A single producer, single consumer FIFO of bytes with a power of two
+ * capacity. Read and write positions are free running counters, which
+ * get masked when the storage is accessed. Producers and consumers can
+ * either copy data in and out, or access the (at most two) contiguous
+ * storage segments directly, which suits scatter/gather style system
+ * calls and zero-copy packet submission.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include <string.h>
+
+#include "libopentracecapture-internal.h"
+
+#define LOG_PREFIX "byte_ring"
+
+/**
+ * Allocate a byte ring buffer.
+ *
+ * @param[in] size The minimum capacity in bytes. Gets rounded up to
+ *   the next power of two.
+ *
+ * @return The ring buffer, or #NULL when allocation failed.
+ */
+OTC_PRIV struct otc_byte_ring *otc_byte_ring_new(size_t size)
+{
+	struct otc_byte_ring *ring;
+	size_t capacity;
+
+	if (!size)
+		return NULL;
+	capacity = 1;
+	while (capacity < size)
+		capacity <<= 1;
+
+	ring = g_malloc0(sizeof(*ring));
+	ring->data = g_try_malloc(capacity);
+	if (!ring->data) {
+		otc_err("Cannot allocate ring buffer of %zu bytes.", capacity);
+		g_free(ring);
+		return NULL;
+	}
+	ring->size = capacity;
+
+	return ring;
+}
+
+/**
+ * Release a byte ring buffer.
+ *
+ * @param[in] ring The ring buffer to release. Can be #NULL.
+ */
+OTC_PRIV void otc_byte_ring_free(struct otc_byte_ring *ring)
+{
+	if (!ring)
+		return;
+
+	g_free(ring->data);
+	g_free(ring);
+}
+
+/**
+ * Discard all of a byte ring buffer's content.
+ *
+ * @param[in] ring The ring buffer to reset.
+ */
+OTC_PRIV void otc_byte_ring_reset(struct otc_byte_ring *ring)
+{
+	if (!ring)
+		return;
+
+	ring->rd_pos = 0;
+	ring->wr_pos = 0;
+}
+
+/**
+ * Get the number of bytes which are queued in a byte ring buffer.
+ *
+ * @param[in] ring The ring buffer to query.
+ *
+ * @return The number of bytes which can get read.
+ */
+OTC_PRIV size_t otc_byte_ring_used(const struct otc_byte_ring *ring)
+{
+	if (!ring)
+		return 0;
+
+	return ring->wr_pos - ring->rd_pos;
+}
+
+/**
+ * Get the number of bytes which can get stored in a byte ring buffer.
+ *
+ * @param[in] ring The ring buffer to query.
+ *
+ * @return The number of bytes which can get written.
+ */
+OTC_PRIV size_t otc_byte_ring_space(const struct otc_byte_ring *ring)
+{
+	if (!ring)
+		return 0;
+
+	return ring->size - (ring->wr_pos - ring->rd_pos);
+}
+
+/*
+ * Get up to two contiguous segments of 'count' bytes which start at
+ * the free running position 'pos'. Returns the number of segments.
+ */
+static size_t get_segments(const struct otc_byte_ring *ring,
+	size_t pos, size_t count, uint8_t **seg_ptr, size_t *seg_len)
+{
+	size_t offset, first;
+
+	seg_ptr[0] = seg_ptr[1] = NULL;
+	seg_len[0] = seg_len[1] = 0;
+	if (!count)
+		return 0;
+
+	offset = pos & (ring->size - 1);
+	first = ring->size - offset;
+	if (first > count)
+		first = count;
+	seg_ptr[0] = &ring->data[offset];
+	seg_len[0] = first;
+	if (first == count)
+		return 1;
+
+	seg_ptr[1] = &ring->data[0];
+	seg_len[1] = count - first;
+	return 2;
+}
+
+/**
+ * Get the storage segments that a producer can write to.
+ *
+ * Callers fill in the segments in order and then call
+ * otc_byte_ring_commit() with the number of bytes that were stored.
+ *
+ * @param[in] ring The ring buffer to write to.
+ * @param[out] seg_ptr Two element array, receives segment start addresses.
+ * @param[out] seg_len Two element array, receives segment lengths.
+ *
+ * @return The number of segments (0, 1, or 2).
+ */
+OTC_PRIV size_t otc_byte_ring_write_segments(struct otc_byte_ring *ring,
+	uint8_t **seg_ptr, size_t *seg_len)
+{
+	return get_segments(ring, ring->wr_pos,
+		otc_byte_ring_space(ring), seg_ptr, seg_len);
+}
+
+/**
+ * Mark bytes as written after a producer filled in storage segments.
+ *
+ * @param[in] ring The ring buffer which was written to.
+ * @param[in] count The number of bytes which were stored.
+ */
+OTC_PRIV void otc_byte_ring_commit(struct otc_byte_ring *ring, size_t count)
+{
+	size_t space;
+
+	space = otc_byte_ring_space(ring);
+	if (count > space)
+		count = space;
+	ring->wr_pos += count;
+}
+
+/**
+ * Get the storage segments that a consumer can read from.
+ *
+ * Callers process the segments in order and then call
+ * otc_byte_ring_consume() with the number of bytes that were taken.
+ *
+ * @param[in] ring The ring buffer to read from.
+ * @param[out] seg_ptr Two element array, receives segment start addresses.
+ * @param[out] seg_len Two element array, receives segment lengths.
+ *
+ * @return The number of segments (0, 1, or 2).
+ */
+OTC_PRIV size_t otc_byte_ring_read_segments(struct otc_byte_ring *ring,
+	uint8_t **seg_ptr, size_t *seg_len)
+{
+	return get_segments(ring, ring->rd_pos,
+		otc_byte_ring_used(ring), seg_ptr, seg_len);
+}
+
+/**
+ * Remove bytes from the head of a byte ring buffer.
+ *
+ * @param[in] ring The ring buffer to remove data from.
+ * @param[in] count The number of bytes to remove.
+ */
+OTC_PRIV void otc_byte_ring_consume(struct otc_byte_ring *ring, size_t count)
+{
+	size_t used;
+
+	used = otc_byte_ring_used(ring);
+	if (count > used)
+		count = used;
+	ring->rd_pos += count;
+}
+
+/**
+ * Copy data into a byte ring buffer.
+ *
+ * @param[in] ring The ring buffer to write to.
+ * @param[in] data The bytes to store.
+ * @param[in] count The number of bytes to store.
+ *
+ * @return The number of bytes stored, which is less than @a count
+ *   when the ring buffer runs full.
+ */
+OTC_PRIV size_t otc_byte_ring_write(struct otc_byte_ring *ring,
+	const void *data, size_t count)
+{
+	const uint8_t *rdptr;
+	uint8_t *seg_ptr[2];
+	size_t seg_len[2], seg_count, idx, copied, chunk;
+
+	rdptr = data;
+	seg_count = otc_byte_ring_write_segments(ring, seg_ptr, seg_len);
+	copied = 0;
+	for (idx = 0; idx < seg_count && copied < count; idx++) {
+		chunk = MIN(seg_len[idx], count - copied);
+		memcpy(seg_ptr[idx], &rdptr[copied], chunk);
+		copied += chunk;
+	}
+	otc_byte_ring_commit(ring, copied);
+
+	return copied;
+}
+
+/**
+ * Copy data out of a byte ring buffer, and remove it.
+ *
+ * @param[in] ring The ring buffer to read from.
+ * @param[out] data The caller's buffer to fill in.
+ * @param[in] count The maximum number of bytes to read.
+ *
+ * @return The number of bytes read.
+ */
+OTC_PRIV size_t otc_byte_ring_read(struct otc_byte_ring *ring,
+	void *data, size_t count)
+{
+	uint8_t *wrptr;
+	uint8_t *seg_ptr[2];
+	size_t seg_len[2], seg_count, idx, copied, chunk;
+
+	wrptr = data;
+	seg_count = otc_byte_ring_read_segments(ring, seg_ptr, seg_len);
+	copied = 0;
+	for (idx = 0; idx < seg_count && copied < count; idx++) {
+		chunk = MIN(seg_len[idx], count - copied);
+		memcpy(&wrptr[copied], seg_ptr[idx], chunk);
+		copied += chunk;
+	}
+	otc_byte_ring_consume(ring, copied);
+
+	return copied;
+}
+
+/**
+ * Grow a byte ring buffer's capacity to hold additional data.
+ *
+ * Queued data is kept. The new storage holds the data in linear order,
+ * starting at its beginning.
+ *
+ * @param[in] ring The ring buffer to grow.
+ * @param[in] count The number of bytes which need to get stored.
+ *
+ * @retval OTC_OK Success, @a count bytes of free space are available.
+ * @retval OTC_ERR_ARG Invalid parameter.
+ * @retval OTC_ERR_MALLOC Allocation failed, the ring buffer is unchanged.
+ */
+OTC_PRIV int otc_byte_ring_reserve(struct otc_byte_ring *ring, size_t count)
+{
+	size_t used, capacity;
+	uint8_t *data;
+
+	if (!ring)
+		return OTC_ERR_ARG;
+	if (otc_byte_ring_space(ring) >= count)
+		return OTC_OK;
+
+	used = otc_byte_ring_used(ring);
+	capacity = ring->size;
+	while (capacity - used < count) {
+		if (capacity > G_MAXSIZE / 2)
+			return OTC_ERR_MALLOC;
+		capacity <<= 1;
+	}
+	data = g_try_malloc(capacity);
+	if (!data) {
+		otc_err("Cannot grow ring buffer to %zu bytes.", capacity);
+		return OTC_ERR_MALLOC;
+	}
+	otc_byte_ring_peek(ring, 0, data, used);
+	g_free(ring->data);
+	ring->data = data;
+	ring->size = capacity;
+	ring->rd_pos = 0;
+	ring->wr_pos = used;
+
+	return OTC_OK;
+}
+
+/**
+ * Copy data out of a byte ring buffer, but keep it queued.
+ *
+ * @param[in] ring The ring buffer to read from.
+ * @param[in] offset The position relative to the ring buffer's head.
+ * @param[out] data The caller's buffer to fill in.
+ * @param[in] count The maximum number of bytes to copy.
+ *
+ * @return The number of bytes copied.
+ */
+OTC_PRIV size_t otc_byte_ring_peek(const struct otc_byte_ring *ring,
+	size_t offset, void *data, size_t count)
+{
+	uint8_t *wrptr;
+	uint8_t *seg_ptr[2];
+	size_t used, seg_len[2], seg_count, idx, copied;
+
+	used = otc_byte_ring_used(ring);
+	if (offset >= used)
+		return 0;
+	count = MIN(count, used - offset);
+
+	wrptr = data;
+	seg_count = get_segments(ring, ring->rd_pos + offset,
+		count, seg_ptr, seg_len);
+	copied = 0;
+	for (idx = 0; idx < seg_count; idx++) {
+		memcpy(&wrptr[copied], seg_ptr[idx], seg_len[idx]);
+		copied += seg_len[idx];
+	}
+
+	return copied;
+}
+
+/* Reverse the storage range [start, end) in place. */
+static void reverse_range(uint8_t *data, size_t start, size_t end)
+{
+	uint8_t b;
+
+	while (start + 1 < end) {
+		end--;
+		b = data[start];
+		data[start] = data[end];
+		data[end] = b;
+		start++;
+	}
+}
+
+/**
+ * Get a contiguous pointer to queued data, without consuming it.
+ *
+ * When the requested range wraps around the end of the storage, the
+ * storage gets rotated in place such that the ring buffer's head is at
+ * the start of the storage. This only happens once per wrap of the
+ * read position, thus the cost is amortized over the data's size and
+ * callers can repeatedly inspect sliding windows without copies.
+ *
+ * Must not get used while a producer holds write segments.
+ *
+ * @param[in] ring The ring buffer to inspect.
+ * @param[in] offset The position relative to the ring buffer's head.
+ * @param[in] count The number of bytes which need to be contiguous.
+ *
+ * @return Pointer to the data, or #NULL when less than @a offset plus
+ *   @a count bytes are queued.
+ */
+OTC_PRIV const uint8_t *otc_byte_ring_peek_ptr(struct otc_byte_ring *ring,
+	size_t offset, size_t count)
+{
+	size_t used, rd_offset;
+
+	used = otc_byte_ring_used(ring);
+	if (!ring || offset > used || count > used - offset)
+		return NULL;
+
+	rd_offset = (ring->rd_pos + offset) & (ring->size - 1);
+	if (rd_offset + count <= ring->size)
+		return &ring->data[rd_offset];
+
+	rd_offset = ring->rd_pos & (ring->size - 1);
+	reverse_range(ring->data, 0, rd_offset);
+	reverse_range(ring->data, rd_offset, ring->size);
+	reverse_range(ring->data, 0, ring->size);
+	ring->rd_pos = 0;
+	ring->wr_pos = used;
+
+	return &ring->data[offset];
+}
+
+/**
+ * Search queued data for a byte pattern, without consuming it.
+ *
+ * @param[in] ring The ring buffer to search.
+ * @param[in] offset The position relative to the ring buffer's head
+ *   where to start searching.
+ * @param[in] pattern The byte sequence to search for.
+ * @param[in] count The pattern's length, must not exceed 16 bytes.
+ * @param[out] pos Receives the match position relative to the head.
+ *
+ * @return TRUE when the pattern was found, FALSE otherwise.
+ */
+OTC_PRIV gboolean otc_byte_ring_find(const struct otc_byte_ring *ring,
+	size_t offset, const uint8_t *pattern, size_t count, size_t *pos)
+{
+	uint8_t *seg_ptr[2], cmp[16];
+	size_t used, seg_len[2], seg_count, idx, seg_pos;
+	const uint8_t *hit;
+
+	if (!ring || !pattern || !count || count > sizeof(cmp) || !pos)
+		return FALSE;
+	used = otc_byte_ring_used(ring);
+	if (offset >= used || used - offset < count)
+		return FALSE;
+
+	/* Scan segments for the first byte, then check the remainder. */
+	seg_count = get_segments(ring, ring->rd_pos + offset,
+		used - offset, seg_ptr, seg_len);
+	seg_pos = offset;
+	for (idx = 0; idx < seg_count; idx++) {
+		hit = seg_ptr[idx];
+		while ((hit = memchr(hit, pattern[0],
+				seg_len[idx] - (hit - seg_ptr[idx])))) {
+			*pos = seg_pos + (hit - seg_ptr[idx]);
+			if (used - *pos < count)
+				return FALSE;
+			if (count == 1)
+				return TRUE;
+			otc_byte_ring_peek(ring, *pos, cmp, count);
+			if (memcmp(cmp, pattern, count) == 0)
+				return TRUE;
+			if (++hit == seg_ptr[idx] + seg_len[idx])
+				break;
+		}
+		seg_pos += seg_len[idx];
+	}
+
+	return FALSE;
+}
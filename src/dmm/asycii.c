@@ -493,6 +493,17 @@ OTC_PRIV gboolean otc_asycii_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Trailing CR. */
+OTC_PRIV const struct otc_dmm_layout otc_asycii_layout = {
+	.packet_size = ASYCII_PACKET_SIZE,
+	.mask = {
+		[15] = 0xff,
+	},
+	.value = {
+		[15] = '\r',
+	},
+};
+
 /**
  * Parse a protocol packet.
  *
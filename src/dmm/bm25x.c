@@ -46,6 +46,23 @@ OTC_PRIV gboolean otc_brymen_bm25x_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** STX, then the byte index in each upper nibble. */
+OTC_PRIV const struct otc_dmm_layout otc_brymen_bm25x_layout = {
+	.packet_size = BRYMEN_BM25X_PACKET_SIZE,
+	.mask = {
+		[0] = 0xff, [1] = 0xf0, [2] = 0xf0, [3] = 0xf0, [4] = 0xf0,
+		[5] = 0xf0, [6] = 0xf0, [7] = 0xf0, [8] = 0xf0, [9] = 0xf0,
+		[10] = 0xf0, [11] = 0xf0, [12] = 0xf0, [13] = 0xf0,
+		[14] = 0xf0,
+	},
+	.value = {
+		[0] = 0x02, [1] = 0x10, [2] = 0x20, [3] = 0x30, [4] = 0x40,
+		[5] = 0x50, [6] = 0x60, [7] = 0x70, [8] = 0x80, [9] = 0x90,
+		[10] = 0xa0, [11] = 0xb0, [12] = 0xc0, [13] = 0xd0,
+		[14] = 0xe0,
+	},
+};
+
 static int decode_digit(int num, const uint8_t *buf)
 {
 	int val;
@@ -79,6 +79,17 @@ OTC_PRIV gboolean otc_brymen_bm86x_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Model ID bytes, see otc_brymen_bm86x_packet_valid(). */
+OTC_PRIV const struct otc_dmm_layout otc_brymen_bm86x_layout = {
+	.packet_size = BRYMEN_BM86X_PACKET_SIZE,
+	.mask = {
+		[16] = 0xff, [17] = 0xff, [18] = 0xff, [19] = 0xff,
+	},
+	.value = {
+		[16] = 0x86, [17] = 0x86, [18] = 0x86, [19] = 0x86,
+	},
+};
+
 /*
  * Data bytes in the DMM packet encode LCD segments in an unusual order
  * (bgcdafe) and in an unusual position (bits 7:1 within the byte). The
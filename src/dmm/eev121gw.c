@@ -672,6 +672,20 @@ OTC_PRIV gboolean otc_eev121gw_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Start byte and XOR checksum. */
+OTC_PRIV const struct otc_dmm_layout otc_eev121gw_layout = {
+	.packet_size = EEV121GW_PACKET_SIZE,
+	.mask = {
+		[OFF_START_CMD] = 0xff,
+	},
+	.value = {
+		[OFF_START_CMD] = VAL_START_CMD,
+	},
+	.checksum = OTC_DMM_CSUM_XOR8,
+	.csum_start = OFF_START_CMD,
+	.csum_pos = OFF_CHECKSUM,
+};
+
 /**
  * Parse a protocol packet.
  *
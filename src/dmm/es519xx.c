@@ -637,6 +637,17 @@ OTC_PRIV gboolean otc_es519xx_2400_11b_packet_valid(const uint8_t *buf)
 	return otc_es519xx_packet_valid(buf, &info);
 }
 
+/** Both copies of the 11 byte block end in CR/LF. */
+OTC_PRIV const struct otc_dmm_layout otc_es519xx_11b_layout = {
+	.packet_size = ES519XX_11B_PACKET_SIZE,
+	.mask = {
+		[9] = 0xff, [10] = 0xff, [20] = 0xff, [21] = 0xff,
+	},
+	.value = {
+		[9] = '\r', [10] = '\n', [20] = '\r', [21] = '\n',
+	},
+};
+
 OTC_PRIV int otc_es519xx_2400_11b_parse(const uint8_t *buf, float *floatval,
 				struct otc_datafeed_analog *analog, void *info)
 {
@@ -783,6 +794,17 @@ OTC_PRIV gboolean otc_es519xx_19200_14b_packet_valid(const uint8_t *buf)
 	return otc_es519xx_packet_valid(buf, &info);
 }
 
+/** CR/LF terminated 14 byte packets. */
+OTC_PRIV const struct otc_dmm_layout otc_es519xx_14b_layout = {
+	.packet_size = ES519XX_14B_PACKET_SIZE,
+	.mask = {
+		[12] = 0xff, [13] = 0xff,
+	},
+	.value = {
+		[12] = '\r', [13] = '\n',
+	},
+};
+
 OTC_PRIV int otc_es519xx_19200_14b_parse(const uint8_t *buf, float *floatval,
 			struct otc_datafeed_analog *analog, void *info)
 {
@@ -332,6 +332,21 @@ OTC_PRIV gboolean otc_fs9721_packet_valid(const uint8_t *buf)
 	return (sync_nibbles_valid(buf) && flags_valid(&info));
 }
 
+/** Each byte's upper nibble holds its 1-based position. */
+OTC_PRIV const struct otc_dmm_layout otc_fs9721_layout = {
+	.packet_size = FS9721_PACKET_SIZE,
+	.mask = {
+		[0] = 0xf0, [1] = 0xf0, [2] = 0xf0, [3] = 0xf0, [4] = 0xf0,
+		[5] = 0xf0, [6] = 0xf0, [7] = 0xf0, [8] = 0xf0, [9] = 0xf0,
+		[10] = 0xf0, [11] = 0xf0, [12] = 0xf0, [13] = 0xf0,
+	},
+	.value = {
+		[0] = 0x10, [1] = 0x20, [2] = 0x30, [3] = 0x40, [4] = 0x50,
+		[5] = 0x60, [6] = 0x70, [7] = 0x80, [8] = 0x90, [9] = 0xa0,
+		[10] = 0xb0, [11] = 0xc0, [12] = 0xd0, [13] = 0xe0,
+	},
+};
+
 /**
  * Parse a protocol packet.
  *
@@ -338,6 +338,17 @@ OTC_PRIV gboolean otc_fs9922_packet_valid(const uint8_t *buf)
 	return flags_valid(&info);
 }
 
+/** Packets end in CR/LF. */
+OTC_PRIV const struct otc_dmm_layout otc_fs9922_layout = {
+	.packet_size = FS9922_PACKET_SIZE,
+	.mask = {
+		[12] = 0xff, [13] = 0xff,
+	},
+	.value = {
+		[12] = '\r', [13] = '\n',
+	},
+};
+
 /**
  * Parse a protocol packet.
  *
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Generic DMM packet layout checks.
+ *
+ * Chip parsers declare the fixed bits of their packets (sync nibbles,
+ * line terminators, start bytes) and an optional checksum. Receivers
+ * can then search for candidate packet positions with memchr() on a
+ * fixed byte, and reject most misaligned positions with a branchless
+ * mask compare, before they call the chip's (more expensive) validity
+ * check and parser.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "../libopentracecapture-internal.h"
+
+#define LOG_PREFIX "dmm-layout"
+
+/**
+ * Check a packet's fixed fields and checksum.
+ *
+ * @param[in] layout The chip's packet layout.
+ * @param[in] buf The packet, at least layout->packet_size bytes.
+ *
+ * @return TRUE when the packet passes the checks, FALSE otherwise.
+ */
+OTC_PRIV gboolean otc_dmm_layout_match(const struct otc_dmm_layout *layout,
+	const uint8_t *buf)
+{
+	size_t idx;
+	uint8_t diff, csum;
+
+	/* No early exit, lets the compiler vectorize the loop. */
+	diff = 0;
+	for (idx = 0; idx < layout->packet_size; idx++)
+		diff |= (buf[idx] & layout->mask[idx]) ^ layout->value[idx];
+	if (diff)
+		return FALSE;
+
+	switch (layout->checksum) {
+	case OTC_DMM_CSUM_XOR8:
+		csum = 0;
+		for (idx = layout->csum_start; idx < layout->csum_pos; idx++)
+			csum ^= buf[idx];
+		return csum == buf[layout->csum_pos];
+	case OTC_DMM_CSUM_NONE:
+	default:
+		return TRUE;
+	}
+}
+
+/**
+ * Get a packet layout's longest run of fully fixed bytes.
+ *
+ * Receivers can search for this byte sequence to find candidate
+ * packet positions.
+ *
+ * @param[in] layout The chip's packet layout.
+ * @param[out] offset The run's position within the packet.
+ * @param[out] len The run's length, limited to @a max_len.
+ * @param[in] max_len The maximum length the caller can handle.
+ *
+ * @return TRUE when the layout has fully fixed bytes, FALSE otherwise.
+ */
+OTC_PRIV gboolean otc_dmm_layout_sync(const struct otc_dmm_layout *layout,
+	size_t *offset, size_t *len, size_t max_len)
+{
+	size_t idx, run_start, run_len;
+
+	*offset = 0;
+	*len = 0;
+	run_len = 0;
+	run_start = 0;
+	for (idx = 0; idx < layout->packet_size; idx++) {
+		if (layout->mask[idx] != 0xff) {
+			run_len = 0;
+			continue;
+		}
+		if (!run_len)
+			run_start = idx;
+		run_len++;
+		if (run_len > *len && *len < max_len) {
+			*offset = run_start;
+			*len = MIN(run_len, max_len);
+		}
+	}
+
+	return *len != 0;
+}
@@ -50,6 +50,17 @@ OTC_PRIV gboolean otc_m2110_packet_valid(const uint8_t *buf)
 		return FALSE;
 }
 
+/** ASCII text, terminated by CR/LF. */
+OTC_PRIV const struct otc_dmm_layout otc_m2110_layout = {
+	.packet_size = BBCGM_M2110_PACKET_SIZE,
+	.mask = {
+		[7] = 0xff, [8] = 0xff,
+	},
+	.value = {
+		[7] = '\r', [8] = '\n',
+	},
+};
+
 OTC_PRIV int otc_m2110_parse(const uint8_t *buf, float *floatval,
 				struct otc_datafeed_analog *analog, void *info)
 {
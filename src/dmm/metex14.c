@@ -363,6 +363,17 @@ OTC_PRIV gboolean otc_metex14_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Single packet, terminated by CR. */
+OTC_PRIV const struct otc_dmm_layout otc_metex14_layout = {
+	.packet_size = METEX14_PACKET_SIZE,
+	.mask = {
+		[13] = 0xff,
+	},
+	.value = {
+		[13] = '\r',
+	},
+};
+
 OTC_PRIV gboolean otc_metex14_4packets_valid(const uint8_t *buf)
 {
 	struct metex14_info info;
@@ -382,6 +393,17 @@ OTC_PRIV gboolean otc_metex14_4packets_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Four packets back to back, each terminated by CR. */
+OTC_PRIV const struct otc_dmm_layout otc_metex14_4packets_layout = {
+	.packet_size = 4 * METEX14_PACKET_SIZE,
+	.mask = {
+		[13] = 0xff, [27] = 0xff, [41] = 0xff, [55] = 0xff,
+	},
+	.value = {
+		[13] = '\r', [27] = '\r', [41] = '\r', [55] = '\r',
+	},
+};
+
 /**
  * Parse a protocol packet.
  *
@@ -337,6 +337,17 @@ OTC_PRIV gboolean meterman_38xr_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Hex digits terminated by CR/LF. */
+OTC_PRIV const struct otc_dmm_layout meterman_38xr_layout = {
+	.packet_size = METERMAN_38XR_PACKET_SIZE,
+	.mask = {
+		[13] = 0xff, [14] = 0xff,
+	},
+	.value = {
+		[13] = '\r', [14] = '\n',
+	},
+};
+
 OTC_PRIV int meterman_38xr_parse(const uint8_t *buf, float *floatval,
 	struct otc_datafeed_analog *analog, void *info)
 {
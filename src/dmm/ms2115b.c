@@ -159,6 +159,17 @@ OTC_PRIV gboolean otc_ms2115b_packet_valid(const uint8_t *buf)
 	return FALSE;
 }
 
+/** Leading 0x55 byte. */
+OTC_PRIV const struct otc_dmm_layout otc_ms2115b_layout = {
+	.packet_size = MS2115B_PACKET_SIZE,
+	.mask = {
+		[0] = 0xff,
+	},
+	.value = {
+		[0] = 0x55,
+	},
+};
+
 /* Mode values equal to received data */
 enum {
 	MODE_A600_1000 = 0,
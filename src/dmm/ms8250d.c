@@ -277,6 +277,17 @@ OTC_PRIV gboolean otc_ms8250d_packet_valid(const uint8_t *buf)
 	return FALSE;
 }
 
+/** The last byte always is zero. */
+OTC_PRIV const struct otc_dmm_layout otc_ms8250d_layout = {
+	.packet_size = MS8250D_PACKET_SIZE,
+	.mask = {
+		[17] = 0xff,
+	},
+	.value = {
+		[17] = 0x00,
+	},
+};
+
 /**
  * Parse a protocol packet.
  *
@@ -102,6 +102,17 @@ OTC_PRIV gboolean otc_digitech_qm1578_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Trailing record separator. */
+OTC_PRIV const struct otc_dmm_layout otc_digitech_qm1578_layout = {
+	.packet_size = DIGITECH_QM1578_PACKET_SIZE,
+	.mask = {
+		[14] = 0xff,
+	},
+	.value = {
+		[14] = 0x0d,
+	},
+};
+
 OTC_PRIV int otc_digitech_qm1578_parse(const uint8_t *buf, float *floatval,
 				     struct otc_datafeed_analog *analog, void *info)
 {
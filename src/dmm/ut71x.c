@@ -330,6 +330,17 @@ OTC_PRIV gboolean otc_ut71x_packet_valid(const uint8_t *buf)
 	return flags_valid(&info);
 }
 
+/** Packets end in CR/LF. */
+OTC_PRIV const struct otc_dmm_layout otc_ut71x_layout = {
+	.packet_size = UT71X_PACKET_SIZE,
+	.mask = {
+		[9] = 0xff, [10] = 0xff,
+	},
+	.value = {
+		[9] = '\r', [10] = '\n',
+	},
+};
+
 OTC_PRIV int otc_ut71x_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info)
 {
@@ -404,6 +404,17 @@ OTC_PRIV gboolean otc_vc870_packet_valid(const uint8_t *buf)
 	return flags_valid(&info);
 }
 
+/** CR/LF terminated packets. */
+OTC_PRIV const struct otc_dmm_layout otc_vc870_layout = {
+	.packet_size = VC870_PACKET_SIZE,
+	.mask = {
+		[21] = 0xff, [22] = 0xff,
+	},
+	.value = {
+		[21] = '\r', [22] = '\n',
+	},
+};
+
 OTC_PRIV int otc_vc870_parse(const uint8_t *buf, float *floatval,
 			   struct otc_datafeed_analog *analog, void *info)
 {
@@ -245,6 +245,17 @@ OTC_PRIV gboolean otc_vc96_packet_valid(const uint8_t *buf)
 	return TRUE;
 }
 
+/** Packets are terminated by CR/LF. */
+OTC_PRIV const struct otc_dmm_layout otc_vc96_layout = {
+	.packet_size = VC96_PACKET_SIZE,
+	.mask = {
+		[11] = 0xff, [12] = 0xff,
+	},
+	.value = {
+		[11] = '\r', [12] = '\n',
+	},
+};
+
 /**
  * Parse a protocol packet.
  *
@@ -1148,19 +1148,14 @@ OTC_PRIV int sigma_set_samplerate(const struct otc_dev_inst *sdi)
 
 struct submit_buffer {
 	size_t unit_size;
-	size_t max_samples, curr_samples;
-	uint8_t *sample_data;
-	uint8_t *write_pointer;
+	struct feed_queue_logic *feed;
 	struct otc_dev_inst *sdi;
-	struct otc_datafeed_packet packet;
-	struct otc_datafeed_logic logic;
 };
 
 static int alloc_submit_buffer(struct otc_dev_inst *sdi)
 {
 	struct dev_context *devc;
 	struct submit_buffer *buffer;
-	size_t size;
 
 	devc = sdi->priv;
 
@@ -1168,23 +1163,13 @@ static int alloc_submit_buffer(struct otc_dev_inst *sdi)
 	devc->buffer = buffer;
 
 	buffer->unit_size = sizeof(uint16_t);
-	size = CHUNK_SIZE;
-	size /= buffer->unit_size;
-	buffer->max_samples = size;
-	size *= buffer->unit_size;
-	buffer->sample_data = g_try_malloc0(size);
-	if (!buffer->sample_data)
+	buffer->feed = feed_queue_logic_alloc(sdi,
+		CHUNK_SIZE / buffer->unit_size, buffer->unit_size);
+	if (!buffer->feed)
 		return OTC_ERR_MALLOC;
-	buffer->write_pointer = buffer->sample_data;
 	otc_sw_limits_init(&devc->limit.submit);
 
 	buffer->sdi = sdi;
-	memset(&buffer->logic, 0, sizeof(buffer->logic));
-	buffer->logic.unitsize = buffer->unit_size;
-	buffer->logic.data = buffer->sample_data;
-	memset(&buffer->packet, 0, sizeof(buffer->packet));
-	buffer->packet.type = OTC_DF_LOGIC;
-	buffer->packet.payload = &buffer->logic;
 
 	return OTC_OK;
 }
@@ -1232,62 +1217,89 @@ static void free_submit_buffer(struct dev_context *devc)
 		return;
 	devc->buffer = NULL;
 
-	g_free(buffer->sample_data);
+	feed_queue_logic_free(buffer->feed);
 	g_free(buffer);
 }
 
 static int flush_submit_buffer(struct dev_context *devc)
+{
+	return feed_queue_logic_flush(devc->buffer->feed);
+}
+
+static int addto_submit_buffer(struct dev_context *devc,
+	uint16_t sample, size_t count)
 {
 	struct submit_buffer *buffer;
+	struct otc_sw_limits *limits;
+	uint8_t unit[sizeof(sample)];
+	uint64_t remain;
 	int ret;
 
 	buffer = devc->buffer;
+	limits = &devc->limit.submit;
 
-	/* Is queued sample data available? */
-	if (!buffer->curr_samples)
+	/*
+	 * Enforce user specified limits exactly: Clip the run at the
+	 * remaining sample count, then submit it in a single call.
+	 */
+	if (!devc->use_triggers) {
+		if (otc_sw_limits_check(limits))
+			return OTC_OK;
+		(void)otc_sw_limits_get_remain(limits,
+			&remain, NULL, NULL, NULL);
+		if (remain && count > remain)
+			count = remain;
+	}
+	if (!count)
 		return OTC_OK;
 
-	/* Submit to the session feed. */
-	buffer->logic.length = buffer->curr_samples * buffer->unit_size;
-	ret = otc_session_send(buffer->sdi, &buffer->packet);
+	write_u16le(unit, sample);
+	ret = feed_queue_logic_submit_one(buffer->feed, unit, count);
 	if (ret != OTC_OK)
 		return ret;
-
-	/* Rewind queue position. */
-	buffer->curr_samples = 0;
-	buffer->write_pointer = buffer->sample_data;
+	otc_sw_limits_update_samples_read(limits, count);
 
 	return OTC_OK;
 }
 
-static int addto_submit_buffer(struct dev_context *devc,
-	uint16_t sample, size_t count)
+/*
+ * Submit a sequence of samples with different values. Enforces limits
+ * in the same way as addto_submit_buffer() does for repeated values.
+ */
+static int addto_submit_buffer_many(struct dev_context *devc,
+	const uint16_t *samples, size_t count)
 {
 	struct submit_buffer *buffer;
 	struct otc_sw_limits *limits;
+	uint8_t units[EVENTS_PER_CLUSTER * 4 * sizeof(samples[0])];
+	uint8_t *wrptr;
+	uint64_t remain;
+	size_t idx, chunk;
 	int ret;
 
 	buffer = devc->buffer;
 	limits = &devc->limit.submit;
-	if (!devc->use_triggers && otc_sw_limits_check(limits))
-		count = 0;
 
-	/*
-	 * Individually accumulate and check each sample, such that
-	 * accumulation between flushes won't exceed local storage, and
-	 * enforcement of user specified limits is exact.
-	 */
-	while (count--) {
-		write_u16le_inc(&buffer->write_pointer, sample);
-		buffer->curr_samples++;
-		if (buffer->curr_samples == buffer->max_samples) {
-			ret = flush_submit_buffer(devc);
-			if (ret != OTC_OK)
-				return ret;
-		}
-		otc_sw_limits_update_samples_read(limits, 1);
-		if (!devc->use_triggers && otc_sw_limits_check(limits))
-			break;
+	if (!devc->use_triggers) {
+		if (otc_sw_limits_check(limits))
+			return OTC_OK;
+		(void)otc_sw_limits_get_remain(limits,
+			&remain, NULL, NULL, NULL);
+		if (remain && count > remain)
+			count = remain;
+	}
+
+	while (count) {
+		chunk = MIN(count, ARRAY_SIZE(units) / sizeof(samples[0]));
+		wrptr = units;
+		for (idx = 0; idx < chunk; idx++)
+			write_u16le_inc(&wrptr, samples[idx]);
+		ret = feed_queue_logic_submit_many(buffer->feed, units, chunk);
+		if (ret != OTC_OK)
+			return ret;
+		otc_sw_limits_update_samples_read(limits, chunk);
+		samples += chunk;
+		count -= chunk;
 	}
 
 	return OTC_OK;
@@ -1390,6 +1402,106 @@ static void rewind_trig_arm_pos(struct dev_context *devc, size_t count)
 	}
 }
 
+/*
+ * Deinterlace sample data that was retrieved at 100MHz samplerate.
+ * One 16bit item contains two samples of 8bits each. The bits of
+ * multiple samples are interleaved.
+ */
+static uint16_t sigma_deinterlace_data_2x8(uint16_t indata, int idx)
+{
+	uint16_t outdata;
+
+	indata >>= idx;
+	outdata = 0;
+	outdata |= (indata >> (0 * 2 - 0)) & (1 << 0);
+	outdata |= (indata >> (1 * 2 - 1)) & (1 << 1);
+	outdata |= (indata >> (2 * 2 - 2)) & (1 << 2);
+	outdata |= (indata >> (3 * 2 - 3)) & (1 << 3);
+	outdata |= (indata >> (4 * 2 - 4)) & (1 << 4);
+	outdata |= (indata >> (5 * 2 - 5)) & (1 << 5);
+	outdata |= (indata >> (6 * 2 - 6)) & (1 << 6);
+	outdata |= (indata >> (7 * 2 - 7)) & (1 << 7);
+	return outdata;
+}
+
+/*
+ * Deinterlace sample data that was retrieved at 200MHz samplerate.
+ * One 16bit item contains four samples of 4bits each. The bits of
+ * multiple samples are interleaved.
+ */
+static uint16_t sigma_deinterlace_data_4x4(uint16_t indata, int idx)
+{
+	uint16_t outdata;
+
+	indata >>= idx;
+	outdata = 0;
+	outdata |= (indata >> (0 * 4 - 0)) & (1 << 0);
+	outdata |= (indata >> (1 * 4 - 1)) & (1 << 1);
+	outdata |= (indata >> (2 * 4 - 2)) & (1 << 2);
+	outdata |= (indata >> (3 * 4 - 3)) & (1 << 3);
+	return outdata;
+}
+
+/*
+ * Prepare the lookup table for the deinterlacing of sample memory
+ * content. Either byte of a 16bit DRAM item carries the bits of a
+ * subset of the channels, for all samples of the event. Table entries
+ * hold the deinterlaced samples of one byte: Four 4bit samples (nibbles)
+ * in 200MHz mode, two 8bit samples (bytes) in 100MHz mode. Entries for
+ * the high byte are the same, shifted by the low byte's channel count.
+ */
+static void sigma_build_deinterlace_lut(struct sigma_sample_interp *interp)
+{
+	size_t idx;
+	uint16_t entry;
+
+	for (idx = 0; idx < ARRAY_SIZE(interp->deinterlace_lut); idx++) {
+		entry = idx;
+		if (interp->samples_per_event == 4) {
+			entry = 0;
+			entry |= sigma_deinterlace_data_4x4(idx, 0) << 0;
+			entry |= sigma_deinterlace_data_4x4(idx, 1) << 4;
+			entry |= sigma_deinterlace_data_4x4(idx, 2) << 8;
+			entry |= sigma_deinterlace_data_4x4(idx, 3) << 12;
+		} else if (interp->samples_per_event == 2) {
+			entry = 0;
+			entry |= sigma_deinterlace_data_2x8(idx, 0) << 0;
+			entry |= sigma_deinterlace_data_2x8(idx, 1) << 8;
+		}
+		interp->deinterlace_lut[idx] = entry;
+	}
+}
+
+/*
+ * Deinterlace the samples of one DRAM event, using the lookup table.
+ * Returns the number of samples written to the caller's buffer.
+ */
+static size_t sigma_deinterlace_event(const struct sigma_sample_interp *interp,
+	uint16_t indata, uint16_t *samples)
+{
+	const uint16_t *lut;
+	uint16_t packed;
+
+	lut = interp->deinterlace_lut;
+	switch (interp->samples_per_event) {
+	case 4:
+		packed = lut[indata & 0xff] | (lut[indata >> 8] << 2);
+		samples[0] = (packed >> 0) & 0xf;
+		samples[1] = (packed >> 4) & 0xf;
+		samples[2] = (packed >> 8) & 0xf;
+		samples[3] = (packed >> 12) & 0xf;
+		return 4;
+	case 2:
+		packed = lut[indata & 0xff] | (lut[indata >> 8] << 4);
+		samples[0] = packed & 0xff;
+		samples[1] = packed >> 8;
+		return 2;
+	default:
+		samples[0] = indata;
+		return 1;
+	}
+}
+
 static int alloc_sample_buffer(struct dev_context *devc,
 	size_t stop_pos, size_t trig_pos, uint8_t mode)
 {
@@ -1439,6 +1551,9 @@ static int alloc_sample_buffer(struct dev_context *devc,
 	rewind_trig_arm_pos(devc, 4 * EVENTS_PER_CLUSTER);
 	memset(&interp->trig_chk, 0, sizeof(interp->trig_chk));
 
+	/* Prepare the deinterlacing of the samplerate dependent layout. */
+	sigma_build_deinterlace_lut(interp);
+
 	/* Determine which DRAM lines to fetch from the device. */
 	memset(&interp->fetch, 0, sizeof(interp->fetch));
 	interp->fetch.lines_total = interp->stop.line + 1;
@@ -1458,9 +1573,6 @@ static int alloc_sample_buffer(struct dev_context *devc,
 	return OTC_OK;
 }
 
-static uint16_t sigma_deinterlace_data_4x4(uint16_t indata, int idx);
-static uint16_t sigma_deinterlace_data_2x8(uint16_t indata, int idx);
-
 static int fetch_sample_buffer(struct dev_context *devc)
 {
 	struct sigma_sample_interp *interp;
@@ -1468,6 +1580,7 @@ static int fetch_sample_buffer(struct dev_context *devc)
 	int ret;
 	const uint8_t *rdptr;
 	uint16_t ts, data;
+	uint16_t samples[4];
 
 	interp = &devc->interp;
 
@@ -1492,13 +1605,9 @@ static int fetch_sample_buffer(struct dev_context *devc)
 		rdptr = (void *)interp->fetch.curr_line;
 		ts = read_u16le_inc(&rdptr);
 		data = read_u16le_inc(&rdptr);
-		if (interp->samples_per_event == 4) {
-			data = sigma_deinterlace_data_4x4(data, 0);
-		} else if (interp->samples_per_event == 2) {
-			data = sigma_deinterlace_data_2x8(data, 0);
-		}
+		(void)sigma_deinterlace_event(interp, data, samples);
 		interp->last.ts = ts;
-		interp->last.sample = data;
+		interp->last.sample = samples[0];
 	}
 
 	return OTC_OK;
@@ -1809,52 +1918,40 @@ static uint16_t sigma_dram_cluster_data(struct sigma_dram_cluster *cl, int idx)
 }
 
 /*
- * Deinterlace sample data that was retrieved at 100MHz samplerate.
- * One 16bit item contains two samples of 8bits each. The bits of
- * multiple samples are interleaved.
+ * Determine whether samples of the current cluster need individual
+ * checks for trigger condition matches. This is the case while the
+ * period of software checks is open, or when it opens within the
+ * current cluster. Also when the hardware provided trigger position
+ * is within the cluster and needs a marker. Interpretation of all
+ * other clusters is not affected by trigger conditions.
  */
-static uint16_t sigma_deinterlace_data_2x8(uint16_t indata, int idx)
+static gboolean sigma_cluster_needs_trigger_check(struct dev_context *devc)
 {
-	uint16_t outdata;
-
-	indata >>= idx;
-	outdata = 0;
-	outdata |= (indata >> (0 * 2 - 0)) & (1 << 0);
-	outdata |= (indata >> (1 * 2 - 1)) & (1 << 1);
-	outdata |= (indata >> (2 * 2 - 2)) & (1 << 2);
-	outdata |= (indata >> (3 * 2 - 3)) & (1 << 3);
-	outdata |= (indata >> (4 * 2 - 4)) & (1 << 4);
-	outdata |= (indata >> (5 * 2 - 5)) & (1 << 5);
-	outdata |= (indata >> (6 * 2 - 6)) & (1 << 6);
-	outdata |= (indata >> (7 * 2 - 7)) & (1 << 7);
-	return outdata;
-}
+	struct sigma_sample_interp *interp;
 
-/*
- * Deinterlace sample data that was retrieved at 200MHz samplerate.
- * One 16bit item contains four samples of 4bits each. The bits of
- * multiple samples are interleaved.
- */
-static uint16_t sigma_deinterlace_data_4x4(uint16_t indata, int idx)
-{
-	uint16_t outdata;
+	interp = &devc->interp;
+	if (!devc->use_triggers)
+		return FALSE;
+	if (interp->trig_chk.armed)
+		return TRUE;
+	if (interp->trig_chk.matched)
+		return FALSE;
+	if (sigma_location_is_eq(&interp->iter, &interp->trig_arm, FALSE))
+		return TRUE;
 
-	indata >>= idx;
-	outdata = 0;
-	outdata |= (indata >> (0 * 4 - 0)) & (1 << 0);
-	outdata |= (indata >> (1 * 4 - 1)) & (1 << 1);
-	outdata |= (indata >> (2 * 4 - 2)) & (1 << 2);
-	outdata |= (indata >> (3 * 4 - 3)) & (1 << 3);
-	return outdata;
+	return FALSE;
 }
 
 static void sigma_decode_dram_cluster(struct dev_context *devc,
 	struct sigma_dram_cluster *dram_cluster,
 	size_t events_in_cluster)
 {
+	struct sigma_sample_interp *interp;
 	uint16_t tsdiff, ts, sample, item16;
-	size_t count;
-	size_t evt;
+	uint16_t samples[EVENTS_PER_CLUSTER * 4];
+	size_t count, evt, idx;
+
+	interp = &devc->interp;
 
 	/*
 	 * If this cluster is not adjacent to the previously received
@@ -1867,50 +1964,55 @@ static void sigma_decode_dram_cluster(struct dev_context *devc,
 	 * counted conditions, which currently are not supported.)
 	 */
 	ts = sigma_dram_cluster_ts(dram_cluster);
-	tsdiff = ts - devc->interp.last.ts;
+	tsdiff = ts - interp->last.ts;
 	if (tsdiff > 0) {
-		sample = devc->interp.last.sample;
-		count = tsdiff * devc->interp.samples_per_event;
+		sample = interp->last.sample;
+		count = tsdiff * interp->samples_per_event;
 		(void)check_and_submit_sample(devc, sample, count);
 	}
-	devc->interp.last.ts = ts + EVENTS_PER_CLUSTER;
+	interp->last.ts = ts + EVENTS_PER_CLUSTER;
 
 	/*
-	 * Grab sample data from the current cluster and prepare their
-	 * submission to the session feed. Handle samplerate dependent
-	 * memory layout of sample data. Accumulation of data chunks
-	 * before submission is transparent to this code path, specific
-	 * buffer depth is neither assumed nor required here.
+	 * Deinterlace all sample data of the current cluster into a local
+	 * buffer, the table lookup handles the samplerate dependent memory
+	 * layout. Accumulation of data chunks before submission is
+	 * transparent to this code path, specific buffer depth is neither
+	 * assumed nor required here.
 	 */
-	sample = 0;
+	count = 0;
 	for (evt = 0; evt < events_in_cluster; evt++) {
 		item16 = sigma_dram_cluster_data(dram_cluster, evt);
-		if (devc->interp.samples_per_event == 4) {
-			sample = sigma_deinterlace_data_4x4(item16, 0);
-			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
-			sample = sigma_deinterlace_data_4x4(item16, 1);
-			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
-			sample = sigma_deinterlace_data_4x4(item16, 2);
-			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
-			sample = sigma_deinterlace_data_4x4(item16, 3);
-			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
-		} else if (devc->interp.samples_per_event == 2) {
-			sample = sigma_deinterlace_data_2x8(item16, 0);
-			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
-			sample = sigma_deinterlace_data_2x8(item16, 1);
-			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
-		} else {
-			sample = item16;
+		count += sigma_deinterlace_event(interp, item16, &samples[count]);
+	}
+	if (!count)
+		return;
+
+	/*
+	 * Most clusters are far away from the trigger position. Submit
+	 * their samples in bulk, and only check whether the next cluster
+	 * starts the period of software trigger checks.
+	 */
+	if (!sigma_cluster_needs_trigger_check(devc)) {
+		(void)addto_submit_buffer_many(devc, samples, count);
+		interp->last.sample = samples[count - 1];
+		for (evt = 0; evt < events_in_cluster; evt++)
+			sigma_location_increment(&interp->iter);
+		sigma_location_check(devc);
+		return;
+	}
+
+	/*
+	 * Check individual samples for trigger condition matches when
+	 * the cluster is within the period of software checks.
+	 */
+	idx = 0;
+	for (evt = 0; evt < events_in_cluster; evt++) {
+		for (count = 0; count < interp->samples_per_event; count++) {
+			sample = samples[idx++];
 			check_and_submit_sample(devc, sample, 1);
-			devc->interp.last.sample = sample;
+			interp->last.sample = sample;
 		}
-		sigma_location_increment(&devc->interp.iter);
+		sigma_location_increment(&interp->iter);
 		sigma_location_check(devc);
 	}
 }
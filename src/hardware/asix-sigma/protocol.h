@@ -356,6 +356,7 @@ struct dev_context {
 		/* Interpretation of sample memory. */
 		size_t num_channels;
 		size_t samples_per_event;
+		uint16_t deinterlace_lut[256];
 		struct {
 			uint16_t ts;
 			uint16_t sample;
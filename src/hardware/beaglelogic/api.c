@@ -110,7 +110,7 @@ static GSList *scan(struct otc_dev_driver *di, GSList *options)
 	/* Default non-zero values (if any) */
 	devc->fd = -1;
 	devc->limit_samples = 10000000;
-	devc->tcp_buffer = 0;
+	devc->socket = -1;
 
 	if (!conn) {
 		devc->beaglelogic = &beaglelogic_native_ops;
@@ -186,8 +186,10 @@ static int dev_open(struct otc_dev_inst *sdi)
 			devc->beaglelogic->close(devc);
 			return OTC_ERR;
 		}
-	} else {
-		devc->tcp_buffer = g_malloc(TCP_BUFFER_SIZE);
+	} else if (otc_tcp_rx_buffer_alloc(devc->tcp,
+			TCP_BUFFER_SIZE) != OTC_OK) {
+		devc->beaglelogic->close(devc);
+		return OTC_ERR_MALLOC;
 	}
 
 	return OTC_OK;
@@ -207,7 +209,7 @@ static int dev_close(struct otc_dev_inst *sdi)
 
 static void clear_helper(struct dev_context *devc)
 {
-	g_free(devc->tcp_buffer);
+	otc_tcp_dev_inst_free(devc->tcp);
 	g_free(devc->address);
 	g_free(devc->port);
 }
@@ -316,7 +318,8 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 
 	/* Clear capture state */
 	devc->bytes_read = 0;
-	devc->offset = 0;
+	if (beaglelogic_ring_init(devc) != OTC_OK)
+		return OTC_ERR;
 
 	/* Configure channels */
 	devc->sampleunit = BL_SAMPLEUNIT_8_BITS;
@@ -367,6 +370,7 @@ static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 	devc->beaglelogic->stop(devc);
 
 	/* Flush the cache */
+	beaglelogic_ring_clear(devc);
 	if (devc->beaglelogic == &beaglelogic_native_ops)
 		lseek(devc->fd, 0, SEEK_SET);
 	else
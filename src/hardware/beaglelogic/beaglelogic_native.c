@@ -88,11 +88,12 @@ static int beaglelogic_get_lasterror(struct dev_context *devc)
 	if ((fd = open(BEAGLELOGIC_SYSFS_ATTR(lasterror), O_RDONLY)) == -1)
 		return OTC_ERR;
 
-	ret = read(fd, buf, 16);
+	ret = read(fd, buf, sizeof(buf) - 1);
 	close(fd);
 
-	if (ret)
+	if (ret <= 0)
 		return OTC_ERR;
+	buf[ret] = '\0';
 
 	devc->last_error = strtoul(buf, NULL, 10);
 
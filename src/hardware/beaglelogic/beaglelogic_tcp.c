@@ -48,42 +48,18 @@
 
 static int beaglelogic_tcp_open(struct dev_context *devc)
 {
-	struct addrinfo hints;
-	struct addrinfo *results, *res;
-	int err;
-
-	memset(&hints, 0, sizeof(hints));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-
-	err = getaddrinfo(devc->address, devc->port, &hints, &results);
-
-	if (err) {
-		otc_err("Address lookup failed: %s:%s: %s", devc->address,
-			devc->port, gai_strerror(err));
-		return OTC_ERR;
-	}
-
-	for (res = results; res; res = res->ai_next) {
-		if ((devc->socket = socket(res->ai_family, res->ai_socktype,
-						res->ai_protocol)) < 0)
-			continue;
-		if (connect(devc->socket, res->ai_addr, res->ai_addrlen) != 0) {
-			close(devc->socket);
-			devc->socket = -1;
-			continue;
-		}
-		break;
-	}
-
-	freeaddrinfo(results);
-
-	if (devc->socket < 0) {
-		otc_err("Failed to connect to %s:%s: %s", devc->address,
-			devc->port, g_strerror(errno));
+	devc->tcp = otc_tcp_dev_inst_new(devc->address, devc->port);
+	if (!devc->tcp)
+		return OTC_ERR_MALLOC;
+
+	/* Sample data streams in at high rates, use a large window. */
+	(void)otc_tcp_set_sockopts(devc->tcp, TCP_RCVBUF_SIZE, TRUE);
+	if (otc_tcp_connect(devc->tcp) != OTC_OK) {
+		otc_tcp_dev_inst_free(devc->tcp);
+		devc->tcp = NULL;
 		return OTC_ERR;
 	}
+	devc->socket = devc->tcp->sock_fd;
 
 	return OTC_OK;
 }
@@ -162,6 +138,9 @@ OTC_PRIV int beaglelogic_tcp_drain(struct dev_context *devc)
 			len += beaglelogic_tcp_read_data(devc, buf, 1024);
 	} while (ret > 0);
 
+	if (devc->tcp)
+		otc_byte_ring_reset(devc->tcp->rx_ring);
+
 	otc_spew("Drained %d bytes of data.", len);
 
 	g_free(buf);
@@ -259,10 +238,14 @@ static int beaglelogic_open(struct dev_context *devc)
 
 static int beaglelogic_close(struct dev_context *devc)
 {
-	if (close(devc->socket) < 0)
-		return OTC_ERR;
+	int ret;
 
-	return OTC_OK;
+	ret = otc_tcp_disconnect(devc->tcp);
+	otc_tcp_dev_inst_free(devc->tcp);
+	devc->tcp = NULL;
+	devc->socket = -1;
+
+	return ret;
 }
 
 static int beaglelogic_get_buffersize(struct dev_context *devc)
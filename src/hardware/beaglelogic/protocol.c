@@ -40,164 +40,276 @@
  * from the BeagleLogic kernel module */
 #define PACKET_SIZE	(512 * 1024)
 
-/* This implementation is zero copy from the libopentracecapture side.
- * It does not copy any data, just passes a pointer from the mmap'ed
- * kernel buffers appropriately. It is up to the application which is
- * using libopentracecapture to decide how to deal with the data.
+/*
+ * This implementation is zero copy from the libopentracecapture side.
+ * Logic packets point straight into the sample ring, which is the
+ * mmap'ed kernel buffer in native mode, and the receive buffer in TCP
+ * mode. Packets never span the ring's units. otc_session_send() returns
+ * when the session is done with a packet's data (the session threads
+ * copy what they queue), so sent data goes back to the producer (the
+ * kernel's read pointer, or the receive buffer) right after sending.
  */
-OTC_PRIV int beaglelogic_native_receive_data(int fd, int revents, void *cb_data)
+
+static gboolean ring_is_native(const struct dev_context *devc)
+{
+	return devc->beaglelogic == &beaglelogic_native_ops;
+}
+
+OTC_PRIV int beaglelogic_ring_init(struct dev_context *devc)
+{
+	struct beaglelogic_ring *ring;
+
+	beaglelogic_ring_clear(devc);
+	memset(&devc->stats, 0, sizeof(devc->stats));
+
+	ring = &devc->ring;
+	if (ring_is_native(devc)) {
+		ring->base = devc->sample_buf;
+		ring->size = devc->buffersize;
+		ring->unit_size = devc->bufunitsize;
+	} else {
+		ring->base = devc->tcp->rx_ring->data;
+		ring->size = devc->tcp->rx_ring->size;
+		ring->unit_size = MIN(PACKET_SIZE, ring->size);
+	}
+	if (!ring->base || !ring->unit_size || ring->size % ring->unit_size ||
+			ring->unit_size % 2) {
+		otc_err("Unsupported sample buffer layout (%zu/%zu).",
+			ring->size, ring->unit_size);
+		return OTC_ERR;
+	}
+
+	return OTC_OK;
+}
+
+OTC_PRIV void beaglelogic_ring_clear(struct dev_context *devc)
+{
+	struct beaglelogic_stats *stats;
+
+	stats = &devc->stats;
+	if (devc->ring.base) {
+		otc_info("Sent %" PRIu64 " bytes in %" PRIu64 " packets, "
+			"%" PRIu64 " overruns, ring full %" PRIu64 " times, "
+			"max fill %zu bytes.",
+			stats->bytes, stats->packets, stats->overruns,
+			stats->ring_full, stats->max_fill);
+		if (stats->overruns)
+			otc_warn("Samples were lost, the capture has gaps.");
+	}
+	memset(&devc->ring, 0, sizeof(devc->ring));
+}
+
+/* Give the sent data back to the producer, unit by unit. */
+static void beaglelogic_ring_release(struct dev_context *devc)
+{
+	struct beaglelogic_ring *ring;
+	uint64_t unit_end;
+	size_t len;
+
+	ring = &devc->ring;
+	while (ring->released < ring->tail) {
+		unit_end = ring->released - (ring->released % ring->unit_size) +
+			ring->unit_size;
+		len = MIN(unit_end, ring->tail) - ring->released;
+		if (ring_is_native(devc))
+			lseek(devc->fd, len, SEEK_CUR);
+		else
+			otc_byte_ring_consume(devc->tcp->rx_ring, len);
+		ring->released += len;
+	}
+}
+
+/*
+ * Submit a piece of the ring to the session. Until the trigger has
+ * fired, the trigger condition gets checked on the ring data in place.
+ */
+static void beaglelogic_submit(const struct otc_dev_inst *sdi,
+	uint8_t *data, size_t length, uint64_t limit)
 {
-	const struct otc_dev_inst *sdi;
 	struct dev_context *devc;
 	struct otc_datafeed_packet packet;
 	struct otc_datafeed_logic logic;
 
-	int trigger_offset;
 	int pre_trigger_samples;
-	uint32_t packetsize;
-	uint64_t bytes_remaining;
+	int trigger_offset;
+
+	devc = sdi->priv;
+	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+
+	if (!devc->trigger_fired) {
+		trigger_offset = soft_trigger_logic_check(devc->stl,
+				data, length, &pre_trigger_samples);
+		if (trigger_offset < 0)
+			return;
+		devc->trigger_fired = TRUE;
+		devc->bytes_read += pre_trigger_samples * logic.unitsize;
+		data += trigger_offset * logic.unitsize;
+		length -= trigger_offset * logic.unitsize;
+	}
+
+	if (devc->bytes_read >= limit)
+		return;
+	length = MIN(length, limit - devc->bytes_read);
+	if (!length)
+		return;
+
+	/* Send the incoming transfer to the session bus. */
+	packet.type = OTC_DF_LOGIC;
+	packet.payload = &logic;
+	logic.data = data;
+	logic.length = length;
+	otc_session_send(sdi, &packet);
+
+	devc->bytes_read += length;
+	devc->stats.packets++;
+	devc->stats.bytes += length;
+}
+
+/*
+ * Send the ring's data between tail and head, and release what the
+ * session is done with. Returns TRUE when the acquisition is complete.
+ */
+static gboolean beaglelogic_ring_emit(const struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct beaglelogic_ring *ring;
+	struct otc_metrics *metrics;
+	uint64_t limit, fill;
+	uint32_t unitsize;
+	size_t pos, len;
+
+	devc = sdi->priv;
+	ring = &devc->ring;
+	unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	limit = devc->limit_samples > UINT64_MAX / unitsize ?
+		UINT64_MAX : devc->limit_samples * unitsize;
+
+	fill = ring->head - ring->released;
+	devc->stats.max_fill = MAX(devc->stats.max_fill, fill);
+	if (fill >= ring->size)
+		devc->stats.ring_full++;
+	if ((metrics = otc_metrics_get(sdi)))
+		otc_metrics_buffer(metrics, sdi, fill, fill >= ring->size);
+
+	while (ring->tail < ring->head && devc->bytes_read < limit) {
+		pos = ring->tail % ring->size;
+		len = MIN(ring->head - ring->tail,
+			ring->unit_size - (pos % ring->unit_size));
+		len = MIN(len, PACKET_SIZE);
+		len -= len % unitsize;
+		if (!len)
+			break;
+
+		beaglelogic_submit(sdi, ring->base + pos, len, limit);
+		ring->tail += len;
+
+		/* One shot capture, we abort and settle with less than
+		 * the required number of samples */
+		if (devc->triggerflags != BL_TRIGGERFLAGS_CONTINUOUS &&
+				ring->tail >= devc->buffersize)
+			return TRUE;
+	}
+	beaglelogic_ring_release(devc);
+
+	return devc->bytes_read >= limit;
+}
+
+OTC_PRIV int beaglelogic_native_receive_data(int fd, int revents, void *cb_data)
+{
+	const struct otc_dev_inst *sdi;
+	struct dev_context *devc;
+	struct beaglelogic_ring *ring;
+	struct otc_metrics *metrics;
+	gboolean done;
+
+	(void)fd;
 
 	if (!(sdi = cb_data) || !(devc = sdi->priv))
 		return TRUE;
 
-	packetsize = PACKET_SIZE;
-	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
-
-	if (revents == G_IO_IN) {
-		otc_info("In callback G_IO_IN, offset=%d", devc->offset);
-
-		bytes_remaining = (devc->limit_samples * logic.unitsize) -
-				devc->bytes_read;
-
-		/* Configure data packet */
-		packet.type = OTC_DF_LOGIC;
-		packet.payload = &logic;
-		logic.data = devc->sample_buf + devc->offset;
-		logic.length = MIN(packetsize, bytes_remaining);
-
-		if (devc->trigger_fired) {
-			/* Send the incoming transfer to the session bus. */
-			otc_session_send(sdi, &packet);
-		} else {
-			/* Check for trigger */
-			trigger_offset = soft_trigger_logic_check(devc->stl,
-					logic.data, packetsize, &pre_trigger_samples);
-			if (trigger_offset > -1) {
-				devc->bytes_read += pre_trigger_samples * logic.unitsize;
-				trigger_offset *= logic.unitsize;
-				logic.length = MIN(packetsize - trigger_offset,
-						bytes_remaining);
-				logic.data += trigger_offset;
-
-				otc_session_send(sdi, &packet);
-
-				devc->trigger_fired = TRUE;
-			}
-		}
-
-		/* Move the read pointer forward */
-		lseek(fd, packetsize, SEEK_CUR);
-
-		/* Update byte count and offset (roll over if needed) */
-		devc->bytes_read += logic.length;
-		if ((devc->offset += packetsize) >= devc->buffersize) {
-			/* One shot capture, we abort and settle with less than
-			 * the required number of samples */
-			if (devc->triggerflags == BL_TRIGGERFLAGS_CONTINUOUS)
-				devc->offset = 0;
-			else
-				packetsize = 0;
-		}
+	ring = &devc->ring;
+	done = FALSE;
+
+	if (revents & G_IO_ERR) {
+		/* The kernel module stops on buffer overruns. */
+		if (devc->beaglelogic->get_lasterror(devc) == OTC_OK &&
+				devc->last_error)
+			otc_err("Capture buffer overrun, error %d.",
+				devc->last_error);
+		else
+			otc_err("Capture stopped with an error.");
+		devc->stats.overruns++;
+		if ((metrics = otc_metrics_get(sdi)))
+			otc_metrics_overrun(metrics, sdi);
+		done = TRUE;
+	} else if (revents & G_IO_IN) {
+		otc_spew("In callback G_IO_IN, tail=%" PRIu64, ring->tail);
+
+		/*
+		 * Readiness means the unit at the kernel's read pointer is
+		 * complete. The read pointer is where the ring was released
+		 * up to.
+		 */
+		ring->head = MAX(ring->head, ring->released -
+			(ring->released % ring->unit_size) + ring->unit_size);
+		done = beaglelogic_ring_emit(sdi);
 	}
 
 	/* EOF Received or we have reached the limit */
-	if (devc->bytes_read >= devc->limit_samples * logic.unitsize ||
-			packetsize == 0) {
+	if (done) {
 		/* Send EOA Packet, stop polling */
 		std_session_send_df_end(sdi);
+		beaglelogic_ring_clear(devc);
 		otc_session_source_remove_pollfd(sdi->session, &devc->pollfd);
 	}
 
 	return TRUE;
 }
 
+/*
+ * The TCP layer drains the socket into the receive buffer, which the
+ * ring covers. Partial samples stay in the ring until the next receive
+ * callback. The ring's power of two size keeps wrapped data aligned.
+ */
 OTC_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data)
 {
 	const struct otc_dev_inst *sdi;
 	struct dev_context *devc;
-	struct otc_datafeed_packet packet;
-	struct otc_datafeed_logic logic;
+	struct otc_byte_ring *rx_ring;
+	struct beaglelogic_ring *ring;
+	uint32_t unitsize;
+	gboolean done;
 
-	int len;
-	int pre_trigger_samples;
-	int trigger_offset;
-	uint32_t packetsize;
-	uint64_t bytes_remaining;
+	(void)fd;
 
 	if (!(sdi = cb_data) || !(devc = sdi->priv))
 		return TRUE;
 
-	packetsize = TCP_BUFFER_SIZE;
-	logic.unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	ring = &devc->ring;
+	unitsize = SAMPLEUNIT_TO_BYTES(devc->sampleunit);
+	done = FALSE;
 
 	if (revents == G_IO_IN) {
-		otc_info("In callback G_IO_IN");
+		otc_spew("In callback G_IO_IN");
 
-		len = recv(fd, devc->tcp_buffer, TCP_BUFFER_SIZE, 0);
-		if (len < 0) {
-			otc_err("Receive error: %s", g_strerror(errno));
+		if (otc_tcp_rx_fill(devc->tcp) < 0)
 			return OTC_ERR;
-		}
-
-		packetsize = len;
-
-		bytes_remaining = (devc->limit_samples * logic.unitsize) -
-				devc->bytes_read;
-
-		/* Configure data packet */
-		packet.type = OTC_DF_LOGIC;
-		packet.payload = &logic;
-		logic.data = devc->tcp_buffer;
-		logic.length = MIN(packetsize, bytes_remaining);
-
-		if (devc->trigger_fired) {
-			/* Send the incoming transfer to the session bus. */
-			otc_session_send(sdi, &packet);
-		} else {
-			/* Check for trigger */
-			trigger_offset = soft_trigger_logic_check(devc->stl,
-					logic.data, packetsize, &pre_trigger_samples);
-			if (trigger_offset > -1) {
-				devc->bytes_read += pre_trigger_samples * logic.unitsize;
-				trigger_offset *= logic.unitsize;
-				logic.length = MIN(packetsize - trigger_offset,
-						bytes_remaining);
-				logic.data += trigger_offset;
-
-				otc_session_send(sdi, &packet);
-
-				devc->trigger_fired = TRUE;
-			}
-		}
-
-		/* Update byte count and offset (roll over if needed) */
-		devc->bytes_read += logic.length;
-		if ((devc->offset += packetsize) >= devc->buffersize) {
-			/* One shot capture, we abort and settle with less than
-			 * the required number of samples */
-			if (devc->triggerflags == BL_TRIGGERFLAGS_CONTINUOUS)
-				devc->offset = 0;
-			else
-				packetsize = 0;
-		}
+
+		rx_ring = devc->tcp->rx_ring;
+		ring->head = ring->released + otc_byte_ring_used(rx_ring);
+		done = beaglelogic_ring_emit(sdi);
+
+		/* EOF Received */
+		if (devc->tcp->rx_eof && ring->head - ring->tail < unitsize)
+			done = TRUE;
 	}
 
 	/* EOF Received or we have reached the limit */
-	if (devc->bytes_read >= devc->limit_samples * logic.unitsize ||
-			packetsize == 0) {
+	if (done) {
 		/* Send EOA Packet, stop polling */
 		std_session_send_df_end(sdi);
 		devc->beaglelogic->stop(devc);
+		beaglelogic_ring_clear(devc);
 
 		/* Drain the receive buffer */
 		beaglelogic_tcp_drain(devc);
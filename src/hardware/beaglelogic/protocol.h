@@ -32,7 +32,36 @@
 
 #define SAMPLEUNIT_TO_BYTES(x)	((x) == 1 ? 1 : 2)
 
-#define TCP_BUFFER_SIZE         (128 * 1024)
+#define TCP_BUFFER_SIZE         (8 * 1024 * 1024)
+#define TCP_RCVBUF_SIZE         (4 * 1024 * 1024)
+
+/**
+ * Sample ring, over the mmap'ed kernel buffer or the TCP receive buffer.
+ * Positions are free running byte counts since the acquisition start.
+ */
+struct beaglelogic_ring {
+	uint8_t *base;
+	size_t size;
+	/* Granularity of packets, and of releases to the producer */
+	size_t unit_size;
+	uint64_t head;		/* End of the data which the producer filled */
+	uint64_t tail;		/* End of the data which was sent */
+	uint64_t released;	/* End of the data which was given back */
+};
+
+/**
+ * Acquisition statistics, logged when the acquisition ends. The fill
+ * levels and overruns also go to the session statistics.
+ */
+struct beaglelogic_stats {
+	uint64_t packets;
+	uint64_t bytes;
+	/* Data which the kernel module lost, since the reader fell behind */
+	uint64_t overruns;
+	/* Receive callbacks which found the ring without free space */
+	uint64_t ring_full;
+	size_t max_fill;
+};
 
 /** Private, per-device-instance driver context. */
 struct dev_context {
@@ -47,7 +76,7 @@ struct dev_context {
 	char *port;
 	int socket;
 	unsigned int read_timeout;
-	unsigned char *tcp_buffer;
+	struct otc_tcp_dev_inst *tcp;
 
 	/* Acquisition settings: see beaglelogic.h */
 	uint64_t cur_samplerate;
@@ -66,14 +95,17 @@ struct dev_context {
 
 	uint64_t bytes_read;
 	uint64_t sent_samples;
-	uint32_t offset;
 	uint8_t *sample_buf;	/* mmap'd kernel buffer here */
+	struct beaglelogic_ring ring;
+	struct beaglelogic_stats stats;
 
 	/* Trigger logic */
 	struct soft_trigger_logic *stl;
 	gboolean trigger_fired;
 };
 
+OTC_PRIV int beaglelogic_ring_init(struct dev_context *devc);
+OTC_PRIV void beaglelogic_ring_clear(struct dev_context *devc);
 OTC_PRIV int beaglelogic_native_receive_data(int fd, int revents, void *cb_data);
 OTC_PRIV int beaglelogic_tcp_receive_data(int fd, int revents, void *cb_data);
 
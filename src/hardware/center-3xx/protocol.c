@@ -171,44 +171,38 @@ static int handle_packet(const uint8_t *buf, struct otc_dev_inst *sdi, int idx)
 	return OTC_OK;
 }
 
-/* Return TRUE if a full packet was parsed, FALSE otherwise. */
-static gboolean handle_new_data(struct otc_dev_inst *sdi, int idx)
+/** Framer check callback, see otc_ser_framer_new(). */
+OTC_PRIV int center_3xx_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len)
 {
+	struct otc_dev_inst *sdi;
 	struct dev_context *devc;
-	struct otc_serial_dev_inst *serial;
-	int len, offset, ret = FALSE;
 
+	(void)len;
+
+	sdi = cb_data;
 	devc = sdi->priv;
-	serial = sdi->conn;
 
-	/* Try to get as much data as the buffer can hold. */
-	len = SERIAL_BUFSIZE - devc->buflen;
-	len = serial_read_nonblocking(serial, devc->buf + devc->buflen, len);
-	if (len < 1) {
-		otc_err("Serial port read error: %d.", len);
-		return FALSE;
-	}
+	if (!center_devs[devc->idx].packet_valid(buf))
+		return OTC_PACKET_INVALID;
+	*pkt_len = center_devs[devc->idx].packet_size;
 
-	devc->buflen += len;
+	return OTC_PACKET_VALID;
+}
 
-	/* Now look for packets in that data. */
-	offset = 0;
-	while ((devc->buflen - offset) >= center_devs[idx].packet_size) {
-		if (center_devs[idx].packet_valid(devc->buf + offset)) {
-			handle_packet(devc->buf + offset, sdi, idx);
-			offset += center_devs[idx].packet_size;
-			ret = TRUE;
-		} else {
-			offset++;
-		}
-	}
+/** Framer packet callback, see otc_ser_framer_new(). */
+OTC_PRIV void center_3xx_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len)
+{
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
+
+	(void)len;
 
-	/* If we have any data left, move it to the beginning of our buffer. */
-	if (offset < devc->buflen)
-		memmove(devc->buf, devc->buf + offset, devc->buflen - offset);
-	devc->buflen -= offset;
+	sdi = cb_data;
+	devc = sdi->priv;
 
-	return ret;
+	handle_packet(buf, sdi, devc->idx);
 }
 
 static int receive_data(int fd, int revents, int idx, void *cb_data)
@@ -219,6 +213,7 @@ static int receive_data(int fd, int revents, int idx, void *cb_data)
 	struct otc_serial_dev_inst *serial;
 
 	(void)fd;
+	(void)idx;
 
 	if (!(sdi = cb_data))
 		return TRUE;
@@ -230,7 +225,8 @@ static int receive_data(int fd, int revents, int idx, void *cb_data)
 
 	if (revents == G_IO_IN) {
 		/* New data arrived. */
-		request_new_packet = handle_new_data(sdi, idx);
+		request_new_packet = otc_ser_framer_receive(devc->framer,
+			serial) > 0;
 	} else {
 		/*
 		 * Timeout. Send "A" to request a packet, but then don't send
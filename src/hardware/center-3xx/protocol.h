@@ -54,12 +54,15 @@ extern OTC_PRIV const struct center_dev_info center_devs[];
 struct dev_context {
 	struct otc_sw_limits sw_limits;
 
-	uint8_t buf[SERIAL_BUFSIZE];
-	int bufoffset;
-	int buflen;
+	struct otc_ser_framer *framer;
+	int idx;
 };
 
 OTC_PRIV gboolean center_3xx_packet_valid(const uint8_t *buf);
+OTC_PRIV int center_3xx_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len);
+OTC_PRIV void center_3xx_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len);
 
 OTC_PRIV int receive_data_CENTER_309(int fd, int revents, void *cb_data);
 OTC_PRIV int receive_data_VOLTCRAFT_K204(int fd, int revents, void *cb_data);
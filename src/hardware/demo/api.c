@@ -69,6 +69,7 @@ static const uint32_t devopts[] = {
 	OTC_CONF_AVG_SAMPLES | OTC_CONF_GET | OTC_CONF_SET,
 	OTC_CONF_TRIGGER_MATCH | OTC_CONF_LIST,
 	OTC_CONF_CAPTURE_RATIO | OTC_CONF_GET | OTC_CONF_SET,
+	OTC_CONF_FLOOD | OTC_CONF_GET | OTC_CONF_SET,
 };
 
 static const uint32_t devopts_cg_logic[] = {
@@ -148,6 +149,8 @@ static GSList *scan(struct otc_dev_driver *di, GSList *options)
 	devc->limit_frames = limit_frames;
 	devc->capture_ratio = 20;
 	devc->stl = NULL;
+	g_mutex_init(&devc->gen_mutex);
+	g_cond_init(&devc->gen_cond);
 
 	if (num_logic_channels > 0) {
 		/* Logic channels, all in one channel group. */
@@ -220,6 +223,8 @@ static void clear_helper(struct dev_context *devc)
 	void *value;
 
 	demo_free_analog_pattern(devc);
+	g_mutex_clear(&devc->gen_mutex);
+	g_cond_clear(&devc->gen_cond);
 
 	/* Analog generators. */
 	g_hash_table_iter_init(&iter, devc->ch_ag);
@@ -259,6 +264,9 @@ static int config_get(uint32_t key, GVariant **data,
 	case OTC_CONF_LIMIT_FRAMES:
 		*data = g_variant_new_uint64(devc->limit_frames);
 		break;
+	case OTC_CONF_FLOOD:
+		*data = g_variant_new_uint64(devc->flood);
+		break;
 	case OTC_CONF_AVERAGING:
 		*data = g_variant_new_boolean(devc->avg);
 		break;
@@ -349,6 +357,11 @@ static int config_set(uint32_t key, GVariant *data,
 	case OTC_CONF_LIMIT_FRAMES:
 		devc->limit_frames = g_variant_get_uint64(data);
 		break;
+	case OTC_CONF_FLOOD:
+		if (g_variant_get_uint64(data) > FLOOD_MAX_THREADS)
+			return OTC_ERR_ARG;
+		devc->flood = g_variant_get_uint64(data);
+		break;
 	case OTC_CONF_AVERAGING:
 		devc->avg = g_variant_get_boolean(data);
 		otc_dbg("%s averaging", devc->avg ? "Enabling" : "Disabling");
@@ -387,11 +400,6 @@ static int config_set(uint32_t key, GVariant *data,
 				otc_dbg("Setting logic pattern to %s",
 						logic_pattern_str[logic_pattern]);
 				devc->logic_pattern = logic_pattern;
-				/* Might as well do this now, these are static. */
-				if (logic_pattern == PATTERN_ALL_LOW)
-					memset(devc->logic_data, 0x00, LOGIC_BUFSIZE);
-				else if (logic_pattern == PATTERN_ALL_HIGH)
-					memset(devc->logic_data, 0xff, LOGIC_BUFSIZE);
 			} else if (ch->type == OTC_CHANNEL_ANALOG) {
 				if (analog_pattern == -1)
 					return OTC_ERR_ARG;
@@ -497,6 +505,7 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	int bitpos;
 	uint8_t mask;
 	struct otc_trigger *trigger;
+	int ret;
 
 	devc = sdi->priv;
 	devc->sent_samples = 0;
@@ -561,7 +570,17 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 		devc->first_partial_logic_index,
 		devc->first_partial_logic_mask);
 
-	otc_session_source_add(sdi->session, -1, 0, 100,
+	ret = demo_generator_start(devc);
+	if (ret != OTC_OK) {
+		if (devc->stl) {
+			soft_trigger_logic_free(devc->stl);
+			devc->stl = NULL;
+		}
+		return ret;
+	}
+
+	/* Flood mode runs the data callback whenever the mainloop is idle. */
+	otc_session_source_add(sdi->session, -1, 0, devc->flood ? 0 : 100,
 			demo_prepare_data, (struct otc_dev_inst *)sdi);
 
 	std_session_send_df_header(sdi);
@@ -572,7 +591,6 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	/* We use this timestamp to decide how many more samples to send. */
 	devc->start_us = g_get_monotonic_time();
 	devc->spent_us = 0;
-	devc->step = 0;
 
 	return OTC_OK;
 }
@@ -580,6 +598,7 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 {
 	struct dev_context *devc;
+	int64_t elapsed_us;
 
 	otc_session_source_remove(sdi->session, -1);
 
@@ -589,6 +608,15 @@ static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 
 	std_session_send_df_end(sdi);
 
+	demo_generator_stop(devc);
+	if (devc->flood) {
+		elapsed_us = g_get_monotonic_time() - devc->start_us;
+		otc_info("Flood mode sent %" PRIu64 " samples in %.3f s "
+			"(%.2f Msamples/s).", devc->sent_samples,
+			elapsed_us / 1e6,
+			elapsed_us ? (double)devc->sent_samples / elapsed_us : 0.0);
+	}
+
 	if (devc->stl) {
 		soft_trigger_logic_free(devc->stl);
 		devc->stl = NULL;
@@ -30,6 +30,7 @@
 #include "protocol.h"
 
 #define ANALOG_SAMPLES_PER_PERIOD 20
+#define PRNG_LANES 4
 
 static const uint8_t pattern_opentracelab[] = {
 	0x4c, 0x92, 0x92, 0x92, 0x64, 0x00, 0x00, 0x00,
@@ -274,95 +275,165 @@ static void set_logic_data(uint64_t bits, uint8_t *data, size_t len)
 	}
 }
 
-static void logic_generator(struct otc_dev_inst *sdi, uint64_t size)
+static inline uint64_t rotl64(uint64_t x, int k)
 {
-	struct dev_context *devc;
-	uint64_t i, j;
-	uint8_t pat;
-	uint8_t *sample;
+	return (x << k) | (x >> (64 - k));
+}
+
+/*
+ * The xoshiro256** generator by David Blackman and Sebastiano Vigna,
+ * see https://prng.di.unimi.it/. The state words are passed separately,
+ * which lets interleaved generators keep them in vector friendly order.
+ */
+static inline uint64_t xoshiro_next(uint64_t *s0, uint64_t *s1,
+		uint64_t *s2, uint64_t *s3)
+{
+	uint64_t result, t;
+
+	result = rotl64(*s1 * 5, 7) * 9;
+	t = *s1 << 17;
+	*s2 ^= *s0;
+	*s3 ^= *s1;
+	*s1 ^= *s2;
+	*s0 ^= *s3;
+	*s2 ^= t;
+	*s3 = rotl64(*s3, 45);
+
+	return result;
+}
+
+/* Expand a seed into generator state, as the xoshiro authors suggest. */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z;
+
+	z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+static uint64_t prng_next(uint64_t *state)
+{
+	return xoshiro_next(&state[0], &state[1], &state[2], &state[3]);
+}
+
+/*
+ * Fill a buffer with pseudo-random data. Several generators run side
+ * by side, which the compiler turns into vector instructions. The
+ * seed selects the sequence, which allows to fill chunks out of order.
+ */
+static void random_fill(uint8_t *data, size_t len, uint64_t seed)
+{
+	uint64_t s[4][PRNG_LANES], out[PRNG_LANES];
+	size_t lane, word, pos;
+
+	for (lane = 0; lane < PRNG_LANES; lane++) {
+		for (word = 0; word < 4; word++)
+			s[word][lane] = splitmix64(&seed);
+	}
+
+	for (pos = 0; pos < len; pos += sizeof(out)) {
+		for (lane = 0; lane < PRNG_LANES; lane++) {
+			out[lane] = xoshiro_next(&s[0][lane], &s[1][lane],
+				&s[2][lane], &s[3][lane]);
+		}
+		memcpy(&data[pos], out, MIN(sizeof(out), len - pos));
+	}
+}
+
+/*
+ * Generate logic data for a number of samples, starting at the given
+ * sample position of the acquisition. Only depends on the position and
+ * the device's configuration, so flood mode threads can fill chunks in
+ * parallel.
+ */
+static void logic_generator(const struct dev_context *devc,
+		uint64_t first_sample, uint8_t *data, size_t num_samples)
+{
+	size_t unitsize, i, j, pos, cycle;
+	uint8_t ring[2 * sizeof(pattern_opentracelab)];
+	uint8_t *sample, pat, invert;
 	const uint8_t *image_col;
 	size_t col_count, col_height;
 	uint64_t gray;
 
-	devc = sdi->priv;
+	unitsize = devc->logic_unitsize;
 
 	switch (devc->logic_pattern) {
 	case PATTERN_SIGROK:
-		memset(devc->logic_data, 0x00, size);
-		for (i = 0; i < size; i += devc->logic_unitsize) {
-			for (j = 0; j < devc->logic_unitsize; j++) {
-				pat = pattern_opentracelab[(devc->step + j) % sizeof(pattern_opentracelab)] >> 1;
-				devc->logic_data[i + j] = ~pat;
+		/* Samples are windows into the (inverted) pattern. */
+		for (i = 0; i < sizeof(ring); i++) {
+			pat = pattern_opentracelab[i % sizeof(pattern_opentracelab)] >> 1;
+			ring[i] = ~pat;
+		}
+		pos = first_sample % sizeof(pattern_opentracelab);
+		for (i = 0; i < num_samples; i++) {
+			sample = &data[i * unitsize];
+			if (unitsize <= sizeof(pattern_opentracelab)) {
+				memcpy(sample, &ring[pos], unitsize);
+			} else {
+				for (j = 0; j < unitsize; j++)
+					sample[j] = ring[(pos + j) % sizeof(pattern_opentracelab)];
 			}
-			devc->step++;
+			if (++pos == sizeof(pattern_opentracelab))
+				pos = 0;
 		}
 		break;
 	case PATTERN_RANDOM:
-		for (i = 0; i < size; i++)
-			devc->logic_data[i] = (uint8_t)(rand() & 0xff);
+		random_fill(data, num_samples * unitsize, first_sample);
 		break;
 	case PATTERN_INC:
-		for (i = 0; i < size; i++) {
-			for (j = 0; j < devc->logic_unitsize; j++)
-				devc->logic_data[i + j] = devc->step;
-			devc->step++;
-		}
+		pos = first_sample * unitsize;
+		for (i = 0; i < num_samples * unitsize; i++)
+			data[i] = (uint8_t)(pos + i);
 		break;
 	case PATTERN_WALKING_ONE:
-		/* j contains the value of the highest bit */
-		j = 1 << (devc->num_logic_channels - 1);
-		for (i = 0; i < size; i++) {
-			devc->logic_data[i] = devc->step;
-			if (devc->step == 0)
-				devc->step = 1;
-			else
-				if (devc->step == j)
-					devc->step = 0;
-				else
-					devc->step <<= 1;
-		}
-		break;
 	case PATTERN_WALKING_ZERO:
-		/* Same as walking one, only with inverted output */
-		/* j contains the value of the highest bit */
-		j = 1 << (devc->num_logic_channels - 1);
-		for (i = 0; i < size; i++) {
-			devc->logic_data[i] = ~devc->step;
-			if (devc->step == 0)
-				devc->step = 1;
-			else
-				if (devc->step == j)
-					devc->step = 0;
-				else
-					devc->step <<= 1;
+		/*
+		 * Every byte holds the next state of a cycle, which has
+		 * one state per channel plus the all-zero (all-one) state.
+		 */
+		invert = devc->logic_pattern == PATTERN_WALKING_ZERO ? 0xff : 0x00;
+		cycle = devc->num_logic_channels + 1;
+		pos = (first_sample * unitsize) % cycle;
+		for (i = 0; i < num_samples * unitsize; i++) {
+			pat = (pos >= 1 && pos <= 8) ? 1 << (pos - 1) : 0;
+			data[i] = pat ^ invert;
+			if (++pos == cycle)
+				pos = 0;
 		}
 		break;
 	case PATTERN_ALL_LOW:
+		memset(data, 0x00, num_samples * unitsize);
+		break;
 	case PATTERN_ALL_HIGH:
-		/* These were set when the pattern mode was selected. */
+		memset(data, 0xff, num_samples * unitsize);
 		break;
 	case PATTERN_SQUID:
-		memset(devc->logic_data, 0x00, size);
 		col_count = ARRAY_SIZE(pattern_squid);
 		col_height = ARRAY_SIZE(pattern_squid[0]);
-		for (i = 0; i < size; i += devc->logic_unitsize) {
-			sample = &devc->logic_data[i];
-			image_col = pattern_squid[devc->step];
-			for (j = 0; j < devc->logic_unitsize; j++) {
-				pat = image_col[j % col_height];
-				sample[j] = pat;
+		pos = first_sample % col_count;
+		for (i = 0; i < num_samples; i++) {
+			sample = &data[i * unitsize];
+			image_col = pattern_squid[pos];
+			if (unitsize <= col_height) {
+				memcpy(sample, image_col, unitsize);
+			} else {
+				for (j = 0; j < unitsize; j++)
+					sample[j] = image_col[j % col_height];
 			}
-			devc->step++;
-			devc->step %= col_count;
+			if (++pos == col_count)
+				pos = 0;
 		}
 		break;
 	case PATTERN_GRAYCODE:
-		for (i = 0; i < size; i += devc->logic_unitsize) {
-			devc->step++;
-			devc->step &= devc->all_logic_channels_mask;
-			gray = encode_number_to_gray(devc->step);
+		for (i = 0; i < num_samples; i++) {
+			gray = (first_sample + i + 1) & devc->all_logic_channels_mask;
+			gray = encode_number_to_gray(gray);
 			gray &= devc->all_logic_channels_mask;
-			set_logic_data(gray, &devc->logic_data[i], devc->logic_unitsize);
+			set_logic_data(gray, &data[i * unitsize], unitsize);
 		}
 		break;
 	default:
@@ -371,6 +442,157 @@ static void logic_generator(struct otc_dev_inst *sdi, uint64_t size)
 	}
 }
 
+static gpointer generator_thread(gpointer data)
+{
+	struct dev_context *devc;
+	struct logic_chunk *chunk;
+	uint64_t first_sample;
+
+	devc = data;
+
+	g_mutex_lock(&devc->gen_mutex);
+	while (!devc->gen_stop) {
+		chunk = &devc->chunks[devc->fill_idx];
+		if (chunk->state != CHUNK_FREE) {
+			g_cond_wait(&devc->gen_cond, &devc->gen_mutex);
+			continue;
+		}
+		chunk->state = CHUNK_BUSY;
+		first_sample = devc->fill_pos;
+		devc->fill_pos += devc->chunk_samples;
+		devc->fill_idx = (devc->fill_idx + 1) % devc->num_chunks;
+		g_mutex_unlock(&devc->gen_mutex);
+
+		logic_generator(devc, first_sample, chunk->data, devc->chunk_samples);
+
+		g_mutex_lock(&devc->gen_mutex);
+		chunk->state = CHUNK_READY;
+		g_cond_broadcast(&devc->gen_cond);
+	}
+	g_mutex_unlock(&devc->gen_mutex);
+
+	return NULL;
+}
+
+/*
+ * Prepare logic data generation for an acquisition. In flood mode with
+ * more than one thread, worker threads fill a ring of chunks (two per
+ * thread), while the session thread sends the chunks in order.
+ */
+OTC_PRIV int demo_generator_start(struct dev_context *devc)
+{
+	uint64_t seed;
+	size_t idx;
+	GError *error;
+
+	seed = 0;
+	for (idx = 0; idx < ARRAY_SIZE(devc->prng); idx++)
+		devc->prng[idx] = splitmix64(&seed);
+	devc->logic_pos = 0;
+	devc->logic_bufsize = devc->flood ? FLOOD_BUFSIZE : LOGIC_BUFSIZE;
+
+	if (devc->flood <= 1 || !devc->enabled_logic_channels) {
+		devc->logic_data = g_malloc(devc->logic_bufsize);
+		return OTC_OK;
+	}
+
+	devc->gen_stop = FALSE;
+	devc->chunk_samples = FLOOD_BUFSIZE / devc->logic_unitsize;
+	devc->num_chunks = 2 * devc->flood;
+	devc->chunks = g_new0(struct logic_chunk, devc->num_chunks);
+	for (idx = 0; idx < devc->num_chunks; idx++)
+		devc->chunks[idx].data = g_malloc(FLOOD_BUFSIZE);
+	devc->fill_idx = 0;
+	devc->fill_pos = 0;
+	devc->consume_idx = 0;
+	devc->consume_off = 0;
+
+	devc->gen_threads = g_new0(GThread *, devc->flood);
+	for (idx = 0; idx < devc->flood; idx++) {
+		error = NULL;
+		devc->gen_threads[idx] = g_thread_try_new("demo-gen",
+			generator_thread, devc, &error);
+		if (!devc->gen_threads[idx]) {
+			otc_err("Cannot create generator thread: %s.",
+				error->message);
+			g_error_free(error);
+			demo_generator_stop(devc);
+			return OTC_ERR;
+		}
+		devc->num_gen_threads++;
+	}
+	otc_dbg("Started %zu generator threads.", devc->num_gen_threads);
+
+	return OTC_OK;
+}
+
+OTC_PRIV void demo_generator_stop(struct dev_context *devc)
+{
+	size_t idx;
+
+	if (devc->chunks) {
+		g_mutex_lock(&devc->gen_mutex);
+		devc->gen_stop = TRUE;
+		g_cond_broadcast(&devc->gen_cond);
+		g_mutex_unlock(&devc->gen_mutex);
+		for (idx = 0; idx < devc->num_gen_threads; idx++)
+			g_thread_join(devc->gen_threads[idx]);
+		for (idx = 0; idx < devc->num_chunks; idx++)
+			g_free(devc->chunks[idx].data);
+	}
+	g_free(devc->gen_threads);
+	devc->gen_threads = NULL;
+	devc->num_gen_threads = 0;
+	g_free(devc->chunks);
+	devc->chunks = NULL;
+	devc->num_chunks = 0;
+
+	g_free(devc->logic_data);
+	devc->logic_data = NULL;
+}
+
+/* Take the next chunk's data (or part of it) from the generator threads. */
+static uint8_t *logic_chunk_take(struct dev_context *devc, uint64_t *count)
+{
+	struct logic_chunk *chunk;
+	uint8_t *data;
+
+	g_mutex_lock(&devc->gen_mutex);
+	chunk = &devc->chunks[devc->consume_idx];
+	if (devc->consume_off == devc->chunk_samples) {
+		chunk->state = CHUNK_FREE;
+		g_cond_broadcast(&devc->gen_cond);
+		devc->consume_idx = (devc->consume_idx + 1) % devc->num_chunks;
+		devc->consume_off = 0;
+		chunk = &devc->chunks[devc->consume_idx];
+	}
+	while (chunk->state != CHUNK_READY)
+		g_cond_wait(&devc->gen_cond, &devc->gen_mutex);
+	g_mutex_unlock(&devc->gen_mutex);
+
+	*count = MIN(*count, devc->chunk_samples - devc->consume_off);
+	data = chunk->data + devc->consume_off * devc->logic_unitsize;
+	devc->consume_off += *count;
+
+	return data;
+}
+
+/*
+ * Get the logic data for up to 'count' samples. The data remains valid
+ * until the next call, and may be modified in place.
+ */
+static uint8_t *logic_data_get(struct dev_context *devc, uint64_t *count)
+{
+	if (devc->num_gen_threads)
+		return logic_chunk_take(devc, count);
+
+	*count = MIN(*count, devc->logic_bufsize / devc->logic_unitsize);
+	logic_generator(devc, devc->logic_pos, devc->logic_data, *count);
+	devc->logic_pos += *count;
+
+	return devc->logic_data;
+}
+
 /*
  * Fixup a memory image of generated logic data before it gets sent to
  * the session's datafeed. Mask out content from disabled channels.
@@ -515,7 +737,7 @@ static void send_analog_packet(struct analog_gen *ag,
 			data = ag->packet.data;
 			for (i = 0; i < sending_now; i++) {
 				if (ag->pattern == PATTERN_ANALOG_RANDOM)
-					data[i] = (rand() % 1000) * amplitude + offset;
+					data[i] = (prng_next(devc->prng) % 1000) * amplitude + offset;
 				else
 					data[i] = pattern->data[ag_pattern_pos + i] * amplitude + offset;
 			}
@@ -541,7 +763,7 @@ static void send_analog_packet(struct analog_gen *ag,
 
 		for (i = 0; i < to_avg; i++) {
 			if (ag->pattern == PATTERN_ANALOG_RANDOM)
-				value = (rand() % 1000) * amplitude + offset;
+				value = (prng_next(devc->prng) % 1000) * amplitude + offset;
 			else
 				value = *(pattern->data + ag_pattern_pos + i) * amplitude + offset;
 			ag->avg_val = (ag->avg_val + value) / 2;
@@ -582,6 +804,7 @@ OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	struct analog_gen *ag;
 	GHashTableIter iter;
 	void *value;
+	uint8_t *logic_data;
 	uint64_t samples_todo, logic_done, analog_done, analog_sent, sending_now;
 	int64_t elapsed_us, limit_us, todo_us;
 	int64_t trigger_offset;
@@ -604,14 +827,20 @@ OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	/* What time span should we send samples for? */
 	elapsed_us = g_get_monotonic_time() - devc->start_us;
 	limit_us = 1000 * devc->limit_msec;
-	if (limit_us > 0 && limit_us < elapsed_us)
-		todo_us = MAX(0, limit_us - devc->spent_us);
-	else
-		todo_us = MAX(0, elapsed_us - devc->spent_us);
-
-	/* How many samples are outstanding since the last round? */
-	samples_todo = (todo_us * devc->cur_samplerate + G_USEC_PER_SEC - 1)
-			/ G_USEC_PER_SEC;
+	if (devc->flood) {
+		/* Don't pace the data, send as much as the session accepts. */
+		samples_todo = FLOOD_CHUNKS_PER_RUN * devc->logic_bufsize
+			/ MAX(devc->logic_unitsize, 1);
+	} else {
+		if (limit_us > 0 && limit_us < elapsed_us)
+			todo_us = MAX(0, limit_us - devc->spent_us);
+		else
+			todo_us = MAX(0, elapsed_us - devc->spent_us);
+
+		/* How many samples are outstanding since the last round? */
+		samples_todo = (todo_us * devc->cur_samplerate + G_USEC_PER_SEC - 1)
+				/ G_USEC_PER_SEC;
+	}
 
 	if (devc->limit_samples > 0) {
 		if (devc->limit_samples < devc->sent_samples)
@@ -648,13 +877,12 @@ OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	while (logic_done < samples_todo || analog_done < samples_todo) {
 		/* Logic */
 		if (logic_done < samples_todo) {
-			sending_now = MIN(samples_todo - logic_done,
-					LOGIC_BUFSIZE / devc->logic_unitsize);
-			logic_generator(sdi, sending_now * devc->logic_unitsize);
+			sending_now = samples_todo - logic_done;
+			logic_data = logic_data_get(devc, &sending_now);
 			/* Check for trigger and send pre-trigger data if needed */
 			if (devc->stl && (!devc->trigger_fired)) {
 				trigger_offset = soft_trigger_logic_check(devc->stl,
-						devc->logic_data, sending_now * devc->logic_unitsize,
+						logic_data, sending_now * devc->logic_unitsize,
 						&pre_trigger_samples);
 				if (trigger_offset > -1) {
 					devc->trigger_fired = TRUE;
@@ -672,7 +900,7 @@ OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 				if (devc->trigger_fired && (trigger_offset < (int)sending_now)) {
 					/* Send after-trigger data */
 					logic.length = (sending_now - trigger_offset) * devc->logic_unitsize;
-					logic.data = devc->logic_data + trigger_offset * devc->logic_unitsize;
+					logic.data = logic_data + trigger_offset * devc->logic_unitsize;
 					logic_fixup_feed(devc, &logic);
 					otc_session_send(sdi, &packet);
 					logic_done += sending_now - trigger_offset;
@@ -687,7 +915,7 @@ OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 			} else if (!devc->stl) {
 				/* No trigger defined, send logic samples */
 				logic.length = sending_now * devc->logic_unitsize;
-				logic.data = devc->logic_data;
+				logic.data = logic_data;
 				logic_fixup_feed(devc, &logic);
 				otc_session_send(sdi, &packet);
 				logic_done += sending_now;
@@ -711,7 +939,10 @@ OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data)
 	uint64_t min = MIN(logic_done, analog_done);
 	devc->sent_samples += min;
 	devc->sent_frame_samples += min;
-	devc->spent_us += todo_us;
+	if (devc->flood)
+		devc->spent_us = elapsed_us;
+	else
+		devc->spent_us += todo_us;
 
 	if (devc->limit_frames && devc->sent_frame_samples >= SAMPLES_PER_FRAME) {
 		std_session_send_df_frame_end(sdi);
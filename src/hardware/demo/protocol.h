@@ -32,6 +32,12 @@
 
 /* The size in bytes of chunks to send through the session bus. */
 #define LOGIC_BUFSIZE			4096
+/* The size in bytes of chunks to send in flood mode. */
+#define FLOOD_BUFSIZE			(256 * 1024)
+/* Number of chunks to send per data callback in flood mode. */
+#define FLOOD_CHUNKS_PER_RUN		4
+/* Upper limit for the number of flood mode generator threads. */
+#define FLOOD_MAX_THREADS		64
 /* Size of the analog pattern space per channel. */
 #define ANALOG_BUFSIZE			4096
 /* This is a development feature: it starts a new frame every n samples. */
@@ -111,6 +117,16 @@ struct analog_pattern {
 	unsigned int num_samples;
 };
 
+/* Logic data chunk which flood mode generator threads fill ahead of time. */
+struct logic_chunk {
+	uint8_t *data;
+	enum {
+		CHUNK_FREE,
+		CHUNK_BUSY,
+		CHUNK_READY,
+	} state;
+};
+
 struct dev_context {
 	uint64_t cur_samplerate;
 	uint64_t limit_samples;
@@ -120,14 +136,30 @@ struct dev_context {
 	uint64_t sent_frame_samples; /* Number of samples that were sent for current frame. */
 	int64_t start_us;
 	int64_t spent_us;
-	uint64_t step;
+	uint64_t flood;
+	uint64_t prng[4]; /* xoshiro256** state for analog random data. */
 	/* Logic */
 	int32_t num_logic_channels;
 	size_t logic_unitsize;
 	uint64_t all_logic_channels_mask;
 	/* There is only ever one logic channel group, so its pattern goes here. */
 	enum logic_pattern_type logic_pattern;
-	uint8_t logic_data[LOGIC_BUFSIZE];
+	uint64_t logic_pos; /* Number of logic samples generated so far. */
+	uint8_t *logic_data;
+	size_t logic_bufsize;
+	/* Flood mode generator threads, filling a ring of chunks. */
+	GThread **gen_threads;
+	size_t num_gen_threads;
+	GMutex gen_mutex;
+	GCond gen_cond;
+	gboolean gen_stop;
+	struct logic_chunk *chunks;
+	size_t num_chunks;
+	size_t chunk_samples;
+	size_t fill_idx;
+	uint64_t fill_pos;
+	size_t consume_idx;
+	size_t consume_off;
 	/* Analog */
 	struct analog_pattern *analog_patterns[ARRAY_SIZE(analog_pattern_str)];
 	int32_t num_analog_channels;
@@ -162,6 +194,8 @@ struct analog_gen {
 
 OTC_PRIV void demo_generate_analog_pattern(struct dev_context *devc);
 OTC_PRIV void demo_free_analog_pattern(struct dev_context *devc);
+OTC_PRIV int demo_generator_start(struct dev_context *devc);
+OTC_PRIV void demo_generator_stop(struct dev_context *devc);
 OTC_PRIV int demo_prepare_data(int fd, int revents, void *cb_data);
 
 #endif
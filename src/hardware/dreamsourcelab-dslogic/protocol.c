@@ -681,10 +681,13 @@ static void finish_acquisition(struct otc_dev_inst *sdi)
 	std_session_send_df_end(sdi);
 
 	usb_source_remove(sdi->session, devc->ctx);
+	otc_usb_queue_free(devc->queue);
+	devc->queue = NULL;
 
 	devc->num_transfers = 0;
 	g_free(devc->transfers);
 	g_free(devc->deinterleave_buffer);
+	otc_usb_tune_clear(&devc->tune);
 }
 
 static void free_transfer(struct libusb_transfer *transfer)
@@ -712,16 +715,99 @@ static void free_transfer(struct libusb_transfer *transfer)
 		finish_acquisition(sdi);
 }
 
+static unsigned int transfer_slot(struct dev_context *devc,
+	struct libusb_transfer *transfer)
+{
+	unsigned int i;
+
+	for (i = 0; i < devc->num_transfers; i++) {
+		if (devc->transfers[i] == transfer)
+			break;
+	}
+
+	return i;
+}
+
+static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer);
+
+static int add_transfer(const struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct otc_usb_dev_inst *usb;
+	struct libusb_transfer *transfer;
+	unsigned int slot;
+	unsigned char *buf;
+	int ret;
+
+	devc = sdi->priv;
+	usb = sdi->conn;
+
+	slot = transfer_slot(devc, NULL);
+	if (slot == devc->num_transfers)
+		return OTC_ERR_BUG;
+
+	if (!(buf = g_try_malloc(devc->tune.size))) {
+		otc_err("USB transfer buffer malloc failed.");
+		return OTC_ERR_MALLOC;
+	}
+	transfer = libusb_alloc_transfer(0);
+	libusb_fill_bulk_transfer(transfer, usb->devhdl,
+			6 | LIBUSB_ENDPOINT_IN, buf, devc->tune.size,
+			receive_transfer, (void *)sdi,
+			otc_usb_tune_timeout(&devc->tune));
+	otc_usb_tune_submitted(&devc->tune, slot);
+	if ((ret = otc_usb_queue_submit(devc->queue, transfer)) != 0) {
+		otc_err("Failed to submit transfer: %s.",
+		       libusb_error_name(ret));
+		libusb_free_transfer(transfer);
+		g_free(buf);
+		return OTC_ERR;
+	}
+	devc->transfers[slot] = transfer;
+	devc->submitted_transfers++;
+
+	return OTC_OK;
+}
+
 static void resubmit_transfer(struct libusb_transfer *transfer)
 {
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
+	unsigned char *buf;
 	int ret;
 
-	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
+	sdi = transfer->user_data;
+	devc = sdi->priv;
+
+	/* Apply the tuner's choice of the transfers' number and size. */
+	if (devc->submitted_transfers > (int)devc->tune.count) {
+		free_transfer(transfer);
 		return;
+	}
+	if (transfer->length != (int)devc->tune.size) {
+		if (!(buf = g_try_malloc(devc->tune.size))) {
+			otc_err("USB transfer buffer malloc failed.");
+			free_transfer(transfer);
+			return;
+		}
+		g_free(transfer->buffer);
+		transfer->buffer = buf;
+		transfer->length = devc->tune.size;
+	}
+	transfer->timeout = otc_usb_tune_timeout(&devc->tune);
+	otc_usb_tune_submitted(&devc->tune, transfer_slot(devc, transfer));
 
-	otc_err("%s: %s", __func__, libusb_error_name(ret));
-	free_transfer(transfer);
+	if ((ret = otc_usb_queue_submit(devc->queue, transfer)) != LIBUSB_SUCCESS) {
+		otc_err("%s: %s", __func__, libusb_error_name(ret));
+		free_transfer(transfer);
+		return;
+	}
 
+	while (!devc->acq_aborted
+			&& devc->submitted_transfers < (int)devc->tune.count) {
+		if (add_transfer(sdi) != OTC_OK)
+			break;
+	}
 }
 
 static void deinterleave_buffer(const uint8_t *src, size_t length,
@@ -775,6 +861,8 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 		transfer->actual_length /
 		(DSLOGIC_ATOMIC_BYTES * channel_count);
 
+	const int64_t begin_us = g_get_monotonic_time();
+
 	gboolean packet_has_error = FALSE;
 	unsigned int num_samples;
 	int trigger_offset;
@@ -867,6 +955,9 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 		}
 	}
 
+	otc_usb_tune_completed(&devc->tune, transfer_slot(devc, transfer),
+		begin_us, transfer->actual_length);
+
 	if (devc->limit_samples && devc->sent_samples >= devc->limit_samples) {
 		abort_acquisition(devc);
 		free_transfer(transfer);
@@ -877,15 +968,21 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 static int receive_data(int fd, int revents, void *cb_data)
 {
 	struct timeval tv;
-	struct drv_context *drvc;
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
 
 	(void)fd;
 	(void)revents;
 
-	drvc = (struct drv_context *)cb_data;
+	sdi = cb_data;
+	devc = sdi->priv;
+
+	/* The event thread handles libusb, the source ran the callbacks. */
+	if (devc->queue)
+		return TRUE;
 
 	tv.tv_sec = tv.tv_usec = 0;
-	libusb_handle_events_timeout(drvc->otc_ctx->libusb_ctx, &tv);
+	libusb_handle_events_timeout(devc->ctx->libusb_ctx, &tv);
 
 	return TRUE;
 }
@@ -937,61 +1034,51 @@ static unsigned int get_timeout(const struct otc_dev_inst *sdi)
 static int start_transfers(const struct otc_dev_inst *sdi)
 {
 	const size_t channel_count = enabled_channel_count(sdi);
-	const size_t size = get_buffer_size(sdi);
-	const unsigned int num_transfers = get_number_of_transfers(sdi);
-	const unsigned int timeout = get_timeout(sdi);
 
 	struct dev_context *devc;
-	struct otc_usb_dev_inst *usb;
-	struct libusb_transfer *transfer;
 	unsigned int i;
-	int ret;
-	unsigned char *buf;
 
 	devc = sdi->priv;
-	usb = sdi->conn;
 
 	devc->sent_samples = 0;
 	devc->acq_aborted = FALSE;
 	devc->empty_transfer_count = 0;
 	devc->submitted_transfers = 0;
 
+	/*
+	 * Start from the heuristics, the tuner adjusts from there. Buffered
+	 * mode reads from the device's memory, and can't overflow.
+	 */
+	otc_usb_tune_init(&devc->tune, to_bytes_per_ms(sdi),
+		get_buffer_size(sdi), get_number_of_transfers(sdi),
+		channel_count * 512, NUM_SIMUL_TRANSFERS,
+		MAX_TOTAL_TRANSFER_SIZE, devc->continuous_mode);
+
+	/* Leave room for the transfers which the tuner might add. */
 	g_free(devc->transfers);
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * num_transfers);
+	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) *
+		devc->tune.max_count);
 	if (!devc->transfers) {
 		otc_err("USB transfers malloc failed.");
 		return OTC_ERR_MALLOC;
 	}
 
 	devc->deinterleave_buffer = g_try_malloc(DSLOGIC_ATOMIC_SAMPLES *
-		(size / (channel_count * DSLOGIC_ATOMIC_BYTES)) * sizeof(uint16_t));
+		(devc->tune.max_size / (channel_count * DSLOGIC_ATOMIC_BYTES)) *
+		sizeof(uint16_t));
 	if (!devc->deinterleave_buffer) {
 		otc_err("Deinterleave buffer malloc failed.");
 		g_free(devc->deinterleave_buffer);
 		return OTC_ERR_MALLOC;
 	}
 
-	devc->num_transfers = num_transfers;
-	for (i = 0; i < num_transfers; i++) {
-		if (!(buf = g_try_malloc(size))) {
-			otc_err("USB transfer buffer malloc failed.");
-			return OTC_ERR_MALLOC;
-		}
-		transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(transfer, usb->devhdl,
-				6 | LIBUSB_ENDPOINT_IN, buf, size,
-				receive_transfer, (void *)sdi, timeout);
+	devc->num_transfers = devc->tune.max_count;
+	for (i = 0; i < devc->tune.count; i++) {
 		otc_info("submitting transfer: %d", i);
-		if ((ret = libusb_submit_transfer(transfer)) != 0) {
-			otc_err("Failed to submit transfer: %s.",
-			       libusb_error_name(ret));
-			libusb_free_transfer(transfer);
-			g_free(buf);
+		if (add_transfer(sdi) != OTC_OK) {
 			abort_acquisition(devc);
 			return OTC_ERR;
 		}
-		devc->transfers[i] = transfer;
-		devc->submitted_transfers++;
 	}
 
 	std_session_send_df_header(sdi);
@@ -1007,11 +1094,14 @@ static void LIBUSB_CALL trigger_receive(struct libusb_transfer *transfer)
 
 	sdi = transfer->user_data;
 	devc = sdi->priv;
+	devc->trigger_transfer = NULL;
 	if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
 		otc_dbg("Trigger transfer canceled.");
 		/* Terminate session. */
 		std_session_send_df_end(sdi);
 		usb_source_remove(sdi->session, devc->ctx);
+		otc_usb_queue_free(devc->queue);
+		devc->queue = NULL;
 		devc->num_transfers = 0;
 		g_free(devc->transfers);
 	} else if (transfer->status == LIBUSB_TRANSFER_COMPLETED
@@ -1026,6 +1116,21 @@ static void LIBUSB_CALL trigger_receive(struct libusb_transfer *transfer)
 	libusb_free_transfer(transfer);
 }
 
+/* The completion queue takes one callback for all transfers. */
+static void LIBUSB_CALL queued_transfer(struct libusb_transfer *transfer)
+{
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
+
+	sdi = transfer->user_data;
+	devc = sdi->priv;
+
+	if (transfer == devc->trigger_transfer)
+		trigger_receive(transfer);
+	else
+		receive_transfer(transfer);
+}
+
 OTC_PRIV int dslogic_acquisition_start(const struct otc_dev_inst *sdi)
 {
 	const unsigned int timeout = get_timeout(sdi);
@@ -1048,7 +1153,16 @@ OTC_PRIV int dslogic_acquisition_start(const struct otc_dev_inst *sdi)
 	devc->empty_transfer_count = 0;
 	devc->acq_aborted = FALSE;
 
-	usb_source_add(sdi->session, devc->ctx, timeout, receive_data, drvc);
+	/* The trigger position transfer comes before the data transfers. */
+	devc->queue = otc_usb_queue_new(devc->ctx, NUM_SIMUL_TRANSFERS + 1,
+		queued_transfer, (void *)sdi);
+	ret = usb_source_add_queue(sdi->session, devc->ctx, devc->queue,
+		timeout, receive_data, (void *)sdi);
+	if (ret != OTC_OK) {
+		otc_usb_queue_free(devc->queue);
+		devc->queue = NULL;
+		return ret;
+	}
 
 	if ((ret = command_stop_acquisition(sdi)) != OTC_OK)
 		return ret;
@@ -1065,8 +1179,10 @@ OTC_PRIV int dslogic_acquisition_start(const struct otc_dev_inst *sdi)
 	libusb_fill_bulk_transfer(transfer, usb->devhdl, 6 | LIBUSB_ENDPOINT_IN,
 			(unsigned char *)tpos, sizeof(struct dslogic_trigger_pos),
 			trigger_receive, (void *)sdi, 0);
-	if ((ret = libusb_submit_transfer(transfer)) < 0) {
+	devc->trigger_transfer = transfer;
+	if ((ret = otc_usb_queue_submit(devc->queue, transfer)) < 0) {
 		otc_err("Failed to request trigger: %s.", libusb_error_name(ret));
+		devc->trigger_transfer = NULL;
 		libusb_free_transfer(transfer);
 		g_free(tpos);
 		return OTC_ERR;
@@ -37,6 +37,7 @@
 #define MAX_RENUM_DELAY_MS	3000
 #define NUM_SIMUL_TRANSFERS	32
 #define MAX_EMPTY_TRANSFERS	(NUM_SIMUL_TRANSFERS * 2)
+#define MAX_TOTAL_TRANSFER_SIZE	(16 * 1024 * 1024)
 
 #define NUM_CHANNELS		16
 #define NUM_TRIGGER_STAGES	16
@@ -130,7 +131,11 @@ struct dev_context {
 
 	unsigned int num_transfers;
 	struct libusb_transfer **transfers;
+	struct otc_usb_tune tune;
 	struct otc_context *ctx;
+	/* Completed transfers, when the context runs a USB event thread. */
+	struct otc_usb_queue *queue;
+	struct libusb_transfer *trigger_transfer;
 
 	uint16_t *deinterleave_buffer;
 
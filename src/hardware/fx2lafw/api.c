@@ -139,6 +139,9 @@ static const uint32_t devopts[] = {
 	OTC_CONF_SAMPLERATE | OTC_CONF_GET | OTC_CONF_SET | OTC_CONF_LIST,
 	OTC_CONF_TRIGGER_MATCH | OTC_CONF_LIST,
 	OTC_CONF_CAPTURE_RATIO | OTC_CONF_GET | OTC_CONF_SET,
+	OTC_CONF_TRANSFER_SIZE | OTC_CONF_GET,
+	OTC_CONF_TRANSFER_COUNT | OTC_CONF_GET,
+	OTC_CONF_OVERFLOW_COUNT | OTC_CONF_GET,
 };
 
 static const int32_t trigger_matches[] = {
@@ -551,6 +554,15 @@ static int config_get(uint32_t key, GVariant **data,
 	case OTC_CONF_CAPTURE_RATIO:
 		*data = g_variant_new_uint64(devc->capture_ratio);
 		break;
+	case OTC_CONF_TRANSFER_SIZE:
+		*data = g_variant_new_uint64(devc->tune.size);
+		break;
+	case OTC_CONF_TRANSFER_COUNT:
+		*data = g_variant_new_uint64(devc->tune.count);
+		break;
+	case OTC_CONF_OVERFLOW_COUNT:
+		*data = g_variant_new_uint64(devc->tune.overflows);
+		break;
 	default:
 		return OTC_ERR_NA;
 	}
@@ -21,6 +21,11 @@
 #include <config.h>
 #include <glib.h>
 #include <glib/gstdio.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "protocol.h"
 
 #pragma pack(push, 1)
@@ -302,9 +307,12 @@ static void finish_acquisition(struct otc_dev_inst *sdi)
 	std_session_send_df_end(sdi);
 
 	usb_source_remove(sdi->session, devc->ctx);
+	otc_usb_queue_free(devc->queue);
+	devc->queue = NULL;
 
 	devc->num_transfers = 0;
 	g_free(devc->transfers);
+	otc_usb_tune_clear(&devc->tune);
 
 	/* Free the deinterlace buffers if we had them. */
 	if (g_slist_length(devc->enabled_analog_channels) > 0) {
@@ -343,22 +351,150 @@ static void free_transfer(struct libusb_transfer *transfer)
 		finish_acquisition(sdi);
 }
 
+static unsigned int transfer_slot(struct dev_context *devc,
+	struct libusb_transfer *transfer)
+{
+	unsigned int i;
+
+	for (i = 0; i < devc->num_transfers; i++) {
+		if (devc->transfers[i] == transfer)
+			break;
+	}
+
+	return i;
+}
+
+static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer);
+
+static int add_transfer(const struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	struct otc_usb_dev_inst *usb;
+	struct libusb_transfer *transfer;
+	unsigned int slot;
+	unsigned char *buf;
+	int ret;
+
+	devc = sdi->priv;
+	usb = sdi->conn;
+
+	slot = transfer_slot(devc, NULL);
+	if (slot == devc->num_transfers)
+		return OTC_ERR_BUG;
+
+	if (!(buf = g_try_malloc(devc->tune.size))) {
+		otc_err("USB transfer buffer malloc failed.");
+		return OTC_ERR_MALLOC;
+	}
+	transfer = libusb_alloc_transfer(0);
+	libusb_fill_bulk_transfer(transfer, usb->devhdl,
+			2 | LIBUSB_ENDPOINT_IN, buf, devc->tune.size,
+			receive_transfer, (void *)sdi,
+			otc_usb_tune_timeout(&devc->tune));
+	otc_usb_tune_submitted(&devc->tune, slot);
+	if ((ret = otc_usb_queue_submit(devc->queue, transfer)) != 0) {
+		otc_err("Failed to submit transfer: %s.",
+		       libusb_error_name(ret));
+		libusb_free_transfer(transfer);
+		g_free(buf);
+		return OTC_ERR;
+	}
+	devc->transfers[slot] = transfer;
+	devc->submitted_transfers++;
+
+	return OTC_OK;
+}
+
 static void resubmit_transfer(struct libusb_transfer *transfer)
 {
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
+	unsigned char *buf;
 	int ret;
 
-	if ((ret = libusb_submit_transfer(transfer)) == LIBUSB_SUCCESS)
+	sdi = transfer->user_data;
+	devc = sdi->priv;
+
+	/* Apply the tuner's choice of the transfers' number and size. */
+	if (devc->submitted_transfers > (int)devc->tune.count) {
+		free_transfer(transfer);
 		return;
+	}
+	if (transfer->length != (int)devc->tune.size) {
+		if (!(buf = g_try_malloc(devc->tune.size))) {
+			otc_err("USB transfer buffer malloc failed.");
+			free_transfer(transfer);
+			return;
+		}
+		g_free(transfer->buffer);
+		transfer->buffer = buf;
+		transfer->length = devc->tune.size;
+	}
+	transfer->timeout = otc_usb_tune_timeout(&devc->tune);
+	otc_usb_tune_submitted(&devc->tune, transfer_slot(devc, transfer));
 
-	otc_err("%s: %s", __func__, libusb_error_name(ret));
-	free_transfer(transfer);
+	if ((ret = otc_usb_queue_submit(devc->queue, transfer)) != LIBUSB_SUCCESS) {
+		otc_err("%s: %s", __func__, libusb_error_name(ret));
+		free_transfer(transfer);
+		return;
+	}
 
+	while (!devc->acq_aborted
+			&& devc->submitted_transfers < (int)devc->tune.count) {
+		if (add_transfer(sdi) != OTC_OK)
+			break;
+	}
+}
+
+/*
+ * Split interleaved (logic, analog) byte pairs into separate buffers.
+ * Vector registers take 32 pairs per step with AVX2, 16 with SSE2.
+ */
+static void mso_deinterleave(const uint8_t *data, size_t count,
+	uint8_t *logic, uint8_t *analog)
+{
+	size_t i;
+#if defined(__AVX2__)
+	const __m256i mask = _mm256_set1_epi16(0x00ff);
+	__m256i a, b, even, odd;
+
+	for (i = 0; i + 32 <= count; i += 32) {
+		a = _mm256_loadu_si256((const __m256i *)&data[i * 2]);
+		b = _mm256_loadu_si256((const __m256i *)&data[i * 2 + 32]);
+		/* Packing works per 128bit lane, restore the qword order. */
+		even = _mm256_packus_epi16(_mm256_and_si256(a, mask),
+			_mm256_and_si256(b, mask));
+		odd = _mm256_packus_epi16(_mm256_srli_epi16(a, 8),
+			_mm256_srli_epi16(b, 8));
+		_mm256_storeu_si256((__m256i *)&logic[i],
+			_mm256_permute4x64_epi64(even, 0xd8));
+		_mm256_storeu_si256((__m256i *)&analog[i],
+			_mm256_permute4x64_epi64(odd, 0xd8));
+	}
+#elif defined(__SSE2__)
+	const __m128i mask = _mm_set1_epi16(0x00ff);
+	__m128i a, b;
+
+	for (i = 0; i + 16 <= count; i += 16) {
+		a = _mm_loadu_si128((const __m128i *)&data[i * 2]);
+		b = _mm_loadu_si128((const __m128i *)&data[i * 2 + 16]);
+		_mm_storeu_si128((__m128i *)&logic[i], _mm_packus_epi16(
+			_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i *)&analog[i], _mm_packus_epi16(
+			_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+#else
+	i = 0;
+#endif
+	for (; i < count; i++) {
+		logic[i] = data[i * 2];
+		analog[i] = data[i * 2 + 1];
+	}
 }
 
 static void mso_send_data_proc(struct otc_dev_inst *sdi,
 	uint8_t *data, size_t length, size_t sample_width)
 {
-	size_t i;
 	struct dev_context *devc;
 	struct otc_datafeed_analog analog;
 	struct otc_analog_encoding encoding;
@@ -371,13 +507,9 @@ static void mso_send_data_proc(struct otc_dev_inst *sdi,
 
 	length /= 2;
 
-	/* Send the logic */
-	for (i = 0; i < length; i++) {
-		devc->logic_buffer[i] = data[i * 2];
-		/* Rescale to -10V - +10V from 0-255. */
-		devc->analog_buffer[i] = (data[i * 2 + 1] - 128.0f) / 12.8f;
-	};
+	mso_deinterleave(data, length, devc->logic_buffer, devc->analog_buffer);
 
+	/* Send the logic */
 	const struct otc_datafeed_logic logic = {
 		.length = length,
 		.unitsize = 1,
@@ -391,7 +523,16 @@ static void mso_send_data_proc(struct otc_dev_inst *sdi,
 
 	otc_session_send(sdi, &logic_packet);
 
+	/*
+	 * Send the raw ADC values, and let consumers which need floats
+	 * convert them. Rescale to -10V - +10V from 0-255.
+	 */
 	otc_analog_init(&analog, &encoding, &meaning, &spec, 2);
+	encoding.unitsize = sizeof(uint8_t);
+	encoding.is_float = FALSE;
+	encoding.is_signed = FALSE;
+	otc_rational_set(&encoding.scale, 10, 128);
+	otc_rational_set(&encoding.offset, -10, 1);
 	analog.meaning->channels = devc->enabled_analog_channels;
 	analog.meaning->mq = OTC_MQ_VOLTAGE;
 	analog.meaning->unit = OTC_UNIT_VOLT;
@@ -432,7 +573,9 @@ static void LIBUSB_CALL receive_transfer(struct libusb_transfer *transfer)
 	unsigned int num_samples;
 	int trigger_offset, cur_sample_count, unitsize, processed_samples;
 	int pre_trigger_samples;
+	int64_t begin_us;
 
+	begin_us = g_get_monotonic_time();
 	sdi = transfer->user_data;
 	devc = sdi->priv;
 
@@ -542,6 +685,9 @@ check_trigger:
 				goto check_trigger;
 		}
 	}
+	otc_usb_tune_completed(&devc->tune, transfer_slot(devc, transfer),
+		begin_us, transfer->actual_length);
+
 	if (frame_ended && final_frame) {
 		fx2lafw_abort_acquisition(devc);
 		free_transfer(transfer);
@@ -628,29 +774,24 @@ static unsigned int get_number_of_transfers(struct dev_context *devc)
 	return n;
 }
 
-static unsigned int get_timeout(struct dev_context *devc)
-{
-	size_t total_size;
-	unsigned int timeout;
-
-	total_size = get_buffer_size(devc) *
-			get_number_of_transfers(devc);
-	timeout = total_size / to_bytes_per_ms(devc->cur_samplerate, devc->unitsize);
-	return timeout + timeout / 4; /* Leave a headroom of 25% percent. */
-}
-
 static int receive_data(int fd, int revents, void *cb_data)
 {
 	struct timeval tv;
-	struct drv_context *drvc;
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
 
 	(void)fd;
 	(void)revents;
 
-	drvc = (struct drv_context *)cb_data;
+	sdi = cb_data;
+	devc = sdi->priv;
+
+	/* The event thread handles libusb, the source ran the callbacks. */
+	if (devc->queue)
+		return TRUE;
 
 	tv.tv_sec = tv.tv_usec = 0;
-	libusb_handle_events_timeout(drvc->otc_ctx->libusb_ctx, &tv);
+	libusb_handle_events_timeout(devc->ctx->libusb_ctx, &tv);
 
 	return TRUE;
 }
@@ -658,16 +799,10 @@ static int receive_data(int fd, int revents, void *cb_data)
 static int start_transfers(const struct otc_dev_inst *sdi)
 {
 	struct dev_context *devc;
-	struct otc_usb_dev_inst *usb;
 	struct otc_trigger *trigger;
-	struct libusb_transfer *transfer;
-	unsigned int i, num_transfers;
-	int timeout, ret;
-	unsigned char *buf;
-	size_t size;
+	unsigned int i;
 
 	devc = sdi->priv;
-	usb = sdi->conn;
 
 	devc->sent_samples = 0;
 	devc->acq_aborted = FALSE;
@@ -686,39 +821,23 @@ static int start_transfers(const struct otc_dev_inst *sdi)
 		devc->trigger_fired = TRUE;
 	}
 
-	num_transfers = get_number_of_transfers(devc);
-
-	size = get_buffer_size(devc);
 	devc->submitted_transfers = 0;
 
-	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) * num_transfers);
+	/* Leave room for the transfers which the tuner might add. */
+	devc->transfers = g_try_malloc0(sizeof(*devc->transfers) *
+		devc->tune.max_count);
 	if (!devc->transfers) {
 		otc_err("USB transfers malloc failed.");
 		return OTC_ERR_MALLOC;
 	}
 
-	timeout = get_timeout(devc);
-	devc->num_transfers = num_transfers;
-	for (i = 0; i < num_transfers; i++) {
-		if (!(buf = g_try_malloc(size))) {
-			otc_err("USB transfer buffer malloc failed.");
-			return OTC_ERR_MALLOC;
-		}
-		transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(transfer, usb->devhdl,
-				2 | LIBUSB_ENDPOINT_IN, buf, size,
-				receive_transfer, (void *)sdi, timeout);
+	devc->num_transfers = devc->tune.max_count;
+	for (i = 0; i < devc->tune.count; i++) {
 		otc_info("submitting transfer: %d", i);
-		if ((ret = libusb_submit_transfer(transfer)) != 0) {
-			otc_err("Failed to submit transfer: %s.",
-			       libusb_error_name(ret));
-			libusb_free_transfer(transfer);
-			g_free(buf);
+		if (add_transfer(sdi) != OTC_OK) {
 			fx2lafw_abort_acquisition(devc);
 			return OTC_ERR;
 		}
-		devc->transfers[i] = transfer;
-		devc->submitted_transfers++;
 	}
 
 	/*
@@ -741,8 +860,7 @@ OTC_PRIV int fx2lafw_start_acquisition(const struct otc_dev_inst *sdi)
 	struct otc_dev_driver *di;
 	struct drv_context *drvc;
 	struct dev_context *devc;
-	int timeout, ret;
-	size_t size;
+	int ret;
 
 	di = sdi->driver;
 	drvc = di->context;
@@ -759,16 +877,29 @@ OTC_PRIV int fx2lafw_start_acquisition(const struct otc_dev_inst *sdi)
 		return OTC_ERR;
 	}
 
-	timeout = get_timeout(devc);
-	usb_source_add(sdi->session, devc->ctx, timeout, receive_data, drvc);
+	/* Start from the heuristics, the tuner adjusts from there. */
+	otc_usb_tune_init(&devc->tune,
+		to_bytes_per_ms(devc->cur_samplerate, devc->unitsize),
+		get_buffer_size(devc), get_number_of_transfers(devc),
+		devc->unitsize == 3 ? 3 * 1024 : 1024,
+		NUM_SIMUL_TRANSFERS, MAX_TOTAL_TRANSFER_SIZE, TRUE);
+
+	devc->queue = otc_usb_queue_new(devc->ctx, devc->tune.max_count,
+		receive_transfer, (void *)sdi);
+	ret = usb_source_add_queue(sdi->session, devc->ctx, devc->queue,
+		otc_usb_tune_timeout(&devc->tune), receive_data, (void *)sdi);
+	if (ret != OTC_OK) {
+		otc_usb_queue_free(devc->queue);
+		devc->queue = NULL;
+		otc_usb_tune_clear(&devc->tune);
+		return ret;
+	}
 
-	size = get_buffer_size(devc);
 	/* Prepare for analog sampling. */
 	if (g_slist_length(devc->enabled_analog_channels) > 0) {
-		/* We need a buffer half the size of a transfer. */
-		devc->logic_buffer = g_try_malloc(size / 2);
-		devc->analog_buffer = g_try_malloc(
-			sizeof(float) * size / 2);
+		/* We need buffers half the size of the largest transfer. */
+		devc->logic_buffer = g_try_malloc(devc->tune.max_size / 2);
+		devc->analog_buffer = g_try_malloc(devc->tune.max_size / 2);
 	}
 	start_transfers(sdi);
 	if ((ret = command_start_acquisition(sdi)) != OTC_OK) {
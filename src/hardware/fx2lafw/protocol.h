@@ -130,11 +130,14 @@ struct dev_context {
 
 	unsigned int num_transfers;
 	struct libusb_transfer **transfers;
+	struct otc_usb_tune tune;
 	struct otc_context *ctx;
+	/* Completed transfers, when the context runs a USB event thread. */
+	struct otc_usb_queue *queue;
 	void (*send_data_proc)(struct otc_dev_inst *sdi,
 		uint8_t *data, size_t length, size_t sample_width);
 	uint8_t *logic_buffer;
-	float *analog_buffer;
+	uint8_t *analog_buffer;
 };
 
 OTC_PRIV int fx2lafw_dev_open(struct otc_dev_inst *sdi, struct otc_dev_driver *di);
@@ -368,12 +368,13 @@ static const char *scope_digital_channel_names[] = {
 	"D8", "D9", "D10", "D11", "D12", "D13", "D14", "D15",
 };
 
-static struct scope_config scope_models[] = {
+static const struct scope_config scope_models[] = {
 	{
 		/* HMO Compact2: HMO722/1022/1522/2022 support only 8 digital channels. */
 		.name = {"HMO722", "HMO1022", "HMO1522", "HMO2022", NULL},
 		.analog_channels = 2,
 		.digital_channels = 8,
+		.digital_pods = 8 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -415,6 +416,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTC1002", "HMO1002", "HMO1202", NULL},
 		.analog_channels = 2,
 		.digital_channels = 8,
+		.digital_pods = 8 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -456,6 +458,7 @@ static struct scope_config scope_models[] = {
 		.name = {"HMO3032", "HMO3042", "HMO3052", "HMO3522", NULL},
 		.analog_channels = 2,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -497,6 +500,7 @@ static struct scope_config scope_models[] = {
 		.name = {"HMO724", "HMO1024", "HMO1524", "HMO2024", NULL},
 		.analog_channels = 4,
 		.digital_channels = 8,
+		.digital_pods = 8 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -537,6 +541,7 @@ static struct scope_config scope_models[] = {
 		.name = {"HMO2524", "HMO3034", "HMO3044", "HMO3054", "HMO3524", NULL},
 		.analog_channels = 4,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -577,6 +582,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTB2002", NULL},
 		.analog_channels = 2,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -617,6 +623,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTB2004", NULL},
 		.analog_channels = 4,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -657,6 +664,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTM3002", NULL},
 		.analog_channels = 2,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -697,6 +705,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTM3004", NULL},
 		.analog_channels = 4,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -737,6 +746,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTA4004", NULL},
 		.analog_channels = 4,
 		.digital_channels = 16,
+		.digital_pods = 16 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -777,6 +787,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTH1002", NULL},
 		.analog_channels = 2,
 		.digital_channels = 8,
+		.digital_pods = 8 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -817,6 +828,7 @@ static struct scope_config scope_models[] = {
 		.name = {"RTH1004", NULL},
 		.analog_channels = 4,
 		.digital_channels = 8,
+		.digital_pods = 8 / DIGITAL_CHANNELS_PER_POD,
 
 		.analog_names = &scope_analog_channel_names,
 		.digital_names = &scope_digital_channel_names,
@@ -1322,9 +1334,6 @@ OTC_PRIV int hmo_init_device(struct otc_dev_inst *sdi)
 		return OTC_ERR_NA;
 	}
 
-	/* Configure the number of PODs given the number of digital channels. */
-	scope_models[model_index].digital_pods = scope_models[model_index].digital_channels / DIGITAL_CHANNELS_PER_POD;
-
 	devc->analog_groups = g_malloc0(sizeof(struct otc_channel_group*) *
 					scope_models[model_index].analog_channels);
 	devc->digital_groups = g_malloc0(sizeof(struct otc_channel_group*) *
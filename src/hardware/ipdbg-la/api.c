@@ -249,7 +249,7 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	/* If the device stops sending for longer than it takes to send a byte,
 	 * that means it's finished. But wait at least 100 ms to be safe.
 	 */
-	otc_session_source_add(sdi->session, tcp->socket, G_IO_IN, 100,
+	otc_tcp_rx_source_add(sdi->session, tcp->dev, 100,
 		ipdbg_la_receive_data, (struct otc_dev_inst *)sdi);
 
 	ipdbg_la_send_start(tcp);
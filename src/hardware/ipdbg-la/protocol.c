@@ -28,7 +28,6 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
-#include <sys/ioctl.h>
 #endif
 #include <string.h>
 #ifndef _MSC_VER
@@ -67,21 +66,6 @@
 /* LA subfunction command opcodes */
 #define CMD_LA_DELAY               0x1F
 
-static gboolean data_available(struct ipdbg_la_tcp *tcp)
-{
-#ifdef _WIN32
-	u_long bytes_available;
-	if (ioctlsocket(tcp->socket, FIONREAD, &bytes_available) != 0) {
-#else
-	int bytes_available;
-	if (ioctl(tcp->socket, FIONREAD, &bytes_available) < 0) { /* TIOCMGET */
-#endif
-		otc_err("FIONREAD failed: %s\n", g_strerror(errno));
-		return FALSE;
-	}
-	return (bytes_available > 0);
-}
-
 OTC_PRIV struct ipdbg_la_tcp *ipdbg_la_tcp_new(void)
 {
 	struct ipdbg_la_tcp *tcp;
@@ -89,7 +73,7 @@ OTC_PRIV struct ipdbg_la_tcp *ipdbg_la_tcp_new(void)
 	tcp = g_malloc0(sizeof(struct ipdbg_la_tcp));
 	tcp->address = NULL;
 	tcp->port = NULL;
-	tcp->socket = -1;
+	tcp->dev = NULL;
 
 	return tcp;
 }
@@ -102,40 +86,24 @@ OTC_PRIV void ipdbg_la_tcp_free(struct ipdbg_la_tcp *tcp)
 
 OTC_PRIV int ipdbg_la_tcp_open(struct ipdbg_la_tcp *tcp)
 {
-	struct addrinfo hints;
-	struct addrinfo *results, *res;
-	int err;
-
-	memset(&hints, 0, sizeof(hints));
-	hints.ai_family = AF_UNSPEC;
-	hints.ai_socktype = SOCK_STREAM;
-	hints.ai_protocol = IPPROTO_TCP;
-
-	err = getaddrinfo(tcp->address, tcp->port, &hints, &results);
-
-	if (err) {
-		otc_err("Address lookup failed: %s:%s: %s", tcp->address,
-			tcp->port, gai_strerror(err));
-		return OTC_ERR;
-	}
-
-	for (res = results; res; res = res->ai_next) {
-		if ((tcp->socket = socket(res->ai_family, res->ai_socktype,
-			res->ai_protocol)) < 0)
-			continue;
-		if (connect(tcp->socket, res->ai_addr, res->ai_addrlen) != 0) {
-			close(tcp->socket);
-			tcp->socket = -1;
-			continue;
-		}
-		break;
-	}
-
-	freeaddrinfo(results);
-
-	if (tcp->socket < 0) {
-		otc_err("Failed to connect to %s:%s: %s", tcp->address, tcp->port,
-			g_strerror(errno));
+	int ret;
+
+	tcp->dev = otc_tcp_dev_inst_new(tcp->address, tcp->port);
+	if (!tcp->dev)
+		return OTC_ERR_MALLOC;
+
+	/*
+	 * Commands are single bytes which expect quick responses, while
+	 * the sample memory gets uploaded in one burst. Disable Nagle,
+	 * and drain the socket into a large receive buffer.
+	 */
+	(void)otc_tcp_set_sockopts(tcp->dev, IPDBG_LA_RX_BUFFER_SIZE, TRUE);
+	ret = otc_tcp_rx_buffer_alloc(tcp->dev, IPDBG_LA_RX_BUFFER_SIZE);
+	if (ret == OTC_OK)
+		ret = otc_tcp_connect(tcp->dev);
+	if (ret != OTC_OK) {
+		otc_tcp_dev_inst_free(tcp->dev);
+		tcp->dev = NULL;
 		return OTC_ERR;
 	}
 
@@ -146,18 +114,22 @@ OTC_PRIV int ipdbg_la_tcp_close(struct ipdbg_la_tcp *tcp)
 {
 	int ret = OTC_OK;
 
+	if (!tcp->dev)
+		return OTC_OK;
+
 #ifdef _WIN32
-	if (shutdown(tcp->socket, SD_SEND) != SOCKET_ERROR) {
+	if (shutdown(tcp->dev->sock_fd, SD_SEND) != SOCKET_ERROR) {
 		char recvbuf[16];
 		int recvbuflen = 16;
 		/* Receive until the peer closes the connection. */
-		while (recv(tcp->socket, recvbuf, recvbuflen, 0) > 0);
+		while (recv(tcp->dev->sock_fd, recvbuf, recvbuflen, 0) > 0);
 	}
 #endif
-	if (close(tcp->socket) < 0)
+	if (otc_tcp_disconnect(tcp->dev) != OTC_OK)
 		ret = OTC_ERR;
 
-	tcp->socket = -1;
+	otc_tcp_dev_inst_free(tcp->dev);
+	tcp->dev = NULL;
 
 	return ret;
 }
@@ -165,7 +137,7 @@ OTC_PRIV int ipdbg_la_tcp_close(struct ipdbg_la_tcp *tcp)
 static int tcp_send(struct ipdbg_la_tcp *tcp, const uint8_t *buf, size_t len)
 {
 	int out;
-	out = send(tcp->socket, (const char *)buf, len, 0);
+	out = otc_tcp_write_bytes(tcp->dev, buf, len);
 
 	if (out < 0) {
 		otc_err("Send error: %s", g_strerror(errno));
@@ -203,9 +175,9 @@ static int tcp_receive_blocking(struct ipdbg_la_tcp *tcp,
 OTC_PRIV int ipdbg_la_tcp_receive(struct ipdbg_la_tcp *tcp,
 	uint8_t *buf, size_t bufsize)
 {
-	int received = 0;
-	if (data_available(tcp))
-		received = recv(tcp->socket, (char *)buf, bufsize, 0);
+	int received;
+
+	received = otc_tcp_rx_read(tcp->dev, buf, bufsize);
 	if (received < 0) {
 		otc_err("Receive error: %s", g_strerror(errno));
 		return -1;
@@ -301,6 +273,9 @@ OTC_PRIV int ipdbg_la_receive_data(int fd, int revents, void *cb_data)
 	struct ipdbg_la_tcp *tcp = sdi->conn;
 	struct otc_datafeed_packet packet;
 	struct otc_datafeed_logic logic;
+	struct otc_byte_ring *ring;
+	uint64_t stored, expected;
+	size_t count;
 
 	if (!devc->raw_sample_buf) {
 		devc->raw_sample_buf =
@@ -311,24 +286,27 @@ OTC_PRIV int ipdbg_la_receive_data(int fd, int revents, void *cb_data)
 		}
 	}
 
-	if (devc->num_transfers <
-		(devc->limit_samples_max * devc->data_width_bytes)) {
-		const size_t bufsize = 1024;
-		uint8_t buffer[bufsize];
-
-		const int recd = ipdbg_la_tcp_receive(tcp, buffer, bufsize);
-		if ( recd > 0) {
-			int num_move = (((devc->num_transfers + recd) <=
-							 (devc->limit_samples * devc->data_width_bytes))
-			?
-				recd
-			:
-				(int)((devc->limit_samples * devc->data_width_bytes) -
-						devc->num_transfers));
-			if ( num_move > 0 )
-				memcpy(&(devc->raw_sample_buf[devc->num_transfers]),
-						buffer, num_move);
-			devc->num_transfers += recd;
+	/*
+	 * The device always uploads its complete sample memory. Keep the
+	 * part which the user asked for, discard the remainder. The TCP
+	 * layer has drained the socket, move all of its data at once.
+	 */
+	stored = devc->limit_samples * devc->data_width_bytes;
+	expected = devc->limit_samples_max * devc->data_width_bytes;
+	if (devc->num_transfers < expected) {
+		ring = tcp->dev->rx_ring;
+		if (devc->num_transfers < stored) {
+			count = MIN(stored - devc->num_transfers,
+				otc_byte_ring_used(ring));
+			otc_byte_ring_read(ring,
+				&devc->raw_sample_buf[devc->num_transfers], count);
+			devc->num_transfers += count;
+		}
+		if (devc->num_transfers >= stored) {
+			count = MIN(expected - devc->num_transfers,
+				otc_byte_ring_used(ring));
+			otc_byte_ring_consume(ring, count);
+			devc->num_transfers += count;
 		}
 	} else {
 		if (devc->delay_value > 0) {
@@ -560,7 +538,7 @@ OTC_PRIV void ipdbg_la_abort_acquisition(const struct otc_dev_inst *sdi)
 {
 	struct ipdbg_la_tcp *tcp = sdi->conn;
 
-	otc_session_source_remove(sdi->session, tcp->socket);
+	otc_tcp_source_remove(sdi->session, tcp->dev);
 
 	std_session_send_df_end(sdi);
 }
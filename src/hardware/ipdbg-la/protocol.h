@@ -27,10 +27,12 @@
 
 #define LOG_PREFIX "ipdbg-la"
 
+#define IPDBG_LA_RX_BUFFER_SIZE	(256 * 1024)
+
 struct ipdbg_la_tcp {
 	char *address;
 	char *port;
-	int socket;
+	struct otc_tcp_dev_inst *dev;
 };
 
 /** Private, per-device-instance driver context. */
@@ -133,11 +133,21 @@ static int config_list(uint32_t key, GVariant **data,
 static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 {
 	struct dev_context *devc;
+	struct scale_info *scale;
 	struct otc_serial_dev_inst *serial;
 
 	devc = sdi->priv;
+	scale = (struct scale_info *)sdi->driver;
 	serial = sdi->conn;
 
+	otc_ser_framer_free(devc->framer);
+	devc->framer = otc_ser_framer_new(scale->packet_size, SCALE_BUFSIZE,
+		kern_scale_check_packet, kern_scale_process_packet, (void *)sdi);
+	if (!devc->framer)
+		return OTC_ERR_MALLOC;
+	g_free(devc->info);
+	devc->info = g_malloc(scale->info_size);
+
 	otc_spew("Set O1 mode (continuous values, stable and unstable ones).");
 	if (serial_write_blocking(serial, "O1\r\n", 4, 0) < 0)
 		return OTC_ERR;
@@ -152,6 +162,23 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	return OTC_OK;
 }
 
+static int dev_acquisition_stop(struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	int ret;
+
+	devc = sdi->priv;
+
+	ret = std_serial_dev_acquisition_stop(sdi);
+
+	otc_ser_framer_free(devc->framer);
+	devc->framer = NULL;
+	g_free(devc->info);
+	devc->info = NULL;
+
+	return ret;
+}
+
 #define SCALE(ID, CHIPSET, VENDOR, MODEL, CONN, PACKETSIZE, \
 			VALID, PARSE) \
 	&((struct scale_info) { \
@@ -170,7 +197,7 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 			.dev_open = std_serial_dev_open, \
 			.dev_close = std_serial_dev_close, \
 			.dev_acquisition_start = dev_acquisition_start, \
-			.dev_acquisition_stop = std_serial_dev_acquisition_stop, \
+			.dev_acquisition_stop = dev_acquisition_stop, \
 			.context = NULL, \
 		}, \
 		VENDOR, MODEL, CONN, PACKETSIZE, \
@@ -61,52 +61,44 @@ static void handle_packet(const uint8_t *buf, struct otc_dev_inst *sdi,
 	}
 }
 
-static void handle_new_data(struct otc_dev_inst *sdi, void *info)
+/** Framer check callback, see otc_ser_framer_new(). */
+OTC_PRIV int kern_scale_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len)
 {
+	struct otc_dev_inst *sdi;
 	struct scale_info *scale;
-	struct dev_context *devc;
-	int len, offset;
-	struct otc_serial_dev_inst *serial;
 
+	(void)len;
+
+	sdi = cb_data;
 	scale = (struct scale_info *)sdi->driver;
 
+	if (!scale->packet_valid(buf))
+		return OTC_PACKET_INVALID;
+	*pkt_len = scale->packet_size;
+
+	return OTC_PACKET_VALID;
+}
+
+/** Framer packet callback, see otc_ser_framer_new(). */
+OTC_PRIV void kern_scale_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len)
+{
+	struct otc_dev_inst *sdi;
+	struct dev_context *devc;
+
+	(void)len;
+
+	sdi = cb_data;
 	devc = sdi->priv;
-	serial = sdi->conn;
-
-	/* Try to get as much data as the buffer can hold. */
-	len = SCALE_BUFSIZE - devc->buflen;
-	len = serial_read_nonblocking(serial, devc->buf + devc->buflen, len);
-	if (len == 0)
-		return; /* No new bytes, nothing to do. */
-	if (len < 0) {
-		otc_err("Serial port read error: %d.", len);
-		return;
-	}
-	devc->buflen += len;
-
-	/* Now look for packets in that data. */
-	offset = 0;
-	while ((devc->buflen - offset) >= scale->packet_size) {
-		if (scale->packet_valid(devc->buf + offset)) {
-			handle_packet(devc->buf + offset, sdi, info);
-			offset += scale->packet_size;
-		} else {
-			offset++;
-		}
-	}
 
-	/* If we have any data left, move it to the beginning of our buffer. */
-	if (offset < devc->buflen)
-		memmove(devc->buf, devc->buf + offset, devc->buflen - offset);
-	devc->buflen -= offset;
+	handle_packet(buf, sdi, devc->info);
 }
 
 OTC_PRIV int kern_scale_receive_data(int fd, int revents, void *cb_data)
 {
 	struct otc_dev_inst *sdi;
 	struct dev_context *devc;
-	struct scale_info *scale;
-	void *info;
 
 	(void)fd;
 
@@ -116,13 +108,9 @@ OTC_PRIV int kern_scale_receive_data(int fd, int revents, void *cb_data)
 	if (!(devc = sdi->priv))
 		return TRUE;
 
-	scale = (struct scale_info *)sdi->driver;
-
 	if (revents == G_IO_IN) {
 		/* Serial data arrived. */
-		info = g_malloc(scale->info_size);
-		handle_new_data(sdi, info);
-		g_free(info);
+		otc_ser_framer_receive(devc->framer, sdi->conn);
 	}
 
 	if (otc_sw_limits_check(&devc->limits))
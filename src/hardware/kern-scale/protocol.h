@@ -47,10 +47,14 @@ struct scale_info {
 struct dev_context {
 	struct otc_sw_limits limits;
 
-	uint8_t buf[SCALE_BUFSIZE];
-	int buflen;
+	struct otc_ser_framer *framer;
+	void *info;
 };
 
+OTC_PRIV int kern_scale_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len);
+OTC_PRIV void kern_scale_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len);
 OTC_PRIV int kern_scale_receive_data(int fd, int revents, void *cb_data);
 
 #endif
@@ -570,6 +570,7 @@ static void la2016_prepare_stream(const struct otc_dev_inst *sdi)
 
 	devc = sdi->priv;
 	stream = &devc->stream;
+	otc_bit_transpose_free(stream->xpose);
 	memset(stream, 0, sizeof(*stream));
 
 	stream->enabled_count = 0;
@@ -583,7 +584,13 @@ static void la2016_prepare_stream(const struct otc_dev_inst *sdi)
 		stream->enabled_mask |= channel_mask;
 		stream->channel_masks[stream->enabled_count++] = channel_mask;
 	}
-	stream->channel_index = 0;
+	if (!stream->enabled_count)
+		return;
+
+	/* Chunks carry 16 samples per enabled channel, LSB first. */
+	stream->xpose = otc_bit_transpose_new(16, FALSE,
+		devc->model->channel_count == 32 ? sizeof(uint32_t) : sizeof(uint16_t),
+		stream->channel_masks, stream->enabled_count);
 }
 
 /*
@@ -1322,6 +1329,9 @@ static int la2016_start_download(const struct otc_dev_inst *sdi)
 	return OTC_OK;
 }
 
+/* Number of sample value runs to collect before bulk submission. */
+#define SEND_CHUNK_RUNS	64
+
 /*
  * A chunk of sample memory was received via USB. These chunks contain
  * transfers of 16 or 32 bytes each (model dependent size and layout).
@@ -1351,7 +1361,10 @@ static void send_chunk(struct otc_dev_inst *sdi,
 	const uint8_t *rp;
 	uint32_t sample_value;
 	size_t repetitions;
-	uint8_t sample_buff[sizeof(sample_value)];
+	uint8_t run_values[SEND_CHUNK_RUNS * sizeof(sample_value)];
+	size_t run_counts[SEND_CHUNK_RUNS];
+	size_t run_count, unitsize;
+	uint8_t *run_wrptr;
 
 	devc = sdi->priv;
 
@@ -1374,8 +1387,16 @@ static void send_chunk(struct otc_dev_inst *sdi,
 	else
 		devc->n_bytes_to_read -= data_length;
 
-	/* Process the received chunk of capture data. */
+	/*
+	 * Process the received chunk of capture data. Collect runs of
+	 * sample values, and submit them in bulk. Pending runs must be
+	 * submitted before the trigger gets marked.
+	 */
 	sample_value = 0;
+	unitsize = devc->model->channel_count == 32
+		? sizeof(uint32_t) : sizeof(uint16_t);
+	run_count = 0;
+	run_wrptr = run_values;
 	rp = data_buffer;
 	num_xfers = data_length / devc->transfer_size;
 	while (num_xfers--) {
@@ -1390,14 +1411,26 @@ static void send_chunk(struct otc_dev_inst *sdi,
 
 			devc->total_samples += repetitions;
 
-			write_u32le(sample_buff, sample_value);
-			feed_queue_logic_submit_one(devc->feed_queue,
-				sample_buff, repetitions);
+			if (unitsize == sizeof(uint32_t))
+				write_u32le_inc(&run_wrptr, sample_value);
+			else
+				write_u16le_inc(&run_wrptr, sample_value);
+			run_counts[run_count++] = repetitions;
+			if (run_count == SEND_CHUNK_RUNS) {
+				feed_queue_logic_submit_runs(devc->feed_queue,
+					run_values, run_counts, run_count);
+				run_count = 0;
+				run_wrptr = run_values;
+			}
 			otc_sw_limits_update_samples_read(&devc->sw_limits,
 				repetitions);
 
 			if (devc->trigger_involved && !devc->trigger_marked) {
 				if (!--devc->n_reps_until_trigger) {
+					feed_queue_logic_submit_runs(devc->feed_queue,
+						run_values, run_counts, run_count);
+					run_count = 0;
+					run_wrptr = run_values;
 					feed_queue_logic_send_trigger(devc->feed_queue);
 					devc->trigger_marked = TRUE;
 					otc_dbg("Trigger position after %" PRIu64 " samples, %.6fms.",
@@ -1411,6 +1444,8 @@ static void send_chunk(struct otc_dev_inst *sdi,
 		while (num_seqs--)
 			(void)read_u8_inc(&rp);
 	}
+	feed_queue_logic_submit_runs(devc->feed_queue,
+		run_values, run_counts, run_count);
 
 	/*
 	 * Check for several conditions which shall terminate the
@@ -1449,26 +1484,20 @@ static void send_chunk(struct otc_dev_inst *sdi,
  * sampled later. After all 16bit entities for all enabled channels
  * were seen, the first enabled channel's next chunk follows.
  *
- * Implementor's note: This routine is inspired by convert_sample_data()
- * in the https://github.com/AlexUg/opentracelab implementation. Which in turn
- * appears to have been derived from the saleae-logic16 opentracelab driver.
- * The code is phrased conservatively to verify the layout as discussed
- * above, performance was not a priority. Operation was verified with an
- * LA2016 device. The LA5032 reportedly shares the 16 samples per channel
- * layout, just round-robins through a potentially larger set of enabled
- * channels before returning to the first of the channels.
+ * Operation was verified with an LA2016 device. The LA5032 reportedly
+ * shares the 16 samples per channel layout, just round-robins through
+ * a potentially larger set of enabled channels before returning to the
+ * first of the channels. The common bit matrix transposer does the
+ * conversion, and keeps incomplete sets of channel chunks across USB
+ * transfers. Input gets processed in slices which fit the conversion
+ * buffer.
  */
 static void stream_data(struct otc_dev_inst *sdi,
 	const uint8_t *data_buffer, size_t data_length)
 {
 	struct dev_context *devc;
 	struct stream_state_t *stream;
-	size_t bit_count;
-	const uint8_t *rp;
-	uint32_t sample_value;
-	uint8_t sample_buff[sizeof(sample_value)];
-	size_t bit_idx;
-	uint32_t ch_mask;
+	size_t slice_max, slice_len, sample_count;
 
 	devc = sdi->priv;
 	stream = &devc->stream;
@@ -1478,43 +1507,35 @@ static void stream_data(struct otc_dev_inst *sdi,
 		return;
 	otc_dbg("Stream mode, got another chunk: %p, length %zu.",
 		data_buffer, data_length);
+	if (!stream->xpose) {
+		otc_err("Stream mode without sample data conversion.");
+		devc->download_finished = TRUE;
+		return;
+	}
 
 	/* TODO Add soft trigger support when in stream mode? */
 
-	/* All channels' chunks carry 16 samples for one channel. */
-	bit_count = 16;
-	data_length /= sizeof(uint16_t);
-
-	rp = data_buffer;
-	sample_value = 0;
-	while (data_length--) {
-		/* Get another entity. */
-		sample_value = read_u16le_inc(&rp);
-
-		/* Map the entity's bits to a channel's samples. */
-		ch_mask = stream->channel_masks[stream->channel_index];
-		for (bit_idx = 0; bit_idx < bit_count; bit_idx++) {
-			if (sample_value & (1UL << bit_idx))
-				stream->sample_data[bit_idx] |= ch_mask;
-		}
-
-		/*
-		 * Advance to the next channel. Submit a block of
-		 * samples when all channels' data was seen.
-		 */
-		stream->channel_index++;
-		if (stream->channel_index != stream->enabled_count)
+	/*
+	 * Each slice completes at most as many sets of channel chunks
+	 * as fit into the conversion buffer, even when a previous
+	 * transfer has left an incomplete set.
+	 */
+	slice_max = LA2016_STREAM_CONV_SAMPLES / 16;
+	slice_max *= stream->enabled_count * sizeof(uint16_t);
+	while (data_length) {
+		slice_len = MIN(data_length, slice_max);
+		sample_count = otc_bit_transpose_run(stream->xpose,
+			data_buffer, slice_len,
+			stream->conv_buffer, sizeof(stream->conv_buffer));
+		data_buffer += slice_len;
+		data_length -= slice_len;
+		if (!sample_count)
 			continue;
-		for (bit_idx = 0; bit_idx < bit_count; bit_idx++) {
-			sample_value = stream->sample_data[bit_idx];
-			write_u32le(sample_buff, sample_value);
-			feed_queue_logic_submit_one(devc->feed_queue,
-				sample_buff, 1);
-		}
-		otc_sw_limits_update_samples_read(&devc->sw_limits, bit_count);
-		devc->total_samples += bit_count;
-		memset(stream->sample_data, 0, sizeof(stream->sample_data));
-		stream->channel_index = 0;
+		feed_queue_logic_submit_many(devc->feed_queue,
+			stream->conv_buffer, sample_count);
+		otc_sw_limits_update_samples_read(&devc->sw_limits,
+			sample_count);
+		devc->total_samples += sample_count;
 	}
 
 	/*
@@ -1697,6 +1718,8 @@ OTC_PRIV int la2016_receive_data(int fd, int revents, void *cb_data)
 		feed_queue_logic_flush(devc->feed_queue);
 		feed_queue_logic_free(devc->feed_queue);
 		devc->feed_queue = NULL;
+		otc_bit_transpose_free(devc->stream.xpose);
+		devc->stream.xpose = NULL;
 		if (devc->frame_begin_sent) {
 			std_session_send_df_frame_end(sdi);
 			devc->frame_begin_sent = FALSE;
@@ -103,6 +103,7 @@
 #define WITH_DEINIT_IN_CLOSE	0
 
 #define LA2016_CONVBUFFER_SIZE	(4 * 1024 * 1024)
+#define LA2016_STREAM_CONV_SAMPLES	4096
 
 struct kingst_model {
 	uint8_t magic, magic2;	/* EEPROM magic byte values. */
@@ -163,8 +164,8 @@ struct dev_context {
 		size_t enabled_count;
 		uint32_t enabled_mask;
 		uint32_t channel_masks[32];
-		size_t channel_index;
-		uint32_t sample_data[32];
+		struct otc_bit_transpose *xpose;
+		uint8_t conv_buffer[LA2016_STREAM_CONV_SAMPLES * sizeof(uint32_t)];
 		uint64_t flush_period_ms;
 		uint64_t last_flushed;
 	} stream;
@@ -158,6 +158,14 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi, int idx)
 
 	devc = sdi->priv;
 
+	devc->idx = idx;
+	otc_ser_framer_free(devc->framer);
+	devc->framer = otc_ser_framer_new(mic_devs[idx].packet_size,
+		SERIAL_BUFSIZE, mic_check_packet, mic_process_packet,
+		(void *)sdi);
+	if (!devc->framer)
+		return OTC_ERR_MALLOC;
+
 	otc_sw_limits_acquisition_start(&devc->limits);
 	std_session_send_df_header(sdi);
 
@@ -168,6 +176,21 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi, int idx)
 	return OTC_OK;
 }
 
+static int dev_acquisition_stop(struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	int ret;
+
+	devc = sdi->priv;
+
+	ret = std_serial_dev_acquisition_stop(sdi);
+
+	otc_ser_framer_free(devc->framer);
+	devc->framer = NULL;
+
+	return ret;
+}
+
 /* Driver-specific API function wrappers */
 #define HW_SCAN(X) \
 static GSList *scan_##X(struct otc_dev_driver *di, GSList *options) { \
@@ -200,7 +223,7 @@ static struct otc_dev_driver ID##_driver_info = { \
 	.dev_open = std_serial_dev_open, \
 	.dev_close = std_serial_dev_close, \
 	.dev_acquisition_start = dev_acquisition_start_##ID_UPPER, \
-	.dev_acquisition_stop = std_serial_dev_acquisition_stop, \
+	.dev_acquisition_stop = dev_acquisition_stop, \
 	.context = NULL, \
 }; \
 OTC_REGISTER_DEV_DRIVER(ID##_driver_info)
@@ -54,13 +54,16 @@ extern OTC_PRIV const struct mic_dev_info mic_devs[];
 struct dev_context {
 	struct otc_sw_limits limits;
 
-	uint8_t buf[SERIAL_BUFSIZE];
-	int bufoffset;
-	int buflen;
+	struct otc_ser_framer *framer;
+	int idx;
 };
 
 OTC_PRIV gboolean packet_valid_temp(const uint8_t *buf);
 OTC_PRIV gboolean packet_valid_temp_hum(const uint8_t *buf);
+OTC_PRIV int mic_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len);
+OTC_PRIV void mic_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len);
 
 OTC_PRIV int receive_data_MIC_98581(int fd, int revents, void *cb_data);
 OTC_PRIV int receive_data_MIC_98583(int fd, int revents, void *cb_data);
@@ -354,6 +354,95 @@ OTC_PRIV void abort_acquisition(const struct otc_dev_inst *sdi)
 	std_session_send_df_end(sdi);
 }
 
+/*
+ * Process a complete sample (or RLE count) which was received from
+ * the device. Stores sample data in the raw sample buffer, in reverse
+ * order. RLE runs get expanded in a single step.
+ */
+static void ols_process_sample(struct dev_context *devc, int num_changroups)
+{
+	uint32_t sample;
+	int offset, j;
+	unsigned int i;
+	uint8_t tmp_sample[4];
+
+	devc->cnt_samples++;
+	devc->cnt_samples_rle++;
+	/*
+	 * Got a full sample. Convert from the OLS's little-endian
+	 * sample to the local format.
+	 */
+	sample = devc->sample[0] | (devc->sample[1] << 8) |
+		 (devc->sample[2] << 16) |
+		 (devc->sample[3] << 24);
+	otc_spew("Received sample 0x%.*x.", devc->num_bytes * 2, sample);
+	if (devc->capture_flags & CAPTURE_FLAG_RLE) {
+		/*
+		 * In RLE mode the high bit of the sample is the
+		 * "count" flag, meaning this sample is the number
+		 * of times the previous sample occurred.
+		 */
+		if (devc->sample[devc->num_bytes - 1] & 0x80) {
+			/* Clear the high bit. */
+			sample &= ~(0x80 << (devc->num_bytes - 1) * 8);
+			devc->rle_count = sample;
+			devc->cnt_samples_rle += devc->rle_count;
+			otc_spew("RLE count: %u.", devc->rle_count);
+			devc->num_bytes = 0;
+			return;
+		}
+	}
+	devc->num_samples += devc->rle_count + 1;
+	if (devc->num_samples > devc->limit_samples) {
+		/* Save us from overrunning the buffer. */
+		devc->rle_count -= devc->num_samples - devc->limit_samples;
+		devc->num_samples = devc->limit_samples;
+	}
+
+	if (num_changroups < 4) {
+		/*
+		 * Some channel groups may have been turned
+		 * off, to speed up transfer between the
+		 * hardware and the PC. Expand that here before
+		 * submitting it over the session bus --
+		 * whatever is listening on the bus will be
+		 * expecting a full sample of devc->unitsize bytes,
+		 * based on the maximum number of channels.
+		 * For simplicity we expand the sample to 32 bits
+		 * little endian, and crop below
+		 */
+		j = 0;
+		memset(tmp_sample, 0, sizeof(tmp_sample));
+		for (i = 0; i < 4; i++) {
+			if (((devc->capture_flags >> 2) & (1 << i)) == 0) {
+				/*
+				 * This channel group was
+				 * enabled, copy from received
+				 * sample.
+				 */
+				tmp_sample[i] = devc->sample[j++];
+			}
+		}
+		memcpy(devc->sample, tmp_sample, 4);
+		otc_spew("Expanded sample: 0x%.2hhx%.2hhx%.2hhx%.2hhx ",
+			devc->sample[3], devc->sample[2],
+			devc->sample[1], devc->sample[0]);
+	}
+
+	/*
+	 * the OLS sends its sample buffer backwards.
+	 * store it in reverse order here, so we can dump
+	 * this on the session bus later.
+	 * Here cropping to devc->unitsize happens
+	 */
+	offset = (devc->limit_samples - devc->num_samples) * devc->unitsize;
+	feed_queue_logic_fill(devc->raw_sample_buf + offset,
+		devc->sample, devc->unitsize, devc->rle_count + 1);
+	memset(devc->sample, 0, 4);
+	devc->num_bytes = 0;
+	devc->rle_count = 0;
+}
+
 OTC_PRIV int ols_receive_data(int fd, int revents, void *cb_data)
 {
 	struct dev_context *devc;
@@ -361,10 +450,9 @@ OTC_PRIV int ols_receive_data(int fd, int revents, void *cb_data)
 	struct otc_serial_dev_inst *serial;
 	struct otc_datafeed_packet packet;
 	struct otc_datafeed_logic logic;
-	uint32_t sample;
-	int num_changroups, offset, j;
+	int num_changroups, len, pos;
 	unsigned int i;
-	unsigned char byte;
+	uint8_t rx_buf[RX_CHUNK_SIZE];
 
 	(void)fd;
 
@@ -395,101 +483,28 @@ OTC_PRIV int ols_receive_data(int fd, int revents, void *cb_data)
 	}
 
 	if (revents == G_IO_IN && devc->num_samples < devc->limit_samples) {
-		if (serial_read_nonblocking(serial, &byte, 1) != 1)
-			return FALSE;
-		devc->cnt_bytes++;
-
-		/* Ignore it if we've read enough. */
-		if (devc->num_samples >= devc->limit_samples)
-			return TRUE;
-
-		devc->sample[devc->num_bytes++] = byte;
-		otc_spew("Received byte 0x%.2x.", byte);
-		if (devc->num_bytes == num_changroups) {
-			devc->cnt_samples++;
-			devc->cnt_samples_rle++;
-			/*
-			 * Got a full sample. Convert from the OLS's little-endian
-			 * sample to the local format.
-			 */
-			sample = devc->sample[0] | (devc->sample[1] << 8) |
-				 (devc->sample[2] << 16) |
-				 (devc->sample[3] << 24);
-			otc_dbg("Received sample 0x%.*x.", devc->num_bytes * 2,
-			       sample);
-			if (devc->capture_flags & CAPTURE_FLAG_RLE) {
-				/*
-				 * In RLE mode the high bit of the sample is the
-				 * "count" flag, meaning this sample is the number
-				 * of times the previous sample occurred.
-				 */
-				if (devc->sample[devc->num_bytes - 1] & 0x80) {
-					/* Clear the high bit. */
-					sample &= ~(0x80 << (devc->num_bytes -
-							     1) * 8);
-					devc->rle_count = sample;
-					devc->cnt_samples_rle +=
-						devc->rle_count;
-					otc_dbg("RLE count: %u.",
-					       devc->rle_count);
-					devc->num_bytes = 0;
-					return TRUE;
-				}
-			}
-			devc->num_samples += devc->rle_count + 1;
-			if (devc->num_samples > devc->limit_samples) {
-				/* Save us from overrunning the buffer. */
-				devc->rle_count -=
-					devc->num_samples - devc->limit_samples;
-				devc->num_samples = devc->limit_samples;
-			}
-
-			if (num_changroups < 4) {
-				/*
-				 * Some channel groups may have been turned
-				 * off, to speed up transfer between the
-				 * hardware and the PC. Expand that here before
-				 * submitting it over the session bus --
-				 * whatever is listening on the bus will be
-				 * expecting a full sample of devc->unitsize bytes,
-				 * based on the maximum number of channels.
-				 * For simplicity we expand the sample to 32 bits
-				 * little endian, and crop below
-				 */
-				j = 0;
-				uint8_t tmp_sample[4] = { 0, 0, 0, 0 };
-				for (i = 0; i < 4; i++) {
-					if (((devc->capture_flags >> 2) &
-					     (1 << i)) == 0) {
-						/*
-						 * This channel group was
-						 * enabled, copy from received
-						 * sample.
-						 */
-						tmp_sample[i] =
-							devc->sample[j++];
-					}
-				}
-				memcpy(devc->sample, tmp_sample, 4);
-				otc_spew("Expanded sample: 0x%.2hhx%.2hhx%.2hhx%.2hhx ",
-					devc->sample[3], devc->sample[2],
-					devc->sample[1], devc->sample[0]);
-			}
-
-			/*
-			 * the OLS sends its sample buffer backwards.
-			 * store it in reverse order here, so we can dump
-			 * this on the session bus later.
-			 * Here cropping to devc->unitsize happens
-			 */
-			offset = (devc->limit_samples - devc->num_samples) * devc->unitsize;
-			for (i = 0; i <= devc->rle_count; i++) {
-				memcpy(devc->raw_sample_buf + offset + (i * devc->unitsize),
-				       devc->sample, devc->unitsize);
+		/*
+		 * Drain all receive data which is available, instead of
+		 * taking one byte per event loop iteration. Samples may
+		 * span reads, the partial sample is kept in the device
+		 * context. Data past the sample count limit is ignored.
+		 */
+		while (devc->num_samples < devc->limit_samples) {
+			len = serial_read_nonblocking(serial,
+				rx_buf, sizeof(rx_buf));
+			if (len < 0)
+				return FALSE;
+			if (!len)
+				break;
+			devc->cnt_bytes += len;
+			for (pos = 0; pos < len; pos++) {
+				devc->sample[devc->num_bytes++] = rx_buf[pos];
+				if (devc->num_bytes != num_changroups)
+					continue;
+				ols_process_sample(devc, num_changroups);
+				if (devc->num_samples >= devc->limit_samples)
+					break;
 			}
-			memset(devc->sample, 0, 4);
-			devc->num_bytes = 0;
-			devc->rle_count = 0;
 		}
 	} else {
 		/*
@@ -32,6 +32,7 @@
 #define CLOCK_RATE                   OTC_MHZ(100)
 #define MIN_NUM_SAMPLES              4
 #define DEFAULT_SAMPLERATE           OTC_KHZ(200)
+#define RX_CHUNK_SIZE                4096
 
 /* Command opcodes */
 #define CMD_RESET                     0x00
@@ -260,6 +260,13 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	devc->buffer_len = 0;
 	devc->memory_state = MEM_STATE_REQUEST_MEMORY_USAGE;
 
+	otc_ser_framer_free(devc->framer);
+	devc->framer = otc_ser_framer_new(BUFFER_SIZE, BUFFER_SIZE,
+		pce_322a_check_packet, pce_322a_process_packet, (void *)sdi);
+	if (!devc->framer)
+		return OTC_ERR_MALLOC;
+	otc_ser_framer_set_sync(devc->framer, 0, (const uint8_t *)"\x7f", 1);
+
 	std_session_send_df_header(sdi);
 
 	serial = sdi->conn;
@@ -269,6 +276,21 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	return OTC_OK;
 }
 
+static int dev_acquisition_stop(struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	int ret;
+
+	devc = sdi->priv;
+
+	ret = std_serial_dev_acquisition_stop(sdi);
+
+	otc_ser_framer_free(devc->framer);
+	devc->framer = NULL;
+
+	return ret;
+}
+
 static struct otc_dev_driver pce_322a_driver_info = {
 	.name = "pce-322a",
 	.longname = "PCE PCE-322A",
@@ -284,7 +306,7 @@ static struct otc_dev_driver pce_322a_driver_info = {
 	.dev_open = dev_open,
 	.dev_close = dev_close,
 	.dev_acquisition_start = dev_acquisition_start,
-	.dev_acquisition_stop = std_serial_dev_acquisition_stop,
+	.dev_acquisition_stop = dev_acquisition_stop,
 	.context = NULL,
 };
 OTC_REGISTER_DEV_DRIVER(pce_322a_driver_info);
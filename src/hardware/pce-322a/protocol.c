@@ -146,24 +146,33 @@ static void process_memory_measurement(const struct otc_dev_inst *sdi)
 	send_data(sdi, value / 10.0);
 }
 
-static void process_byte(const struct otc_dev_inst *sdi, const unsigned char c)
+/** Framer check callback, see otc_ser_framer_new(). */
+OTC_PRIV int pce_322a_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len)
 {
+	(void)cb_data;
+	(void)len;
+
+	if (buf[0] != 0x7f || buf[BUFFER_SIZE - 1] != 0x00)
+		return OTC_PACKET_INVALID;
+	*pkt_len = BUFFER_SIZE;
+
+	return OTC_PACKET_VALID;
+}
+
+/** Framer packet callback, see otc_ser_framer_new(). */
+OTC_PRIV void pce_322a_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len)
+{
+	const struct otc_dev_inst *sdi;
 	struct dev_context *devc;
 
+	sdi = cb_data;
 	devc = sdi->priv;
 
-	if (devc->buffer_len < BUFFER_SIZE) {
-		devc->buffer[devc->buffer_len++] = c;
-	} else {
-		memmove(devc->buffer, devc->buffer + 1, BUFFER_SIZE - 1);
-		devc->buffer[BUFFER_SIZE - 1] = c;
-	}
-
-	if (devc->buffer_len == BUFFER_SIZE && devc->buffer[0] == 0x7f
-			&& devc->buffer[BUFFER_SIZE - 1] == 0x00) {
-		process_measurement(sdi);
-		devc->buffer_len = 0;
-	}
+	memcpy(devc->buffer, buf, len);
+	process_measurement(sdi);
+	devc->buffer_len = 0;
 }
 
 static void process_usage_byte(const struct otc_dev_inst *sdi, uint8_t c)
@@ -317,12 +326,9 @@ OTC_PRIV int pce_322a_receive_data(int fd, int revents, void *cb_data)
 			break;
 		}
 	} else {
-		/* Listen for live data. */
-		if (revents == G_IO_IN) {
-			if (serial_read_nonblocking(serial, &c, 1) != 1)
-				return TRUE;
-			process_byte(sdi, c);
-		}
+		/* Listen for live data, take all available bytes at once. */
+		if (revents == G_IO_IN)
+			otc_ser_framer_receive(devc->framer, serial);
 	}
 
 	return TRUE;
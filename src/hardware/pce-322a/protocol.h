@@ -84,6 +84,7 @@ struct dev_context {
 	uint16_t memory_block_counter; /* Number of memory blocks retrieved so far. */
 	uint8_t memory_block_cursor; /* Number of bytes retrieved in current memory block. */
 
+	struct otc_ser_framer *framer; /* Live data packet search. */
 	uint8_t buffer[BUFFER_SIZE];
 	int buffer_len;
 	int buffer_skip; /* Number of bytes to skip in memory mode. */
@@ -94,6 +95,10 @@ OTC_PRIV int pce_322a_disconnect(const struct otc_dev_inst *sdi);
 OTC_PRIV int pce_322a_memory_status(const struct otc_dev_inst *sdi);
 OTC_PRIV int pce_322a_memory_clear(const struct otc_dev_inst *sdi);
 OTC_PRIV int pce_322a_memory_block(const struct otc_dev_inst *sdi, uint16_t memblk);
+OTC_PRIV int pce_322a_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len);
+OTC_PRIV void pce_322a_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len);
 OTC_PRIV int pce_322a_receive_data(int fd, int revents, void *cb_data);
 OTC_PRIV uint64_t pce_322a_weight_freq_get(const struct otc_dev_inst *sdi);
 OTC_PRIV int pce_322a_weight_freq_set(const struct otc_dev_inst *sdi, uint64_t freqw);
@@ -663,6 +663,18 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 		}
 	}
 
+	/* Digital only captures can skip the expansion of the device's RLE
+	 * codes, and pass the runs to the session */
+	otc_logic_runs_free(devc->runs);
+	devc->runs = NULL;
+	devc->runs_active = FALSE;
+	if ((a_enabled == 0) && (devc->num_d_channels > 0)) {
+		devc->runs = otc_logic_runs_new(sdi, devc->dig_sample_bytes,
+			RUNS_LATENCY_MS);
+		if (!(devc->runs))
+			return OTC_ERR_MALLOC;
+	}
+
 	devc->pretrig_entries = (devc->capture_ratio * devc->limit_samples) / 100;
 	/* While the driver supports the passing of trigger info to the device
 	 * it has been found that the sw overhead of supporting triggering and
@@ -790,6 +802,12 @@ static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 
 	otc_dbg("At dev_acquisition_stop");
 
+	if (devc->runs) {
+		otc_logic_runs_flush(devc->runs);
+		otc_logic_runs_free(devc->runs);
+		devc->runs = NULL;
+	}
+
 	std_session_send_df_end(sdi);
 
 	/* If we reached this while still active it is likely because the stop
@@ -123,6 +123,117 @@ OTC_PRIV int send_serial_w_ack(struct otc_serial_dev_inst *serial, char *str)
 	}
 }
 
+/* Handle the character which ends a D4 data stream */
+static void process_D4_end(struct dev_context *d, uint8_t cbyte)
+{
+	/* Any other character ends parsing - it could be a frame error or a
+	 * start of the final byte cnt */
+	if (cbyte == '$') {
+		otc_info("D4 Data stream stops with cbyte %d char %c rdidx %d cnt %lu",
+			cbyte, cbyte, d->ser_rdptr, d->byte_cnt);
+		d->rxstate = RX_STOPPED;
+	} else {
+		otc_err("D4 Data stream aborts with cbyte %d char %c rdidx %d cnt %lu",
+			cbyte, cbyte, d->ser_rdptr, d->byte_cnt);
+		d->rxstate = RX_ABORT;
+	}
+}
+
+/* Once the trigger fired, digital only captures pass runs to the session.
+ * They continue from the last value process_group() saw, and stop at the
+ * samples that remain to limit_samples. */
+static void runs_begin(struct dev_context *d)
+{
+	if (d->runs_active)
+		return;
+
+	otc_logic_runs_limit(d->runs, (d->limit_samples > d->sent_samples) ?
+		d->limit_samples - d->sent_samples : 0);
+	otc_logic_runs_add(d->runs, d->d_last, 0);
+	d->runs_active = TRUE;
+}
+
+/* Whether the received data has hardly any RLE only bytes. Signals which
+ * change with almost every sample decode faster into d_data_buf than into
+ * runs, so it's decided for each chunk, from its first bytes. */
+static gboolean runs_dense(const struct dev_context *d)
+{
+	uint32_t i, end, rle_bytes = 0;
+
+	end = MIN(d->bytes_avail, d->ser_rdptr + RUNS_DENSE_SCAN);
+	for (i = d->ser_rdptr; i < end; i++)
+		rle_bytes += (d->buffer[i] >= 48) && (d->buffer[i] <= 127);
+
+	return rle_bytes * RUNS_DENSE_RATIO < end - d->ser_rdptr;
+}
+
+/* Whether to pass this chunk's samples as runs. Switching to d_data_buf
+ * sends the held back runs first, to keep the samples in order, and the
+ * next runs_begin() picks up from what process_group() sent. */
+static gboolean runs_use(struct dev_context *d)
+{
+	if (!d->runs || !d->trigger_fired)
+		return FALSE;
+	if (!runs_dense(d))
+		return TRUE;
+
+	if (d->runs_active) {
+		otc_logic_runs_flush(d->runs);
+		d->runs_active = FALSE;
+	}
+	return FALSE;
+}
+
+/* The run-length variant of process_D4, which needs no sample buffer.
+ * Runs get collected in a small table, the first entry continues the
+ * run which the previous call ended with. Sequences of RLE only bytes
+ * just add up, and become a single run. */
+static void process_D4_runs(struct dev_context *d)
+{
+	uint8_t values[D4_RUNS * 4], cbyte;
+	size_t counts[D4_RUNS];
+	uint32_t i, n, dsb;
+	uint64_t samples;
+
+	runs_begin(d);
+	samples = otc_logic_runs_samples(d->runs);
+	dsb = d->dig_sample_bytes;
+
+	/* Only the first byte of a sample changes in this mode */
+	for (i = 0; i < D4_RUNS; i++)
+		memcpy(&values[i * dsb], d->d_last, dsb);
+	counts[0] = 0;
+	n = 1;
+
+	while (d->ser_rdptr < d->bytes_avail) {
+		cbyte = d->buffer[d->ser_rdptr];
+
+		if ((cbyte >= 48) && (cbyte <= 127)) {
+			counts[n - 1] += (cbyte - 47) * 8;
+		} else if (cbyte >= 0x80) {
+			counts[n - 1] += (cbyte & 0x70) >> 4;
+			if (n == D4_RUNS) {
+				otc_logic_runs_add_many(d->runs, values, counts, n);
+				values[0] = values[(n - 1) * dsb];
+				counts[0] = 0;
+				n = 1;
+			}
+			values[n * dsb] = cbyte & 0xF;
+			counts[n++] = 1;
+		} else {
+			process_D4_end(d, cbyte);
+			break;
+		}
+
+		d->byte_cnt++;
+		d->ser_rdptr++;
+	}
+
+	otc_logic_runs_add_many(d->runs, values, counts, n);
+	d->d_last[0] = values[(n - 1) * dsb];
+	d->sent_samples += otc_logic_runs_samples(d->runs) - samples;
+}
+
 /* Process incoming data stream assuming it is optimized packing of 4 channels
  * or less.
  * Each byte is 4 channels of data and a 3 bit rle value, or a larger rle value,
@@ -141,6 +252,11 @@ void process_D4(struct otc_dev_inst *sdi, struct dev_context *d)
 	uint8_t cbyte, cval;
 	uint32_t rlecnt = 0;
 
+	if (runs_use(d)) {
+		process_D4_runs(d);
+		return;
+	}
+
 	while (d->ser_rdptr < d->bytes_avail) {
 		cbyte = d->buffer[(d->ser_rdptr)];
 
@@ -172,17 +288,7 @@ void process_D4(struct otc_dev_inst *sdi, struct dev_context *d)
 			rlecnt = 0;
 			d->d_last[0] = cval;
 		} else {
-			/* Any other character ends parsing - it could be a frame error or a
-			 * start of the final byte cnt */
-			if (cbyte == '$') {
-				otc_info("D4 Data stream stops with cbyte %d char %c rdidx %d cnt %lu",
-					cbyte, cbyte, d->ser_rdptr, d->byte_cnt);
-				d->rxstate = RX_STOPPED;
-			} else {
-				otc_err("D4 Data stream aborts with cbyte %d char %c rdidx %d cnt %lu",
-					cbyte, cbyte, d->ser_rdptr, d->byte_cnt);
-				d->rxstate = RX_ABORT;
-			}
+			process_D4_end(d, cbyte);
 			break;	/* break from while loop */
 		}
 
@@ -232,6 +338,14 @@ void process_slice(struct otc_dev_inst *sdi, struct dev_context *devc)
 	uint32_t tmp32, cword;
 	uint8_t cbyte;
 	uint32_t slice_bytes;	/* Number of bytes that have legal slice values including RLE */
+	uint64_t samples = 0;
+	gboolean use_runs;
+
+	use_runs = runs_use(devc);
+	if (use_runs) {
+		runs_begin(devc);
+		samples = otc_logic_runs_samples(devc->runs);
+	}
 
 	/* Only process legal data values for this mode which are 0x32-0x7F for RLE and 0x80 to 0xFF for data*/
 	for (slice_bytes = 1; (slice_bytes < devc->bytes_avail)
@@ -270,10 +384,12 @@ void process_slice(struct otc_dev_inst *sdi, struct dev_context *devc)
 		else
 			rlecnt = (devc->buffer[devc->ser_rdptr] - 78) * 32;
 
-		otc_info("RLEcnt of %d in %d", rlecnt, devc->buffer[devc->ser_rdptr]);
+		otc_spew("RLEcnt of %d in %d", rlecnt, devc->buffer[devc->ser_rdptr]);
 		if ((rlecnt < 1) || (rlecnt > 1568))
 			otc_err("Bad rlecnt val %d in %d",
 				rlecnt, devc->buffer[devc->ser_rdptr]);
+		else if (use_runs)
+			otc_logic_runs_repeat(devc->runs, rlecnt);
 		else
 			rle_memset(devc,rlecnt);
 
@@ -295,6 +411,11 @@ void process_slice(struct otc_dev_inst *sdi, struct dev_context *devc)
 		devc->d_last[2] = (cword >> 16) & 0xFF;
 		devc->d_last[3] = (cword >> 24) & 0xFF;
 
+		if (use_runs) {
+			otc_logic_runs_add(devc->runs, devc->d_last, 1);
+			continue;
+		}
+
 		for (i = 0; i < devc->num_d_channels; i += 8) {
 			uint32_t idx = ((devc->cbuf_wrptr) * devc->dig_sample_bytes) +
 				(i >> 3);
@@ -344,6 +465,8 @@ void process_slice(struct otc_dev_inst *sdi, struct dev_context *devc)
 		process_group(sdi, devc, devc->cbuf_wrptr);
 	}
 
+	if (use_runs)
+		devc->sent_samples += otc_logic_runs_samples(devc->runs) - samples;
 }
 
 /* Send the processed analog values to the session */
@@ -723,6 +846,8 @@ OTC_PRIV int raspberrypi_pico_receive(int fd, int revents, void *cb_data)
 			len, devc->bytes_avail, devc->sent_samples, devc->wrptr);
 	} else {
 		if (len == 0) {
+			if (devc->runs)
+				otc_logic_runs_poll(devc->runs);
 			return TRUE;
 		} else {
 			otc_err("ERROR: Negative serial read code %d", len);
@@ -815,6 +940,9 @@ OTC_PRIV int raspberrypi_pico_receive(int fd, int revents, void *cb_data)
 		send_serial_char(serial, '+');
 	}
 
+	if (devc->runs)
+		otc_logic_runs_poll(devc->runs);
+
 	otc_spew("Receive function done: sent %u limit %lu wrptr %u len %d",
 		devc->sent_samples, devc->limit_samples, devc->wrptr, len);
 
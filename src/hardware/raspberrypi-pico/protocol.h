@@ -41,6 +41,18 @@
 /* Digits input to otc_analog_init */
 #define ANALOG_DIGITS 4
 
+/* Longest time that run-length samples are held back from the session */
+#define RUNS_LATENCY_MS 100
+
+/* Runs which process_D4 collects before it passes them on */
+#define D4_RUNS 256
+
+/* Received data with less than one RLE only byte in this many is decoded
+ * into d_data_buf, its runs are too short to pass them on */
+#define RUNS_DENSE_RATIO 8
+/* Received bytes which that decision looks at */
+#define RUNS_DENSE_SCAN 512
+
 OTC_PRIV int send_serial_str(struct otc_serial_dev_inst *serial, char *str);
 OTC_PRIV int send_serial_char(struct otc_serial_dev_inst *serial, char ch);
 int send_serial_w_resp(struct otc_serial_dev_inst *serial, char *str,
@@ -131,6 +143,10 @@ struct dev_context {
 	/* Previous sample values to duplicate for rle */
 	float a_last[MAX_ANALOG_CHANNELS];
 	uint8_t d_last[4];
+	/* Digital only captures pass the runs to the session once triggered,
+	 * without expanding them into d_data_buf */
+	struct otc_logic_runs *runs;
+	gboolean runs_active;
 
 	/* SW trigger related */
 	struct soft_trigger_logic *stl;
@@ -644,6 +644,17 @@ static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 	return OTC_OK;
 }
 
+static void clear_helper(struct dev_context *devc)
+{
+	otc_modbus_plan_free(devc->state_plan);
+}
+
+static int dev_clear(const struct otc_dev_driver *di)
+{
+	return std_dev_clear_with_callback(di,
+		(std_dev_clear_callback)clear_helper);
+}
+
 static struct otc_dev_driver rdtech_dps_driver_info = {
 	.name = "rdtech-dps",
 	.longname = "RDTech DPS/DPH series power supply",
@@ -652,7 +663,7 @@ static struct otc_dev_driver rdtech_dps_driver_info = {
 	.cleanup = std_cleanup,
 	.scan = scan_dps,
 	.dev_list = std_dev_list,
-	.dev_clear = std_dev_clear,
+	.dev_clear = dev_clear,
 	.config_get = config_get,
 	.config_set = config_set,
 	.config_list = config_list,
@@ -672,7 +683,7 @@ static struct otc_dev_driver rdtech_rd_driver_info = {
 	.cleanup = std_cleanup,
 	.scan = scan_rd,
 	.dev_list = std_dev_list,
-	.dev_clear = std_dev_clear,
+	.dev_clear = dev_clear,
 	.config_get = config_get,
 	.config_set = config_set,
 	.config_list = config_list,
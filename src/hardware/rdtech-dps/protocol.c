@@ -127,6 +127,66 @@ static int rdtech_dps_read_holding_registers(struct otc_modbus_dev_inst *modbus,
 	return ret;
 }
 
+/*
+ * The state query polls the setpoints, the measurements, the status
+ * flags, and the protection thresholds. The plan merges the adjacent
+ * groups into one request, the thresholds are too far apart and take
+ * another. RD models leave register 15 unused between the measurements
+ * and the status flags, which they accept reads of.
+ */
+static struct otc_modbus_plan *rdtech_dps_state_plan(struct dev_context *devc)
+{
+	struct otc_modbus_plan *plan;
+
+	if (devc->state_plan)
+		return devc->state_plan;
+
+	switch (devc->model.rdtech_model->model_type) {
+	case MODEL_DPS:
+		plan = otc_modbus_plan_new(0);
+		otc_modbus_plan_add(plan, REG_DPS_USET, 2);
+		otc_modbus_plan_add(plan, REG_DPS_UOUT,
+			REG_DPS_UIN - REG_DPS_UOUT + 1);
+		otc_modbus_plan_add(plan, REG_DPS_LOCK,
+			REG_DPS_ENABLE - REG_DPS_LOCK + 1);
+		otc_modbus_plan_add(plan, PRE_DPS_OVPSET, 2);
+		break;
+	case MODEL_RD:
+		plan = otc_modbus_plan_new(1);
+		otc_modbus_plan_add(plan, REG_RD_VOLT_TGT, 2);
+		otc_modbus_plan_add(plan, REG_RD_VOLTAGE,
+			REG_RD_VOLT_IN - REG_RD_VOLTAGE + 1);
+		otc_modbus_plan_add(plan, REG_RD_PROTECT,
+			REG_RD_ENABLE - REG_RD_PROTECT + 1);
+		if (devc->model.rdtech_model->n_ranges > 1)
+			otc_modbus_plan_add(plan, REG_RD_PRESET, 2);
+		otc_modbus_plan_add(plan, REG_RD_OVP_THR, 2);
+		break;
+	default:
+		return NULL;
+	}
+	devc->state_plan = plan;
+
+	return plan;
+}
+
+/* Retries failed polling cycles like individual reads above. */
+static int rdtech_dps_run_plan(struct otc_modbus_dev_inst *modbus,
+	struct otc_modbus_plan *plan)
+{
+	size_t retries;
+	int ret;
+
+	retries = 3;
+	while (retries--) {
+		ret = otc_modbus_plan_run(modbus, plan);
+		if (ret == OTC_OK)
+			return ret;
+	}
+
+	return ret;
+}
+
 /* Set one 16bit register. LE format for DPS devices. */
 static int rdtech_dps_set_reg(const struct otc_dev_inst *sdi,
 	uint16_t address, uint16_t value)
@@ -310,6 +370,7 @@ OTC_PRIV int rdtech_dps_get_state(const struct otc_dev_inst *sdi,
 {
 	struct dev_context *devc;
 	struct otc_modbus_dev_inst *modbus;
+	struct otc_modbus_plan *plan;
 	gboolean get_config, get_init_state, get_curr_meas;
 	uint16_t registers[14];
 	int ret;
@@ -366,21 +427,33 @@ OTC_PRIV int rdtech_dps_get_state(const struct otc_dev_inst *sdi,
 	if (!have_range)
 		range = 0;
 
+	/*
+	 * Fetch all of the model's state registers in one polling cycle.
+	 * Both register chunks are in flight at the same time when the
+	 * transport supports it (Modbus/TCP).
+	 */
+	plan = rdtech_dps_state_plan(devc);
+	if (!plan)
+		return OTC_ERR_ARG;
+	g_mutex_lock(&devc->rw_mutex);
+	ret = rdtech_dps_run_plan(modbus, plan);
+	g_mutex_unlock(&devc->rw_mutex);
+	if (ret != OTC_OK)
+		return ret;
+
 	switch (devc->model.rdtech_model->model_type) {
 	case MODEL_DPS:
 		/*
-		 * Transfer a chunk of registers in a single call. It's
-		 * unfortunate that the model dependency and the sparse
-		 * register map force us to open code addresses, sizes,
-		 * and the sequence of the registers and how to interpret
-		 * their bit fields. But then this is not too unusual for
-		 * a hardware specific device driver ...
+		 * Interpret a chunk of registers. It's unfortunate that
+		 * the model dependency and the sparse register map force
+		 * us to open code addresses, sizes, and the sequence of
+		 * the registers and how to interpret their bit fields.
+		 * But then this is not too unusual for a hardware specific
+		 * device driver ...
 		 */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
+		ret = otc_modbus_plan_get(plan,
 			REG_DPS_USET, REG_DPS_ENABLE - REG_DPS_USET + 1,
 			registers);
-		g_mutex_unlock(&devc->rw_mutex);
 		if (ret != OTC_OK)
 			return ret;
 
@@ -407,11 +480,8 @@ OTC_PRIV int rdtech_dps_get_state(const struct otc_dev_inst *sdi,
 		out_state = read_u16be_inc(&rdptr); /* ENABLE */
 		is_out_enabled = out_state != 0;
 
-		/* Transfer another chunk of registers in a single call. */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
-			PRE_DPS_OVPSET, 2, registers);
-		g_mutex_unlock(&devc->rw_mutex);
+		/* Pick the second chunk of registers. */
+		ret = otc_modbus_plan_get(plan, PRE_DPS_OVPSET, 2, registers);
 		if (ret != OTC_OK)
 			return ret;
 
@@ -425,15 +495,13 @@ OTC_PRIV int rdtech_dps_get_state(const struct otc_dev_inst *sdi,
 		break;
 
 	case MODEL_RD:
-		/* Retrieve a set of adjacent registers. */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
+		/* Pick a set of adjacent registers. */
+		ret = otc_modbus_plan_get(plan,
 			REG_RD_VOLT_TGT,
 			devc->model.rdtech_model->n_ranges > 1
 				? REG_RD_RANGE - REG_RD_VOLT_TGT + 1
 				: REG_RD_ENABLE - REG_RD_VOLT_TGT + 1,
 			registers);
-		g_mutex_unlock(&devc->rw_mutex);
 		if (ret != OTC_OK)
 			return ret;
 
@@ -464,11 +532,8 @@ OTC_PRIV int rdtech_dps_get_state(const struct otc_dev_inst *sdi,
 			range = read_u16be_inc(&rdptr) ? 1 : 0; /* RANGE */
 		}
 
-		/* Retrieve a set of adjacent registers. */
-		g_mutex_lock(&devc->rw_mutex);
-		ret = rdtech_dps_read_holding_registers(modbus,
-			REG_RD_OVP_THR, 2, registers);
-		g_mutex_unlock(&devc->rw_mutex);
+		/* Pick the protection thresholds. */
+		ret = otc_modbus_plan_get(plan, REG_RD_OVP_THR, 2, registers);
 		if (ret != OTC_OK)
 			return ret;
 
@@ -77,6 +77,7 @@ struct dev_context {
 	double power_multiplier;
 	struct otc_sw_limits limits;
 	GMutex rw_mutex;
+	struct otc_modbus_plan *state_plan;
 	gboolean curr_ovp_state;
 	gboolean curr_ocp_state;
 	gboolean curr_cc_state;
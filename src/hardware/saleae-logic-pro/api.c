@@ -408,6 +408,11 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 
 	usb = sdi->conn;
 
+	/* Each batch carries 32 samples per enabled channel, MSB first. */
+	devc->xpose = otc_bit_transpose_new(32, TRUE, 2,
+		devc->dig_channel_masks, devc->dig_channel_cnt);
+	if (!devc->xpose)
+		return OTC_ERR_ARG;
 	devc->conv_buffer = g_malloc(CONV_BUFFER_SIZE);
 
 	devc->num_transfers = BUF_COUNT;
@@ -453,6 +458,8 @@ static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 	usb_source_remove(sdi->session, drvc->otc_ctx);
 
 	g_free(devc->conv_buffer);
+	otc_bit_transpose_free(devc->xpose);
+	devc->xpose = NULL;
 
 	return OTC_OK;
 }
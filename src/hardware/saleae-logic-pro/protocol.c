@@ -796,7 +796,7 @@ OTC_PRIV int saleae_logic_pro_start(const struct otc_dev_inst *sdi)
 	struct dev_context *devc = sdi->priv;
 
 	devc->conv_size = 0;
-	devc->batch_index = 0;
+	otc_bit_transpose_reset(devc->xpose);
 
 	write_reg(sdi, 0x00, 0x01);
 
@@ -846,43 +846,14 @@ static void saleae_logic_pro_send_data(const struct otc_dev_inst *sdi,
  * This stream of batches is packed into USB packets with 16384 bytes each.
  */
 static void saleae_logic_pro_convert_data(const struct otc_dev_inst *sdi,
-					 const uint32_t *src, size_t srccnt)
+					 const uint8_t *src, size_t srclen)
 {
 	struct dev_context *devc = sdi->priv;
-	uint8_t *dst = devc->conv_buffer;
-	uint32_t samples;
-	uint16_t channel_mask;
-	unsigned int sample_index, batch_index;
-	uint16_t *dst_batch;
-
-	/* Copy partial batch to the beginning. */
-	memcpy(dst, dst + devc->conv_size, CONV_BATCH_SIZE);
-	/* Reset converted size. */
-	devc->conv_size = 0;
+	size_t samples;
 
-	batch_index = devc->batch_index;
-	while (srccnt--) {
-		samples = *src++;
-		dst_batch = (uint16_t*)dst;
-
-		/* First index of the batch. */
-		if (batch_index == 0)
-			memset(dst, 0, CONV_BATCH_SIZE);
-
-		/* Convert one channel. */
-		channel_mask = devc->dig_channel_masks[batch_index];
-		for (sample_index = 0; sample_index <= 31; sample_index++)
-			if ((samples >> (31 - sample_index)) & 1)
-				dst_batch[sample_index] |= channel_mask;
-
-		/* Last index of the batch. */
-		if (++batch_index == devc->dig_channel_cnt) {
-			devc->conv_size += CONV_BATCH_SIZE;
-			batch_index = 0;
-			dst += CONV_BATCH_SIZE;
-		}
-	}
-	devc->batch_index = batch_index;
+	samples = otc_bit_transpose_run(devc->xpose, src, srclen,
+		devc->conv_buffer, CONV_BUFFER_SIZE);
+	devc->conv_size = samples * 2;
 }
 
 OTC_PRIV void LIBUSB_CALL saleae_logic_pro_receive_data(struct libusb_transfer *transfer)
@@ -903,7 +874,7 @@ OTC_PRIV void LIBUSB_CALL saleae_logic_pro_receive_data(struct libusb_transfer *
 		return;
 	}
 
-	saleae_logic_pro_convert_data(sdi, (uint32_t*)transfer->buffer, 16 * 1024 / 4);
+	saleae_logic_pro_convert_data(sdi, transfer->buffer, 16 * 1024);
 	saleae_logic_pro_send_data(sdi, devc->conv_buffer, devc->conv_size, 2);
 
 	if ((ret = libusb_submit_transfer(transfer)) != LIBUSB_SUCCESS)
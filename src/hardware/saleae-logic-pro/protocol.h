@@ -31,15 +31,16 @@
 #define CONV_BATCH_SIZE (2 * 32)
 
 /*
- * One packet + one partial conversion: Worst case is only one active
- * channel converted to 2 bytes per sample, with 8 * 16384 samples per packet.
+ * One packet worth of complete batches: Worst case is only one active
+ * channel converted to 2 bytes per sample, with 8 * 16384 samples per
+ * packet. Partial batches are kept by the transposer.
  */
 #define CONV_BUFFER_SIZE (2 * 8 * 16384 + CONV_BATCH_SIZE)
 
 struct dev_context {
 	unsigned int dig_channel_cnt;
 	uint16_t dig_channel_mask;
-	uint16_t dig_channel_masks[16];
+	uint32_t dig_channel_masks[16];
 	uint64_t dig_samplerate;
 
 	uint32_t lfsr;
@@ -48,9 +49,9 @@ struct dev_context {
 	unsigned int submitted_transfers;
 	struct libusb_transfer **transfers;
 
+	struct otc_bit_transpose *xpose;
 	uint8_t *conv_buffer;
 	unsigned int conv_size;
-	unsigned int batch_index;
 };
 
 OTC_PRIV int saleae_logic_pro_init(const struct otc_dev_inst *sdi);
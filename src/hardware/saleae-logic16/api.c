@@ -578,16 +578,6 @@ static int configure_channels(const struct otc_dev_inst *sdi)
 		channel_bit = 1 << (ch->index);
 
 		devc->cur_channels |= channel_bit;
-
-#ifdef WORDS_BIGENDIAN
-		/*
-		 * Output logic data should be stored in little endian format.
-		 * To speed things up during conversion, do the switcharoo
-		 * here instead.
-		 */
-		channel_bit = 1 << (ch->index ^ 8);
-#endif
-
 		devc->channel_masks[devc->num_channels++] = channel_bit;
 	}
 
@@ -646,8 +636,6 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 
 	devc->sent_samples = 0;
 	devc->empty_transfer_count = 0;
-	devc->cur_channel = 0;
-	memset(devc->channel_data, 0, sizeof(devc->channel_data));
 
 	if ((trigger = otc_session_trigger_get(sdi->session))) {
 		int pre_trigger_samples = 0;
@@ -666,9 +654,17 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	convsize = (size / devc->num_channels + 2) * 16;
 	devc->submitted_transfers = 0;
 
+	/* The device sends 16 samples per enabled channel, MSB first. */
+	devc->xpose = otc_bit_transpose_new(16, TRUE, 2,
+		devc->channel_masks, devc->num_channels);
+	if (!devc->xpose)
+		return OTC_ERR_ARG;
+
 	devc->convbuffer_size = convsize;
 	if (!(devc->convbuffer = g_try_malloc(convsize))) {
 		otc_err("Conversion buffer malloc failed.");
+		otc_bit_transpose_free(devc->xpose);
+		devc->xpose = NULL;
 		return OTC_ERR_MALLOC;
 	}
 
@@ -676,6 +672,8 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	if (!devc->transfers) {
 		otc_err("USB transfers malloc failed.");
 		g_free(devc->convbuffer);
+		otc_bit_transpose_free(devc->xpose);
+		devc->xpose = NULL;
 		return OTC_ERR_MALLOC;
 	}
 
@@ -683,6 +681,8 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 					     devc->cur_channels)) != OTC_OK) {
 		g_free(devc->transfers);
 		g_free(devc->convbuffer);
+		otc_bit_transpose_free(devc->xpose);
+		devc->xpose = NULL;
 		return ret;
 	}
 
@@ -695,6 +695,8 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 			else {
 				g_free(devc->transfers);
 				g_free(devc->convbuffer);
+				otc_bit_transpose_free(devc->xpose);
+				devc->xpose = NULL;
 			}
 			return OTC_ERR_MALLOC;
 		}
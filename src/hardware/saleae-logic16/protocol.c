@@ -759,6 +759,8 @@ static void finish_acquisition(struct otc_dev_inst *sdi)
 	devc->num_transfers = 0;
 	g_free(devc->transfers);
 	g_free(devc->convbuffer);
+	otc_bit_transpose_free(devc->xpose);
+	devc->xpose = NULL;
 	if (devc->stl) {
 		soft_trigger_logic_free(devc->stl);
 		devc->stl = NULL;
@@ -803,48 +805,6 @@ static void resubmit_transfer(struct libusb_transfer *transfer)
 	otc_err("%s: %s", __func__, libusb_error_name(ret));
 }
 
-static size_t convert_sample_data(struct dev_context *devc,
-		uint8_t *dest, size_t destcnt, const uint8_t *src, size_t srccnt)
-{
-	uint16_t *channel_data;
-	int i, cur_channel;
-	size_t ret = 0;
-	uint16_t sample, channel_mask;
-
-	srccnt /= 2;
-
-	channel_data = devc->channel_data;
-	cur_channel = devc->cur_channel;
-
-	while (srccnt--) {
-		sample = src[0] | (src[1] << 8);
-		src += 2;
-
-		channel_mask = devc->channel_masks[cur_channel];
-
-		for (i = 15; i >= 0; --i, sample >>= 1)
-			if (sample & 1)
-				channel_data[i] |= channel_mask;
-
-		if (++cur_channel == devc->num_channels) {
-			cur_channel = 0;
-			if (destcnt < 16 * 2) {
-				otc_err("Conversion buffer too small!");
-				break;
-			}
-			memcpy(dest, channel_data, 16 * 2);
-			memset(channel_data, 0, 16 * 2);
-			dest += 16 * 2;
-			ret += 16;
-			destcnt -= 16 * 2;
-		}
-	}
-
-	devc->cur_channel = cur_channel;
-
-	return ret;
-}
-
 OTC_PRIV void LIBUSB_CALL logic16_receive_transfer(struct libusb_transfer *transfer)
 {
 	gboolean packet_has_error = FALSE;
@@ -909,8 +869,9 @@ OTC_PRIV void LIBUSB_CALL logic16_receive_transfer(struct libusb_transfer *trans
 		devc->empty_transfer_count = 0;
 	}
 
-	new_samples = convert_sample_data(devc, devc->convbuffer,
-			devc->convbuffer_size, transfer->buffer, transfer->actual_length);
+	new_samples = otc_bit_transpose_run(devc->xpose,
+			transfer->buffer, transfer->actual_length,
+			devc->convbuffer, devc->convbuffer_size);
 
 	if (new_samples <= 0) {
 		resubmit_transfer(transfer);
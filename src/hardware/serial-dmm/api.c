@@ -264,16 +264,31 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	otc_receive_data_callback cb_func;
 	void *cb_data;
 	int ret;
+	size_t sync_offset, sync_len;
 	struct otc_serial_dev_inst *serial;
 
 	devc = sdi->priv;
+	dmm = (struct dmm_info *)sdi->driver;
+
+	otc_ser_framer_free(devc->framer);
+	devc->framer = otc_ser_framer_new(dmm->packet_size, DMM_BUFSIZE,
+		serial_dmm_check_packet, serial_dmm_process_packet, (void *)sdi);
+	if (!devc->framer)
+		return OTC_ERR_MALLOC;
+	devc->layout = dmm_layout_lookup(dmm);
+	if (devc->layout && otc_dmm_layout_sync(devc->layout,
+			&sync_offset, &sync_len, sizeof(devc->framer->sync))) {
+		otc_ser_framer_set_sync(devc->framer, sync_offset,
+			&devc->layout->value[sync_offset], sync_len);
+	}
+	g_free(devc->info);
+	devc->info = g_malloc(dmm->info_size);
 
 	otc_sw_limits_acquisition_start(&devc->limits);
 	std_session_send_df_header(sdi);
 
 	cb_func = receive_data;
 	cb_data = (void *)sdi;
-	dmm = (struct dmm_info *)sdi->driver;
 	if (dmm && dmm->acquire_start) {
 		ret = dmm->acquire_start(dmm->dmm_state, sdi,
 			&cb_func, &cb_data);
@@ -288,6 +303,23 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	return OTC_OK;
 }
 
+static int dev_acquisition_stop(struct otc_dev_inst *sdi)
+{
+	struct dev_context *devc;
+	int ret;
+
+	devc = sdi->priv;
+
+	ret = std_serial_dev_acquisition_stop(sdi);
+
+	otc_ser_framer_free(devc->framer);
+	devc->framer = NULL;
+	g_free(devc->info);
+	devc->info = NULL;
+
+	return ret;
+}
+
 #define DMM_ENTRY(ID, CHIPSET, VENDOR, MODEL, \
 		CONN, SERIALCOMM, PACKETSIZE, TIMEOUT, DELAY, \
 		OPEN, REQUEST, VALID, PARSE, DETAILS, \
@@ -309,7 +341,7 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 			.dev_open = std_serial_dev_open, \
 			.dev_close = std_serial_dev_close, \
 			.dev_acquisition_start = dev_acquisition_start, \
-			.dev_acquisition_stop = std_serial_dev_acquisition_stop, \
+			.dev_acquisition_stop = dev_acquisition_stop, \
 			.context = NULL, \
 		}, \
 		VENDOR, MODEL, CONN, SERIALCOMM, PACKETSIZE, TIMEOUT, DELAY, \
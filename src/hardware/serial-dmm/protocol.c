@@ -138,100 +138,104 @@ OTC_PRIV int req_packet(struct otc_dev_inst *sdi)
 	return OTC_OK;
 }
 
-static void handle_new_data(struct otc_dev_inst *sdi, void *info)
+/*
+ * Fixed packet fields of chip parsers. Lets the receive path search for
+ * sync bytes in bulk, and reject misaligned positions before the chip's
+ * validity check runs.
+ */
+static const struct {
+	packet_valid_callback packet_valid;
+	const struct otc_dmm_layout *layout;
+} dmm_layouts[] = {
+	{ otc_asycii_packet_valid, &otc_asycii_layout, },
+	{ otc_brymen_bm25x_packet_valid, &otc_brymen_bm25x_layout, },
+	{ otc_brymen_bm86x_packet_valid, &otc_brymen_bm86x_layout, },
+	{ otc_digitech_qm1578_packet_valid, &otc_digitech_qm1578_layout, },
+	{ otc_dtm0660_packet_valid, &otc_dtm0660_layout, },
+	{ otc_eev121gw_packet_valid, &otc_eev121gw_layout, },
+	{ otc_es519xx_2400_11b_packet_valid, &otc_es519xx_11b_layout, },
+	{ otc_es519xx_19200_11b_packet_valid, &otc_es519xx_11b_layout, },
+	{ otc_es519xx_19200_14b_packet_valid, &otc_es519xx_14b_layout, },
+	{ otc_fs9721_packet_valid, &otc_fs9721_layout, },
+	{ otc_fs9922_packet_valid, &otc_fs9922_layout, },
+	{ otc_m2110_packet_valid, &otc_m2110_layout, },
+	{ meterman_38xr_packet_valid, &meterman_38xr_layout, },
+	{ otc_metex14_packet_valid, &otc_metex14_layout, },
+	{ otc_metex14_4packets_valid, &otc_metex14_4packets_layout, },
+	{ otc_ms2115b_packet_valid, &otc_ms2115b_layout, },
+	{ otc_ms8250d_packet_valid, &otc_ms8250d_layout, },
+	{ otc_ut71x_packet_valid, &otc_ut71x_layout, },
+	{ otc_vc870_packet_valid, &otc_vc870_layout, },
+	{ otc_vc96_packet_valid, &otc_vc96_layout, },
+};
+
+/** Lookup the fixed packet fields of a DMM's chip, if known. */
+OTC_PRIV const struct otc_dmm_layout *dmm_layout_lookup(
+	const struct dmm_info *dmm)
+{
+	size_t idx;
+
+	if (!dmm->packet_valid)
+		return NULL;
+	for (idx = 0; idx < ARRAY_SIZE(dmm_layouts); idx++) {
+		if (dmm_layouts[idx].packet_valid != dmm->packet_valid)
+			continue;
+		if (dmm_layouts[idx].layout->packet_size != dmm->packet_size)
+			return NULL;
+		return dmm_layouts[idx].layout;
+	}
+
+	return NULL;
+}
+
+/** Framer check callback, see otc_ser_framer_new(). */
+OTC_PRIV int serial_dmm_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len)
 {
+	struct otc_dev_inst *sdi;
 	struct dmm_info *dmm;
 	struct dev_context *devc;
-	struct otc_serial_dev_inst *serial;
-	int ret;
-	size_t read_len, check_pos, check_len, pkt_size, copy_len;
-	uint8_t *check_ptr;
-	uint64_t deadline;
 
+	sdi = cb_data;
 	dmm = (struct dmm_info *)sdi->driver;
-
 	devc = sdi->priv;
-	serial = sdi->conn;
 
-	/* Add the maximum available RX data we can get to the local buffer. */
-	read_len = DMM_BUFSIZE - devc->buflen;
-	ret = serial_read_nonblocking(serial, &devc->buf[devc->buflen], read_len);
-	if (ret == 0)
-		return; /* No new bytes, nothing to do. */
-	if (ret < 0) {
-		otc_err("Serial port read error: %d.", ret);
-		return;
+	if (devc->layout && !otc_dmm_layout_match(devc->layout, buf))
+		return OTC_PACKET_INVALID;
+	if (dmm->packet_valid_len)
+		return dmm->packet_valid_len(dmm->dmm_state, buf, len, pkt_len);
+	if (dmm->packet_valid && dmm->packet_valid(buf)) {
+		*pkt_len = dmm->packet_size;
+		return OTC_PACKET_VALID;
 	}
-	devc->buflen += ret;
-
-	/*
-	 * Process packets when their reception has completed, or keep
-	 * trying to synchronize to the stream of input data.
-	 */
-	check_pos = 0;
-	while (check_pos < devc->buflen) {
-		/* Got the (minimum) amount of receive data for a packet? */
-		check_len = devc->buflen - check_pos;
-		if (check_len < dmm->packet_size)
-			break;
-		otc_dbg("Checking: pos %zu, len %zu.", check_pos, check_len);
-
-		/* Is it a valid packet? */
-		check_ptr = &devc->buf[check_pos];
-		if (dmm->packet_valid_len) {
-			ret = dmm->packet_valid_len(dmm->dmm_state,
-				check_ptr, check_len, &pkt_size);
-			if (ret == OTC_PACKET_NEED_RX) {
-				otc_dbg("Need more RX data.");
-				break;
-			}
-			if (ret == OTC_PACKET_INVALID) {
-				otc_dbg("Not a valid packet, searching.");
-				check_pos++;
-				continue;
-			}
-		} else if (dmm->packet_valid) {
-			if (!dmm->packet_valid(check_ptr)) {
-				otc_dbg("Not a valid packet, searching.");
-				check_pos++;
-				continue;
-			}
-			pkt_size = dmm->packet_size;
-		}
 
-		/* Process the packet. */
-		otc_dbg("Valid packet, size %zu, processing", pkt_size);
-		handle_packet(sdi, check_ptr, pkt_size, info);
-		check_pos += pkt_size;
+	return OTC_PACKET_INVALID;
+}
 
-		/* Arrange for the next packet request if needed. */
-		if (!dmm->packet_request)
-			continue;
-		if (dmm->req_timeout_ms || dmm->req_delay_ms) {
-			deadline = g_get_monotonic_time();
-			deadline += dmm->req_delay_ms * 1000;
-			devc->req_next_at = deadline;
-		}
-		req_packet(sdi);
-		continue;
-	}
+/** Framer packet callback, see otc_ser_framer_new(). */
+OTC_PRIV void serial_dmm_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len)
+{
+	struct otc_dev_inst *sdi;
+	struct dmm_info *dmm;
+	struct dev_context *devc;
+	uint64_t deadline;
 
-	/* If we have any data left, move it to the beginning of our buffer. */
-	if (devc->buflen > check_pos) {
-		copy_len = devc->buflen - check_pos;
-		memmove(&devc->buf[0], &devc->buf[check_pos], copy_len);
-	}
-	devc->buflen -= check_pos;
-
-	/*
-	 * If the complete buffer filled up and none of it got processed,
-	 * discard the unprocessed buffer, re-sync to the stream in later
-	 * calls again.
-	 */
-	if (devc->buflen == sizeof(devc->buf)) {
-		otc_info("Drop unprocessed RX data, try to re-sync to stream.");
-		devc->buflen = 0;
+	sdi = cb_data;
+	dmm = (struct dmm_info *)sdi->driver;
+	devc = sdi->priv;
+
+	handle_packet(sdi, buf, len, devc->info);
+
+	/* Arrange for the next packet request if needed. */
+	if (!dmm->packet_request)
+		return;
+	if (dmm->req_timeout_ms || dmm->req_delay_ms) {
+		deadline = g_get_monotonic_time();
+		deadline += dmm->req_delay_ms * 1000;
+		devc->req_next_at = deadline;
 	}
+	req_packet(sdi);
 }
 
 int receive_data(int fd, int revents, void *cb_data)
@@ -239,7 +243,6 @@ int receive_data(int fd, int revents, void *cb_data)
 	struct otc_dev_inst *sdi;
 	struct dev_context *devc;
 	struct dmm_info *dmm;
-	void *info;
 
 	(void)fd;
 
@@ -253,9 +256,7 @@ int receive_data(int fd, int revents, void *cb_data)
 
 	if (revents == G_IO_IN) {
 		/* Serial data arrived. */
-		info = g_malloc(dmm->info_size);
-		handle_new_data(sdi, info);
-		g_free(info);
+		otc_ser_framer_receive(devc->framer, sdi->conn);
 	} else {
 		/* Timeout; send another packet request if DMM needs it. */
 		if (dmm->packet_request && (req_packet(sdi) < 0))
@@ -85,8 +85,12 @@ struct dmm_info {
 struct dev_context {
 	struct otc_sw_limits limits;
 
-	uint8_t buf[DMM_BUFSIZE];
-	size_t buflen;
+	/** Receive buffer and packet search, see otc_ser_framer_new(). */
+	struct otc_ser_framer *framer;
+	/** Fixed packet fields of the DMM's chip, or NULL. */
+	const struct otc_dmm_layout *layout;
+	/** Parser specific details of the most recent packet. */
+	void *info;
 
 	/**
 	 * The timestamp [µs] to send the next request.
@@ -96,6 +100,12 @@ struct dev_context {
 };
 
 OTC_PRIV int req_packet(struct otc_dev_inst *sdi);
+OTC_PRIV const struct otc_dmm_layout *dmm_layout_lookup(
+	const struct dmm_info *dmm);
+OTC_PRIV int serial_dmm_check_packet(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len);
+OTC_PRIV void serial_dmm_process_packet(void *cb_data,
+	const uint8_t *buf, size_t len);
 OTC_PRIV int receive_data(int fd, int revents, void *cb_data);
 
 #endif
@@ -387,6 +387,14 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 	devc->last_sample = 0;
 	devc->last_timestamp = 0;
 
+	otc_logic_runs_free(devc->runs);
+	devc->runs = NULL;
+	if (devc->RLE_mode) {
+		devc->runs = otc_logic_runs_new(sdi, 2, RUNS_LATENCY_MS);
+		if (!devc->runs)
+			return OTC_ERR_MALLOC;
+	}
+
 	otc_scpi_source_add(sdi->session, scpi, G_IO_IN, 50,
 			tlf_receive_data, (void *)sdi);
 
@@ -400,7 +408,15 @@ static int dev_acquisition_start(const struct otc_dev_inst *sdi)
 
 static int dev_acquisition_stop(struct otc_dev_inst *sdi)
 {
+	struct dev_context *devc;
+
 	otc_spew("-> Enter dev_acquisition_stop");
+	devc = sdi->priv;
+	if (devc->runs) {
+		otc_logic_runs_flush(devc->runs);
+		otc_logic_runs_free(devc->runs);
+		devc->runs = NULL;
+	}
 	std_session_send_df_frame_end(sdi);
 	otc_scpi_source_remove(sdi->session, sdi->conn);
 	tlf_exec_stop(sdi);
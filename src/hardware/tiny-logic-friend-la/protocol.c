@@ -374,9 +374,9 @@ OTC_PRIV int tlf_receive_data(int fd, int revents, void *cb_data)
 	struct otc_datafeed_packet packet;
 	struct otc_datafeed_logic logic;
 
-	unsigned int rle_buffer_size = 12;
 	uint32_t timestamp;
 	uint16_t value;
+	uint8_t sample[2];
 
 	(void)revents;
 	(void)fd;
@@ -428,45 +428,24 @@ OTC_PRIV int tlf_receive_data(int fd, int revents, void *cb_data)
 	logic.unitsize = 2;
 
 	if (devc->RLE_mode) {
-		for (int i = 0; i < chunk_len; i = i + 4) {
-			timestamp = (((uint8_t)devc->receive_buffer[i + 1]) << 8) | ((uint8_t)devc->receive_buffer[i]);
-			value = (((uint8_t)devc->receive_buffer[i + 3]) << 8) | ((uint8_t)devc->receive_buffer[i + 2]);
-		}
-
-		if (devc->measured_samples == 0) {
-			devc->raw_sample_buf = g_try_malloc(rle_buffer_size * 2);
-			if (!devc->raw_sample_buf) {
-				otc_err("Sample buffer malloc failed.");
-				return FALSE;
-			}
-		}
-
-		logic.data = devc->raw_sample_buf;
-
-		for (int i = 0; i < chunk_len; i = i + 4) {
+		/* Each record holds a timestamp and the value which starts
+		 * there, the previous value lasts until that timestamp. */
+		for (int i = 0; i + 4 <= chunk_len; i = i + 4) {
 			timestamp = (((uint8_t)devc->receive_buffer[i + 1]) << 8) | ((uint8_t)devc->receive_buffer[i]);
 			value = (((uint8_t)devc->receive_buffer[i + 3]) << 8) | ((uint8_t)devc->receive_buffer[i + 2]);
 			samples_sent++;
 
-			otc_spew("devc->measured_samples: %zu", devc->measured_samples);
-
-			for (int32_t tick = devc->last_timestamp; tick < (int32_t)timestamp; tick++) {
-				((uint16_t *)devc->raw_sample_buf)[devc->pending_samples] = devc->last_sample;
-				devc->measured_samples++;
-				devc->pending_samples++;
-
-				if (devc->pending_samples == rle_buffer_size) {
-					logic.length = devc->pending_samples * 2;
-					if (logic.data == NULL) {
-						otc_spew("tlf_receive_data: payload is NULL");
-					}
-					otc_session_send(sdi, &packet);
-
-					devc->pending_samples = 0;
-				}
+			if ((int32_t)timestamp > devc->last_timestamp) {
+				otc_logic_runs_repeat(devc->runs,
+					(int32_t)timestamp - devc->last_timestamp);
+				devc->measured_samples += (int32_t)timestamp - devc->last_timestamp;
 			}
+			otc_spew("devc->measured_samples: %zu", devc->measured_samples);
 
 			devc->last_sample = value;
+			sample[0] = value & 0xff;
+			sample[1] = value >> 8;
+			otc_logic_runs_add(devc->runs, sample, 0);
 			if (timestamp == 65535) {
 				devc->last_timestamp = -1;
 			} else {
@@ -474,13 +453,7 @@ OTC_PRIV int tlf_receive_data(int fd, int revents, void *cb_data)
 			}
 		}
 
-		otc_spew("About to flush...");
-		if (devc->pending_samples > 0) {
-			logic.length = devc->pending_samples * 2;
-			otc_session_send(sdi, &packet);
-		}
-
-		otc_spew("Finished flush.");
+		otc_logic_runs_poll(devc->runs);
 	} else {
 		for (int i = 0; i < chunk_len * 2; i = i + 2) {
 			devc->raw_sample_buf = g_try_malloc(chunk_len * 4);
@@ -513,6 +486,8 @@ OTC_PRIV int tlf_receive_data(int fd, int revents, void *cb_data)
 
 close:
 	if (data) {
+		if (devc->runs)
+			otc_logic_runs_flush(devc->runs);
 		std_session_send_df_frame_end(sdi);
 		std_session_send_df_end(sdi);
 		otc_dbg("read is complete");
@@ -34,6 +34,9 @@
 
 #define RECEIVE_BUFFER_SIZE 4096
 
+/* Longest time that RLE samples are held back from the session */
+#define RUNS_LATENCY_MS 100
+
 struct dev_context {
 	int channels;
 	char chan_names[TLF_CHANNEL_COUNT_MAX][TLF_CHANNEL_COUNT_MAX + 1];
@@ -59,6 +62,7 @@ struct dev_context {
 	int32_t last_timestamp;
 
 	uint16_t *raw_sample_buf;
+	struct otc_logic_runs *runs;
 
 	int RLE_mode;
 };
@@ -45,6 +45,12 @@
  * @{
  */
 
+/* Upper limit for parallel probes, see otc_scan_resources(). */
+#define SCAN_WORKERS_MAX 16
+
+/* The calling thread's scan deadline, see otc_driver_scan(). */
+static GPrivate scan_deadline_us;
+
 /* Please use the same order/grouping as in enum otc_configkey (libopentracecapture.h). */
 static struct otc_key_info otc_key_info_config[] = {
 	/* Device classes */
@@ -265,6 +271,14 @@ static struct otc_key_info otc_key_info_config[] = {
 
 	{OTC_CONF_GATE_TIME, OTC_T_RATIONAL_PERIOD, "gate_time",
 		"Gate time", NULL},
+	{OTC_CONF_FLOOD, OTC_T_UINT64, "flood",
+		"Flood mode", NULL},
+	{OTC_CONF_TRANSFER_SIZE, OTC_T_UINT64, "transfer_size",
+		"Transfer size", NULL},
+	{OTC_CONF_TRANSFER_COUNT, OTC_T_UINT64, "transfer_count",
+		"Transfer count", NULL},
+	{OTC_CONF_OVERFLOW_COUNT, OTC_T_UINT64, "overflow_count",
+		"Overflow count", NULL},
 	ALL_ZERO
 };
 
@@ -568,7 +582,9 @@ static int check_options(struct otc_dev_driver *driver, GSList *options,
  */
 OTC_API GSList *otc_driver_scan(struct otc_dev_driver *driver, GSList *options)
 {
+	struct drv_context *drvc;
 	GSList *l;
+	gint64 deadline, *prev_deadline;
 
 	if (!driver) {
 		otc_err("Invalid driver, can't scan for devices.");
@@ -585,13 +601,180 @@ OTC_API GSList *otc_driver_scan(struct otc_dev_driver *driver, GSList *options)
 			return NULL;
 	}
 
+	/*
+	 * Scans run synchronously in the caller's thread. Keep the
+	 * deadline with that thread, so that concurrent scans (of the
+	 * same or of different contexts) don't see each other's limit.
+	 */
+	drvc = driver->context;
+	deadline = 0;
+	if (drvc->otc_ctx->scan_timeout_ms)
+		deadline = g_get_monotonic_time()
+			+ drvc->otc_ctx->scan_timeout_ms * 1000;
+	prev_deadline = g_private_get(&scan_deadline_us);
+	g_private_set(&scan_deadline_us, &deadline);
+
 	l = driver->scan(driver, options);
 
+	g_private_set(&scan_deadline_us, prev_deadline);
+
 	otc_spew("Scan found %d devices (%s).", g_slist_length(l), driver->name);
 
 	return l;
 }
 
+/**
+ * Limit the duration of subsequent device scans.
+ *
+ * Scan routines which probe several resources don't start probing more
+ * resources after the limit has passed. Probes which are in progress
+ * complete with their own timeouts, so the limit is not a hard one.
+ *
+ * @param ctx The context whose drivers' scans to limit. Must not be NULL.
+ * @param timeout_ms The maximum scan duration in milliseconds, or 0 for
+ *                   no limit (the default).
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_driver_scan_timeout_set(struct otc_context *ctx,
+		uint64_t timeout_ms)
+{
+	if (!ctx) {
+		otc_err("%s: ctx was NULL.", __func__);
+		return OTC_ERR_ARG;
+	}
+	ctx->scan_timeout_ms = timeout_ms;
+
+	return OTC_OK;
+}
+
+/**
+ * Get the device scan duration limit.
+ *
+ * @param ctx The context to query. Must not be NULL.
+ *
+ * @return The limit in milliseconds, or 0 when scans are not limited.
+ *
+ * @since 0.6.0
+ */
+OTC_API uint64_t otc_driver_scan_timeout_get(const struct otc_context *ctx)
+{
+	if (!ctx)
+		return 0;
+
+	return ctx->scan_timeout_ms;
+}
+
+/** @private */
+struct scan_job {
+	const char *resource;
+	struct otc_dev_inst *sdi;
+};
+
+/** @private */
+struct scan_pool {
+	otc_scan_probe_callback probe;
+	void *cb_data;
+	gint64 deadline;
+};
+
+static void scan_job_run(gpointer data, gpointer user_data)
+{
+	struct scan_job *job;
+	struct scan_pool *pool;
+
+	job = data;
+	pool = user_data;
+
+	if (pool->deadline && g_get_monotonic_time() >= pool->deadline) {
+		otc_info("Scan time limit reached, skipping %s.", job->resource);
+		return;
+	}
+	job->sdi = pool->probe(job->resource, pool->cb_data);
+}
+
+/**
+ * Probe a list of resources, several of them in parallel.
+ *
+ * Scan routines can use this to not wait out the timeouts of absent
+ * devices one after another. The probe callback runs in worker threads
+ * and must not touch state which is shared between resources, except
+ * for the read-only driver context. The caller limits the parallelism
+ * depending on what the transport layer tolerates. Probing stops when
+ * the scan time limit passes, see otc_driver_scan_timeout_set().
+ *
+ * @param[in] resources List of resource names (strings).
+ * @param[in] max_workers Maximum number of parallel probes, 1 (or less)
+ *   to probe in the caller's thread.
+ * @param[in] probe The routine which probes one resource.
+ * @param[in] cb_data Caller provided data, passed to @a probe.
+ *
+ * @return The list of devices which were found, in the order of the
+ *   resources they were found at (independent of the order of probe
+ *   completion).
+ *
+ * @private
+ */
+OTC_PRIV GSList *otc_scan_resources(GSList *resources, int max_workers,
+	otc_scan_probe_callback probe, void *cb_data)
+{
+	struct scan_pool pool;
+	struct scan_job *jobs;
+	GThreadPool *threads;
+	GError *error;
+	GSList *l, *devices;
+	size_t count, idx;
+	gint64 *deadline;
+
+	count = g_slist_length(resources);
+	if (!count || !probe)
+		return NULL;
+
+	pool.probe = probe;
+	pool.cb_data = cb_data;
+	deadline = g_private_get(&scan_deadline_us);
+	pool.deadline = deadline ? *deadline : 0;
+	jobs = g_new0(struct scan_job, count);
+	for (l = resources, idx = 0; l; l = l->next, idx++)
+		jobs[idx].resource = l->data;
+
+	max_workers = MIN(max_workers, MIN((int)count, SCAN_WORKERS_MAX));
+	threads = NULL;
+	if (max_workers > 1) {
+		error = NULL;
+		threads = g_thread_pool_new(scan_job_run, &pool,
+			max_workers, TRUE, &error);
+		if (!threads) {
+			otc_warn("Cannot create scan threads: %s.",
+				error ? error->message : "unknown error");
+			g_clear_error(&error);
+		}
+	}
+	if (threads) {
+		otc_dbg("Probing %zu resources, %d in parallel.",
+			count, max_workers);
+		for (idx = 0; idx < count; idx++)
+			g_thread_pool_push(threads, &jobs[idx], NULL);
+		/* Wait for all queued jobs to complete. */
+		g_thread_pool_free(threads, FALSE, TRUE);
+	} else {
+		for (idx = 0; idx < count; idx++)
+			scan_job_run(&jobs[idx], &pool);
+	}
+
+	devices = NULL;
+	for (idx = count; idx-- > 0; ) {
+		if (jobs[idx].sdi)
+			devices = g_slist_prepend(devices, jobs[idx].sdi);
+	}
+	g_free(jobs);
+
+	return devices;
+}
+
 /**
  * Call driver cleanup function for all drivers.
  *
@@ -660,6 +843,11 @@ OTC_PRIV void otc_config_free(struct otc_config *src)
 /** @private */
 OTC_PRIV int otc_dev_acquisition_start(struct otc_dev_inst *sdi)
 {
+#ifdef HAVE_LIBUSB_1_0
+	struct drv_context *drvc;
+	int ret;
+#endif
+
 	if (!sdi || !sdi->driver) {
 		otc_err("%s: Invalid arguments.", __func__);
 		return OTC_ERR_ARG;
@@ -673,6 +861,21 @@ OTC_PRIV int otc_dev_acquisition_start(struct otc_dev_inst *sdi)
 
 	otc_dbg("%s: Starting acquisition.", sdi->driver->name);
 
+#ifdef HAVE_LIBUSB_1_0
+	/*
+	 * Drivers without a completion queue may submit transfers before
+	 * they add their event source, keep the USB event thread from
+	 * running the callbacks meanwhile.
+	 */
+	drvc = sdi->driver->context;
+	if (sdi->inst_type == OTC_INST_USB && drvc && drvc->otc_ctx) {
+		otc_usb_events_pause(drvc->otc_ctx);
+		ret = sdi->driver->dev_acquisition_start(sdi);
+		otc_usb_events_resume(drvc->otc_ctx);
+		return ret;
+	}
+#endif
+
 	return sdi->driver->dev_acquisition_start(sdi);
 }
 
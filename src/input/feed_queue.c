@@ -57,28 +57,126 @@ OTC_API struct feed_queue_logic *feed_queue_logic_alloc(
 	return q;
 }
 
-OTC_API int feed_queue_logic_submit_one(struct feed_queue_logic *q,
+/*
+ * Replicate a sample value. Uniform byte patterns (idle lines which are
+ * all low or all high) become a single memset() call. Other values are
+ * written once, and then get doubled with each memcpy() call, such that
+ * long runs take a logarithmic number of library calls.
+ */
+OTC_PRIV void feed_queue_logic_fill(uint8_t *wrptr, const uint8_t *data,
+	size_t unit_size, size_t repeat_count)
+{
+	size_t total, done, chunk;
+
+	total = repeat_count * unit_size;
+	if (!total)
+		return;
+
+	if (unit_size == 1 || !memcmp(data, data + 1, unit_size - 1)) {
+		memset(wrptr, data[0], total);
+		return;
+	}
+
+	memcpy(wrptr, data, unit_size);
+	done = unit_size;
+	while (done < total) {
+		chunk = MIN(done, total - done);
+		memcpy(wrptr + done, wrptr, chunk);
+		done += chunk;
+	}
+}
+
+/*
+ * Whether a sent buffer still holds what was submitted. Datafeed
+ * callbacks receive const packets, but transforms may change logic
+ * data in place (the invert transform does).
+ */
+static gboolean feed_queue_logic_data_kept(const struct feed_queue_logic *q)
+{
+	return q->sdi && q->sdi->session && !q->sdi->session->transforms;
+}
+
+static int feed_queue_logic_append_run(struct feed_queue_logic *q,
 	const uint8_t *data, size_t repeat_count)
 {
-	uint8_t *wrptr;
+	size_t space, count;
 	int ret;
 
-	wrptr = &q->data_bytes[q->fill_count * q->unit_size];
-	while (repeat_count--) {
-		memcpy(wrptr, data, q->unit_size);
-		wrptr += q->unit_size;
-		q->fill_count++;
+	while (repeat_count) {
+		/*
+		 * Runs which span complete buffers need not get expanded
+		 * over and over again. Fill the buffer once, send it as
+		 * often as is needed, and keep the run's tail which the
+		 * buffer already holds. Only when no transform can change
+		 * the buffer, otherwise each buffer gets filled again.
+		 */
+		if (!q->fill_count && repeat_count >= q->alloc_count
+				&& feed_queue_logic_data_kept(q)) {
+			feed_queue_logic_fill(q->data_bytes, data,
+				q->unit_size, q->alloc_count);
+			while (repeat_count >= q->alloc_count) {
+				q->fill_count = q->alloc_count;
+				ret = feed_queue_logic_flush(q);
+				if (ret != OTC_OK)
+					return ret;
+				repeat_count -= q->alloc_count;
+			}
+			q->fill_count = repeat_count;
+			return OTC_OK;
+		}
+
+		space = q->alloc_count - q->fill_count;
+		count = MIN(repeat_count, space);
+		feed_queue_logic_fill(&q->data_bytes[q->fill_count * q->unit_size],
+			data, q->unit_size, count);
+		q->fill_count += count;
+		repeat_count -= count;
 		if (q->fill_count == q->alloc_count) {
 			ret = feed_queue_logic_flush(q);
 			if (ret != OTC_OK)
 				return ret;
-			wrptr = &q->data_bytes[0];
 		}
 	}
 
 	return OTC_OK;
 }
 
+OTC_API int feed_queue_logic_submit_one(struct feed_queue_logic *q,
+	const uint8_t *data, size_t repeat_count)
+{
+	return feed_queue_logic_append_run(q, data, repeat_count);
+}
+
+/*
+ * Submit a sequence of runs. The 'values' array holds 'run_count'
+ * sample values of the queue's unit size each, 'counts' holds the
+ * respective repeat counts. Zero counts are permitted.
+ */
+OTC_API int feed_queue_logic_submit_runs(struct feed_queue_logic *q,
+	const uint8_t *values, const size_t *counts, size_t run_count)
+{
+	uint8_t *wrptr;
+	size_t count;
+	int ret;
+
+	while (run_count--) {
+		count = *counts++;
+		/* Short runs are most frequent, avoid the generic path. */
+		if (count == 1 && q->fill_count + 1 < q->alloc_count) {
+			wrptr = &q->data_bytes[q->fill_count * q->unit_size];
+			memcpy(wrptr, values, q->unit_size);
+			q->fill_count++;
+		} else if (count) {
+			ret = feed_queue_logic_append_run(q, values, count);
+			if (ret != OTC_OK)
+				return ret;
+		}
+		values += q->unit_size;
+	}
+
+	return OTC_OK;
+}
+
 OTC_API int feed_queue_logic_submit_many(struct feed_queue_logic *q,
 	const uint8_t *data, size_t samples_count)
 {
@@ -110,12 +208,16 @@ OTC_API int feed_queue_logic_submit_many(struct feed_queue_logic *q,
 
 OTC_API int feed_queue_logic_flush(struct feed_queue_logic *q)
 {
+	struct otc_metrics *metrics;
 	int ret;
 
 	if (!q->fill_count)
 		return OTC_OK;
 
 	q->logic.length = q->fill_count * q->unit_size;
+	metrics = otc_metrics_get(q->sdi);
+	if (G_UNLIKELY(metrics))
+		otc_metrics_feed_queue(metrics, q->sdi, q->fill_count);
 	ret = otc_session_send(q->sdi, &q->packet);
 	if (ret != OTC_OK)
 		return ret;
@@ -249,12 +351,16 @@ OTC_API int feed_queue_analog_submit_one(struct feed_queue_analog *q,
 
 OTC_API int feed_queue_analog_flush(struct feed_queue_analog *q)
 {
+	struct otc_metrics *metrics;
 	int ret;
 
 	if (!q->fill_count)
 		return OTC_OK;
 
 	q->analog.num_samples = q->fill_count;
+	metrics = otc_metrics_get(q->sdi);
+	if (G_UNLIKELY(metrics))
+		otc_metrics_feed_queue(metrics, q->sdi, q->fill_count);
 	ret = otc_session_send(q->sdi, &q->packet);
 	if (ret != OTC_OK)
 		return ret;
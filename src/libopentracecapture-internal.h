@@ -1282,11 +1282,14 @@ struct otc_context {
 	struct otc_dev_driver **driver_list;
 #ifdef HAVE_LIBUSB_1_0
 	libusb_context *libusb_ctx;
+	struct otc_usb_events *usb_events;
 #endif
 	otc_resource_open_callback resource_open_cb;
 	otc_resource_close_callback resource_close_cb;
 	otc_resource_read_callback resource_read_cb;
 	void *resource_cb_data;
+	/** Scan duration limit, see otc_driver_scan_timeout_set(). */
+	uint64_t scan_timeout_ms;
 };
 
 /** Input module metadata keys. */
@@ -1470,6 +1473,12 @@ struct otc_output {
 	 * there, and only flush it when it reaches a certain size.
 	 */
 	void *priv;
+
+	/**
+	 * Text buffer which otc_output_send_fd() formats into. It is kept
+	 * for the lifetime of the instance, so that its memory gets reused.
+	 */
+	GString *buffer;
 };
 
 /** Output module driver. */
@@ -1552,6 +1561,23 @@ struct otc_output_module {
 	int (*receive) (const struct otc_output *o,
 			const struct otc_datafeed_packet *packet, GString **out);
 
+	/**
+	 * Like receive(), but appends the output to a GString which the
+	 * caller owns. Modules implement this, receive(), or both. Those
+	 * which implement this avoid a string allocation per packet, and
+	 * callers can reuse the string's memory across packets.
+	 *
+	 * @param o Pointer to the respective 'struct otc_output'.
+	 * @param packet The complete packet.
+	 * @param out The string to append the module's output to. Text
+	 * which is already in there must be left untouched.
+	 *
+	 * @retval OTC_OK Success
+	 * @retval other Negative error code.
+	 */
+	int (*append) (const struct otc_output *o,
+			const struct otc_datafeed_packet *packet, GString *out);
+
 	/**
 	 * This function is called after the caller is finished using
 	 * the output module, and can be used to free any internal
@@ -1667,6 +1693,10 @@ struct otc_tcp_dev_inst {
 	char *host_addr;	/**!< IP address or host name */
 	char *tcp_port;		/**!< TCP port number/name */
 	int sock_fd;		/**!< TCP socket's file descriptor */
+	size_t rcvbuf_size;	/**!< Requested SO_RCVBUF size, 0 for OS default */
+	gboolean low_latency;	/**!< Use TCP_NODELAY and TCP_QUICKACK */
+	struct otc_byte_ring *rx_ring;	/**!< Receive buffer, see otc_tcp_rx_fill() */
+	gboolean rx_eof;	/**!< Peer has closed the connection */
 };
 
 struct otc_serial_dev_inst;
@@ -1688,7 +1718,7 @@ struct otc_serial_dev_inst {
 		int parity_bits;
 		int stop_bits;
 	} comm_params;
-	GString *rcv_buffer;
+	struct otc_byte_ring *rcv_buffer;
 	serial_rx_chunk_callback rx_chunk_cb_func;
 	void *rx_chunk_cb_data;
 #ifdef HAVE_LIBSERIALPORT
@@ -1765,8 +1795,17 @@ struct drv_context {
 #define ATTR_FMT_PRINTF(fmt_pos, arg_pos)	G_GNUC_PRINTF(fmt_pos, arg_pos)
 #endif
 
+extern OTC_PRIV int otc_cur_loglevel;
+
 OTC_PRIV int otc_log(int loglevel, const char *format, ...) ATTR_FMT_PRINTF(2, 3);
 
+/*
+ * Check the loglevel before the call, so that messages which don't get
+ * logged cost neither the call nor the evaluation of their arguments.
+ */
+#define otc_log(loglevel, ...) \
+	((loglevel) > otc_cur_loglevel ? OTC_OK : (otc_log)(loglevel, __VA_ARGS__))
+
 /* Message logging helpers with subsystem-specific prefix string. */
 #define otc_spew(...)	otc_log(OTC_LOG_SPEW, LOG_PREFIX ": " __VA_ARGS__)
 #define otc_dbg(...)	otc_log(OTC_LOG_DBG,  LOG_PREFIX ": " __VA_ARGS__)
@@ -1891,6 +1930,11 @@ OTC_PRIV void otc_config_free(struct otc_config *src);
 OTC_PRIV int otc_dev_acquisition_start(struct otc_dev_inst *sdi);
 OTC_PRIV int otc_dev_acquisition_stop(struct otc_dev_inst *sdi);
 
+typedef struct otc_dev_inst *(*otc_scan_probe_callback)(const char *resource,
+	void *cb_data);
+OTC_PRIV GSList *otc_scan_resources(GSList *resources, int max_workers,
+	otc_scan_probe_callback probe, void *cb_data);
+
 /*--- session.c -------------------------------------------------------------*/
 
 struct otc_session {
@@ -1923,6 +1967,19 @@ struct otc_session {
 	unsigned int stop_check_id;
 	/** Whether the session has been started. */
 	gboolean running;
+
+	/** Whether each device acquires on its own thread. */
+	gboolean device_threads;
+	/** List of struct otc_session_dev_thread pointers, while running. */
+	GSList *dev_threads;
+	/** Event source which merges the devices' packets. */
+	GSource *merge_source;
+	/** Number of wakeups from device threads, since the last merge. */
+	int merge_pending;
+	/** Pool of the packet copies which device threads queue. */
+	struct otc_packet_pool *packet_pool;
+	/** Performance statistics, NULL unless enabled. */
+	struct otc_metrics *metrics;
 };
 
 OTC_PRIV int otc_session_source_add_internal(struct otc_session *session,
@@ -1949,6 +2006,8 @@ OTC_PRIV int otc_session_source_remove_pollfd(struct otc_session *session,
 OTC_PRIV int otc_session_source_remove_channel(struct otc_session *session,
 		GIOChannel *channel);
 
+OTC_PRIV int otc_session_stop_check_later(struct otc_session *session);
+
 OTC_PRIV int otc_session_send_meta(const struct otc_dev_inst *sdi,
 		uint32_t key, GVariant *var);
 OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
@@ -1957,6 +2016,86 @@ OTC_PRIV int otc_sessionfile_check(const char *filename);
 OTC_PRIV struct otc_dev_inst *otc_session_prepare_sdi(const char *filename,
 		struct otc_session **session);
 
+/*--- session_thread.c ------------------------------------------------------*/
+
+/** Acquisition thread of a device, in sessions with device threads. */
+struct otc_session_dev_thread {
+	struct otc_session *session;
+	struct otc_dev_inst *sdi;
+	GThread *thread;
+	/** Context of the thread's main loop, for the device's sources. */
+	GMainContext *main_context;
+	GMainLoop *main_loop;
+	/** Registered event sources of the device. */
+	GHashTable *event_sources;
+	/** ID of idle source for checking whether the device stopped. */
+	unsigned int stop_check_id;
+
+	/** Protects the fields below. */
+	GMutex mutex;
+	GCond cond;
+	/** Packets for the session, oldest first. */
+	GQueue packets;
+	/** Whether otc_dev_acquisition_start() returned. */
+	gboolean started;
+	int start_result;
+	/** Whether the thread left its main loop. */
+	gboolean finished;
+	/** Drop packets instead of waiting for the session. */
+	gboolean discard;
+};
+
+OTC_PRIV struct otc_session_dev_thread *otc_session_dev_thread_current(
+		const struct otc_session *session);
+OTC_PRIV int otc_session_dev_thread_stop_check_later(
+		struct otc_session_dev_thread *dt);
+OTC_PRIV int otc_session_dev_thread_send(struct otc_session_dev_thread *dt,
+		const struct otc_datafeed_packet *packet);
+OTC_PRIV int otc_session_dev_threads_start(struct otc_session *session);
+OTC_PRIV void otc_session_dev_threads_stop(struct otc_session *session);
+OTC_PRIV gboolean otc_session_dev_threads_busy(struct otc_session *session);
+OTC_PRIV void otc_session_dev_threads_free(struct otc_session *session);
+
+/*--- session_stats.c -------------------------------------------------------*/
+
+/** Session-wide durations, see struct otc_session_stats. */
+enum otc_metrics_histogram {
+	OTC_METRICS_TRANSFORM,
+	OTC_METRICS_CALLBACKS,
+	OTC_METRICS_USB_RESUBMIT,
+	OTC_METRICS_OUTPUT,
+	OTC_METRICS_NUM_HISTOGRAMS,
+};
+
+struct otc_metrics;
+
+OTC_PRIV uint64_t otc_metrics_now_ns(void);
+OTC_PRIV void otc_metrics_start(struct otc_metrics *metrics, GSList *devs);
+OTC_PRIV void otc_metrics_free(struct otc_metrics *metrics);
+OTC_PRIV void otc_metrics_record(struct otc_metrics *metrics,
+		enum otc_metrics_histogram id, uint64_t ns);
+OTC_PRIV void otc_metrics_packet(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi,
+		const struct otc_datafeed_packet *packet,
+		uint64_t transform_ns, uint64_t callbacks_ns);
+OTC_PRIV void otc_metrics_feed_queue(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, uint64_t samples);
+OTC_PRIV void otc_metrics_trigger_scan(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, uint64_t samples, uint64_t ns);
+OTC_PRIV void otc_metrics_queued(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, unsigned int queued);
+OTC_PRIV void otc_metrics_buffer(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, uint64_t fill, gboolean full);
+OTC_PRIV void otc_metrics_overrun(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi);
+
+/** Statistics of the session of a device, NULL when disabled. */
+static inline struct otc_metrics *otc_metrics_get(
+		const struct otc_dev_inst *sdi)
+{
+	return (sdi && sdi->session) ? sdi->session->metrics : NULL;
+}
+
 /*--- session_file.c --------------------------------------------------------*/
 
 #if !HAVE_ZIP_DISCARD
@@ -2167,6 +2306,44 @@ OTC_PRIV void otc_ser_queue_rx_data(struct otc_serial_dev_inst *serial,
 OTC_PRIV size_t otc_ser_unqueue_rx_data(struct otc_serial_dev_inst *serial,
 		uint8_t *data, size_t len);
 
+/**
+ * Packet framer check callback. Inspects @a len bytes at @a buf (at
+ * least the framer's minimum packet length). Returns OTC_PACKET_VALID
+ * and stores the packet's length in @a pkt_len, or OTC_PACKET_INVALID
+ * to advance by one byte, or OTC_PACKET_NEED_RX to wait for more data.
+ */
+typedef int (*otc_ser_framer_check_cb)(void *cb_data,
+	const uint8_t *buf, size_t len, size_t *pkt_len);
+/** Packet framer callback, receives a complete and valid packet. */
+typedef void (*otc_ser_framer_packet_cb)(void *cb_data,
+	const uint8_t *buf, size_t len);
+
+/** Common framer for packet based serial protocols, see serial.c. */
+struct otc_ser_framer {
+	struct otc_byte_ring *ring;	/**!< Received and unprocessed data */
+	size_t min_len;			/**!< Minimum packet length */
+	size_t max_len;			/**!< Maximum window for the check */
+	uint8_t sync[8];		/**!< Optional fixed packet content */
+	size_t sync_offset;		/**!< Position of 'sync' in packets */
+	size_t sync_len;
+	otc_ser_framer_check_cb check_cb;
+	otc_ser_framer_packet_cb packet_cb;
+	void *cb_data;
+	uint64_t skipped;		/**!< Bytes dropped while syncing */
+};
+
+OTC_PRIV struct otc_ser_framer *otc_ser_framer_new(size_t min_len,
+		size_t max_len, otc_ser_framer_check_cb check_cb,
+		otc_ser_framer_packet_cb packet_cb, void *cb_data);
+OTC_PRIV void otc_ser_framer_free(struct otc_ser_framer *framer);
+OTC_PRIV void otc_ser_framer_reset(struct otc_ser_framer *framer);
+OTC_PRIV int otc_ser_framer_set_sync(struct otc_ser_framer *framer,
+		size_t offset, const uint8_t *pattern, size_t len);
+OTC_PRIV int otc_ser_framer_feed(struct otc_ser_framer *framer,
+		const uint8_t *data, size_t len);
+OTC_PRIV int otc_ser_framer_receive(struct otc_ser_framer *framer,
+		struct otc_serial_dev_inst *serial);
+
 struct ser_lib_functions {
 	int (*open)(struct otc_serial_dev_inst *serial, int flags);
 	int (*close)(struct otc_serial_dev_inst *serial);
@@ -2287,6 +2464,9 @@ OTC_PRIV int ezusb_upload_firmware(struct otc_context *ctx, libusb_device *dev,
 
 /*--- usb.c -----------------------------------------------------------------*/
 
+struct otc_usb_events;
+struct otc_usb_queue;
+
 OTC_PRIV int otc_usb_split_conn(const char *conn,
 	uint16_t *vid, uint16_t *pid, uint8_t *bus, uint8_t *addr);
 #ifdef HAVE_LIBUSB_1_0
@@ -2295,12 +2475,124 @@ OTC_PRIV int otc_usb_open(libusb_context *usb_ctx, struct otc_usb_dev_inst *usb)
 OTC_PRIV void otc_usb_close(struct otc_usb_dev_inst *usb);
 OTC_PRIV int usb_source_add(struct otc_session *session, struct otc_context *ctx,
 		int timeout, otc_receive_data_callback cb, void *cb_data);
+OTC_PRIV int usb_source_add_queue(struct otc_session *session,
+		struct otc_context *ctx, struct otc_usb_queue *queue,
+		int timeout, otc_receive_data_callback cb, void *cb_data);
 OTC_PRIV int usb_source_remove(struct otc_session *session, struct otc_context *ctx);
+OTC_PRIV struct otc_usb_queue *otc_usb_queue_new(struct otc_context *ctx,
+		unsigned int max_transfers, libusb_transfer_cb_fn cb, void *cb_data);
+OTC_PRIV void otc_usb_queue_free(struct otc_usb_queue *queue);
+OTC_PRIV int otc_usb_queue_submit(struct otc_usb_queue *queue,
+		struct libusb_transfer *transfer);
+OTC_PRIV void otc_usb_events_free(struct otc_context *ctx);
+OTC_PRIV void otc_usb_events_pause(struct otc_context *ctx);
+OTC_PRIV void otc_usb_events_resume(struct otc_context *ctx);
 OTC_PRIV int usb_get_port_path(libusb_device *dev, char *path, int path_len);
 OTC_PRIV gboolean usb_match_manuf_prod(libusb_device *dev,
 		const char *manufacturer, const char *product);
 #endif
 
+/*--- byte_ring.c -----------------------------------------------------------*/
+
+/** Single producer, single consumer byte FIFO, power of two capacity. */
+struct otc_byte_ring {
+	uint8_t *data;		/**!< Storage, 'size' bytes */
+	size_t size;		/**!< Capacity, always a power of two */
+	size_t rd_pos;		/**!< Free running read position */
+	size_t wr_pos;		/**!< Free running write position */
+};
+
+OTC_PRIV struct otc_byte_ring *otc_byte_ring_new(size_t size);
+OTC_PRIV void otc_byte_ring_free(struct otc_byte_ring *ring);
+OTC_PRIV void otc_byte_ring_reset(struct otc_byte_ring *ring);
+OTC_PRIV size_t otc_byte_ring_used(const struct otc_byte_ring *ring);
+OTC_PRIV size_t otc_byte_ring_space(const struct otc_byte_ring *ring);
+OTC_PRIV size_t otc_byte_ring_write_segments(struct otc_byte_ring *ring,
+	uint8_t **seg_ptr, size_t *seg_len);
+OTC_PRIV void otc_byte_ring_commit(struct otc_byte_ring *ring, size_t count);
+OTC_PRIV size_t otc_byte_ring_read_segments(struct otc_byte_ring *ring,
+	uint8_t **seg_ptr, size_t *seg_len);
+OTC_PRIV void otc_byte_ring_consume(struct otc_byte_ring *ring, size_t count);
+OTC_PRIV size_t otc_byte_ring_write(struct otc_byte_ring *ring,
+	const void *data, size_t count);
+OTC_PRIV size_t otc_byte_ring_read(struct otc_byte_ring *ring,
+	void *data, size_t count);
+OTC_PRIV int otc_byte_ring_reserve(struct otc_byte_ring *ring, size_t count);
+OTC_PRIV size_t otc_byte_ring_peek(const struct otc_byte_ring *ring,
+	size_t offset, void *data, size_t count);
+OTC_PRIV const uint8_t *otc_byte_ring_peek_ptr(struct otc_byte_ring *ring,
+	size_t offset, size_t count);
+OTC_PRIV gboolean otc_byte_ring_find(const struct otc_byte_ring *ring,
+	size_t offset, const uint8_t *pattern, size_t count, size_t *pos);
+
+/*--- bit_transpose.c -------------------------------------------------------*/
+
+struct otc_bit_transpose;
+
+OTC_PRIV struct otc_bit_transpose *otc_bit_transpose_new(size_t word_bits,
+	gboolean msb_first, size_t unitsize,
+	const uint32_t *channel_masks, size_t channel_count);
+OTC_PRIV void otc_bit_transpose_free(struct otc_bit_transpose *xp);
+OTC_PRIV void otc_bit_transpose_reset(struct otc_bit_transpose *xp);
+OTC_PRIV size_t otc_bit_transpose_batch_samples(const struct otc_bit_transpose *xp);
+OTC_PRIV size_t otc_bit_transpose_run(struct otc_bit_transpose *xp,
+	const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len);
+
+/*--- usb_tune.c ------------------------------------------------------------*/
+
+/** Adaptive sizing of a streaming bulk IN transfer queue. */
+struct otc_usb_tune {
+	size_t size;			/**!< Current transfer size in bytes */
+	unsigned int count;		/**!< Current number of transfers */
+	uint64_t overflows;		/**!< Rounds which lost data */
+	size_t min_size;
+	size_t max_size;		/**!< Largest transfer size to pick */
+	unsigned int min_count;
+	unsigned int max_count;		/**!< Largest number of transfers */
+	size_t align;
+	size_t max_total;
+	uint64_t bytes_per_ms;
+	gboolean adaptive;
+	gboolean settling;		/**!< Queue changed in the last round */
+	int64_t *submit_us;		/**!< Submission times, per slot */
+	unsigned int round_left;
+	int64_t round_min_wait_us;
+	int64_t round_max_proc_us;
+	size_t round_bytes;
+	int64_t round_end_us;		/**!< Completion time of the last round */
+	unsigned int calm_rounds;
+};
+
+OTC_PRIV void otc_usb_tune_init(struct otc_usb_tune *tune,
+	uint64_t bytes_per_ms, size_t size, unsigned int count,
+	size_t align, unsigned int max_count, size_t max_total,
+	gboolean adaptive);
+OTC_PRIV void otc_usb_tune_clear(struct otc_usb_tune *tune);
+OTC_PRIV unsigned int otc_usb_tune_timeout(const struct otc_usb_tune *tune);
+OTC_PRIV void otc_usb_tune_submitted(struct otc_usb_tune *tune,
+	unsigned int slot);
+OTC_PRIV void otc_usb_tune_completed(struct otc_usb_tune *tune,
+	unsigned int slot, int64_t begin_us, size_t length);
+
+/*--- logic_runs.c ----------------------------------------------------------*/
+
+struct otc_logic_runs;
+
+OTC_PRIV struct otc_logic_runs *otc_logic_runs_new(
+	const struct otc_dev_inst *sdi, size_t unitsize,
+	unsigned int latency_ms);
+OTC_PRIV void otc_logic_runs_free(struct otc_logic_runs *runs);
+OTC_PRIV void otc_logic_runs_limit(struct otc_logic_runs *runs, uint64_t limit);
+OTC_PRIV uint64_t otc_logic_runs_samples(const struct otc_logic_runs *runs);
+OTC_PRIV gboolean otc_logic_runs_full(const struct otc_logic_runs *runs);
+OTC_PRIV int otc_logic_runs_repeat(struct otc_logic_runs *runs, uint64_t count);
+OTC_PRIV int otc_logic_runs_add(struct otc_logic_runs *runs,
+	const uint8_t *value, uint64_t count);
+OTC_PRIV int otc_logic_runs_add_many(struct otc_logic_runs *runs,
+	const uint8_t *values, const size_t *counts, size_t run_count);
+OTC_PRIV int otc_logic_runs_flush(struct otc_logic_runs *runs);
+OTC_PRIV int otc_logic_runs_poll(struct otc_logic_runs *runs);
+
 /*--- tcp.c -----------------------------------------------------------------*/
 
 OTC_PRIV gboolean otc_fd_is_readable(int fd);
@@ -2321,6 +2613,18 @@ OTC_PRIV int otc_tcp_source_add(struct otc_session *session,
 	otc_receive_data_callback cb, void *cb_data);
 OTC_PRIV int otc_tcp_source_remove(struct otc_session *session,
 	struct otc_tcp_dev_inst *tcp);
+OTC_PRIV int otc_tcp_set_sockopts(struct otc_tcp_dev_inst *tcp,
+	size_t rcvbuf_size, gboolean low_latency);
+OTC_PRIV int otc_tcp_rx_buffer_alloc(struct otc_tcp_dev_inst *tcp,
+	size_t size);
+OTC_PRIV int otc_tcp_rx_fill(struct otc_tcp_dev_inst *tcp);
+OTC_PRIV int otc_tcp_rx_read(struct otc_tcp_dev_inst *tcp,
+	uint8_t *data, size_t dlen);
+OTC_PRIV int otc_tcp_rx_wait(struct otc_tcp_dev_inst *tcp,
+	unsigned int timeout_ms);
+OTC_PRIV int otc_tcp_rx_source_add(struct otc_session *session,
+	struct otc_tcp_dev_inst *tcp, int timeout,
+	otc_receive_data_callback cb, void *cb_data);
 
 /*--- binary_helpers.c ------------------------------------------------------*/
 
@@ -2401,12 +2705,18 @@ struct otc_modbus_dev_inst {
 		int timeout, otc_receive_data_callback cb, void *cb_data);
 	int (*source_remove)(struct otc_session *session, void *priv);
 	int (*send)(void *priv, const uint8_t *buffer, int buffer_size);
-	int (*read_begin)(void *priv, uint8_t *function_code);
+	int (*read_begin)(void *priv, uint8_t *function_code,
+		unsigned int timeout_ms);
 	int (*read_data)(void *priv, uint8_t *buf, int maxlen);
 	int (*read_end)(void *priv);
+	/* Optional: forget about outstanding requests after errors. */
+	void (*flush)(void *priv);
 	int (*close)(void *priv);
 	void (*free)(void *priv);
+	/* Max time without receive data while reading a response. */
 	unsigned int read_timeout_ms;
+	/* Max number of requests in flight, 0 means one at a time. */
+	int max_pending;
 	void *priv;
 };
 
@@ -2440,6 +2750,45 @@ OTC_PRIV int otc_modbus_write_multiple_registers(struct otc_modbus_dev_inst*modb
 OTC_PRIV int otc_modbus_close(struct otc_modbus_dev_inst *modbus);
 OTC_PRIV void otc_modbus_free(struct otc_modbus_dev_inst *modbus);
 
+struct otc_modbus_plan;
+
+OTC_PRIV struct otc_modbus_plan *otc_modbus_plan_new(int max_gap);
+OTC_PRIV void otc_modbus_plan_free(struct otc_modbus_plan *plan);
+OTC_PRIV int otc_modbus_plan_add(struct otc_modbus_plan *plan,
+		int address, int nb_registers);
+OTC_PRIV size_t otc_modbus_plan_block_count(struct otc_modbus_plan *plan);
+OTC_PRIV int otc_modbus_plan_run(struct otc_modbus_dev_inst *modbus,
+		struct otc_modbus_plan *plan);
+OTC_PRIV int otc_modbus_plan_get(const struct otc_modbus_plan *plan,
+		int address, int nb_registers, uint16_t *registers);
+
+/*--- dmm/layout.c ----------------------------------------------------------*/
+
+#define OTC_DMM_LAYOUT_MAX 64
+
+enum otc_dmm_checksum {
+	OTC_DMM_CSUM_NONE,
+	OTC_DMM_CSUM_XOR8,
+};
+
+/** Fixed properties of a DMM chip's packets, see dmm/layout.c. */
+struct otc_dmm_layout {
+	size_t packet_size;
+	/** Fixed bits of each byte position. */
+	uint8_t mask[OTC_DMM_LAYOUT_MAX];
+	/** Expected values of the fixed bits. */
+	uint8_t value[OTC_DMM_LAYOUT_MAX];
+	/** Checksum type, covers bytes [csum_start, csum_pos). */
+	enum otc_dmm_checksum checksum;
+	size_t csum_start;
+	size_t csum_pos;
+};
+
+OTC_PRIV gboolean otc_dmm_layout_match(const struct otc_dmm_layout *layout,
+	const uint8_t *buf);
+OTC_PRIV gboolean otc_dmm_layout_sync(const struct otc_dmm_layout *layout,
+	size_t *offset, size_t *len, size_t max_len);
+
 /*--- dmm/es519xx.c ---------------------------------------------------------*/
 
 /**
@@ -2465,6 +2814,7 @@ struct es519xx_info {
 };
 
 OTC_PRIV gboolean otc_es519xx_2400_11b_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_es519xx_11b_layout;
 OTC_PRIV int otc_es519xx_2400_11b_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 OTC_PRIV gboolean otc_es519xx_2400_11b_altfn_packet_valid(const uint8_t *buf);
@@ -2480,6 +2830,7 @@ OTC_PRIV gboolean otc_es519xx_19200_11b_packet_valid(const uint8_t *buf);
 OTC_PRIV int otc_es519xx_19200_11b_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 OTC_PRIV gboolean otc_es519xx_19200_14b_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_es519xx_14b_layout;
 OTC_PRIV int otc_es519xx_19200_14b_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 OTC_PRIV gboolean otc_es519xx_19200_14b_sel_lpf_packet_valid(const uint8_t *buf);
@@ -2500,6 +2851,7 @@ struct fs9922_info {
 };
 
 OTC_PRIV gboolean otc_fs9922_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_fs9922_layout;
 OTC_PRIV int otc_fs9922_parse(const uint8_t *buf, float *floatval,
 			    struct otc_datafeed_analog *analog, void *info);
 OTC_PRIV void otc_fs9922_z1_diode(struct otc_datafeed_analog *analog, void *info);
@@ -2516,6 +2868,7 @@ struct fs9721_info {
 };
 
 OTC_PRIV gboolean otc_fs9721_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_fs9721_layout;
 OTC_PRIV int otc_fs9721_parse(const uint8_t *buf, float *floatval,
 			    struct otc_datafeed_analog *analog, void *info);
 OTC_PRIV void otc_fs9721_00_temp_c(struct otc_datafeed_analog *analog, void *info);
@@ -2531,6 +2884,7 @@ OTC_PRIV void otc_fs9721_max_c_min(struct otc_datafeed_analog *analog, void *inf
 struct meterman_38xr_info { int dummy; };
 
 OTC_PRIV gboolean meterman_38xr_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout meterman_38xr_layout;
 OTC_PRIV int meterman_38xr_parse(const uint8_t *buf, float *floatval,
 	struct otc_datafeed_analog *analog, void *info);
 
@@ -2555,6 +2909,7 @@ struct ms2115b_info {
 
 extern OTC_PRIV const char *ms2115b_channel_formats[];
 OTC_PRIV gboolean otc_ms2115b_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_ms2115b_layout;
 OTC_PRIV int otc_ms2115b_parse(const uint8_t *buf, float *floatval,
 	struct otc_datafeed_analog *analog, void *info);
 
@@ -2570,6 +2925,7 @@ struct ms8250d_info {
 };
 
 OTC_PRIV gboolean otc_ms8250d_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_ms8250d_layout;
 OTC_PRIV int otc_ms8250d_parse(const uint8_t *buf, float *floatval,
 			     struct otc_datafeed_analog *analog, void *info);
 
@@ -2586,6 +2942,7 @@ struct dtm0660_info {
 };
 
 OTC_PRIV gboolean otc_dtm0660_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_dtm0660_layout;
 OTC_PRIV int otc_dtm0660_parse(const uint8_t *buf, float *floatval,
 			struct otc_datafeed_analog *analog, void *info);
 
@@ -2597,6 +2954,7 @@ OTC_PRIV int otc_dtm0660_parse(const uint8_t *buf, float *floatval,
 struct m2110_info { int dummy; };
 
 OTC_PRIV gboolean otc_m2110_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_m2110_layout;
 OTC_PRIV int otc_m2110_parse(const uint8_t *buf, float *floatval,
 			     struct otc_datafeed_analog *analog, void *info);
 
@@ -2618,9 +2976,11 @@ struct metex14_info {
 OTC_PRIV int otc_metex14_packet_request(struct otc_serial_dev_inst *serial);
 #endif
 OTC_PRIV gboolean otc_metex14_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_metex14_layout;
 OTC_PRIV int otc_metex14_parse(const uint8_t *buf, float *floatval,
 			     struct otc_datafeed_analog *analog, void *info);
 OTC_PRIV gboolean otc_metex14_4packets_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_metex14_4packets_layout;
 OTC_PRIV int otc_metex14_4packets_parse(const uint8_t *buf, float *floatval,
 			     struct otc_datafeed_analog *analog, void *info);
 
@@ -2643,6 +3003,7 @@ OTC_PRIV int otc_rs9lcd_parse(const uint8_t *buf, float *floatval,
 struct qm1578_info { int dummy; };
 
 OTC_PRIV gboolean otc_digitech_qm1578_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_digitech_qm1578_layout;
 OTC_PRIV int otc_digitech_qm1578_parse(const uint8_t *buf, float *floatval,
 			     struct otc_datafeed_analog *analog, void *info);
 /*--- dmm/bm25x.c -----------------------------------------------------------*/
@@ -2653,6 +3014,7 @@ OTC_PRIV int otc_digitech_qm1578_parse(const uint8_t *buf, float *floatval,
 struct bm25x_info { int dummy; };
 
 OTC_PRIV gboolean otc_brymen_bm25x_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_brymen_bm25x_layout;
 OTC_PRIV int otc_brymen_bm25x_parse(const uint8_t *buf, float *floatval,
 			     struct otc_datafeed_analog *analog, void *info);
 
@@ -2713,6 +3075,7 @@ struct brymen_bm86x_info { size_t ch_idx; };
 OTC_PRIV int otc_brymen_bm86x_packet_request(struct otc_serial_dev_inst *serial);
 #endif
 OTC_PRIV gboolean otc_brymen_bm86x_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_brymen_bm86x_layout;
 OTC_PRIV int otc_brymen_bm86x_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 
@@ -2728,6 +3091,7 @@ struct ut71x_info {
 };
 
 OTC_PRIV gboolean otc_ut71x_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_ut71x_layout;
 OTC_PRIV int otc_ut71x_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 
@@ -2749,6 +3113,7 @@ struct vc870_info {
 };
 
 OTC_PRIV gboolean otc_vc870_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_vc870_layout;
 OTC_PRIV int otc_vc870_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 
@@ -2764,6 +3129,7 @@ struct vc96_info {
 };
 
 OTC_PRIV gboolean otc_vc96_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_vc96_layout;
 OTC_PRIV int otc_vc96_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 
@@ -2851,6 +3217,7 @@ struct asycii_info {
 OTC_PRIV int otc_asycii_packet_request(struct otc_serial_dev_inst *serial);
 #endif
 OTC_PRIV gboolean otc_asycii_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_asycii_layout;
 OTC_PRIV int otc_asycii_parse(const uint8_t *buf, float *floatval,
 			    struct otc_datafeed_analog *analog, void *info);
 
@@ -2892,6 +3259,7 @@ struct eev121gw_info {
 
 extern OTC_PRIV const char *eev121gw_channel_formats[];
 OTC_PRIV gboolean otc_eev121gw_packet_valid(const uint8_t *buf);
+extern OTC_PRIV const struct otc_dmm_layout otc_eev121gw_layout;
 OTC_PRIV int otc_eev121gw_3displays_parse(const uint8_t *buf, float *floatval,
 		struct otc_datafeed_analog *analog, void *info);
 
@@ -2956,6 +3324,10 @@ OTC_API int feed_queue_logic_submit_one(struct feed_queue_logic *q,
 	const uint8_t *data, size_t repeat_count);
 OTC_API int feed_queue_logic_submit_many(struct feed_queue_logic *q,
 	const uint8_t *data, size_t samples_count);
+OTC_API int feed_queue_logic_submit_runs(struct feed_queue_logic *q,
+	const uint8_t *values, const size_t *counts, size_t run_count);
+OTC_PRIV void feed_queue_logic_fill(uint8_t *wrptr, const uint8_t *data,
+	size_t unit_size, size_t repeat_count);
 OTC_API int feed_queue_logic_flush(struct feed_queue_logic *q);
 OTC_API int feed_queue_logic_send_trigger(struct feed_queue_logic *q);
 OTC_API void feed_queue_logic_free(struct feed_queue_logic *q);
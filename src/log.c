@@ -20,6 +20,7 @@
 #include <config.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <glib/gprintf.h>
 #include <opentracecapture/libopentracecapture.h>
 #include "libopentracecapture-internal.h"
@@ -39,11 +40,26 @@
  *
  * Controlling the libopentracecapture message logging functionality.
  *
+ * Messages get passed to the log callback on the thread which logs them,
+ * by default. Writing them out takes time, which acquisitions may not
+ * have at debug and spew loglevels. otc_log_async_set() moves this to a
+ * background thread. Each logging thread then puts its messages into a
+ * ring of its own, without locks, and the background thread passes them
+ * on in the order in which they were logged. Info, debug and spew
+ * messages for which a ring has no room get dropped and counted, see
+ * otc_log_dropped_get(). Errors and warnings never get dropped, a thread
+ * whose ring is full waits for the background thread to pass on its
+ * pending messages first. Log callbacks thus only get called on the
+ * background thread, one message at a time.
+ *
  * @{
  */
 
-/* Currently selected libopentracecapture loglevel. Default: OTC_LOG_WARN. */
-static int cur_loglevel = OTC_LOG_WARN; /* Show errors+warnings per default. */
+/*
+ * Currently selected libopentracecapture loglevel. Default: OTC_LOG_WARN.
+ * The otc_log() macro checks it before the call.
+ */
+OTC_PRIV int otc_cur_loglevel = OTC_LOG_WARN; /* Show errors+warnings per default. */
 
 /* Function prototype. */
 static int otc_logv(void *cb_data, int loglevel, const char *format,
@@ -63,6 +79,72 @@ static void *otc_log_cb_data = NULL;
 /** @endcond */
 static int64_t otc_log_start_time = 0;
 
+/** @cond PRIVATE */
+/* Messages a thread can have pending, before further ones get dropped. */
+#define LOG_RING_SIZE 256
+/* Messages up to this length are kept in the ring itself. */
+#define LOG_TEXT_SIZE 240
+/* Output which the background thread collects before it writes. */
+#define LOG_BATCH_SIZE 4096
+/* Ring positions wrap at a multiple of the ring size. */
+#define LOG_POS_MASK 0x3fffffff
+/* Number of entries from one ring position to another. */
+#define LOG_POS_DIFF(to, from) (((to) - (from)) & LOG_POS_MASK)
+/** @endcond */
+
+struct log_entry {
+	int loglevel;
+	unsigned int seq;
+	int64_t time_us;
+	/* The message, if it does not fit into text. */
+	char *long_text;
+	char text[LOG_TEXT_SIZE];
+};
+
+/*
+ * Pending messages of one thread. The thread writes entries and advances
+ * wr_pos, the background thread reads them and advances rd_pos.
+ */
+struct log_ring {
+	struct log_ring *next;
+	int rd_pos;
+	int wr_pos;
+	/* Set when the thread exits, the ring gets freed once it's empty. */
+	int orphaned;
+	struct log_entry entries[LOG_RING_SIZE];
+};
+
+static void log_ring_orphan(void *data);
+static void log_flush(void);
+
+/* Whether messages go to the background thread. */
+static int log_async;
+/* Threads which are about to queue a message. */
+static int log_inflight;
+/* Messages which got dropped because a ring was full. */
+static guint64 log_dropped;
+/* Protects log_dropped, 64-bit atomics are not available everywhere. */
+static GMutex log_dropped_mutex;
+/* Set when log_dropped changed, checked by the background thread. */
+static int log_dropped_changed;
+/* Order of the messages across threads. */
+static int log_seq;
+/* Whether the background thread waits for messages. */
+static int log_writer_idle;
+static GPrivate log_thread_ring = G_PRIVATE_INIT(log_ring_orphan);
+
+/* Serializes otc_log_async_set(). */
+static GMutex log_async_mutex;
+/* Protects the following, and the callback and its data. */
+static GMutex log_mutex;
+static GCond log_cond;
+static GCond log_flushed_cond;
+static GThread *log_thread;
+static gboolean log_stop;
+static struct log_ring *log_rings;
+/* Threads in log_flush(), which keep rings from being freed. */
+static int log_flushing;
+
 /**
  * Set the libopentracecapture loglevel.
  *
@@ -90,7 +172,7 @@ OTC_API int otc_log_loglevel_set(int loglevel)
 	if (loglevel >= LOGLEVEL_TIMESTAMP && otc_log_start_time == 0)
 		otc_log_start_time = g_get_monotonic_time();
 
-	cur_loglevel = loglevel;
+	otc_cur_loglevel = loglevel;
 
 	otc_dbg("libopentracecapture loglevel set to %d.", loglevel);
 
@@ -106,7 +188,7 @@ OTC_API int otc_log_loglevel_set(int loglevel)
  */
 OTC_API int otc_log_loglevel_get(void)
 {
-	return cur_loglevel;
+	return otc_cur_loglevel;
 }
 
 /**
@@ -133,8 +215,13 @@ OTC_API int otc_log_callback_set(otc_log_callback cb, void *cb_data)
 
 	/* Note: 'cb_data' is allowed to be NULL. */
 
+	/* Pending messages still go to the previous callback. */
+	log_flush();
+
+	g_mutex_lock(&log_mutex);
 	otc_log_cb = cb;
 	otc_log_cb_data = cb_data;
+	g_mutex_unlock(&log_mutex);
 
 	return OTC_OK;
 }
@@ -154,8 +241,12 @@ OTC_API int otc_log_callback_set_default(void)
 	 * Note: No log output in this function, as it should safely work
 	 * even if the currently set log callback is buggy/broken.
 	 */
+	log_flush();
+
+	g_mutex_lock(&log_mutex);
 	otc_log_cb = otc_logv;
 	otc_log_cb_data = NULL;
+	g_mutex_unlock(&log_mutex);
 
 	return OTC_OK;
 }
@@ -174,96 +265,477 @@ OTC_API int otc_log_callback_set_default(void)
  */
 OTC_API int otc_log_callback_get(otc_log_callback *cb, void **cb_data)
 {
+	g_mutex_lock(&log_mutex);
 	if (cb)
 		*cb = otc_log_cb;
 	if (cb_data)
 		*cb_data = otc_log_cb_data;
+	g_mutex_unlock(&log_mutex);
 
 	return OTC_OK;
 }
 
-static int otc_logv(void *cb_data, int loglevel, const char *format, va_list args)
+/* Append a message with prefix and time stamp, without line breaks. */
+static void log_format_line(GString *line, int64_t time_us, const char *text)
 {
-	int ret;
 	uint64_t elapsed_us, minutes;
 	unsigned int rest_us, seconds, microseconds;
-	char *raw_output, *output, c;
-	ssize_t print_len;
-	size_t raw_len;
-	const char *raw_ptr;
-	char *out_ptr;
-
-	/* This specific log callback doesn't need the void pointer data. */
-	(void)cb_data;
-
-	(void)loglevel;
+	size_t len;
 
 	/* Prefix with 'sr:'. Optionally prefix with timestamp. */
-	ret = fputs("sr: ", stderr);
-	if (ret < 0)
-		return OTC_ERR;
-	if (cur_loglevel >= LOGLEVEL_TIMESTAMP) {
-		elapsed_us = g_get_monotonic_time() - otc_log_start_time;
+	g_string_append(line, "sr: ");
+	if (otc_cur_loglevel >= LOGLEVEL_TIMESTAMP) {
+		elapsed_us = time_us - otc_log_start_time;
 
 		minutes = elapsed_us / G_TIME_SPAN_MINUTE;
 		rest_us = elapsed_us % G_TIME_SPAN_MINUTE;
 		seconds = rest_us / G_TIME_SPAN_SECOND;
 		microseconds = rest_us % G_TIME_SPAN_SECOND;
 
-		ret = g_fprintf(stderr, "[%.2" PRIu64 ":%.2u.%.6u] ",
+		g_string_append_printf(line, "[%.2" PRIu64 ":%.2u.%.6u] ",
 				minutes, seconds, microseconds);
-		if (ret < 0)
-			return OTC_ERR;
 	}
 
+	/* Strip unwanted line breaks. */
+	while (*text) {
+		len = strcspn(text, "\r\n");
+		g_string_append_len(line, text, len);
+		text += len;
+		if (*text)
+			text++;
+	}
+	g_string_append_c(line, '\n');
+}
+
+static int log_write(GString *line)
+{
+	size_t len, written;
+
+	len = line->len;
+	written = fwrite(line->str, 1, len, stderr);
+	fflush(stderr);
+	g_string_truncate(line, 0);
+
+	return (written == len) ? OTC_OK : OTC_ERR;
+}
+
+static int otc_logv(void *cb_data, int loglevel, const char *format, va_list args)
+{
+	char *output;
+	GString *line;
+	int ret;
+
+	/* This specific log callback doesn't need the void pointer data. */
+	(void)cb_data;
+
+	(void)loglevel;
+
 	/* Print the caller's message into a local buffer. */
-	raw_output = NULL;
-	print_len = g_vasprintf(&raw_output, format, args);
-	if (print_len < 0) {
-		g_free(raw_output);
+	output = g_strdup_vprintf(format, args);
+	if (!output)
 		return OTC_ERR;
+
+	/* Print the trimmed output text, in one write. */
+	line = g_string_sized_new(64 + strlen(output));
+	log_format_line(line, g_get_monotonic_time(), output);
+	g_free(output);
+	ret = log_write(line);
+	g_string_free(line, TRUE);
+
+	return ret;
+}
+
+/* Pass an already formatted message to a log callback. */
+static int log_call(otc_log_callback cb, void *cb_data, int loglevel,
+		const char *format, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, format);
+	ret = cb(cb_data, loglevel, format, args);
+	va_end(args);
+
+	return ret;
+}
+
+static void log_ring_orphan(void *data)
+{
+	struct log_ring *ring;
+
+	ring = data;
+	g_atomic_int_set(&ring->orphaned, 1);
+}
+
+/*
+ * Queue a message on the calling thread's ring, or drop it. Returns FALSE
+ * when the ring is full and the message is too important to drop, the
+ * caller passes it on right away then.
+ */
+static gboolean log_queue(int loglevel, const char *format, va_list args)
+{
+	struct log_ring *ring;
+	struct log_entry *entry;
+	va_list args_copy;
+	int wr_pos, len;
+
+	ring = g_private_get(&log_thread_ring);
+	if (!ring) {
+		ring = g_malloc0(sizeof(*ring));
+		g_mutex_lock(&log_mutex);
+		ring->next = log_rings;
+		log_rings = ring;
+		g_mutex_unlock(&log_mutex);
+		g_private_set(&log_thread_ring, ring);
 	}
-	raw_len = (size_t)print_len;
 
-	/* Copy the string. Strip unwanted line breaks. */
-	output = g_malloc(raw_len + 1);
-	if (!output) {
-		g_free(raw_output);
-		return OTC_ERR;
+	wr_pos = ring->wr_pos;
+	if (LOG_POS_DIFF(wr_pos, g_atomic_int_get(&ring->rd_pos))
+			>= LOG_RING_SIZE) {
+		if (loglevel <= OTC_LOG_WARN)
+			return FALSE;
+		g_mutex_lock(&log_dropped_mutex);
+		log_dropped++;
+		g_mutex_unlock(&log_dropped_mutex);
+		g_atomic_int_set(&log_dropped_changed, 1);
+		return TRUE;
 	}
-	out_ptr = output;
-	raw_ptr = raw_output;
-	while (*raw_ptr) {
-		c = *raw_ptr++;
-		if (c == '\r' || c == '\n')
+
+	entry = &ring->entries[wr_pos % LOG_RING_SIZE];
+	entry->loglevel = loglevel;
+	entry->seq = g_atomic_int_add(&log_seq, 1);
+	entry->time_us = g_get_monotonic_time();
+	va_copy(args_copy, args);
+	len = g_vsnprintf(entry->text, sizeof(entry->text), format, args);
+	entry->long_text = NULL;
+	if (len >= (int)sizeof(entry->text))
+		entry->long_text = g_strdup_vprintf(format, args_copy);
+	va_end(args_copy);
+
+	g_atomic_int_set(&ring->wr_pos, (wr_pos + 1) & LOG_POS_MASK);
+
+	if (g_atomic_int_get(&log_writer_idle)) {
+		g_mutex_lock(&log_mutex);
+		g_cond_signal(&log_cond);
+		g_mutex_unlock(&log_mutex);
+	}
+
+	return TRUE;
+}
+
+/* Find the ring whose next message was logged first. Needs log_mutex. */
+static struct log_ring *log_next_ring(void)
+{
+	struct log_ring *ring, *next;
+	struct log_entry *entry;
+	unsigned int seq;
+	int rd_pos;
+
+	next = NULL;
+	seq = 0;
+	for (ring = log_rings; ring; ring = ring->next) {
+		rd_pos = ring->rd_pos;
+		if (g_atomic_int_get(&ring->wr_pos) == rd_pos)
 			continue;
-		*out_ptr++ = c;
+		entry = &ring->entries[rd_pos % LOG_RING_SIZE];
+		if (!next || (int)(entry->seq - seq) < 0) {
+			next = ring;
+			seq = entry->seq;
+		}
 	}
-	*out_ptr = '\0';
-	g_free(raw_output);
 
-	/* Print the trimmed output text. */
-	g_fprintf(stderr, "%s\n", output);
-	fflush(stderr);
-	g_free(output);
+	return next;
+}
+
+/* Free the rings of threads which exited. Needs log_mutex. */
+static void log_free_orphans(void)
+{
+	struct log_ring **link, *ring;
+
+	link = &log_rings;
+	while ((ring = *link)) {
+		if (g_atomic_int_get(&ring->orphaned)
+				&& g_atomic_int_get(&ring->wr_pos) == ring->rd_pos) {
+			*link = ring->next;
+			g_free(ring);
+		} else {
+			link = &ring->next;
+		}
+	}
+}
+
+/* Pass on one message, return FALSE when there is none. */
+static gboolean log_write_next(GString *batch, guint64 *dropped)
+{
+	struct log_ring *ring;
+	struct log_entry *entry;
+	otc_log_callback cb;
+	void *cb_data;
+	const char *text;
+	char notice[64];
+	guint64 count;
+
+	g_mutex_lock(&log_mutex);
+	ring = log_next_ring();
+	cb = otc_log_cb;
+	cb_data = otc_log_cb_data;
+	g_mutex_unlock(&log_mutex);
+
+	/* Report drops where they happened, i.e. before the next message. */
+	count = *dropped;
+	if (g_atomic_int_compare_and_exchange(&log_dropped_changed, 1, 0))
+		count = otc_log_dropped_get();
+	if (count != *dropped) {
+		g_snprintf(notice, sizeof(notice), "%s: %" G_GUINT64_FORMAT
+			" messages dropped.", LOG_PREFIX, count - *dropped);
+		if (cb == otc_logv)
+			log_format_line(batch, g_get_monotonic_time(), notice);
+		else if (cb)
+			log_call(cb, cb_data, OTC_LOG_WARN, "%s", notice);
+		*dropped = count;
+	}
+
+	if (!ring)
+		return FALSE;
+
+	/* The entry stays in place until rd_pos moves on. */
+	entry = &ring->entries[ring->rd_pos % LOG_RING_SIZE];
+	text = entry->long_text ? entry->long_text : entry->text;
+	if (cb == otc_logv) {
+		log_format_line(batch, entry->time_us, text);
+		if (batch->len >= LOG_BATCH_SIZE)
+			log_write(batch);
+	} else if (cb) {
+		log_call(cb, cb_data, entry->loglevel, "%s", text);
+	}
+	g_free(entry->long_text);
+	entry->long_text = NULL;
+	g_atomic_int_set(&ring->rd_pos, (ring->rd_pos + 1) & LOG_POS_MASK);
+
+	return TRUE;
+}
+
+static gpointer log_thread_run(void *data)
+{
+	GString *batch;
+	guint64 dropped;
+	int count;
+	gboolean stop;
+
+	(void)data;
+
+	batch = g_string_sized_new(LOG_BATCH_SIZE * 2);
+	g_atomic_int_set(&log_dropped_changed, 0);
+	dropped = otc_log_dropped_get();
+
+	do {
+		/* Let log_flush() check its progress now and then. */
+		for (count = 0; count < LOG_RING_SIZE; count++) {
+			if (!log_write_next(batch, &dropped))
+				break;
+		}
+		if (batch->len)
+			log_write(batch);
+
+		g_mutex_lock(&log_mutex);
+		g_cond_broadcast(&log_flushed_cond);
+		if (!log_flushing)
+			log_free_orphans();
+		/* Checked after setting the flag, see log_queue(). */
+		g_atomic_int_set(&log_writer_idle, 1);
+		if (!log_stop && !log_next_ring()) {
+			g_cond_wait_until(&log_cond, &log_mutex,
+				g_get_monotonic_time() + G_TIME_SPAN_SECOND);
+		}
+		g_atomic_int_set(&log_writer_idle, 0);
+		stop = log_stop && !log_next_ring();
+		g_mutex_unlock(&log_mutex);
+	} while (!stop);
+
+	g_string_free(batch, TRUE);
+
+	return NULL;
+}
+
+/* Wait until the background thread passed on the pending messages. */
+static void log_flush(void)
+{
+	struct log_ring *ring;
+	GPtrArray *rings;
+	GArray *targets;
+	unsigned int i;
+	int wr_pos, pending;
+
+	g_mutex_lock(&log_mutex);
+	if (!log_thread || g_thread_self() == log_thread) {
+		g_mutex_unlock(&log_mutex);
+		return;
+	}
+
+	rings = g_ptr_array_new();
+	targets = g_array_new(FALSE, FALSE, sizeof(int));
+	for (ring = log_rings; ring; ring = ring->next) {
+		wr_pos = g_atomic_int_get(&ring->wr_pos);
+		if (wr_pos != g_atomic_int_get(&ring->rd_pos)) {
+			g_ptr_array_add(rings, ring);
+			g_array_append_val(targets, wr_pos);
+		}
+	}
+
+	log_flushing++;
+	g_cond_signal(&log_cond);
+	for (i = 0; i < rings->len; ) {
+		ring = g_ptr_array_index(rings, i);
+		/* Up to the ring size while rd_pos is before the target. */
+		pending = LOG_POS_DIFF(g_array_index(targets, int, i),
+			g_atomic_int_get(&ring->rd_pos));
+		if (pending > 0 && pending <= LOG_RING_SIZE)
+			g_cond_wait(&log_flushed_cond, &log_mutex);
+		else
+			i++;
+	}
+	log_flushing--;
+	g_mutex_unlock(&log_mutex);
+
+	g_ptr_array_free(rings, TRUE);
+	g_array_free(targets, TRUE);
+}
+
+/**
+ * Set whether messages get passed on by a background thread.
+ *
+ * Messages then get formatted on the thread which logs them, and written
+ * out, or passed to the log callback, on the background thread. A log
+ * callback which otc_log_callback_set() installs then gets called on the
+ * background thread, with the formatted message as a "%s" argument.
+ *
+ * Disabling passes on all pending messages before it returns.
+ *
+ * @param enable TRUE to pass on messages in the background, FALSE to pass
+ *               them on right away (the default).
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR Failed to start the background thread.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_log_async_set(gboolean enable)
+{
+	GThread *thread;
+	GError *error;
+
+	g_mutex_lock(&log_async_mutex);
+
+	if (enable && !log_thread) {
+		log_stop = FALSE;
+		error = NULL;
+		thread = g_thread_try_new("otc-log", log_thread_run, NULL,
+			&error);
+		if (!thread) {
+			g_mutex_unlock(&log_async_mutex);
+			otc_err("Failed to start log thread: %s.",
+				error->message);
+			g_error_free(error);
+			return OTC_ERR;
+		}
+		g_mutex_lock(&log_mutex);
+		log_thread = thread;
+		g_mutex_unlock(&log_mutex);
+		g_atomic_int_set(&log_async, 1);
+	} else if (!enable && log_thread) {
+		/* Wait for threads which already decided to queue. */
+		g_atomic_int_set(&log_async, 0);
+		while (g_atomic_int_get(&log_inflight))
+			g_thread_yield();
+
+		g_mutex_lock(&log_mutex);
+		log_stop = TRUE;
+		g_cond_signal(&log_cond);
+		thread = log_thread;
+		g_mutex_unlock(&log_mutex);
+
+		g_thread_join(thread);
+
+		g_mutex_lock(&log_mutex);
+		log_thread = NULL;
+		g_mutex_unlock(&log_mutex);
+	}
+
+	g_mutex_unlock(&log_async_mutex);
 
 	return OTC_OK;
 }
 
-/** @private */
-OTC_PRIV int otc_log(int loglevel, const char *format, ...)
+/**
+ * Get the number of messages which were dropped.
+ *
+ * With otc_log_async_set(), info, debug and spew messages get dropped
+ * when a thread logs them faster than the background thread can pass
+ * them on. Errors and warnings don't get dropped, the thread waits for
+ * the background thread to catch up instead.
+ *
+ * @return The number of dropped messages since the library was loaded.
+ *
+ * @since 0.6.0
+ */
+OTC_API uint64_t otc_log_dropped_get(void)
+{
+	uint64_t count;
+
+	g_mutex_lock(&log_dropped_mutex);
+	count = log_dropped;
+	g_mutex_unlock(&log_dropped_mutex);
+
+	return count;
+}
+
+/**
+ * Log a message.
+ *
+ * Calls usually go through the otc_log() macro, which skips messages
+ * below the loglevel without a call.
+ *
+ * @private
+ */
+OTC_PRIV int (otc_log)(int loglevel, const char *format, ...)
 {
 	int ret;
+	gboolean queued;
 	va_list args;
 
 	/* Only output messages of at least the selected loglevel(s). */
-	if (loglevel > cur_loglevel)
+	if (loglevel > otc_cur_loglevel)
 		return OTC_OK;
 
 	/* Silently succeed when no logging callback is registered. */
 	if (!otc_log_cb)
 		return OTC_OK;
 
+	if (g_atomic_int_get(&log_async)) {
+		g_atomic_int_inc(&log_inflight);
+		queued = FALSE;
+		if (g_atomic_int_get(&log_async)) {
+			va_start(args, format);
+			queued = log_queue(loglevel, format, args);
+			va_end(args);
+		}
+		/*
+		 * Errors and warnings which found the ring full wait for it
+		 * to drain. That keeps their order, and the callback on the
+		 * background thread.
+		 */
+		if (!queued && g_atomic_int_get(&log_async)) {
+			log_flush();
+			va_start(args, format);
+			queued = log_queue(loglevel, format, args);
+			va_end(args);
+		}
+		g_atomic_int_add(&log_inflight, -1);
+		/* Messages of the background thread itself go below. */
+		if (queued)
+			return OTC_OK;
+	}
+
 	va_start(args, format);
 	ret = otc_log_cb(otc_log_cb_data, loglevel, format, args);
 	va_end(args);
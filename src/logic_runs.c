@@ -0,0 +1,428 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * Run-length logic sample feed
+ *
+ * For devices which compress their samples on the wire as (value, count)
+ * pairs. Drivers hand over runs as they decode them. The last run stays
+ * open, so that repetitions of its value only add to its count. Runs go
+ * to a logic feed queue when the value changes, which fills long runs
+ * without per sample work.
+ *
+ * Samples are held back until the queue's packet is complete, which can
+ * take long on slowly changing signals. otc_logic_runs_poll() bounds
+ * that latency, so that viewers keep updating while an acquisition is
+ * running.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include <string.h>
+
+#include "libopentracecapture-internal.h"
+
+#define LOG_PREFIX "logic_runs"
+
+/* Samples per logic packet which the session receives. */
+#define RUNS_PACKET_SAMPLES	(64 * 1024)
+/* Runs shorter than this get expanded into the literals buffer. */
+#define RUNS_SHORT	8
+#define RUNS_LITERALS	4096
+
+struct otc_logic_runs {
+	struct feed_queue_logic *queue;
+	size_t unitsize;
+	/* The open run. */
+	uint8_t *value;
+	size_t count;
+	/* Expanded short runs, which go to the queue in one piece. */
+	uint8_t *literals;
+	size_t literal_count;
+	uint64_t limit;
+	uint64_t samples;
+	/* Samples which were not sent to the session yet, and since when. */
+	gboolean pending;
+	gint64 pending_since_us;
+	gint64 latency_us;
+};
+
+/**
+ * Allocate a run-length logic feed.
+ *
+ * The initial value of the open run is all zeros, see
+ * otc_logic_runs_add() to start with another value.
+ *
+ * @param[in] sdi The device instance which sends the samples.
+ * @param[in] unitsize The number of bytes per logic sample.
+ * @param[in] latency_ms The maximum time which samples are held back by
+ *   otc_logic_runs_poll(). 0 sends all samples on every poll.
+ *
+ * @return The run-length feed, or #NULL when allocation failed.
+ */
+OTC_PRIV struct otc_logic_runs *otc_logic_runs_new(
+	const struct otc_dev_inst *sdi, size_t unitsize,
+	unsigned int latency_ms)
+{
+	struct otc_logic_runs *runs;
+
+	if (!unitsize)
+		return NULL;
+
+	runs = g_malloc0(sizeof(*runs));
+	runs->unitsize = unitsize;
+	runs->latency_us = (gint64)latency_ms * 1000;
+	runs->limit = UINT64_MAX;
+	runs->value = g_malloc0(unitsize);
+	runs->literals = g_malloc(RUNS_LITERALS * unitsize);
+	runs->queue = feed_queue_logic_alloc(sdi, RUNS_PACKET_SAMPLES, unitsize);
+	if (!runs->queue) {
+		otc_err("Cannot allocate run-length feed.");
+		otc_logic_runs_free(runs);
+		return NULL;
+	}
+
+	return runs;
+}
+
+/**
+ * Release a run-length logic feed.
+ *
+ * Samples which were not flushed get discarded.
+ *
+ * @param[in] runs The run-length feed to release. Can be #NULL.
+ */
+OTC_PRIV void otc_logic_runs_free(struct otc_logic_runs *runs)
+{
+	if (!runs)
+		return;
+
+	if (runs->queue)
+		feed_queue_logic_free(runs->queue);
+	g_free(runs->value);
+	g_free(runs->literals);
+	g_free(runs);
+}
+
+/**
+ * Limit the number of samples which the feed accepts.
+ *
+ * Samples beyond the limit get dropped silently. The limit counts from
+ * the current otc_logic_runs_samples() on. New feeds have no limit.
+ *
+ * @param[in] runs The run-length feed.
+ * @param[in] limit The number of further samples to accept.
+ */
+OTC_PRIV void otc_logic_runs_limit(struct otc_logic_runs *runs, uint64_t limit)
+{
+	runs->limit = limit < UINT64_MAX - runs->samples ?
+		runs->samples + limit : UINT64_MAX;
+}
+
+/**
+ * Get the number of samples which the feed accepted.
+ *
+ * @param[in] runs The run-length feed.
+ *
+ * @return The total number of samples, including those which are not
+ *   flushed yet.
+ */
+OTC_PRIV uint64_t otc_logic_runs_samples(const struct otc_logic_runs *runs)
+{
+	return runs->samples;
+}
+
+/**
+ * Check whether the feed reached its sample limit.
+ *
+ * @param[in] runs The run-length feed.
+ *
+ * @return TRUE when no more samples get accepted.
+ */
+OTC_PRIV gboolean otc_logic_runs_full(const struct otc_logic_runs *runs)
+{
+	return runs->samples >= runs->limit;
+}
+
+/* Clip a count to the sample limit and account for it. */
+static uint64_t runs_take(struct otc_logic_runs *runs, uint64_t count)
+{
+	if (count > runs->limit - runs->samples)
+		count = runs->limit - runs->samples;
+	if (!count)
+		return 0;
+
+	runs->samples += count;
+	if (!runs->pending) {
+		runs->pending = TRUE;
+		runs->pending_since_us = g_get_monotonic_time();
+	}
+
+	return count;
+}
+
+static int runs_submit_literals(struct otc_logic_runs *runs)
+{
+	int ret;
+
+	if (!runs->literal_count)
+		return OTC_OK;
+	ret = feed_queue_logic_submit_many(runs->queue, runs->literals,
+		runs->literal_count);
+	runs->literal_count = 0;
+
+	return ret;
+}
+
+/* Expand a short open run into the literals, the caller checked room. */
+static inline void runs_expand(struct otc_logic_runs *runs)
+{
+	uint8_t *wrptr;
+	size_t idx;
+
+	wrptr = &runs->literals[runs->literal_count * runs->unitsize];
+	if (runs->unitsize == 1) {
+		for (idx = 0; idx < runs->count; idx++)
+			wrptr[idx] = runs->value[0];
+	} else {
+		for (idx = 0; idx < runs->count; idx++)
+			memcpy(&wrptr[idx * runs->unitsize], runs->value,
+				runs->unitsize);
+	}
+	runs->literal_count += runs->count;
+}
+
+/*
+ * Pass the open run to the feed queue, keep its value. Signals which
+ * change with almost every sample would cost a queue call per sample,
+ * so short runs get collected, and submitted in one piece.
+ */
+static int runs_submit(struct otc_logic_runs *runs)
+{
+	int ret;
+
+	ret = OTC_OK;
+	if (runs->count >= RUNS_SHORT
+			|| runs->literal_count + runs->count > RUNS_LITERALS)
+		ret = runs_submit_literals(runs);
+	if (ret != OTC_OK) {
+		/* Nothing to do. */
+	} else if (runs->count < RUNS_SHORT) {
+		runs_expand(runs);
+	} else {
+		ret = feed_queue_logic_submit_runs(runs->queue, runs->value,
+			&runs->count, 1);
+	}
+	runs->count = 0;
+
+	return ret;
+}
+
+/**
+ * Extend the open run.
+ *
+ * This is the fast path for run-length codes which repeat the previous
+ * value, it does not touch any sample data.
+ *
+ * @param[in] runs The run-length feed.
+ * @param[in] count The number of additional samples of the open run's
+ *   value.
+ *
+ * @retval OTC_OK Success.
+ * @retval other Error code of the session feed.
+ */
+OTC_PRIV int otc_logic_runs_repeat(struct otc_logic_runs *runs, uint64_t count)
+{
+	size_t part;
+	int ret;
+
+	count = runs_take(runs, count);
+	while (count) {
+		/* Don't let the run's count wrap around. */
+		part = MIN(count, G_MAXSIZE - runs->count);
+		if (!part) {
+			ret = runs_submit(runs);
+			if (ret != OTC_OK)
+				return ret;
+			continue;
+		}
+		runs->count += part;
+		count -= part;
+	}
+
+	return OTC_OK;
+}
+
+/**
+ * Add a run of samples.
+ *
+ * The run becomes the open run, unless its value equals the open run's
+ * value, in which case that one gets extended. A count of 0 only sets
+ * the value which later otc_logic_runs_repeat() calls extend.
+ *
+ * @param[in] runs The run-length feed.
+ * @param[in] value The sample value, with the feed's unit size.
+ * @param[in] count The number of samples.
+ *
+ * @retval OTC_OK Success.
+ * @retval other Error code of the session feed.
+ */
+OTC_PRIV int otc_logic_runs_add(struct otc_logic_runs *runs,
+	const uint8_t *value, uint64_t count)
+{
+	int ret;
+
+	if (runs->unitsize == 1 ? *runs->value != *value :
+			memcmp(runs->value, value, runs->unitsize) != 0) {
+		if (runs->count) {
+			ret = runs_submit(runs);
+			if (ret != OTC_OK)
+				return ret;
+		}
+		memcpy(runs->value, value, runs->unitsize);
+	}
+
+	return otc_logic_runs_repeat(runs, count);
+}
+
+/* Runs of a batch which fits below the limit, see otc_logic_runs_add_many(). */
+static int runs_add_batch(struct otc_logic_runs *runs,
+	const uint8_t *values, const size_t *counts, size_t run_count)
+{
+	const size_t unitsize = runs->unitsize;
+	int ret;
+
+	for (; run_count; run_count--, values += unitsize, counts++) {
+		if (unitsize == 1 ? *runs->value == *values :
+				memcmp(runs->value, values, unitsize) == 0) {
+			runs->count += *counts;
+			continue;
+		}
+		if (runs->count < RUNS_SHORT && runs->literal_count
+				+ runs->count <= RUNS_LITERALS) {
+			runs_expand(runs);
+		} else if (runs->count) {
+			ret = runs_submit(runs);
+			if (ret != OTC_OK)
+				return ret;
+		}
+		if (unitsize == 1)
+			runs->value[0] = *values;
+		else
+			memcpy(runs->value, values, unitsize);
+		runs->count = *counts;
+	}
+
+	return OTC_OK;
+}
+
+/**
+ * Add a sequence of runs.
+ *
+ * Like otc_logic_runs_add() for each run, for decoders which collect
+ * runs before they pass them on. That saves a call per run, which
+ * matters for signals which change with almost every sample. Batches
+ * which stay below the sample limit get accounted for once, and short
+ * runs get expanded in place.
+ *
+ * @param[in] runs The run-length feed.
+ * @param[in] values The sample values, with the feed's unit size each.
+ * @param[in] counts The number of samples of each run.
+ * @param[in] run_count The number of runs.
+ *
+ * @retval OTC_OK Success.
+ * @retval other Error code of the session feed.
+ */
+OTC_PRIV int otc_logic_runs_add_many(struct otc_logic_runs *runs,
+	const uint8_t *values, const size_t *counts, size_t run_count)
+{
+	size_t idx, total;
+	int ret;
+
+	/* The open run's count must not wrap around either. */
+	total = runs->count;
+	for (idx = 0; idx < run_count; idx++) {
+		if (counts[idx] > G_MAXSIZE - total)
+			break;
+		total += counts[idx];
+	}
+	if (idx == run_count && total - runs->count
+			<= runs->limit - runs->samples) {
+		runs_take(runs, total - runs->count);
+		return runs_add_batch(runs, values, counts, run_count);
+	}
+
+	while (run_count--) {
+		ret = otc_logic_runs_add(runs, values, *counts++);
+		if (ret != OTC_OK)
+			return ret;
+		values += runs->unitsize;
+	}
+
+	return OTC_OK;
+}
+
+/**
+ * Send all accepted samples to the session.
+ *
+ * The open run's value is kept, so that otc_logic_runs_repeat() can
+ * continue it.
+ *
+ * @param[in] runs The run-length feed.
+ *
+ * @retval OTC_OK Success.
+ * @retval other Error code of the session feed.
+ */
+OTC_PRIV int otc_logic_runs_flush(struct otc_logic_runs *runs)
+{
+	int ret;
+
+	ret = runs_submit(runs);
+	if (ret == OTC_OK)
+		ret = runs_submit_literals(runs);
+	if (ret == OTC_OK)
+		ret = feed_queue_logic_flush(runs->queue);
+	runs->pending = FALSE;
+
+	return ret;
+}
+
+/**
+ * Send samples to the session which were held back for too long.
+ *
+ * Drivers call this after they processed a chunk of input data, and
+ * when their receive callbacks time out.
+ *
+ * @param[in] runs The run-length feed.
+ *
+ * @retval OTC_OK Success.
+ * @retval other Error code of the session feed.
+ */
+OTC_PRIV int otc_logic_runs_poll(struct otc_logic_runs *runs)
+{
+	if (!runs->pending)
+		return OTC_OK;
+	if (g_get_monotonic_time() - runs->pending_since_us < runs->latency_us)
+		return OTC_OK;
+
+	return otc_logic_runs_flush(runs);
+}
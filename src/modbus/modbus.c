@@ -25,9 +25,11 @@
 
 #define LOG_PREFIX "modbus"
 
+OTC_PRIV extern const struct otc_modbus_dev_inst modbus_tcp_dev;
 OTC_PRIV extern const struct otc_modbus_dev_inst modbus_serial_rtu_dev;
 
 static const struct otc_modbus_dev_inst *modbus_devs[] = {
+	&modbus_tcp_dev,
 #ifdef HAVE_SERIAL_COMM
 	&modbus_serial_rtu_dev, /* Must be last as it matches any resource. */
 #endif
@@ -258,7 +260,7 @@ OTC_PRIV int otc_modbus_reply(struct otc_modbus_dev_inst *modbus,
 
 	laststart = g_get_monotonic_time();
 
-	ret = modbus->read_begin(modbus->priv, reply);
+	ret = modbus->read_begin(modbus->priv, reply, modbus->read_timeout_ms);
 	if (ret != OTC_OK)
 		return ret;
 	if (*reply & 0x80)
@@ -552,6 +554,267 @@ OTC_PRIV int otc_modbus_write_multiple_registers(struct otc_modbus_dev_inst*modb
 	return OTC_OK;
 }
 
+/*
+ * Register polling plans. Drivers which periodically read several
+ * register ranges declare them once, the plan coalesces adjacent (or
+ * nearly adjacent) ranges into as few read holding registers requests
+ * as possible. Transports which support it get all of a cycle's
+ * requests in flight before the first response is awaited.
+ */
+
+#define MODBUS_MAX_READ_REGISTERS 125
+
+struct modbus_plan_block {
+	uint16_t address;
+	uint16_t count;
+	size_t offset;
+	gboolean valid;
+};
+
+struct otc_modbus_plan {
+	GArray *ranges;
+	GArray *blocks;
+	uint16_t *cache;
+	int max_gap;
+	gboolean dirty;
+};
+
+/**
+ * Create a register polling plan.
+ *
+ * @param max_gap The number of unrequested registers which may get read
+ *                in addition, to merge two ranges into a single request.
+ *                Use 0 when the device rejects reads of unmapped registers.
+ *
+ * @return The newly allocated plan.
+ */
+OTC_PRIV struct otc_modbus_plan *otc_modbus_plan_new(int max_gap)
+{
+	struct otc_modbus_plan *plan;
+
+	plan = g_malloc0(sizeof(*plan));
+	plan->ranges = g_array_new(FALSE, FALSE, sizeof(struct modbus_plan_block));
+	plan->blocks = g_array_new(FALSE, FALSE, sizeof(struct modbus_plan_block));
+	plan->max_gap = MAX(max_gap, 0);
+
+	return plan;
+}
+
+/**
+ * Free a register polling plan.
+ *
+ * @param plan The plan to free. Can be NULL.
+ */
+OTC_PRIV void otc_modbus_plan_free(struct otc_modbus_plan *plan)
+{
+	if (!plan)
+		return;
+
+	g_array_free(plan->ranges, TRUE);
+	g_array_free(plan->blocks, TRUE);
+	g_free(plan->cache);
+	g_free(plan);
+}
+
+/**
+ * Add a range of holding registers to a polling plan.
+ *
+ * @param plan The plan to extend.
+ * @param address The Modbus address of the first register.
+ * @param nb_registers The number of registers.
+ *
+ * @return OTC_OK upon success, OTC_ERR_ARG upon invalid arguments.
+ */
+OTC_PRIV int otc_modbus_plan_add(struct otc_modbus_plan *plan,
+		int address, int nb_registers)
+{
+	struct modbus_plan_block range;
+
+	if (!plan || address < 0 || nb_registers < 1
+	    || nb_registers > MODBUS_MAX_READ_REGISTERS
+	    || address + nb_registers > 0x10000)
+		return OTC_ERR_ARG;
+
+	memset(&range, 0, sizeof(range));
+	range.address = address;
+	range.count = nb_registers;
+	g_array_append_val(plan->ranges, range);
+	plan->dirty = TRUE;
+
+	return OTC_OK;
+}
+
+static int modbus_plan_range_cmp(const void *a, const void *b)
+{
+	const struct modbus_plan_block *ra = a, *rb = b;
+
+	if (ra->address != rb->address)
+		return ra->address < rb->address ? -1 : 1;
+	return (int)ra->count - (int)rb->count;
+}
+
+static void modbus_plan_build(struct otc_modbus_plan *plan)
+{
+	struct modbus_plan_block *range, block;
+	unsigned int end, range_end;
+	size_t i, total;
+
+	g_array_sort(plan->ranges, modbus_plan_range_cmp);
+	g_array_set_size(plan->blocks, 0);
+
+	memset(&block, 0, sizeof(block));
+	total = 0;
+	end = 0;
+	for (i = 0; i < plan->ranges->len; i++) {
+		range = &g_array_index(plan->ranges, struct modbus_plan_block, i);
+		range_end = range->address + range->count;
+		if (i && range->address <= end + plan->max_gap
+		    && MAX(end, range_end) - block.address
+		       <= MODBUS_MAX_READ_REGISTERS) {
+			end = MAX(end, range_end);
+			continue;
+		}
+		if (i) {
+			block.count = end - block.address;
+			block.offset = total;
+			total += block.count;
+			g_array_append_val(plan->blocks, block);
+		}
+		memset(&block, 0, sizeof(block));
+		block.address = range->address;
+		end = range_end;
+	}
+	if (plan->ranges->len) {
+		block.count = end - block.address;
+		block.offset = total;
+		total += block.count;
+		g_array_append_val(plan->blocks, block);
+	}
+
+	g_free(plan->cache);
+	plan->cache = g_malloc0(MAX(total, 1) * sizeof(plan->cache[0]));
+	plan->dirty = FALSE;
+
+	otc_dbg("Polling plan: %u range(s) in %u request(s), %zu register(s).",
+		plan->ranges->len, plan->blocks->len, total);
+}
+
+/**
+ * Get the number of read requests which a polling plan issues per cycle.
+ *
+ * @param plan The plan to inspect.
+ *
+ * @return The number of coalesced register blocks.
+ */
+OTC_PRIV size_t otc_modbus_plan_block_count(struct otc_modbus_plan *plan)
+{
+	if (!plan)
+		return 0;
+	if (plan->dirty)
+		modbus_plan_build(plan);
+
+	return plan->blocks->len;
+}
+
+/**
+ * Run one polling cycle: read all of a plan's register blocks.
+ *
+ * Up to the transport's max_pending requests are sent before the
+ * respective responses get read, to hide the round trip time on links
+ * which support pipelining. Serial links keep one request in flight.
+ *
+ * @param modbus Previously initialized Modbus device structure.
+ * @param plan The plan to run.
+ *
+ * @return OTC_OK upon success, OTC_ERR_ARG upon invalid arguments,
+ *         OTC_ERR_DATA upon invalid data, or OTC_ERR on failure. Blocks
+ *         which were read before a failure remain accessible.
+ */
+OTC_PRIV int otc_modbus_plan_run(struct otc_modbus_dev_inst *modbus,
+		struct otc_modbus_plan *plan)
+{
+	struct modbus_plan_block *block;
+	size_t count, depth, sent, done, i;
+	int ret;
+
+	if (!modbus || !plan)
+		return OTC_ERR_ARG;
+	if (plan->dirty)
+		modbus_plan_build(plan);
+
+	count = plan->blocks->len;
+	for (i = 0; i < count; i++)
+		g_array_index(plan->blocks, struct modbus_plan_block, i).valid = FALSE;
+
+	depth = MAX(modbus->max_pending, 1);
+	sent = done = 0;
+	while (done < count) {
+		while (sent < count && sent - done < depth) {
+			block = &g_array_index(plan->blocks,
+				struct modbus_plan_block, sent);
+			ret = otc_modbus_read_holding_registers(modbus,
+				block->address, block->count, NULL);
+			if (ret != OTC_OK)
+				goto abort;
+			sent++;
+		}
+		block = &g_array_index(plan->blocks, struct modbus_plan_block, done);
+		ret = otc_modbus_read_holding_registers(modbus,
+			-1, block->count, &plan->cache[block->offset]);
+		if (ret != OTC_OK)
+			goto abort;
+		block->valid = TRUE;
+		done++;
+	}
+
+	return OTC_OK;
+
+abort:
+	if (modbus->flush && sent > done)
+		modbus->flush(modbus->priv);
+	return ret;
+}
+
+/**
+ * Get register values which the last polling cycle has read.
+ *
+ * @param plan The plan which was run before.
+ * @param address The Modbus address of the first register.
+ * @param nb_registers The number of registers.
+ * @param registers Buffer to store the registers values, in the same
+ *                  format as otc_modbus_read_holding_registers() uses.
+ *
+ * @return OTC_OK upon success, OTC_ERR_ARG upon invalid arguments,
+ *         OTC_ERR_NA when the range was not (successfully) read.
+ */
+OTC_PRIV int otc_modbus_plan_get(const struct otc_modbus_plan *plan,
+		int address, int nb_registers, uint16_t *registers)
+{
+	const struct modbus_plan_block *block;
+	size_t i;
+
+	if (!plan || !registers || address < 0 || nb_registers < 1)
+		return OTC_ERR_ARG;
+	if (plan->dirty)
+		return OTC_ERR_NA;
+
+	for (i = 0; i < plan->blocks->len; i++) {
+		block = &g_array_index(plan->blocks, struct modbus_plan_block, i);
+		if (address < block->address)
+			break;
+		if (address + nb_registers > block->address + block->count)
+			continue;
+		if (!block->valid)
+			return OTC_ERR_NA;
+		memcpy(registers,
+			&plan->cache[block->offset + address - block->address],
+			nb_registers * sizeof(registers[0]));
+		return OTC_OK;
+	}
+
+	return OTC_ERR_NA;
+}
+
 /**
  * Close Modbus device.
  *
@@ -105,12 +105,16 @@ static int modbus_serial_rtu_send(void *priv,
 	return OTC_OK;
 }
 
-static int modbus_serial_rtu_read_begin(void *priv, uint8_t *function_code)
+static int modbus_serial_rtu_read_begin(void *priv, uint8_t *function_code,
+		unsigned int timeout_ms)
 {
 	struct modbus_serial_rtu *modbus = priv;
 	uint8_t slave_addr;
 	int ret;
 
+	/* RTU framing has its own inter-character timing, see below. */
+	(void)timeout_ms;
+
 	ret = serial_read_blocking(modbus->serial, &slave_addr, 1, 500);
 	if (ret != 1 || slave_addr != modbus->slave_addr)
 		return OTC_ERR;
@@ -0,0 +1,361 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Modbus/TCP transport. Resources look like "tcp/<host>[/<port>]", the
+ * port defaults to 502. Each PDU is prefixed with an MBAP header which
+ * carries a transaction identifier. Responses get matched against the
+ * identifiers of outstanding requests, which allows to have several
+ * requests in flight (see otc_modbus_plan_run()).
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <string.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "../libopentracecapture-internal.h"
+
+#define LOG_PREFIX "modbus_tcp"
+
+#define MODBUS_TCP_DEFAULT_PORT	"502"
+#define MBAP_HEADER_SIZE	7
+#define MBAP_MAX_LENGTH		254	/* Unit ID plus max PDU size (253). */
+#define MODBUS_TCP_MAX_PENDING	8
+#define MODBUS_TCP_RX_SIZE	4096
+
+struct modbus_tcp {
+	struct otc_tcp_dev_inst *tcp_dev;
+	uint8_t unit_id;
+	uint16_t next_tid;
+	uint16_t pending[MODBUS_TCP_MAX_PENDING];
+	size_t pending_head;
+	size_t pending_count;
+	size_t rx_remain;
+	unsigned int rx_timeout_ms;
+};
+
+static int modbus_tcp_dev_inst_new(void *priv, const char *resource,
+		char **params, const char *serialcomm, int modbusaddr)
+{
+	struct modbus_tcp *modbus = priv;
+
+	(void)resource;
+	(void)serialcomm;
+
+	if (!params || !params[1] || !*params[1]) {
+		otc_err("Invalid parameters.");
+		return OTC_ERR;
+	}
+
+	modbus->tcp_dev = otc_tcp_dev_inst_new(params[1],
+		(params[2] && *params[2]) ? params[2] : MODBUS_TCP_DEFAULT_PORT);
+	if (!modbus->tcp_dev)
+		return OTC_ERR;
+	modbus->unit_id = modbusaddr;
+
+	return OTC_OK;
+}
+
+static void modbus_tcp_flush(void *priv)
+{
+	struct modbus_tcp *modbus = priv;
+
+	/*
+	 * Forget about outstanding requests and discard buffered receive
+	 * data. Late responses to the forgotten requests carry unknown
+	 * transaction identifiers, and get skipped by read_begin().
+	 */
+	modbus->pending_head = 0;
+	modbus->pending_count = 0;
+	modbus->rx_remain = 0;
+	(void)otc_tcp_rx_buffer_alloc(modbus->tcp_dev, MODBUS_TCP_RX_SIZE);
+}
+
+static int modbus_tcp_open(void *priv)
+{
+	struct modbus_tcp *modbus = priv;
+	int ret;
+
+	ret = otc_tcp_connect(modbus->tcp_dev);
+	if (ret != OTC_OK)
+		return ret;
+
+	/* Requests are tiny, don't let Nagle hold them back. */
+	(void)otc_tcp_set_sockopts(modbus->tcp_dev, 0, TRUE);
+
+	ret = otc_tcp_rx_buffer_alloc(modbus->tcp_dev, MODBUS_TCP_RX_SIZE);
+	if (ret != OTC_OK) {
+		otc_tcp_disconnect(modbus->tcp_dev);
+		return ret;
+	}
+	modbus_tcp_flush(modbus);
+
+	return OTC_OK;
+}
+
+static int modbus_tcp_source_add(struct otc_session *session, void *priv,
+		int events, int timeout, otc_receive_data_callback cb, void *cb_data)
+{
+	struct modbus_tcp *modbus = priv;
+
+	(void)events;
+
+	return otc_tcp_rx_source_add(session, modbus->tcp_dev,
+		timeout, cb, cb_data);
+}
+
+static int modbus_tcp_source_remove(struct otc_session *session, void *priv)
+{
+	struct modbus_tcp *modbus = priv;
+
+	return otc_tcp_source_remove(session, modbus->tcp_dev);
+}
+
+static int modbus_tcp_send(void *priv, const uint8_t *buffer, int buffer_size)
+{
+	struct modbus_tcp *modbus = priv;
+	uint8_t adu[MBAP_HEADER_SIZE + MBAP_MAX_LENGTH - 1];
+	size_t adu_len, written, slot;
+	uint16_t tid;
+	int ret;
+
+	if (buffer_size < 1 || buffer_size > MBAP_MAX_LENGTH - 1)
+		return OTC_ERR_ARG;
+	if (modbus->pending_count == MODBUS_TCP_MAX_PENDING) {
+		otc_err("Too many outstanding requests.");
+		return OTC_ERR;
+	}
+
+	tid = modbus->next_tid++;
+	WB16(adu + 0, tid);
+	WB16(adu + 2, 0);
+	WB16(adu + 4, buffer_size + 1);
+	W8(adu + 6, modbus->unit_id);
+	memcpy(adu + MBAP_HEADER_SIZE, buffer, buffer_size);
+	adu_len = MBAP_HEADER_SIZE + buffer_size;
+
+	written = 0;
+	while (written < adu_len) {
+		ret = otc_tcp_write_bytes(modbus->tcp_dev,
+			adu + written, adu_len - written);
+		if (ret <= 0) {
+			otc_err("Send error.");
+			return OTC_ERR;
+		}
+		written += ret;
+	}
+
+	slot = (modbus->pending_head + modbus->pending_count)
+		% MODBUS_TCP_MAX_PENDING;
+	modbus->pending[slot] = tid;
+	modbus->pending_count++;
+
+	return OTC_OK;
+}
+
+/* Receive exactly 'len' bytes, or fail after 'timeout_ms' of silence. */
+static int modbus_tcp_read_full(struct modbus_tcp *modbus,
+		uint8_t *buf, size_t len, unsigned int timeout_ms)
+{
+	size_t got;
+	uint8_t discard[64];
+	int ret;
+
+	got = 0;
+	while (got < len) {
+		if (buf)
+			ret = otc_tcp_rx_read(modbus->tcp_dev,
+				buf + got, len - got);
+		else
+			ret = otc_tcp_rx_read(modbus->tcp_dev,
+				discard, MIN(len - got, sizeof(discard)));
+		if (ret < 0)
+			return ret;
+		if (ret > 0) {
+			got += ret;
+			continue;
+		}
+		if (modbus->tcp_dev->rx_eof) {
+			otc_err("Connection closed by peer.");
+			return OTC_ERR_IO;
+		}
+		ret = otc_tcp_rx_wait(modbus->tcp_dev, timeout_ms);
+		if (ret != OTC_OK)
+			return ret;
+	}
+
+	return OTC_OK;
+}
+
+/* Find an outstanding transaction, drop the ones which were skipped. */
+static gboolean modbus_tcp_pending_take(struct modbus_tcp *modbus,
+		uint16_t tid)
+{
+	size_t idx, slot;
+
+	for (idx = 0; idx < modbus->pending_count; idx++) {
+		slot = (modbus->pending_head + idx) % MODBUS_TCP_MAX_PENDING;
+		if (modbus->pending[slot] != tid)
+			continue;
+		if (idx)
+			otc_warn("Lost %zu response(s) before transaction %u.",
+				idx, tid);
+		modbus->pending_head = (slot + 1) % MODBUS_TCP_MAX_PENDING;
+		modbus->pending_count -= idx + 1;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static int modbus_tcp_read_begin(void *priv, uint8_t *function_code,
+		unsigned int timeout_ms)
+{
+	struct modbus_tcp *modbus = priv;
+	uint8_t header[MBAP_HEADER_SIZE];
+	uint16_t tid, proto, length;
+	int ret;
+
+	if (!modbus->pending_count)
+		return OTC_ERR;
+	modbus->rx_timeout_ms = timeout_ms;
+
+	while (1) {
+		ret = modbus_tcp_read_full(modbus, header, sizeof(header),
+			timeout_ms);
+		if (ret != OTC_OK)
+			return OTC_ERR;
+		tid = RB16(header + 0);
+		proto = RB16(header + 2);
+		length = RB16(header + 4);
+		if (proto != 0 || length < 2 || length > MBAP_MAX_LENGTH) {
+			otc_err("Invalid MBAP header (proto %u, length %u).",
+				proto, length);
+			modbus_tcp_flush(modbus);
+			return OTC_ERR;
+		}
+		if (modbus_tcp_pending_take(modbus, tid))
+			break;
+		/* Late response to a request which was given up on. */
+		otc_dbg("Skipping response to unknown transaction %u.", tid);
+		ret = modbus_tcp_read_full(modbus, NULL, length - 1,
+			timeout_ms);
+		if (ret != OTC_OK)
+			return OTC_ERR;
+	}
+
+	ret = modbus_tcp_read_full(modbus, function_code, 1, timeout_ms);
+	if (ret != OTC_OK)
+		return OTC_ERR;
+	modbus->rx_remain = length - 2;
+
+	if (R8(header + 6) != modbus->unit_id) {
+		otc_err("Response from unexpected unit %u.", R8(header + 6));
+		(void)modbus_tcp_read_full(modbus, NULL, modbus->rx_remain,
+			timeout_ms);
+		modbus->rx_remain = 0;
+		return OTC_ERR;
+	}
+
+	return OTC_OK;
+}
+
+static int modbus_tcp_read_data(void *priv, uint8_t *buf, int maxlen)
+{
+	struct modbus_tcp *modbus = priv;
+	int ret;
+
+	if (maxlen <= 0)
+		return 0;
+	/* The MBAP length tells when the PDU is shorter than expected. */
+	if (!modbus->rx_remain)
+		return OTC_ERR_DATA;
+
+	/*
+	 * Sleep until data arrives rather than have the caller spin. The
+	 * caller gives up when nothing arrived within its timeout.
+	 */
+	ret = otc_tcp_rx_wait(modbus->tcp_dev, modbus->rx_timeout_ms);
+	if (ret == OTC_ERR_TIMEOUT)
+		return 0;
+	if (ret != OTC_OK)
+		return ret;
+	ret = otc_tcp_rx_read(modbus->tcp_dev, buf,
+		MIN((size_t)maxlen, modbus->rx_remain));
+	if (ret < 0)
+		return ret;
+	if (!ret && modbus->tcp_dev->rx_eof)
+		return OTC_ERR_IO;
+	modbus->rx_remain -= ret;
+
+	return ret;
+}
+
+static int modbus_tcp_read_end(void *priv)
+{
+	struct modbus_tcp *modbus = priv;
+	size_t excess;
+
+	if (!modbus->rx_remain)
+		return OTC_OK;
+
+	excess = modbus->rx_remain;
+	modbus->rx_remain = 0;
+	otc_err("Response is %zu byte(s) longer than expected.", excess);
+	if (modbus_tcp_read_full(modbus, NULL, excess,
+			modbus->rx_timeout_ms) != OTC_OK)
+		modbus_tcp_flush(modbus);
+
+	return OTC_ERR_DATA;
+}
+
+static int modbus_tcp_close(void *priv)
+{
+	struct modbus_tcp *modbus = priv;
+
+	(void)otc_tcp_rx_buffer_alloc(modbus->tcp_dev, 0);
+
+	return otc_tcp_disconnect(modbus->tcp_dev);
+}
+
+static void modbus_tcp_free(void *priv)
+{
+	struct modbus_tcp *modbus = priv;
+
+	otc_tcp_dev_inst_free(modbus->tcp_dev);
+}
+
+OTC_PRIV const struct otc_modbus_dev_inst modbus_tcp_dev = {
+	.name          = "tcp",
+	.prefix        = "tcp/",
+	.priv_size     = sizeof(struct modbus_tcp),
+	.scan          = NULL,
+	.dev_inst_new  = modbus_tcp_dev_inst_new,
+	.open          = modbus_tcp_open,
+	.source_add    = modbus_tcp_source_add,
+	.source_remove = modbus_tcp_source_remove,
+	.send          = modbus_tcp_send,
+	.read_begin    = modbus_tcp_read_begin,
+	.read_data     = modbus_tcp_read_data,
+	.read_end      = modbus_tcp_read_end,
+	.flush         = modbus_tcp_flush,
+	.close         = modbus_tcp_close,
+	.free          = modbus_tcp_free,
+	.max_pending   = MODBUS_TCP_MAX_PENDING,
+};
@@ -121,11 +121,10 @@ static int init(struct otc_output *o, GHashTable *options)
 	return OTC_OK;
 }
 
-static GString *gen_header(const struct otc_output *o)
+static void gen_header(const struct otc_output *o, GString *header)
 {
 	struct context *ctx;
 	GVariant *gvar;
-	GString *header;
 	size_t num_channels;
 	char *samplerate_s;
 
@@ -138,8 +137,7 @@ static GString *gen_header(const struct otc_output *o)
 		}
 	}
 
-	header = g_string_sized_new(512);
-	g_string_printf(header, "%s %s\n", PACKAGE_NAME, otc_package_version_string_get());
+	g_string_append_printf(header, "%s %s\n", PACKAGE_NAME, otc_package_version_string_get());
 	num_channels = g_slist_length(o->sdi->channels);
 	g_string_append_printf(header, "Acquisition with %zu/%zu channels",
 			ctx->num_enabled_channels, num_channels);
@@ -148,9 +146,7 @@ static GString *gen_header(const struct otc_output *o)
 		g_string_append_printf(header, " at %s", samplerate_s);
 		g_free(samplerate_s);
 	}
-	g_string_append_printf(header, "\n");
-
-	return header;
+	g_string_append_c(header, '\n');
 }
 
 static void maybe_add_trigger(struct context *ctx, GString *out)
@@ -172,8 +168,8 @@ static void maybe_add_trigger(struct context *ctx, GString *out)
 		offset + 1, "^", offset);
 }
 
-static int receive(const struct otc_output *o, const struct otc_datafeed_packet *packet,
-		GString **out)
+static int append(const struct otc_output *o, const struct otc_datafeed_packet *packet,
+		GString *out)
 {
 	const struct otc_datafeed_meta *meta;
 	const struct otc_datafeed_logic *logic;
@@ -188,7 +184,6 @@ static int receive(const struct otc_output *o, const struct otc_datafeed_packet
 	char c;
 	size_t charidx;
 
-	*out = NULL;
 	if (!o || !o->sdi)
 		return OTC_ERR_ARG;
 	if (!(ctx = o->priv))
@@ -209,10 +204,8 @@ static int receive(const struct otc_output *o, const struct otc_datafeed_packet
 		break;
 	case OTC_DF_LOGIC:
 		if (!ctx->header_done) {
-			*out = gen_header(o);
+			gen_header(o, out);
 			ctx->header_done = TRUE;
-		} else {
-			*out = g_string_sized_new(512);
 		}
 
 		logic = packet->payload;
@@ -237,11 +230,12 @@ static int receive(const struct otc_output *o, const struct otc_datafeed_packet
 
 				if (ctx->spl_cnt == ctx->spl) {
 					/* Flush line buffers. */
-					g_string_append_len(*out, ctx->lines[j]->str, ctx->lines[j]->len);
-					g_string_append_c(*out, '\n');
+					g_string_append_len(out, ctx->lines[j]->str, ctx->lines[j]->len);
+					g_string_append_c(out, '\n');
 					if (j + 1 == ctx->num_enabled_channels)
-						maybe_add_trigger(ctx, *out);
-					g_string_printf(ctx->lines[j], "%s:", ctx->aligned_names[j]);
+						maybe_add_trigger(ctx, out);
+					/* Keep the "name:" prefix. */
+					g_string_truncate(ctx->lines[j], ctx->max_namelen + 1);
 				}
 			}
 			if (ctx->spl_cnt == ctx->spl)
@@ -254,12 +248,11 @@ static int receive(const struct otc_output *o, const struct otc_datafeed_packet
 	case OTC_DF_END:
 		if (ctx->spl_cnt) {
 			/* Line buffers need flushing. */
-			*out = g_string_sized_new(512);
 			for (i = 0; i < ctx->num_enabled_channels; i++) {
-				g_string_append_len(*out, ctx->lines[i]->str, ctx->lines[i]->len);
-				g_string_append_c(*out, '\n');
+				g_string_append_len(out, ctx->lines[i]->str, ctx->lines[i]->len);
+				g_string_append_c(out, '\n');
 			}
-			maybe_add_trigger(ctx, *out);
+			maybe_add_trigger(ctx, out);
 		}
 		break;
 	}
@@ -319,6 +312,6 @@ OTC_PRIV struct otc_output_module output_ascii = {
 	.flags = 0,
 	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
 	.cleanup = cleanup,
 };
@@ -215,19 +215,17 @@ static const char *xlabels[] = {
 	"femtoseconds", "attoseconds",
 };
 
-static GString *gen_header(const struct otc_output *o,
-			   const struct otc_datafeed_header *hdr)
+static void gen_header(const struct otc_output *o,
+			   const struct otc_datafeed_header *hdr, GString *header)
 {
 	struct context *ctx;
 	struct otc_channel *ch;
 	GVariant *gvar;
-	GString *header;
 	GSList *channels, *l;
 	unsigned int num_channels, i;
 	char *samplerate_s;
 
 	ctx = o->priv;
-	header = g_string_sized_new(512);
 
 	if (ctx->sample_rate == 0) {
 		if (otc_config_get(o->sdi->driver, o->sdi, NULL,
@@ -275,7 +273,7 @@ static GString *gen_header(const struct otc_output *o,
 			/* Drop last separator. */
 			g_string_truncate(header, header->len - 1);
 		}
-		g_string_append_printf(header, "\n");
+		g_string_append_c(header, '\n');
 		if (ctx->sample_rate != 0) {
 			samplerate_s = otc_samplerate_string(ctx->sample_rate);
 			g_string_append_printf(header, "%s Samplerate: %s\n",
@@ -288,8 +286,6 @@ static GString *gen_header(const struct otc_output *o,
 	/* Time column requested but samplerate unknown. Emit a warning. */
 	if (ctx->time && !ctx->sample_rate)
 		otc_warn("Samplerate unknown, cannot provide timestamps.");
-
-	return header;
 }
 
 /*
@@ -407,7 +403,7 @@ static void process_logic(struct context *ctx,
 	}
 }
 
-static void dump_saved_values(struct context *ctx, GString **out)
+static void dump_saved_values(struct context *ctx, GString *out)
 {
 	unsigned int i, j, analog_size, num_channels;
 	double sample_time_dbl;
@@ -422,29 +418,27 @@ static void dump_saved_values(struct context *ctx, GString **out)
 	} else {
 		otc_info("Dumping %u samples", ctx->num_samples);
 
-		if (!*out)
-			*out = g_string_sized_new(512);
 		num_channels =
 		    ctx->num_logic_channels + ctx->num_analog_channels;
 
 		if (ctx->label_do) {
 			if (ctx->time)
-				g_string_append_printf(*out, "%s%s",
+				g_string_append_printf(out, "%s%s",
 					ctx->label_names ? "Time" : ctx->xlabel,
 					ctx->value);
 			for (i = 0; i < num_channels; i++) {
-				g_string_append_printf(*out, "%s%s",
+				g_string_append_printf(out, "%s%s",
 					ctx->channels[i].label, ctx->value);
 				if (ctx->channels[i].ch->type == OTC_CHANNEL_ANALOG
 						&& ctx->label_names)
 					g_free(ctx->channels[i].label);
 			}
 			if (ctx->do_trigger)
-				g_string_append_printf(*out, "Trigger%s",
+				g_string_append_printf(out, "Trigger%s",
 						       ctx->value);
 			/* Drop last separator. */
-			g_string_truncate(*out, (*out)->len - 1);
-			g_string_append(*out, ctx->record);
+			g_string_truncate(out, out->len - 1);
+			g_string_append(out, ctx->record);
 
 			ctx->label_do = FALSE;
 		}
@@ -476,13 +470,13 @@ static void dump_saved_values(struct context *ctx, GString **out)
 			}
 
 			if (ctx->time && !ctx->sample_rate) {
-				g_string_append_printf(*out, "0%s", ctx->value);
+				g_string_append_printf(out, "0%s", ctx->value);
 			} else if (ctx->time) {
 				sample_time_dbl = ctx->out_sample_count++;
 				sample_time_dbl /= ctx->sample_rate;
 				sample_time_dbl *= ctx->sample_scale;
 				sample_time_u64 = sample_time_dbl;
-				g_string_append_printf(*out, "%" PRIu64 "%s",
+				g_string_append_printf(out, "%" PRIu64 "%s",
 					sample_time_u64, ctx->value);
 			}
 
@@ -493,11 +487,11 @@ static void dump_saved_values(struct context *ctx, GString **out)
 					    fmax(value, ctx->channels[j].max);
 					ctx->channels[j].min =
 					    fmin(value, ctx->channels[j].min);
-					g_string_append_printf(*out, "%g%s",
+					g_string_append_printf(out, "%g%s",
 						value, ctx->value);
 				} else if (ctx->channels[j].ch->type == OTC_CHANNEL_LOGIC) {
-					g_string_append_printf(*out, "%c%s",
-							       ctx->logic_samples[i * ctx->num_logic_channels + j] ? '1' : '0', ctx->value);
+					g_string_append_c(out, ctx->logic_samples[i * ctx->num_logic_channels + j] ? '1' : '0');
+					g_string_append(out, ctx->value);
 				} else {
 					otc_warn("Unexpected channel type: %d",
 						ctx->channels[i].ch->type);
@@ -505,12 +499,12 @@ static void dump_saved_values(struct context *ctx, GString **out)
 			}
 
 			if (ctx->do_trigger) {
-				g_string_append_printf(*out, "%d%s",
+				g_string_append_printf(out, "%d%s",
 					ctx->trigger, ctx->value);
 				ctx->trigger = FALSE;
 			}
-			g_string_truncate(*out, (*out)->len - 1);
-			g_string_append(*out, ctx->record);
+			g_string_truncate(out, out->len - 1);
+			g_string_append(out, ctx->record);
 		}
 	}
 
@@ -656,14 +650,13 @@ static void check_input_constraints(struct context *ctx)
 	otc_warn("Resulting CSV output data may be incomplete or incorrect.");
 }
 
-static int receive(const struct otc_output *o,
-		   const struct otc_datafeed_packet *packet, GString **out)
+static int append(const struct otc_output *o,
+		   const struct otc_datafeed_packet *packet, GString *out)
 {
 	struct context *ctx;
 	const struct otc_datafeed_logic *logic;
 	const struct otc_datafeed_analog *analog;
 
-	*out = NULL;
 	if (!o || !o->sdi)
 		return OTC_ERR_ARG;
 	if (!(ctx = o->priv))
@@ -675,13 +668,12 @@ static int receive(const struct otc_output *o,
 		ctx->have_checked = FALSE;
 		ctx->have_frames = FALSE;
 		ctx->pkt_snums = FALSE;
-		*out = gen_header(o, packet->payload);
+		gen_header(o, packet->payload, out);
 		break;
 	case OTC_DF_TRIGGER:
 		ctx->trigger = TRUE;
 		break;
 	case OTC_DF_LOGIC:
-		*out = g_string_sized_new(512);
 		logic = packet->payload;
 		ctx->pkt_snums = logic->length;
 		ctx->pkt_snums /= logic->length;
@@ -689,7 +681,6 @@ static int receive(const struct otc_output *o,
 		process_logic(ctx, logic);
 		break;
 	case OTC_DF_ANALOG:
-		*out = g_string_sized_new(512);
 		analog = packet->payload;
 		ctx->pkt_snums = analog->num_samples;
 		ctx->pkt_snums /= g_slist_length(analog->meaning->channels);
@@ -698,7 +689,7 @@ static int receive(const struct otc_output *o,
 		break;
 	case OTC_DF_FRAME_BEGIN:
 		ctx->have_frames = TRUE;
-		*out = g_string_new(ctx->frame);
+		g_string_append(out, ctx->frame);
 		/* Fallthrough */
 	case OTC_DF_END:
 		/* Got to end of frame/session with part of the data. */
@@ -787,6 +778,6 @@ OTC_PRIV struct otc_output_module output_csv = {
 	.flags = 0,
 	.options = get_options,
 	.init = init,
-	.receive = receive,
+	.append = append,
 	.cleanup = cleanup,
 };
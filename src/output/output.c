@@ -18,7 +18,9 @@
  */
 
 #include <config.h>
+#include <errno.h>
 #include <string.h>
+#include <unistd.h>
 #include <opentracecapture/libopentracecapture.h>
 #include "../libopentracecapture-internal.h"
 
@@ -49,6 +51,10 @@
  * Output modules generate a newly allocated GString. The caller is then
  * expected to free this with g_string_free() when finished with it.
  *
+ * Frontends which handle many packets, and only pass the text on, use
+ * otc_output_send_append() or otc_output_send_fd() instead. Those reuse
+ * one buffer for all packets of the stream.
+ *
  * @{
  */
 
@@ -271,7 +277,7 @@ OTC_API const struct otc_output *otc_output_new(const struct otc_output_module *
 	gpointer key, value;
 	int i;
 
-	op = g_malloc(sizeof(struct otc_output));
+	op = g_malloc0(sizeof(struct otc_output));
 	op->module = omod;
 	op->sdi = sdi;
 	op->filename = g_strdup(filename);
@@ -325,6 +331,24 @@ OTC_API const struct otc_output *otc_output_new(const struct otc_output_module *
 	return op;
 }
 
+static int output_send(const struct otc_output *o,
+		const struct otc_datafeed_packet *packet, GString **out)
+{
+	int ret;
+
+	if (o->module->receive)
+		return o->module->receive(o, packet, out);
+
+	*out = g_string_sized_new(512);
+	ret = o->module->append(o, packet, *out);
+	if (ret != OTC_OK || !(*out)->len) {
+		g_string_free(*out, TRUE);
+		*out = NULL;
+	}
+
+	return ret;
+}
+
 /**
  * Send a packet to the specified output instance.
  *
@@ -336,7 +360,137 @@ OTC_API const struct otc_output *otc_output_new(const struct otc_output_module *
 OTC_API int otc_output_send(const struct otc_output *o,
 		const struct otc_datafeed_packet *packet, GString **out)
 {
-	return o->module->receive(o, packet, out);
+	struct otc_metrics *metrics;
+	uint64_t start_ns;
+	int ret;
+
+	metrics = otc_metrics_get(o->sdi);
+	if (G_LIKELY(!metrics))
+		return output_send(o, packet, out);
+
+	start_ns = otc_metrics_now_ns();
+	ret = output_send(o, packet, out);
+	otc_metrics_record(metrics, OTC_METRICS_OUTPUT,
+		otc_metrics_now_ns() - start_ns);
+
+	return ret;
+}
+
+static int output_append(const struct otc_output *o,
+		const struct otc_datafeed_packet *packet, GString *out)
+{
+	GString *text;
+	int ret;
+
+	if (o->module->append)
+		return o->module->append(o, packet, out);
+
+	text = NULL;
+	ret = o->module->receive(o, packet, &text);
+	if (text) {
+		g_string_append_len(out, text->str, text->len);
+		g_string_free(text, TRUE);
+	}
+
+	return ret;
+}
+
+/**
+ * Send a packet to the specified output instance, and append the
+ * instance's output to a string.
+ *
+ * The string stays owned by the caller, who can truncate and reuse it
+ * for the next packet. Modules which support it write their text into
+ * the string directly, which saves the allocation and the copy of
+ * otc_output_send().
+ *
+ * @param o The output instance.
+ * @param packet The packet to handle.
+ * @param out The string to append to. Must not be NULL.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid argument.
+ * @retval other Error code of the output module.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_output_send_append(const struct otc_output *o,
+		const struct otc_datafeed_packet *packet, GString *out)
+{
+	struct otc_metrics *metrics;
+	uint64_t start_ns;
+	int ret;
+
+	if (!o || !packet || !out)
+		return OTC_ERR_ARG;
+
+	metrics = otc_metrics_get(o->sdi);
+	if (G_LIKELY(!metrics))
+		return output_append(o, packet, out);
+
+	start_ns = otc_metrics_now_ns();
+	ret = output_append(o, packet, out);
+	otc_metrics_record(metrics, OTC_METRICS_OUTPUT,
+		otc_metrics_now_ns() - start_ns);
+
+	return ret;
+}
+
+/**
+ * Send a packet to the specified output instance, and write the
+ * instance's output to a file descriptor.
+ *
+ * The text goes through a buffer of the output instance, which gets
+ * reused for all packets. Short writes are continued, so all of the
+ * text was written when this returns OTC_OK.
+ *
+ * @param o The output instance.
+ * @param packet The packet to handle.
+ * @param fd The file descriptor to write to, e.g. of a file or a pipe.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid argument.
+ * @retval OTC_ERR_IO Writing failed.
+ * @retval other Error code of the output module.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_output_send_fd(const struct otc_output *o,
+		const struct otc_datafeed_packet *packet, int fd)
+{
+	struct otc_output *op;
+	const char *p;
+	size_t left;
+	ssize_t written;
+	int ret;
+
+	if (!o || fd < 0)
+		return OTC_ERR_ARG;
+
+	op = (struct otc_output *)o;
+	if (!op->buffer)
+		op->buffer = g_string_sized_new(64 * 1024);
+	g_string_truncate(op->buffer, 0);
+
+	ret = otc_output_send_append(o, packet, op->buffer);
+	if (ret != OTC_OK)
+		return ret;
+
+	p = op->buffer->str;
+	left = op->buffer->len;
+	while (left) {
+		written = write(fd, p, left);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0) {
+			otc_err("Cannot write output: %s.", g_strerror(errno));
+			return OTC_ERR_IO;
+		}
+		p += written;
+		left -= written;
+	}
+
+	return OTC_OK;
 }
 
 /**
@@ -354,6 +508,8 @@ OTC_API int otc_output_free(const struct otc_output *o)
 	ret = OTC_OK;
 	if (o->module->cleanup)
 		ret = o->module->cleanup((struct otc_output *)o);
+	if (o->buffer)
+		g_string_free(o->buffer, TRUE);
 	g_free((char *)o->filename);
 	g_free((gpointer)o);
 
@@ -334,12 +334,11 @@ static uint64_t get_timescale_freq(uint64_t samplerate)
 }
 
 /* Emit a VCD file header. */
-static GString *gen_header(const struct otc_output *o)
+static void gen_header(const struct otc_output *o, GString *header)
 {
 	struct context *ctx;
 	struct otc_channel *ch;
 	GVariant *gvar;
-	GString *header;
 	GSList *l;
 	time_t t;
 	size_t num_channels, i;
@@ -370,8 +369,7 @@ static GString *gen_header(const struct otc_output *o)
 	frequency_s = otc_period_string(1, ctx->period);
 
 	/* Construct the VCD output file header. */
-	header = g_string_sized_new(512);
-	g_string_printf(header, "$date %s $end\n", timestamp);
+	g_string_append_printf(header, "$date %s $end\n", timestamp);
 	g_string_append_printf(header, "$version %s %s $end\n",
 		PACKAGE_NAME, otc_package_version_string_get());
 	g_string_append_printf(header, "$comment\n");
@@ -410,31 +408,23 @@ static GString *gen_header(const struct otc_output *o)
 	g_free(timestamp);
 	g_free(samplerate_s);
 	g_free(frequency_s);
-
-	return header;
 }
 
 /*
- * Gets called when a session feed packet was received. Either creates
- * a VCD file header (once in the output module's lifetime), or an empty
- * GString. Callers will append the text representation of sample data
- * to that string as needed.
+ * Gets called when a session feed packet was received. Emits the VCD
+ * file header once in the output module's lifetime. Callers append the
+ * text representation of sample data after it.
  */
-static GString *chk_header(const struct otc_output *o)
+static void chk_header(const struct otc_output *o, GString *out)
 {
 	struct context *ctx;
-	GString *s;
 
 	ctx = o->priv;
 
 	if (!ctx->header_done) {
 		ctx->header_done = TRUE;
-		s = gen_header(o);
-	} else {
-		s = g_string_sized_new(512);
+		gen_header(o, out);
 	}
-
-	return s;
 }
 
 /*
@@ -980,8 +970,8 @@ static int write_completed_changes(struct context *ctx, GString *out)
 }
 
 /* Get packets from the session feed, generate output text. */
-static int receive(const struct otc_output *o,
-	const struct otc_datafeed_packet *packet, GString **out)
+static int append(const struct otc_output *o,
+	const struct otc_datafeed_packet *packet, GString *out)
 {
 	struct context *ctx;
 	const struct otc_datafeed_meta *meta;
@@ -1001,7 +991,6 @@ static int receive(const struct otc_output *o,
 	float *floats, value;
 	double ts;
 
-	*out = NULL;
 	if (!o || !o->priv)
 		return OTC_ERR_BUG;
 	ctx = o->priv;
@@ -1017,7 +1006,7 @@ static int receive(const struct otc_output *o,
 		}
 		break;
 	case OTC_DF_LOGIC:
-		*out = chk_header(o);
+		chk_header(o, out);
 
 		logic = packet->payload;
 		sample = logic->data;
@@ -1041,7 +1030,7 @@ static int receive(const struct otc_output *o,
 			if (changed) {
 				if (ctx->immediate_write) {
 					ts = snum_to_ts(ctx, snum_curr);
-					append_vcd_timestamp(*out, ts, FALSE);
+					append_vcd_timestamp(out, ts, FALSE);
 				} else {
 					queue_samplenum(ctx, snum_curr);
 				}
@@ -1075,8 +1064,8 @@ static int receive(const struct otc_output *o,
 				 * the observed value change.
 				 */
 				if (ctx->immediate_write) {
-					g_string_append_c(*out, ' ');
-					s_val = *out;
+					g_string_append_c(out, ' ');
+					s_val = out;
 				} else {
 					s_val = queue_value_text_prep(ctx);
 					if (!s_val)
@@ -1089,10 +1078,10 @@ static int receive(const struct otc_output *o,
 			snum_curr++;
 			sample += unit_size;
 		}
-		write_completed_changes(ctx, *out);
+		write_completed_changes(ctx, out);
 		break;
 	case OTC_DF_ANALOG:
-		*out = chk_header(o);
+		chk_header(o, out);
 
 		/*
 		 * This implementation expects one analog packet per
@@ -1150,8 +1139,8 @@ static int receive(const struct otc_output *o,
 			/* Queue, or emit the timestamp and the new value. */
 			if (ctx->immediate_write) {
 				ts = snum_to_ts(ctx, snum_curr + index);
-				append_vcd_timestamp(*out, ts, FALSE);
-				s_val = *out;
+				append_vcd_timestamp(out, ts, FALSE);
+				s_val = out;
 			} else {
 				queue_samplenum(ctx, snum_curr + index);
 				s_val = queue_value_text_prep(ctx);
@@ -1160,15 +1149,15 @@ static int receive(const struct otc_output *o,
 		}
 
 		g_free(floats);
-		write_completed_changes(ctx, *out);
+		write_completed_changes(ctx, out);
 		break;
 	case OTC_DF_END:
-		*out = chk_header(o);
+		chk_header(o, out);
 		/* Push the final timestamp as length indicator. */
 		snum_curr = get_max_snum_flush(ctx);
 		queue_samplenum(ctx, snum_curr);
 		/* Flush previously queued value changes. */
-		write_completed_changes(ctx, *out);
+		write_completed_changes(ctx, out);
 		break;
 	}
 
@@ -1211,6 +1200,6 @@ struct otc_output_module output_vcd = {
 	.flags = 0,
 	.options = NULL,
 	.init = init,
-	.receive = receive,
+	.append = append,
 	.cleanup = cleanup,
 };
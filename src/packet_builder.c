@@ -0,0 +1,206 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "libopentracecapture-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "packet_builder"
+/** @endcond */
+
+/**
+ * @file
+ *
+ * Reusable datafeed packets.
+ */
+
+/**
+ * @defgroup grp_packet_builder Packet builders
+ *
+ * Reusable datafeed packets.
+ *
+ * Frontends which generate sample data, e.g. to inject synthetic signals,
+ * create a packet for every buffer they pass on. A packet builder holds
+ * one packet with its payload, and for analog data its encoding, meaning
+ * and spec, which are set up once. Each packet then only takes a pointer
+ * and a length update.
+ *
+ * The packet points into the caller's buffer, and is only valid until
+ * the next call to the builder. Use otc_packet_copy() to keep it.
+ *
+ * @{
+ */
+
+/** @cond PRIVATE */
+struct otc_packet_builder {
+	struct otc_datafeed_packet packet;
+	struct otc_datafeed_logic logic;
+	struct otc_datafeed_analog analog;
+	struct otc_analog_encoding encoding;
+	struct otc_analog_meaning meaning;
+	struct otc_analog_spec spec;
+};
+/** @endcond */
+
+/**
+ * Create a builder for logic packets.
+ *
+ * @param[in] unitsize The number of bytes per logic sample.
+ *
+ * @return The builder, or NULL on invalid arguments.
+ *
+ * @since 0.6.0
+ */
+OTC_API struct otc_packet_builder *otc_packet_builder_logic_new(
+		unsigned int unitsize)
+{
+	struct otc_packet_builder *builder;
+
+	if (!unitsize) {
+		otc_err("Invalid unit size 0.");
+		return NULL;
+	}
+
+	builder = g_malloc0(sizeof(*builder));
+	builder->packet.type = OTC_DF_LOGIC;
+	builder->packet.payload = &builder->logic;
+	builder->logic.unitsize = unitsize;
+
+	return builder;
+}
+
+/**
+ * Create a builder for analog packets.
+ *
+ * @param[in] channels The channels which the packets carry samples of,
+ *   as a list of struct otc_channel pointers. The list gets copied, the
+ *   channels must outlive the builder.
+ * @param[in] mq The measured quantity.
+ * @param[in] unit The unit of the values.
+ * @param[in] mqflags The flags of the measured quantity.
+ * @param[in] encoding The encoding of the sample data. NULL selects
+ *   floats in host byte order, without scale and offset.
+ *
+ * @return The builder, or NULL on invalid arguments.
+ *
+ * @since 0.6.0
+ */
+OTC_API struct otc_packet_builder *otc_packet_builder_analog_new(
+		GSList *channels, enum otc_mq mq, enum otc_unit unit,
+		enum otc_mqflag mqflags,
+		const struct otc_analog_encoding *encoding)
+{
+	struct otc_packet_builder *builder;
+
+	if (encoding && !encoding->unitsize) {
+		otc_err("Invalid unit size 0.");
+		return NULL;
+	}
+
+	builder = g_malloc0(sizeof(*builder));
+	builder->packet.type = OTC_DF_ANALOG;
+	builder->packet.payload = &builder->analog;
+	otc_analog_init(&builder->analog, &builder->encoding,
+		&builder->meaning, &builder->spec, 0);
+	if (encoding) {
+		builder->encoding = *encoding;
+		builder->spec.spec_digits = encoding->digits;
+	} else {
+		builder->encoding.is_signed = TRUE;
+		builder->encoding.is_digits_decimal = FALSE;
+	}
+	builder->meaning.mq = mq;
+	builder->meaning.unit = unit;
+	builder->meaning.mqflags = mqflags;
+	builder->meaning.channels = g_slist_copy(channels);
+
+	return builder;
+}
+
+/**
+ * Free a packet builder.
+ *
+ * @param[in] builder The builder to free. Can be NULL.
+ *
+ * @since 0.6.0
+ */
+OTC_API void otc_packet_builder_free(struct otc_packet_builder *builder)
+{
+	if (!builder)
+		return;
+
+	g_slist_free(builder->meaning.channels);
+	g_free(builder);
+}
+
+/**
+ * Get a logic packet of the caller's samples.
+ *
+ * @param[in] builder A builder of logic packets.
+ * @param[in] data The sample data, which does not get copied.
+ * @param[in] length The length of the sample data in bytes.
+ *
+ * @return The packet, which is valid until the next call to the builder,
+ *   or NULL when the builder is not one of logic packets.
+ *
+ * @since 0.6.0
+ */
+OTC_API const struct otc_datafeed_packet *otc_packet_builder_logic(
+		struct otc_packet_builder *builder, const void *data,
+		uint64_t length)
+{
+	if (!builder || builder->packet.type != OTC_DF_LOGIC)
+		return NULL;
+
+	builder->logic.data = (void *)data;
+	builder->logic.length = length;
+
+	return &builder->packet;
+}
+
+/**
+ * Get an analog packet of the caller's samples.
+ *
+ * @param[in] builder A builder of analog packets.
+ * @param[in] data The sample data in the builder's encoding, which does
+ *   not get copied. Samples of multiple channels are interleaved.
+ * @param[in] num_samples The number of samples.
+ *
+ * @return The packet, which is valid until the next call to the builder,
+ *   or NULL when the builder is not one of analog packets.
+ *
+ * @since 0.6.0
+ */
+OTC_API const struct otc_datafeed_packet *otc_packet_builder_analog(
+		struct otc_packet_builder *builder, const void *data,
+		uint32_t num_samples)
+{
+	if (!builder || builder->packet.type != OTC_DF_ANALOG)
+		return NULL;
+
+	builder->analog.data = (void *)data;
+	builder->analog.num_samples = num_samples;
+
+	return &builder->packet;
+}
+
+/** @} */
@@ -0,0 +1,457 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stddef.h>
+#include <string.h>
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "libopentracecapture-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "packet_pool"
+/** @endcond */
+
+/**
+ * @file
+ *
+ * Pooled copies of datafeed packets.
+ */
+
+/**
+ * @defgroup grp_packet_pool Packet pools
+ *
+ * Pooled copies of datafeed packets.
+ *
+ * otc_packet_copy() allocates the packet, its payload and its sample data
+ * separately, and for analog packets also the encoding, meaning and spec,
+ * and the meaning's channel list. Frontends which keep packets for
+ * display do this for every packet.
+ *
+ * A packet pool puts each copy into a single block, which holds the
+ * packet, its payload and its sample data. Blocks come in power of two
+ * size classes, and released blocks get reused for later copies of the
+ * same class. Consecutive analog packets with the same meaning and spec
+ * share one read-only instance of them. Each analog copy has its own
+ * encoding, transforms modify encodings in place.
+ *
+ * Copies and releases may happen on any thread. A copy keeps its pool
+ * alive, so the pool may be freed while copies are still in use.
+ *
+ * @{
+ */
+
+/** @cond PRIVATE */
+
+/* Size classes of blocks, from 256 bytes to 16 MiB. */
+#define MIN_BLOCK_SHIFT 8
+#define NUM_BLOCK_CLASSES 17
+
+/* Bytes of released blocks a pool keeps for reuse, by default. */
+#define DEFAULT_MAX_CACHED (64 * 1024 * 1024)
+
+/* A meaning and spec which analog copies share. */
+struct pool_analog_desc {
+	int refcount;
+	struct otc_analog_meaning meaning;
+	struct otc_analog_spec spec;
+};
+
+struct pool_block {
+	struct otc_packet_pool *pool;
+	struct pool_block *next;
+	struct pool_analog_desc *desc;
+	struct otc_analog_encoding encoding;
+	/* Index of the size class, -1 for blocks which are too large. */
+	int size_class;
+	struct otc_datafeed_packet packet;
+	union {
+		struct otc_datafeed_header header;
+		struct otc_datafeed_meta meta;
+		struct otc_datafeed_logic logic;
+		struct otc_datafeed_analog analog;
+	} payload;
+};
+
+/* Sample data follows the block header, 16 byte aligned. */
+#define BLOCK_DATA_OFFSET ((sizeof(struct pool_block) + 15) & ~(size_t)15)
+
+struct otc_packet_pool {
+	/* One reference of the owner, and one of each block in use. */
+	int refcount;
+	GMutex mutex;
+	gboolean freed;
+	struct pool_block *free_blocks[NUM_BLOCK_CLASSES];
+	size_t cached_bytes;
+	size_t max_cached_bytes;
+	/* The description of the latest analog copy. */
+	struct pool_analog_desc *analog_desc;
+};
+
+/** @endcond */
+
+static void pool_unref(struct otc_packet_pool *pool)
+{
+	if (!g_atomic_int_dec_and_test(&pool->refcount))
+		return;
+
+	g_mutex_clear(&pool->mutex);
+	g_free(pool);
+}
+
+static void analog_desc_unref(struct pool_analog_desc *desc)
+{
+	if (!desc || !g_atomic_int_dec_and_test(&desc->refcount))
+		return;
+
+	g_slist_free(desc->meaning.channels);
+	g_free(desc);
+}
+
+static gboolean analog_desc_matches(const struct pool_analog_desc *desc,
+		const struct otc_datafeed_analog *analog)
+{
+	const GSList *l, *m;
+
+	if (desc->spec.spec_digits != analog->spec->spec_digits)
+		return FALSE;
+
+	if (desc->meaning.mq != analog->meaning->mq
+			|| desc->meaning.unit != analog->meaning->unit
+			|| desc->meaning.mqflags != analog->meaning->mqflags)
+		return FALSE;
+	l = desc->meaning.channels;
+	m = analog->meaning->channels;
+	for (; l && m; l = l->next, m = m->next) {
+		if (l->data != m->data)
+			return FALSE;
+	}
+
+	return !l && !m;
+}
+
+/* Get a shared description of an analog packet's meaning and spec. */
+static struct pool_analog_desc *analog_desc_get(struct otc_packet_pool *pool,
+		const struct otc_datafeed_analog *analog)
+{
+	struct pool_analog_desc *desc;
+
+	g_mutex_lock(&pool->mutex);
+	desc = pool->analog_desc;
+	if (desc && analog_desc_matches(desc, analog)) {
+		g_atomic_int_inc(&desc->refcount);
+		g_mutex_unlock(&pool->mutex);
+		return desc;
+	}
+	g_mutex_unlock(&pool->mutex);
+
+	desc = g_malloc(sizeof(*desc));
+	/* One reference for the copy, one for the pool. */
+	desc->refcount = 2;
+	desc->meaning = *analog->meaning;
+	desc->meaning.channels = g_slist_copy(analog->meaning->channels);
+	desc->spec = *analog->spec;
+
+	g_mutex_lock(&pool->mutex);
+	if (pool->freed) {
+		desc->refcount--;
+		g_mutex_unlock(&pool->mutex);
+		return desc;
+	}
+	analog_desc_unref(pool->analog_desc);
+	pool->analog_desc = desc;
+	g_mutex_unlock(&pool->mutex);
+
+	return desc;
+}
+
+static struct pool_block *block_get(struct otc_packet_pool *pool,
+		size_t data_size)
+{
+	struct pool_block *block;
+	size_t size;
+	int size_class;
+
+	if (data_size > G_MAXSIZE - BLOCK_DATA_OFFSET)
+		return NULL;
+	size = BLOCK_DATA_OFFSET + data_size;
+
+	block = NULL;
+	for (size_class = 0; size_class < NUM_BLOCK_CLASSES; size_class++) {
+		if (size <= (size_t)1 << (MIN_BLOCK_SHIFT + size_class))
+			break;
+	}
+	if (size_class < NUM_BLOCK_CLASSES) {
+		size = (size_t)1 << (MIN_BLOCK_SHIFT + size_class);
+		g_mutex_lock(&pool->mutex);
+		if ((block = pool->free_blocks[size_class])) {
+			pool->free_blocks[size_class] = block->next;
+			pool->cached_bytes -= size;
+		}
+		g_mutex_unlock(&pool->mutex);
+	} else {
+		size_class = -1;
+	}
+
+	if (!block && !(block = g_try_malloc(size)))
+		return NULL;
+
+	g_atomic_int_inc(&pool->refcount);
+	block->pool = pool;
+	block->next = NULL;
+	block->desc = NULL;
+	block->size_class = size_class;
+	block->packet.payload = &block->payload;
+
+	return block;
+}
+
+static void block_put(struct pool_block *block)
+{
+	struct otc_packet_pool *pool;
+	size_t size;
+
+	pool = block->pool;
+
+	if (block->size_class >= 0) {
+		size = (size_t)1 << (MIN_BLOCK_SHIFT + block->size_class);
+		g_mutex_lock(&pool->mutex);
+		if (!pool->freed
+				&& pool->cached_bytes + size <= pool->max_cached_bytes) {
+			block->next = pool->free_blocks[block->size_class];
+			pool->free_blocks[block->size_class] = block;
+			pool->cached_bytes += size;
+			block = NULL;
+		}
+		g_mutex_unlock(&pool->mutex);
+	}
+	g_free(block);
+
+	pool_unref(pool);
+}
+
+static void copy_config(const struct otc_config *src, GSList **list)
+{
+	struct otc_config *item;
+
+#if GLIB_CHECK_VERSION(2, 67, 3)
+	item = g_memdup2(src, sizeof(*src));
+#else
+	item = g_memdup(src, sizeof(*src));
+#endif
+	g_variant_ref(item->data);
+	*list = g_slist_prepend(*list, item);
+}
+
+/**
+ * Create a packet pool.
+ *
+ * @param[in] max_cached The number of bytes of released copies which the
+ *   pool keeps for reuse. 0 selects a default of 64 MiB.
+ *
+ * @return The pool.
+ *
+ * @since 0.6.0
+ */
+OTC_API struct otc_packet_pool *otc_packet_pool_new(size_t max_cached)
+{
+	struct otc_packet_pool *pool;
+
+	pool = g_malloc0(sizeof(*pool));
+	pool->refcount = 1;
+	g_mutex_init(&pool->mutex);
+	pool->max_cached_bytes = max_cached ? max_cached : DEFAULT_MAX_CACHED;
+
+	return pool;
+}
+
+/**
+ * Free a packet pool.
+ *
+ * Copies which are still in use stay valid, and still need to be
+ * released with otc_packet_pool_release().
+ *
+ * @param[in] pool The pool to free. Can be NULL.
+ *
+ * @since 0.6.0
+ */
+OTC_API void otc_packet_pool_free(struct otc_packet_pool *pool)
+{
+	struct pool_block *block;
+	struct pool_analog_desc *desc;
+	int i;
+
+	if (!pool)
+		return;
+
+	g_mutex_lock(&pool->mutex);
+	pool->freed = TRUE;
+	desc = pool->analog_desc;
+	pool->analog_desc = NULL;
+	for (i = 0; i < NUM_BLOCK_CLASSES; i++) {
+		while ((block = pool->free_blocks[i])) {
+			pool->free_blocks[i] = block->next;
+			g_free(block);
+		}
+	}
+	pool->cached_bytes = 0;
+	g_mutex_unlock(&pool->mutex);
+
+	analog_desc_unref(desc);
+	pool_unref(pool);
+}
+
+/**
+ * Copy a datafeed packet into a pool.
+ *
+ * The copy is a single block of memory, which holds the packet, its
+ * payload and its sample data. The meaning and spec of analog copies
+ * may be shared with other copies, and must not be modified. Their
+ * encoding is their own.
+ *
+ * @param[in] pool The pool to use.
+ * @param[in] packet The packet to copy.
+ * @param[out] copy The copy. Release it with otc_packet_pool_release(),
+ *   not with otc_packet_free().
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid argument.
+ * @retval OTC_ERR_MALLOC Out of memory.
+ * @retval OTC_ERR_NA Unknown packet type.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_packet_pool_copy(struct otc_packet_pool *pool,
+		const struct otc_datafeed_packet *packet,
+		struct otc_datafeed_packet **copy)
+{
+	const struct otc_datafeed_logic *logic;
+	const struct otc_datafeed_analog *analog;
+	const struct otc_datafeed_meta *meta;
+	struct pool_block *block;
+	size_t data_size;
+	unsigned int num_channels;
+	GSList *config;
+
+	if (!pool || !packet || !copy)
+		return OTC_ERR_ARG;
+
+	logic = NULL;
+	analog = NULL;
+	data_size = 0;
+	switch (packet->type) {
+	case OTC_DF_HEADER:
+	case OTC_DF_META:
+	case OTC_DF_TRIGGER:
+	case OTC_DF_END:
+	case OTC_DF_FRAME_BEGIN:
+	case OTC_DF_FRAME_END:
+		break;
+	case OTC_DF_LOGIC:
+		logic = packet->payload;
+		data_size = logic->length;
+		break;
+	case OTC_DF_ANALOG:
+		analog = packet->payload;
+		/* Samples of multiple channels are interleaved. */
+		num_channels = g_slist_length(analog->meaning->channels);
+		data_size = (size_t)analog->encoding->unitsize
+			* analog->num_samples * MAX(num_channels, 1);
+		break;
+	default:
+		otc_err("Unknown packet type %d", packet->type);
+		return OTC_ERR_NA;
+	}
+
+	if (!(block = block_get(pool, data_size)))
+		return OTC_ERR_MALLOC;
+	block->packet.type = packet->type;
+
+	switch (packet->type) {
+	case OTC_DF_HEADER:
+		block->payload.header =
+			*(const struct otc_datafeed_header *)packet->payload;
+		break;
+	case OTC_DF_META:
+		meta = packet->payload;
+		config = NULL;
+		g_slist_foreach(meta->config, (GFunc)copy_config, &config);
+		block->payload.meta.config = g_slist_reverse(config);
+		break;
+	case OTC_DF_LOGIC:
+		block->payload.logic = *logic;
+		block->payload.logic.data = (uint8_t *)block + BLOCK_DATA_OFFSET;
+		memcpy(block->payload.logic.data, logic->data, data_size);
+		break;
+	case OTC_DF_ANALOG:
+		block->desc = analog_desc_get(pool, analog);
+		block->payload.analog.data = (uint8_t *)block + BLOCK_DATA_OFFSET;
+		memcpy(block->payload.analog.data, analog->data, data_size);
+		block->payload.analog.num_samples = analog->num_samples;
+		block->encoding = *analog->encoding;
+		block->payload.analog.encoding = &block->encoding;
+		block->payload.analog.meaning = &block->desc->meaning;
+		block->payload.analog.spec = &block->desc->spec;
+		break;
+	default:
+		/* No payload. */
+		block->packet.payload = NULL;
+		break;
+	}
+
+	*copy = &block->packet;
+
+	return OTC_OK;
+}
+
+/**
+ * Release a copy which otc_packet_pool_copy() made.
+ *
+ * This may happen on any thread.
+ *
+ * @param[in] packet The copy to release. Can be NULL.
+ *
+ * @since 0.6.0
+ */
+OTC_API void otc_packet_pool_release(struct otc_datafeed_packet *packet)
+{
+	struct pool_block *block;
+	struct otc_config *src;
+	GSList *l;
+
+	if (!packet)
+		return;
+
+	block = (struct pool_block *)((uint8_t *)packet
+		- offsetof(struct pool_block, packet));
+
+	if (packet->type == OTC_DF_META) {
+		for (l = block->payload.meta.config; l; l = l->next) {
+			src = l->data;
+			g_variant_unref(src->data);
+			g_free(src);
+		}
+		g_slist_free(block->payload.meta.config);
+	}
+	analog_desc_unref(block->desc);
+
+	block_put(block);
+}
+
+/** @} */
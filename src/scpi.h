@@ -109,6 +109,13 @@ struct otc_scpi_dev_inst {
 	enum scpi_transport_layer transport;
 	int priv_size;
 	GSList *(*scan)(struct drv_context *drvc);
+	/**
+	 * Number of resources to probe in parallel, 0 or 1 for none.
+	 * Applies to scan() results, and to several conn= specs of this
+	 * transport. Drivers' probe_device() routines then run
+	 * concurrently, and must not modify driver wide state.
+	 */
+	int scan_workers;
 	int (*dev_inst_new)(void *priv, struct drv_context *drvc,
 		const char *resource, char **params, const char *serialcomm);
 	int (*open)(struct otc_scpi_dev_inst *scpi);
@@ -317,44 +317,121 @@ static int scpi_get_data(struct otc_scpi_dev_inst *scpi,
 	return OTC_OK;
 }
 
+struct scpi_scan_context {
+	struct drv_context *drvc;
+	const char *serialcomm;
+	struct otc_dev_inst *(*probe_device)(struct otc_scpi_dev_inst *scpi);
+};
+
+/* Probe one resource of a transport's scan result, see otc_scan_resources(). */
+static struct otc_dev_inst *scpi_scan_probe(const char *resource, void *cb_data)
+{
+	struct scpi_scan_context *ctx;
+	struct otc_dev_inst *sdi;
+	const char *conn, *comm;
+	gchar **res;
+
+	ctx = cb_data;
+
+	res = g_strsplit(resource, ":", 2);
+	if (!res[0]) {
+		g_strfreev(res);
+		return NULL;
+	}
+	conn = res[0];
+	comm = ctx->serialcomm ? : res[1];
+	sdi = otc_scpi_scan_resource(ctx->drvc, conn, comm, ctx->probe_device);
+	if (sdi)
+		sdi->connection_id = g_strdup(resource);
+	g_strfreev(res);
+
+	return sdi;
+}
+
+/* Probe one of several conn= resources, see otc_scan_resources(). */
+static struct otc_dev_inst *scpi_scan_probe_conn(const char *resource,
+		void *cb_data)
+{
+	struct scpi_scan_context *ctx;
+
+	ctx = cb_data;
+
+	return otc_scpi_scan_resource(ctx->drvc, resource, ctx->serialcomm,
+		ctx->probe_device);
+}
+
+/* Parallel probes which all transports of a list of resources tolerate. */
+static int scpi_scan_workers(GSList *resources)
+{
+	const char *resource, *prefix;
+	GSList *l;
+	int workers;
+	unsigned i;
+
+	workers = -1;
+	for (l = resources; l; l = l->next) {
+		resource = l->data;
+		for (i = 0; i < ARRAY_SIZE(scpi_devs); i++) {
+			prefix = scpi_devs[i]->prefix;
+			if (strncmp(resource, prefix, strlen(prefix)) != 0)
+				continue;
+			if (workers < 0 || scpi_devs[i]->scan_workers < workers)
+				workers = scpi_devs[i]->scan_workers;
+			break;
+		}
+	}
+
+	return MAX(workers, 0);
+}
+
 OTC_PRIV GSList *otc_scpi_scan(struct drv_context *drvc, GSList *options,
 		struct otc_dev_inst *(*probe_device)(struct otc_scpi_dev_inst *scpi))
 {
-	GSList *resources, *l, *devices;
+	struct scpi_scan_context ctx;
+	GSList *resources, *devices, *conns, *l;
 	struct otc_dev_inst *sdi;
-	const char *resource, *conn;
-	const char *serialcomm, *comm;
-	gchar **res;
+	struct otc_config *src;
+	const char *resource;
+	const char *serialcomm;
 	unsigned i;
 
 	resource = NULL;
 	serialcomm = NULL;
 	(void)otc_serial_extract_options(options, &resource, &serialcomm);
 
-	devices = NULL;
-	for (i = 0; i < ARRAY_SIZE(scpi_devs); i++) {
-		if (resource && strcmp(resource, scpi_devs[i]->prefix) != 0)
-			continue;
-		if (!scpi_devs[i]->scan)
+	ctx.drvc = drvc;
+	ctx.serialcomm = serialcomm;
+	ctx.probe_device = probe_device;
+
+	conns = NULL;
+	for (l = options; l; l = l->next) {
+		src = l->data;
+		if (src->key != OTC_CONF_CONN)
 			continue;
-		resources = scpi_devs[i]->scan(drvc);
-		for (l = resources; l; l = l->next) {
-			res = g_strsplit(l->data, ":", 2);
-			if (!res[0]) {
-				g_strfreev(res);
+		conns = g_slist_append(conns,
+			(char *)g_variant_get_string(src->data, NULL));
+	}
+
+	devices = NULL;
+	if (g_slist_length(conns) > 1) {
+		/* Several conn= specs, probe exactly those. */
+		devices = otc_scan_resources(conns, scpi_scan_workers(conns),
+			scpi_scan_probe_conn, &ctx);
+		resource = NULL;
+	} else {
+		for (i = 0; i < ARRAY_SIZE(scpi_devs); i++) {
+			if (resource && strcmp(resource, scpi_devs[i]->prefix) != 0)
 				continue;
-			}
-			conn = res[0];
-			comm = serialcomm ? : res[1];
-			sdi = otc_scpi_scan_resource(drvc, conn, comm, probe_device);
-			if (sdi) {
-				devices = g_slist_append(devices, sdi);
-				sdi->connection_id = g_strdup(l->data);
-			}
-			g_strfreev(res);
+			if (!scpi_devs[i]->scan)
+				continue;
+			resources = scpi_devs[i]->scan(drvc);
+			devices = g_slist_concat(devices, otc_scan_resources(
+				resources, scpi_devs[i]->scan_workers,
+				scpi_scan_probe, &ctx));
+			g_slist_free_full(resources, g_free);
 		}
-		g_slist_free_full(resources, g_free);
 	}
+	g_slist_free(conns);
 
 	if (!devices && resource) {
 		sdi = otc_scpi_scan_resource(drvc, resource, serialcomm, probe_device);
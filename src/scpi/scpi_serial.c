@@ -231,6 +231,7 @@ OTC_PRIV const struct otc_scpi_dev_inst scpi_serial_dev = {
 	.transport     = SCPI_TRANSPORT_SERIAL,
 	.priv_size     = sizeof(struct scpi_serial),
 	.scan          = scpi_serial_scan,
+	.scan_workers  = 8,
 	.dev_inst_new  = scpi_serial_dev_inst_new,
 	.open          = scpi_serial_open,
 	.connection_id = scpi_serial_connection_id,
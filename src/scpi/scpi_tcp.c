@@ -277,6 +277,7 @@ OTC_PRIV const struct otc_scpi_dev_inst scpi_tcp_raw_dev = {
 	.prefix        = "tcp-raw",
 	.transport     = SCPI_TRANSPORT_RAW_TCP,
 	.priv_size     = sizeof(struct scpi_tcp),
+	.scan_workers  = 16,
 	.dev_inst_new  = scpi_tcp_dev_inst_new,
 	.open          = scpi_tcp_open,
 	.connection_id = scpi_tcp_connection_id,
@@ -296,6 +297,7 @@ OTC_PRIV const struct otc_scpi_dev_inst scpi_tcp_rigol_dev = {
 	.prefix        = "tcp-rigol",
 	.transport     = SCPI_TRANSPORT_RIGOL_TCP,
 	.priv_size     = sizeof(struct scpi_tcp),
+	.scan_workers  = 16,
 	.dev_inst_new  = scpi_tcp_dev_inst_new,
 	.open          = scpi_tcp_open,
 	.connection_id = scpi_tcp_connection_id,
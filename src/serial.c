@@ -168,7 +168,7 @@ OTC_PRIV int serial_close(struct otc_serial_dev_inst *serial)
 
 	rc = serial->lib_funcs->close(serial);
 	if (rc == OTC_OK && serial->rcv_buffer) {
-		g_string_free(serial->rcv_buffer, TRUE);
+		otc_byte_ring_free(serial->rcv_buffer);
 		serial->rcv_buffer = NULL;
 	}
 
@@ -287,7 +287,7 @@ OTC_PRIV void otc_ser_discard_queued_data(struct otc_serial_dev_inst *serial)
 	if (!serial || !serial->rcv_buffer)
 		return;
 
-	g_string_truncate(serial->rcv_buffer, 0);
+	otc_byte_ring_reset(serial->rcv_buffer);
 }
 
 /**
@@ -303,7 +303,7 @@ OTC_PRIV size_t otc_ser_has_queued_data(struct otc_serial_dev_inst *serial)
 	if (!serial || !serial->rcv_buffer)
 		return 0;
 
-	return serial->rcv_buffer->len;
+	return otc_byte_ring_used(serial->rcv_buffer);
 }
 
 /**
@@ -322,10 +322,17 @@ OTC_PRIV void otc_ser_queue_rx_data(struct otc_serial_dev_inst *serial,
 	if (!serial || !data || !len)
 		return;
 
-	if (serial->rx_chunk_cb_func)
+	if (serial->rx_chunk_cb_func) {
 		serial->rx_chunk_cb_func(serial, serial->rx_chunk_cb_data, data, len);
-	else if (serial->rcv_buffer)
-		g_string_append_len(serial->rcv_buffer, (const gchar *)data, len);
+		return;
+	}
+	if (!serial->rcv_buffer)
+		return;
+
+	/* Keep all data like before, grow when the application lags. */
+	if (otc_byte_ring_reserve(serial->rcv_buffer, len) != OTC_OK)
+		otc_warn("RX queue full, dropping data.");
+	otc_byte_ring_write(serial->rcv_buffer, data, len);
 }
 
 /**
@@ -341,25 +348,13 @@ OTC_PRIV void otc_ser_queue_rx_data(struct otc_serial_dev_inst *serial,
 OTC_PRIV size_t otc_ser_unqueue_rx_data(struct otc_serial_dev_inst *serial,
 	uint8_t *data, size_t len)
 {
-	size_t qlen;
-	GString *buf;
-
 	if (!serial || !data || !len)
 		return 0;
 
-	qlen = otc_ser_has_queued_data(serial);
-	if (!qlen)
+	if (!otc_ser_has_queued_data(serial))
 		return 0;
 
-	buf = serial->rcv_buffer;
-	if (len > buf->len)
-		len = buf->len;
-	if (len) {
-		memcpy(data, buf->str, len);
-		g_string_erase(buf, 0, len);
-	}
-
-	return len;
+	return otc_byte_ring_read(serial->rcv_buffer, data, len);
 }
 
 /**
@@ -925,6 +920,253 @@ OTC_PRIV int serial_stream_detect(struct otc_serial_dev_inst *serial,
 	return OTC_ERR;
 }
 
+/**
+ * Create a packet framer for a serial protocol.
+ *
+ * The framer keeps received data in a ring buffer, and checks for valid
+ * packets at subsequent positions without moving data around. Valid
+ * packets get passed to the caller's packet callback in place. This
+ * replaces the local buffer and memmove() logic of individual drivers.
+ *
+ * @param[in] min_len Minimum packet length, the check callback is only
+ *   called when at least this many bytes are available.
+ * @param[in] max_len Maximum number of bytes which the check callback
+ *   gets to see. Also determines the receive buffer's size.
+ * @param[in] check_cb Routine which checks for a valid packet.
+ * @param[in] packet_cb Routine which processes a valid packet.
+ * @param[in] cb_data Caller provided data, passed to the callbacks.
+ *
+ * @return The framer, or #NULL on invalid parameters or allocation failure.
+ *
+ * @private
+ */
+OTC_PRIV struct otc_ser_framer *otc_ser_framer_new(size_t min_len,
+	size_t max_len, otc_ser_framer_check_cb check_cb,
+	otc_ser_framer_packet_cb packet_cb, void *cb_data)
+{
+	struct otc_ser_framer *framer;
+
+	if (!min_len || max_len < min_len || !check_cb || !packet_cb)
+		return NULL;
+
+	framer = g_malloc0(sizeof(*framer));
+	framer->ring = otc_byte_ring_new(2 * max_len);
+	if (!framer->ring) {
+		g_free(framer);
+		return NULL;
+	}
+	framer->min_len = min_len;
+	framer->max_len = max_len;
+	framer->check_cb = check_cb;
+	framer->packet_cb = packet_cb;
+	framer->cb_data = cb_data;
+
+	return framer;
+}
+
+/**
+ * Release a packet framer.
+ *
+ * @param[in] framer The framer to release. Can be #NULL.
+ *
+ * @private
+ */
+OTC_PRIV void otc_ser_framer_free(struct otc_ser_framer *framer)
+{
+	if (!framer)
+		return;
+
+	otc_byte_ring_free(framer->ring);
+	g_free(framer);
+}
+
+/**
+ * Discard a packet framer's unprocessed data.
+ *
+ * @param[in] framer The framer to reset.
+ *
+ * @private
+ */
+OTC_PRIV void otc_ser_framer_reset(struct otc_ser_framer *framer)
+{
+	if (!framer)
+		return;
+
+	otc_byte_ring_reset(framer->ring);
+	framer->skipped = 0;
+}
+
+/**
+ * Specify a byte sequence which all packets of a protocol contain at
+ * a fixed position.
+ *
+ * The framer then skips to the next occurrence of the pattern in bulk
+ * instead of calling the check routine at every byte position.
+ *
+ * @param[in] framer The framer to configure.
+ * @param[in] offset The pattern's position within packets.
+ * @param[in] pattern The sync pattern, #NULL to disable.
+ * @param[in] len The pattern's length, up to 8 bytes.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid parameter.
+ *
+ * @private
+ */
+OTC_PRIV int otc_ser_framer_set_sync(struct otc_ser_framer *framer,
+	size_t offset, const uint8_t *pattern, size_t len)
+{
+	if (!framer)
+		return OTC_ERR_ARG;
+	if (pattern && (!len || len > sizeof(framer->sync) ||
+			offset + len > framer->min_len))
+		return OTC_ERR_ARG;
+
+	framer->sync_offset = offset;
+	framer->sync_len = pattern ? len : 0;
+	if (framer->sync_len)
+		memcpy(framer->sync, pattern, framer->sync_len);
+
+	return OTC_OK;
+}
+
+/* Check queued data for packets. Returns the number of packets. */
+static int framer_process(struct otc_ser_framer *framer)
+{
+	struct otc_byte_ring *ring;
+	size_t avail, check_len, pkt_len, pos;
+	const uint8_t *check_ptr;
+	int ret, count;
+
+	ring = framer->ring;
+	count = 0;
+	while ((avail = otc_byte_ring_used(ring)) >= framer->min_len) {
+		/* Skip to the next potential packet start in bulk. */
+		if (framer->sync_len) {
+			if (otc_byte_ring_find(ring, framer->sync_offset,
+					framer->sync, framer->sync_len, &pos))
+				pos -= framer->sync_offset;
+			else
+				pos = avail - framer->sync_offset -
+					(framer->sync_len - 1);
+			if (pos) {
+				otc_dbg("Skipping %zu bytes to sync.", pos);
+				otc_byte_ring_consume(ring, pos);
+				framer->skipped += pos;
+				continue;
+			}
+		}
+
+		/* Is it a valid packet? */
+		check_len = MIN(avail, framer->max_len);
+		check_ptr = otc_byte_ring_peek_ptr(ring, 0, check_len);
+		pkt_len = framer->min_len;
+		ret = framer->check_cb(framer->cb_data,
+			check_ptr, check_len, &pkt_len);
+		if (ret == OTC_PACKET_NEED_RX && check_len < framer->max_len)
+			break;
+		if (ret != OTC_PACKET_VALID || !pkt_len || pkt_len > check_len) {
+			otc_spew("Not a valid packet, searching.");
+			otc_byte_ring_consume(ring, 1);
+			framer->skipped++;
+			continue;
+		}
+
+		/* Process the packet. */
+		otc_spew("Valid packet, size %zu, processing.", pkt_len);
+		framer->packet_cb(framer->cb_data, check_ptr, pkt_len);
+		otc_byte_ring_consume(ring, pkt_len);
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * Pass data to a packet framer, and process all complete packets.
+ *
+ * @param[in] framer The framer to pass data to.
+ * @param[in] data The received data.
+ * @param[in] len The number of received bytes.
+ *
+ * @return The number of processed packets, or a negative error code.
+ *
+ * @private
+ */
+OTC_PRIV int otc_ser_framer_feed(struct otc_ser_framer *framer,
+	const uint8_t *data, size_t len)
+{
+	size_t copied;
+	int count;
+
+	if (!framer || (len && !data))
+		return OTC_ERR_ARG;
+
+	count = 0;
+	while (len) {
+		copied = otc_byte_ring_write(framer->ring, data, len);
+		if (!copied) {
+			otc_info("Drop unprocessed RX data, try to re-sync to stream.");
+			otc_byte_ring_reset(framer->ring);
+			continue;
+		}
+		data += copied;
+		len -= copied;
+		count += framer_process(framer);
+	}
+
+	return count;
+}
+
+/**
+ * Receive available serial data into a packet framer, and process all
+ * complete packets.
+ *
+ * Data gets read directly into the framer's ring buffer, there is no
+ * intermediate copy.
+ *
+ * @param[in] framer The framer to receive data into.
+ * @param[in] serial Previously opened serial port instance.
+ *
+ * @return The number of processed packets, or a negative error code.
+ *
+ * @private
+ */
+OTC_PRIV int otc_ser_framer_receive(struct otc_ser_framer *framer,
+	struct otc_serial_dev_inst *serial)
+{
+	uint8_t *seg_ptr[2];
+	size_t seg_len[2], seg_count, idx;
+	int ret;
+
+	if (!framer || !serial)
+		return OTC_ERR_ARG;
+
+	/*
+	 * If the complete buffer filled up and none of it got processed,
+	 * discard the unprocessed buffer, re-sync to the stream in later
+	 * calls again.
+	 */
+	if (!otc_byte_ring_space(framer->ring)) {
+		otc_info("Drop unprocessed RX data, try to re-sync to stream.");
+		otc_byte_ring_reset(framer->ring);
+	}
+
+	seg_count = otc_byte_ring_write_segments(framer->ring, seg_ptr, seg_len);
+	for (idx = 0; idx < seg_count; idx++) {
+		ret = serial_read_nonblocking(serial, seg_ptr[idx], seg_len[idx]);
+		if (ret < 0) {
+			otc_err("Serial port read error: %d.", ret);
+			return ret;
+		}
+		otc_byte_ring_commit(framer->ring, ret);
+		if ((size_t)ret < seg_len[idx])
+			break;
+	}
+
+	return framer_process(framer);
+}
+
 #endif
 
 /**
@@ -613,7 +613,7 @@ static int ser_bt_open(struct otc_serial_dev_inst *serial, int flags)
 
 	/* Make sure the receive buffer can accept input data. */
 	if (!serial->rcv_buffer)
-		serial->rcv_buffer = g_string_sized_new(SER_BT_CHUNK_SIZE);
+		serial->rcv_buffer = otc_byte_ring_new(SER_BT_CHUNK_SIZE);
 	rc = otc_bt_config_cb_data(desc, ser_bt_data_cb, serial);
 	if (rc < 0)
 		return OTC_ERR;
@@ -1131,7 +1131,7 @@ static int ser_hid_open(struct otc_serial_dev_inst *serial, int flags)
 	}
 
 	if (!serial->rcv_buffer)
-		serial->rcv_buffer = g_string_sized_new(SER_HID_CHUNK_SIZE);
+		serial->rcv_buffer = otc_byte_ring_new(SER_HID_CHUNK_SIZE);
 
 	return OTC_OK;
 }
@@ -27,6 +27,7 @@
 #define LOG_PREFIX "serial-tcpraw"
 
 #define SER_TCPRAW_CONN_PREFIX	"tcp-raw"
+#define TCPRAW_RX_BUFFER_SIZE	(64 * 1024)
 
 /**
  * @file
@@ -171,9 +172,14 @@ static int ser_tcpraw_open(struct otc_serial_dev_inst *serial, int flags)
 
 	/*
 	 * Open the TCP socket. Only keep caller's parameters (and the
-	 * resulting socket fd) when open completes successfully.
+	 * resulting socket fd) when open completes successfully. Serial
+	 * traffic is mostly request/response, prefer low latency. Drain
+	 * receive data in bulk, serve reads from the receive buffer.
 	 */
-	ret = otc_tcp_connect(serial->tcp_dev);
+	(void)otc_tcp_set_sockopts(serial->tcp_dev, 0, TRUE);
+	ret = otc_tcp_rx_buffer_alloc(serial->tcp_dev, TCPRAW_RX_BUFFER_SIZE);
+	if (ret == OTC_OK)
+		ret = otc_tcp_connect(serial->tcp_dev);
 	if (ret != OTC_OK) {
 		otc_err("Failed to establish TCP connection.");
 		otc_tcp_dev_inst_free(serial->tcp_dev);
@@ -193,7 +199,9 @@ static int ser_tcpraw_close(struct otc_serial_dev_inst *serial)
 	if (!serial->tcp_dev)
 		return OTC_OK;
 
-	(void)otc_tcp_disconnect(serial->tcp_dev);
+	/* Open creates a new instance, release this one's receive buffer. */
+	otc_tcp_dev_inst_free(serial->tcp_dev);
+	serial->tcp_dev = NULL;
 	return OTC_OK;
 }
 
@@ -203,6 +211,15 @@ static int ser_tcpraw_setup_source_add(struct otc_session *session,
 {
 	if (!serial || !serial->tcp_dev)
 		return OTC_ERR_ARG;
+
+	/*
+	 * Reads drain the socket into the receive buffer. Keep calling
+	 * the driver while buffered data is left, the socket's fd won't
+	 * signal that data.
+	 */
+	if ((events & G_IO_IN) && serial->tcp_dev->rx_ring)
+		return otc_tcp_rx_source_add(session, serial->tcp_dev,
+			timeout, cb, cb_data);
 	return otc_tcp_source_add(session, serial->tcp_dev,
 		events, timeout, cb, cb_data);
 }
@@ -216,6 +233,15 @@ static int ser_tcpraw_setup_source_remove(struct otc_session *session,
 	return OTC_OK;
 }
 
+static int ser_tcpraw_drain(struct otc_serial_dev_inst *serial)
+{
+	if (!serial || !serial->tcp_dev)
+		return OTC_ERR_ARG;
+
+	/* Writes only return after the socket took all data. */
+	return OTC_OK;
+}
+
 static int ser_tcpraw_write(struct otc_serial_dev_inst *serial,
 	const void *buf, size_t count,
 	int nonblocking, unsigned int timeout_ms)
@@ -284,8 +310,10 @@ static int ser_tcpraw_read(struct otc_serial_dev_inst *serial,
 	 */
 	total = 0;
 	while (count) {
-		ret = otc_tcp_read_bytes(serial->tcp_dev,
-			buf, count, nonblocking);
+		ret = otc_tcp_rx_read(serial->tcp_dev, buf, count);
+		if (ret == 0 && !nonblocking && !deadline_us)
+			ret = otc_tcp_read_bytes(serial->tcp_dev,
+				buf, count, FALSE);
 		if (ret < 0 && !total) {
 			otc_err("Failed to receive TCP data.");
 			break;
@@ -312,9 +340,24 @@ static int ser_tcpraw_read(struct otc_serial_dev_inst *serial,
 	return total;
 }
 
+static size_t ser_tcpraw_get_rx_avail(struct otc_serial_dev_inst *serial)
+{
+	if (!serial || !serial->tcp_dev)
+		return 0;
+
+	/*
+	 * Data which is still in the socket counts as well, drivers poll
+	 * here for responses before they start reading.
+	 */
+	(void)otc_tcp_rx_fill(serial->tcp_dev);
+
+	return otc_byte_ring_used(serial->tcp_dev->rx_ring);
+}
+
 static struct ser_lib_functions serlib_tcpraw = {
 	.open = ser_tcpraw_open,
 	.close = ser_tcpraw_close,
+	.drain = ser_tcpraw_drain,
 	.write = ser_tcpraw_write,
 	.read = ser_tcpraw_read,
 	.set_params = std_dummy_set_params,
@@ -322,6 +365,7 @@ static struct ser_lib_functions serlib_tcpraw = {
 	.setup_source_add = ser_tcpraw_setup_source_add,
 	.setup_source_remove = ser_tcpraw_setup_source_remove,
 	.get_frame_format = NULL,
+	.get_rx_avail = ser_tcpraw_get_rx_avail,
 };
 OTC_PRIV struct ser_lib_functions *ser_lib_funcs_tcpraw = &serlib_tcpraw;
 
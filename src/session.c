@@ -263,6 +263,8 @@ OTC_API int otc_session_destroy(struct otc_session *session)
 
 	g_hash_table_unref(session->event_sources);
 
+	otc_metrics_free(session->metrics);
+
 	g_mutex_clear(&session->main_mutex);
 
 	g_free(session);
@@ -656,11 +658,27 @@ static int unset_main_context(struct otc_session *session)
 	return ret;
 }
 
+/* Event sources of the calling device thread, or else of the session. */
+static GHashTable *session_event_sources(struct otc_session *session)
+{
+	struct otc_session_dev_thread *dt;
+
+	if ((dt = otc_session_dev_thread_current(session)))
+		return dt->event_sources;
+
+	return session->event_sources;
+}
+
 static unsigned int session_source_attach(struct otc_session *session,
 		GSource *source)
 {
+	struct otc_session_dev_thread *dt;
 	unsigned int id = 0;
 
+	/* Sources of a device thread's driver run on that thread. */
+	if ((dt = otc_session_dev_thread_current(session)))
+		return g_source_attach(source, dt->main_context);
+
 	g_mutex_lock(&session->main_mutex);
 
 	if (session->main_context)
@@ -691,7 +709,12 @@ static gboolean delayed_stop_check(void *data)
 	if (g_hash_table_size(session->event_sources) != 0)
 		return G_SOURCE_REMOVE;
 
+	/* The merge source checks again once the devices are done. */
+	if (otc_session_dev_threads_busy(session))
+		return G_SOURCE_REMOVE;
+
 	session->running = FALSE;
+	otc_session_dev_threads_free(session);
 	unset_main_context(session);
 
 	otc_info("Stopped.");
@@ -712,7 +735,11 @@ static gboolean delayed_stop_check(void *data)
 	return G_SOURCE_REMOVE;
 }
 
-static int stop_check_later(struct otc_session *session)
+/** Check whether the session stopped, once it is idle.
+ *
+ * @private
+ */
+OTC_PRIV int otc_session_stop_check_later(struct otc_session *session)
 {
 	GSource *source;
 	unsigned int source_id;
@@ -810,8 +837,21 @@ OTC_API int otc_session_start(struct otc_session *session)
 
 	otc_info("Starting.");
 
+	if (session->metrics)
+		otc_metrics_start(session->metrics, session->devs);
 	session->running = TRUE;
 
+	if (session->device_threads) {
+		ret = otc_session_dev_threads_start(session);
+		if (ret != OTC_OK) {
+			session->running = FALSE;
+			unset_main_context(session);
+			return ret;
+		}
+		otc_session_stop_check_later(session);
+		return OTC_OK;
+	}
+
 	/* Have all devices start acquisition. */
 	for (l = session->devs; l; l = l->next) {
 		if (!(sdi = l->data)) {
@@ -844,7 +884,7 @@ OTC_API int otc_session_start(struct otc_session *session)
 	}
 
 	if (g_hash_table_size(session->event_sources) == 0)
-		stop_check_later(session);
+		otc_session_stop_check_later(session);
 
 	return OTC_OK;
 }
@@ -914,6 +954,11 @@ static gboolean session_stop_sync(void *user_data)
 
 	otc_info("Stopping.");
 
+	if (session->device_threads) {
+		otc_session_dev_threads_stop(session);
+		return G_SOURCE_REMOVE;
+	}
+
 	for (node = session->devs; node; node = node->next) {
 		sdi = node->data;
 		otc_dev_acquisition_stop(sdi);
@@ -1028,6 +1073,45 @@ OTC_API int otc_session_stopped_callback_set(struct otc_session *session,
 	return OTC_OK;
 }
 
+/**
+ * Set whether each device of a session acquires on its own thread.
+ *
+ * By default, the event sources of all devices run on the thread which
+ * calls otc_session_start(), one after the other. With device threads,
+ * each device gets a thread and main context of its own, so that one
+ * device's work doesn't hold up the others. The devices' packets still
+ * reach transforms and datafeed callbacks on the session's thread, in
+ * the order in which the devices sent them. Session start and stop
+ * apply to all devices.
+ *
+ * USB devices then need the context's USB event thread, see
+ * otc_usb_event_thread_set().
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param enable TRUE to use device threads, FALSE otherwise.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid session passed.
+ * @retval OTC_ERR The session is running.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_session_device_threads_set(struct otc_session *session,
+		gboolean enable)
+{
+	if (!session) {
+		otc_err("%s: session was NULL", __func__);
+		return OTC_ERR_ARG;
+	}
+	if (session->running) {
+		otc_err("Cannot change device threads while running.");
+		return OTC_ERR;
+	}
+	session->device_threads = enable;
+
+	return OTC_OK;
+}
+
 /**
  * Debug helper.
  *
@@ -1127,9 +1211,12 @@ OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
 		const struct otc_datafeed_packet *packet)
 {
 	GSList *l;
+	struct otc_session_dev_thread *dt;
 	struct datafeed_callback *cb_struct;
 	struct otc_datafeed_packet *packet_in, *packet_out;
 	struct otc_transform *t;
+	struct otc_metrics *metrics;
+	uint64_t start_ns, transform_ns;
 	int ret;
 
 	if (!sdi) {
@@ -1147,6 +1234,13 @@ OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
 		return OTC_ERR_BUG;
 	}
 
+	/* Device threads queue their packets, the session merges them. */
+	if ((dt = otc_session_dev_thread_current(sdi->session)))
+		return otc_session_dev_thread_send(dt, packet);
+
+	metrics = sdi->session->metrics;
+	start_ns = G_UNLIKELY(metrics) ? otc_metrics_now_ns() : 0;
+
 	/*
 	 * Pass the packet to the first transform module. If that returns
 	 * another packet (instead of NULL), pass that packet to the next
@@ -1167,6 +1261,10 @@ OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
 			 * packet, abort.
 			 */
 			otc_spew("Transform module didn't return a packet, aborting.");
+			if (G_UNLIKELY(metrics))
+				otc_metrics_packet(metrics, sdi, packet,
+					otc_metrics_now_ns() - start_ns,
+					UINT64_MAX);
 			return OTC_OK;
 		} else {
 			/*
@@ -1176,7 +1274,12 @@ OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
 			packet_in = packet_out;
 		}
 	}
-	packet = packet_in;
+
+	transform_ns = UINT64_MAX;
+	if (G_UNLIKELY(metrics) && sdi->session->transforms) {
+		transform_ns = otc_metrics_now_ns() - start_ns;
+		start_ns += transform_ns;
+	}
 
 	/*
 	 * If the last transform did output a packet, pass it to all datafeed
@@ -1184,11 +1287,16 @@ OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
 	 */
 	for (l = sdi->session->datafeed_callbacks; l; l = l->next) {
 		if (otc_log_loglevel_get() >= OTC_LOG_DBG)
-			datafeed_dump(packet);
+			datafeed_dump(packet_in);
 		cb_struct = l->data;
-		cb_struct->cb(sdi, packet, cb_struct->cb_data);
+		cb_struct->cb(sdi, packet_in, cb_struct->cb_data);
 	}
 
+	/* Count the packet as the device sent it. */
+	if (G_UNLIKELY(metrics))
+		otc_metrics_packet(metrics, sdi, packet, transform_ns,
+			otc_metrics_now_ns() - start_ns);
+
 	return OTC_OK;
 }
 
@@ -1209,17 +1317,20 @@ OTC_PRIV int otc_session_send(const struct otc_dev_inst *sdi,
 OTC_PRIV int otc_session_source_add_internal(struct otc_session *session,
 		void *key, GSource *source)
 {
+	GHashTable *event_sources;
+
 	/*
 	 * This must not ever happen, since the source has already been
 	 * created and its finalize() method will remove the key for the
 	 * already installed source. (Well it would, if we did not have
 	 * another sanity check there.)
 	 */
-	if (g_hash_table_contains(session->event_sources, key)) {
+	event_sources = session_event_sources(session);
+	if (g_hash_table_contains(event_sources, key)) {
 		otc_err("Event source with key %p already exists.", key);
 		return OTC_ERR_BUG;
 	}
-	g_hash_table_insert(session->event_sources, key, source);
+	g_hash_table_insert(event_sources, key, source);
 
 	if (session_source_attach(session, source) == 0)
 		return OTC_ERR;
@@ -1359,7 +1470,7 @@ OTC_PRIV int otc_session_source_remove_internal(struct otc_session *session,
 {
 	GSource *source;
 
-	source = g_hash_table_lookup(session->event_sources, key);
+	source = g_hash_table_lookup(session_event_sources(session), key);
 	/*
 	 * Trying to remove an already removed event source is problematic
 	 * since the poll_object handle may have been reused in the meantime.
@@ -1454,9 +1565,13 @@ OTC_PRIV int otc_session_source_remove_channel(struct otc_session *session,
 OTC_PRIV int otc_session_source_destroyed(struct otc_session *session,
 		void *key, GSource *source)
 {
+	struct otc_session_dev_thread *dt;
+	GHashTable *event_sources;
 	GSource *registered_source;
 
-	registered_source = g_hash_table_lookup(session->event_sources, key);
+	dt = otc_session_dev_thread_current(session);
+	event_sources = dt ? dt->event_sources : session->event_sources;
+	registered_source = g_hash_table_lookup(event_sources, key);
 	/*
 	 * Trying to remove an already removed event source is problematic
 	 * since the poll_object handle may have been reused in the meantime.
@@ -1470,16 +1585,19 @@ OTC_PRIV int otc_session_source_destroyed(struct otc_session *session,
 			" destroyed source.", key);
 		return OTC_ERR_BUG;
 	}
-	g_hash_table_remove(session->event_sources, key);
+	g_hash_table_remove(event_sources, key);
 
-	if (g_hash_table_size(session->event_sources) > 0)
+	if (g_hash_table_size(event_sources) > 0)
 		return OTC_OK;
 
+	if (dt)
+		return otc_session_dev_thread_stop_check_later(dt);
+
 	/* If no event sources are left, consider the acquisition finished.
 	 * This is pretty crude, as it requires all event sources to be
 	 * registered via the libopentracecapture API.
 	 */
-	return stop_check_later(session);
+	return otc_session_stop_check_later(session);
 }
 
 static void copy_src(struct otc_config *src, struct otc_datafeed_meta *meta_copy)
@@ -1508,6 +1626,8 @@ OTC_API int otc_packet_copy(const struct otc_datafeed_packet *packet,
 	struct otc_analog_encoding *encoding_copy;
 	struct otc_analog_meaning *meaning_copy;
 	struct otc_analog_spec *spec_copy;
+	unsigned int num_channels;
+	size_t data_size;
 	uint8_t *payload;
 
 	*copy = g_malloc0(sizeof(struct otc_datafeed_packet));
@@ -1516,6 +1636,8 @@ OTC_API int otc_packet_copy(const struct otc_datafeed_packet *packet,
 	switch (packet->type) {
 	case OTC_DF_TRIGGER:
 	case OTC_DF_END:
+	case OTC_DF_FRAME_BEGIN:
+	case OTC_DF_FRAME_END:
 		/* No payload. */
 		break;
 	case OTC_DF_HEADER:
@@ -1526,7 +1648,7 @@ OTC_API int otc_packet_copy(const struct otc_datafeed_packet *packet,
 	case OTC_DF_META:
 		meta = packet->payload;
 		meta_copy = g_malloc0(sizeof(struct otc_datafeed_meta));
-		g_slist_foreach(meta->config, (GFunc)copy_src, meta_copy->config);
+		g_slist_foreach(meta->config, (GFunc)copy_src, meta_copy);
 		(*copy)->payload = meta_copy;
 		break;
 	case OTC_DF_LOGIC:
@@ -1536,21 +1658,23 @@ OTC_API int otc_packet_copy(const struct otc_datafeed_packet *packet,
 			return OTC_ERR;
 		logic_copy->length = logic->length;
 		logic_copy->unitsize = logic->unitsize;
-		logic_copy->data = g_malloc(logic->length * logic->unitsize);
+		logic_copy->data = g_malloc(logic->length);
 		if (!logic_copy->data) {
 			g_free(logic_copy);
 			return OTC_ERR;
 		}
-		memcpy(logic_copy->data, logic->data, logic->length * logic->unitsize);
+		memcpy(logic_copy->data, logic->data, logic->length);
 		(*copy)->payload = logic_copy;
 		break;
 	case OTC_DF_ANALOG:
 		analog = packet->payload;
 		analog_copy = g_malloc(sizeof(*analog_copy));
-		analog_copy->data = g_malloc(
-				analog->encoding->unitsize * analog->num_samples);
-		memcpy(analog_copy->data, analog->data,
-				analog->encoding->unitsize * analog->num_samples);
+		/* Samples of multiple channels are interleaved. */
+		num_channels = g_slist_length(analog->meaning->channels);
+		data_size = (size_t)analog->encoding->unitsize
+			* analog->num_samples * MAX(num_channels, 1);
+		analog_copy->data = g_malloc(data_size);
+		memcpy(analog_copy->data, analog->data, data_size);
 		analog_copy->num_samples = analog->num_samples;
 #if GLIB_CHECK_VERSION(2, 67, 3)
 		encoding_copy = g_memdup2(analog->encoding, sizeof(*analog->encoding));
@@ -1587,6 +1711,8 @@ OTC_API void otc_packet_free(struct otc_datafeed_packet *packet)
 	switch (packet->type) {
 	case OTC_DF_TRIGGER:
 	case OTC_DF_END:
+	case OTC_DF_FRAME_BEGIN:
+	case OTC_DF_FRAME_END:
 		/* No payload. */
 		break;
 	case OTC_DF_HEADER:
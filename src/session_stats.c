@@ -0,0 +1,519 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <string.h>
+#include <time.h>
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "libopentracecapture-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "session_stats"
+/** @endcond */
+
+/**
+ * @file
+ *
+ * Performance statistics of sessions.
+ */
+
+/**
+ * @defgroup grp_session_stats Session statistics
+ *
+ * Performance statistics of sessions.
+ *
+ * A session with statistics counts the packets and bytes each device
+ * sends, and measures the time which transforms, datafeed callbacks and
+ * output modules take per packet, how long USB transfers wait for their
+ * resubmission, and how fast the soft trigger scans samples. Drivers
+ * which receive into a sample buffer of their own report how full it
+ * gets, and when samples got lost.
+ * otc_session_stats_get() takes a snapshot of them, at any time and on
+ * any thread.
+ *
+ * Statistics are off by default. Then each of the places which update
+ * them costs a test of a pointer.
+ *
+ * @{
+ */
+
+/** @cond PRIVATE */
+
+/* Each power of two is split into 1 << SUB_BITS buckets. */
+#define SUB_BITS 3
+#define SUB_BUCKETS (1 << SUB_BITS)
+
+/* Durations from 1 << MAX_SHIFT ns (about 69 s) go into the last bucket. */
+#define MAX_SHIFT 36
+
+struct metrics_device {
+	struct otc_stats_device stats;
+	/* Counts at the previous snapshot, for the rates. */
+	uint64_t snapshot_packets;
+	uint64_t snapshot_bytes;
+};
+
+struct otc_metrics {
+	/* Protects all fields, updates come from several threads. */
+	GMutex mutex;
+	int64_t start_us;
+	int64_t snapshot_us;
+	/* Array of struct metrics_device. */
+	GArray *devices;
+	struct otc_stats_histogram histograms[OTC_METRICS_NUM_HISTOGRAMS];
+};
+
+/** @endcond */
+
+/** @private */
+OTC_PRIV uint64_t otc_metrics_now_ns(void)
+{
+#ifdef G_OS_WIN32
+	return (uint64_t)g_get_monotonic_time() * 1000;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static unsigned int bucket_index(uint64_t ns)
+{
+	unsigned int shift;
+
+	if (ns >= UINT64_C(1) << MAX_SHIFT)
+		return OTC_STATS_HISTOGRAM_BUCKETS - 1;
+
+	shift = 0;
+	while ((ns >> shift) >= 2 * SUB_BUCKETS)
+		shift++;
+	if (!shift)
+		return ns;
+
+	return (shift + 1) * SUB_BUCKETS + ((ns >> shift) & (SUB_BUCKETS - 1));
+}
+
+/* The highest duration which goes into a bucket. */
+static uint64_t bucket_highest(unsigned int index)
+{
+	unsigned int shift;
+
+	if (index < 2 * SUB_BUCKETS)
+		return index;
+	/* The last bucket takes all longer durations, too. */
+	if (index >= OTC_STATS_HISTOGRAM_BUCKETS - 1)
+		return UINT64_MAX;
+
+	shift = index / SUB_BUCKETS - 1;
+
+	return ((uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS + 1) << shift) - 1;
+}
+
+static void histogram_record(struct otc_stats_histogram *hist, uint64_t ns)
+{
+	if (!hist->count || ns < hist->min)
+		hist->min = ns;
+	if (ns > hist->max)
+		hist->max = ns;
+	hist->count++;
+	hist->sum += ns;
+	hist->buckets[bucket_index(ns)]++;
+}
+
+static struct metrics_device *device_get(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi)
+{
+	struct metrics_device *dev;
+	unsigned int i;
+
+	for (i = 0; i < metrics->devices->len; i++) {
+		dev = &g_array_index(metrics->devices, struct metrics_device, i);
+		if (dev->stats.sdi == sdi)
+			return dev;
+	}
+
+	/* A device which joined the session while it was running. */
+	g_array_set_size(metrics->devices, i + 1);
+	dev = &g_array_index(metrics->devices, struct metrics_device, i);
+	dev->stats.sdi = sdi;
+
+	return dev;
+}
+
+static uint64_t packet_bytes(const struct otc_datafeed_packet *packet)
+{
+	const struct otc_datafeed_logic *logic;
+	const struct otc_datafeed_analog *analog;
+	unsigned int num_channels;
+
+	switch (packet->type) {
+	case OTC_DF_LOGIC:
+		logic = packet->payload;
+		return logic->length;
+	case OTC_DF_ANALOG:
+		analog = packet->payload;
+		num_channels = g_slist_length(analog->meaning->channels);
+		return (uint64_t)analog->num_samples * analog->encoding->unitsize
+			* MAX(num_channels, 1);
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Start the statistics over, at the start of an acquisition.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_start(struct otc_metrics *metrics, GSList *devs)
+{
+	GSList *l;
+
+	g_mutex_lock(&metrics->mutex);
+	g_array_set_size(metrics->devices, 0);
+	for (l = devs; l; l = l->next)
+		device_get(metrics, l->data);
+	memset(metrics->histograms, 0, sizeof(metrics->histograms));
+	metrics->start_us = metrics->snapshot_us = g_get_monotonic_time();
+	g_mutex_unlock(&metrics->mutex);
+}
+
+static struct otc_metrics *metrics_new(GSList *devs)
+{
+	struct otc_metrics *metrics;
+
+	metrics = g_malloc0(sizeof(*metrics));
+	g_mutex_init(&metrics->mutex);
+	metrics->devices = g_array_new(FALSE, TRUE,
+		sizeof(struct metrics_device));
+	otc_metrics_start(metrics, devs);
+
+	return metrics;
+}
+
+/** @private */
+OTC_PRIV void otc_metrics_free(struct otc_metrics *metrics)
+{
+	if (!metrics)
+		return;
+
+	g_array_free(metrics->devices, TRUE);
+	g_mutex_clear(&metrics->mutex);
+	g_free(metrics);
+}
+
+/**
+ * Record a session-wide duration.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_record(struct otc_metrics *metrics,
+		enum otc_metrics_histogram id, uint64_t ns)
+{
+	g_mutex_lock(&metrics->mutex);
+	histogram_record(&metrics->histograms[id], ns);
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Count a packet which a device sent, with the time of its transforms
+ * and datafeed callbacks.
+ *
+ * @param transform_ns Time of the transforms, UINT64_MAX when the
+ *   session has none.
+ * @param callbacks_ns Time of the datafeed callbacks, UINT64_MAX when
+ *   a transform consumed the packet.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_packet(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi,
+		const struct otc_datafeed_packet *packet,
+		uint64_t transform_ns, uint64_t callbacks_ns)
+{
+	struct metrics_device *dev;
+	uint64_t bytes;
+
+	bytes = packet_bytes(packet);
+
+	g_mutex_lock(&metrics->mutex);
+	dev = device_get(metrics, sdi);
+	dev->stats.packets++;
+	dev->stats.bytes += bytes;
+	if (transform_ns != UINT64_MAX)
+		histogram_record(&metrics->histograms[OTC_METRICS_TRANSFORM],
+			transform_ns);
+	if (callbacks_ns != UINT64_MAX)
+		histogram_record(&metrics->histograms[OTC_METRICS_CALLBACKS],
+			callbacks_ns);
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Count a flush of a device's feed queue.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_feed_queue(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, uint64_t samples)
+{
+	struct metrics_device *dev;
+
+	g_mutex_lock(&metrics->mutex);
+	dev = device_get(metrics, sdi);
+	dev->stats.feed_queue_flushes++;
+	dev->stats.feed_queue_samples += samples;
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Record a scan of the soft trigger of a device.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_trigger_scan(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, uint64_t samples, uint64_t ns)
+{
+	struct metrics_device *dev;
+
+	g_mutex_lock(&metrics->mutex);
+	dev = device_get(metrics, sdi);
+	dev->stats.trigger_samples += samples;
+	histogram_record(&dev->stats.trigger_scan, ns);
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Update the number of packets which a device thread queued.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_queued(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, unsigned int queued)
+{
+	struct metrics_device *dev;
+
+	g_mutex_lock(&metrics->mutex);
+	dev = device_get(metrics, sdi);
+	dev->stats.queued_packets = queued;
+	if (queued > dev->stats.max_queued_packets)
+		dev->stats.max_queued_packets = queued;
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Update the fill level of a device's sample buffer.
+ *
+ * @param fill Bytes waiting in the buffer.
+ * @param full TRUE when the buffer had no space left.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_buffer(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi, uint64_t fill, gboolean full)
+{
+	struct metrics_device *dev;
+
+	g_mutex_lock(&metrics->mutex);
+	dev = device_get(metrics, sdi);
+	if (full)
+		dev->stats.buffer_full++;
+	if (fill > dev->stats.max_buffer_fill)
+		dev->stats.max_buffer_fill = fill;
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Count a loss of samples of a device, since the host fell behind.
+ *
+ * @private
+ */
+OTC_PRIV void otc_metrics_overrun(struct otc_metrics *metrics,
+		const struct otc_dev_inst *sdi)
+{
+	struct metrics_device *dev;
+
+	g_mutex_lock(&metrics->mutex);
+	dev = device_get(metrics, sdi);
+	dev->stats.overruns++;
+	g_mutex_unlock(&metrics->mutex);
+}
+
+/**
+ * Set whether a session collects performance statistics.
+ *
+ * The statistics start over with each otc_session_start(), and stay
+ * available after the session stopped, until they get disabled.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param enable TRUE to collect statistics, FALSE otherwise.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid session passed.
+ * @retval OTC_ERR The session is running.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_session_stats_set(struct otc_session *session,
+		gboolean enable)
+{
+	if (!session) {
+		otc_err("%s: session was NULL", __func__);
+		return OTC_ERR_ARG;
+	}
+	if (session->running) {
+		otc_err("Cannot change statistics while running.");
+		return OTC_ERR;
+	}
+
+	if (enable && !session->metrics) {
+		session->metrics = metrics_new(session->devs);
+	} else if (!enable && session->metrics) {
+		otc_metrics_free(session->metrics);
+		session->metrics = NULL;
+	}
+
+	return OTC_OK;
+}
+
+/**
+ * Take a snapshot of the performance statistics of a session.
+ *
+ * The rates of the devices cover the time since the previous snapshot,
+ * or since the start for the first one. This may be called on any
+ * thread, while the session is running.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param stats Pointer to store the snapshot in. Free it with
+ *   otc_session_stats_free(). Must not be NULL.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid argument.
+ * @retval OTC_ERR_NA The session doesn't collect statistics.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_session_stats_get(struct otc_session *session,
+		struct otc_session_stats **stats)
+{
+	struct otc_metrics *metrics;
+	struct otc_session_stats *snapshot;
+	struct metrics_device *dev;
+	struct otc_stats_device *out;
+	int64_t now_us;
+	double seconds;
+	unsigned int i;
+
+	if (!session || !stats)
+		return OTC_ERR_ARG;
+
+	if (!(metrics = session->metrics))
+		return OTC_ERR_NA;
+
+	snapshot = g_malloc0(sizeof(*snapshot));
+
+	g_mutex_lock(&metrics->mutex);
+	now_us = g_get_monotonic_time();
+	seconds = (now_us - metrics->snapshot_us) / 1e6;
+	snapshot->elapsed_us = now_us - metrics->start_us;
+	snapshot->num_devices = metrics->devices->len;
+	snapshot->devices = g_new0(struct otc_stats_device,
+		metrics->devices->len);
+	for (i = 0; i < metrics->devices->len; i++) {
+		dev = &g_array_index(metrics->devices, struct metrics_device, i);
+		out = &snapshot->devices[i];
+		*out = dev->stats;
+		if (seconds > 0) {
+			out->packets_per_sec = (dev->stats.packets
+				- dev->snapshot_packets) / seconds;
+			out->bytes_per_sec = (dev->stats.bytes
+				- dev->snapshot_bytes) / seconds;
+		}
+		dev->snapshot_packets = dev->stats.packets;
+		dev->snapshot_bytes = dev->stats.bytes;
+	}
+	metrics->snapshot_us = now_us;
+	snapshot->transform = metrics->histograms[OTC_METRICS_TRANSFORM];
+	snapshot->callbacks = metrics->histograms[OTC_METRICS_CALLBACKS];
+	snapshot->usb_resubmit = metrics->histograms[OTC_METRICS_USB_RESUBMIT];
+	snapshot->output = metrics->histograms[OTC_METRICS_OUTPUT];
+	g_mutex_unlock(&metrics->mutex);
+
+	*stats = snapshot;
+
+	return OTC_OK;
+}
+
+/**
+ * Free a snapshot of the statistics of a session.
+ *
+ * @param stats The snapshot to free. Can be NULL.
+ *
+ * @since 0.6.0
+ */
+OTC_API void otc_session_stats_free(struct otc_session_stats *stats)
+{
+	if (!stats)
+		return;
+
+	g_free(stats->devices);
+	g_free(stats);
+}
+
+/**
+ * Get a percentile of the durations of a histogram.
+ *
+ * @param hist The histogram to use. Must not be NULL.
+ * @param percentile The percentile, from 0 to 100.
+ *
+ * @return The highest duration of the bucket the percentile falls
+ *   into, limited to the recorded minimum and maximum, in ns. 0 when
+ *   the histogram is empty.
+ *
+ * @since 0.6.0
+ */
+OTC_API uint64_t otc_stats_histogram_percentile(
+		const struct otc_stats_histogram *hist, double percentile)
+{
+	uint64_t rank, seen;
+	unsigned int i;
+
+	if (!hist || !hist->count)
+		return 0;
+
+	percentile = CLAMP(percentile, 0.0, 100.0);
+	rank = (uint64_t)(percentile / 100.0 * hist->count + 0.5);
+	rank = CLAMP(rank, 1, hist->count);
+
+	seen = 0;
+	for (i = 0; i < OTC_STATS_HISTOGRAM_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen >= rank)
+			break;
+	}
+
+	i = MIN(i, OTC_STATS_HISTOGRAM_BUCKETS - 1);
+
+	return CLAMP(bucket_highest(i), hist->min, hist->max);
+}
+
+/** @} */
@@ -0,0 +1,459 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "libopentracecapture-internal.h"
+
+/** @cond PRIVATE */
+#define LOG_PREFIX "session"
+/** @endcond */
+
+/*
+ * Sessions with device threads run each device's acquisition on a thread
+ * of its own, with its own main context. Drivers work unchanged: their
+ * event sources attach to the context of the thread they are called on,
+ * and otc_session_send() queues a pooled copy of each packet. The
+ * session's main context merges the queues in the order in which the
+ * packets were sent, and passes them on to transforms and datafeed
+ * callbacks.
+ *
+ * The queues are bounded. A device thread waits when the session falls
+ * behind, just like a driver does in a session without device threads.
+ */
+
+/* Packets a device thread queues before it waits for the session. */
+#define MAX_QUEUED_PACKETS 256
+
+/* Packets to merge before other sources of the session get their turn. */
+#define MAX_MERGE_BATCH 1024
+
+struct queued_packet {
+	int64_t time_us;
+	struct otc_datafeed_packet *packet;
+};
+
+struct merge_source {
+	GSource base;
+	struct otc_session *session;
+};
+
+static GPrivate current_dev_thread;
+
+/** @private */
+OTC_PRIV struct otc_session_dev_thread *otc_session_dev_thread_current(
+		const struct otc_session *session)
+{
+	struct otc_session_dev_thread *dt;
+
+	dt = g_private_get(&current_dev_thread);
+
+	return (dt && dt->session == session) ? dt : NULL;
+}
+
+static void wake_session(struct otc_session *session)
+{
+	g_atomic_int_inc(&session->merge_pending);
+	g_main_context_wakeup(session->main_context);
+}
+
+static void queued_packet_free(struct queued_packet *qp)
+{
+	otc_packet_pool_release(qp->packet);
+	g_free(qp);
+}
+
+/**
+ * Queue a packet of a device thread for the session.
+ *
+ * @private
+ */
+OTC_PRIV int otc_session_dev_thread_send(struct otc_session_dev_thread *dt,
+		const struct otc_datafeed_packet *packet)
+{
+	struct otc_metrics *metrics;
+	struct queued_packet *qp;
+
+	qp = g_malloc(sizeof(*qp));
+	qp->time_us = g_get_monotonic_time();
+	if (otc_packet_pool_copy(dt->session->packet_pool, packet,
+			&qp->packet) != OTC_OK) {
+		g_free(qp);
+		return OTC_ERR;
+	}
+
+	g_mutex_lock(&dt->mutex);
+	while (dt->packets.length >= MAX_QUEUED_PACKETS && !dt->discard)
+		g_cond_wait(&dt->cond, &dt->mutex);
+	if (dt->discard) {
+		g_mutex_unlock(&dt->mutex);
+		queued_packet_free(qp);
+		return OTC_OK;
+	}
+	g_queue_push_tail(&dt->packets, qp);
+	metrics = dt->session->metrics;
+	if (G_UNLIKELY(metrics))
+		otc_metrics_queued(metrics, dt->sdi, dt->packets.length);
+	g_mutex_unlock(&dt->mutex);
+
+	wake_session(dt->session);
+
+	return OTC_OK;
+}
+
+static gboolean dev_thread_stop_check(void *data)
+{
+	struct otc_session_dev_thread *dt;
+
+	dt = data;
+	dt->stop_check_id = 0;
+
+	/* New event sources may have been installed in the meantime. */
+	if (g_hash_table_size(dt->event_sources) == 0)
+		g_main_loop_quit(dt->main_loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * Check whether a device stopped, once its thread is idle.
+ *
+ * The device thread's counterpart of otc_session_stop_check_later().
+ *
+ * @private
+ */
+OTC_PRIV int otc_session_dev_thread_stop_check_later(
+		struct otc_session_dev_thread *dt)
+{
+	GSource *source;
+
+	if (dt->stop_check_id != 0)
+		return OTC_OK;
+
+	source = g_idle_source_new();
+	g_source_set_callback(source, &dev_thread_stop_check, dt, NULL);
+	dt->stop_check_id = g_source_attach(source, dt->main_context);
+	g_source_unref(source);
+
+	return (dt->stop_check_id != 0) ? OTC_OK : OTC_ERR;
+}
+
+static gpointer dev_thread_run(gpointer data)
+{
+	struct otc_session_dev_thread *dt;
+	int ret;
+
+	dt = data;
+
+	g_main_context_push_thread_default(dt->main_context);
+	g_private_set(&current_dev_thread, dt);
+
+	ret = otc_dev_acquisition_start(dt->sdi);
+	if (ret != OTC_OK) {
+		otc_err("Could not start %s device %s acquisition.",
+			dt->sdi->driver->name, dt->sdi->connection_id);
+	}
+
+	g_mutex_lock(&dt->mutex);
+	dt->start_result = ret;
+	dt->started = TRUE;
+	g_cond_broadcast(&dt->cond);
+	g_mutex_unlock(&dt->mutex);
+
+	if (ret == OTC_OK) {
+		if (g_hash_table_size(dt->event_sources) == 0)
+			otc_session_dev_thread_stop_check_later(dt);
+		g_main_loop_run(dt->main_loop);
+	}
+
+	g_private_set(&current_dev_thread, NULL);
+	g_main_context_pop_thread_default(dt->main_context);
+
+	g_mutex_lock(&dt->mutex);
+	dt->finished = TRUE;
+	g_mutex_unlock(&dt->mutex);
+	wake_session(dt->session);
+
+	return NULL;
+}
+
+static gboolean dev_thread_stop_sync(void *data)
+{
+	struct otc_session_dev_thread *dt;
+
+	dt = data;
+
+	/*
+	 * A device may have finished on its own, while the session was
+	 * still merging its queued packets. It has ended its feed already.
+	 */
+	if (g_hash_table_size(dt->event_sources) > 0)
+		otc_dev_acquisition_stop(dt->sdi);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Pass on the oldest packet of all devices, return FALSE when none. */
+static gboolean merge_one(struct otc_session *session)
+{
+	struct otc_session_dev_thread *dt, *oldest;
+	struct queued_packet *qp;
+	int64_t oldest_us;
+	GSList *l;
+
+	oldest = NULL;
+	oldest_us = 0;
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		g_mutex_lock(&dt->mutex);
+		qp = g_queue_peek_head(&dt->packets);
+		if (qp && (!oldest || qp->time_us < oldest_us)) {
+			oldest = dt;
+			oldest_us = qp->time_us;
+		}
+		g_mutex_unlock(&dt->mutex);
+	}
+	if (!oldest)
+		return FALSE;
+
+	g_mutex_lock(&oldest->mutex);
+	qp = g_queue_pop_head(&oldest->packets);
+	if (G_UNLIKELY(session->metrics))
+		otc_metrics_queued(session->metrics, oldest->sdi,
+			oldest->packets.length);
+	g_cond_broadcast(&oldest->cond);
+	g_mutex_unlock(&oldest->mutex);
+
+	otc_session_send(oldest->sdi, qp->packet);
+	queued_packet_free(qp);
+
+	return TRUE;
+}
+
+static gboolean merge_source_prepare(GSource *source, int *timeout)
+{
+	struct merge_source *msource;
+
+	msource = (struct merge_source *)source;
+	*timeout = -1;
+
+	return g_atomic_int_get(&msource->session->merge_pending) > 0;
+}
+
+static gboolean merge_source_check(GSource *source)
+{
+	struct merge_source *msource;
+
+	msource = (struct merge_source *)source;
+
+	return g_atomic_int_get(&msource->session->merge_pending) > 0;
+}
+
+static gboolean merge_source_dispatch(GSource *source,
+		GSourceFunc callback, void *user_data)
+{
+	struct otc_session *session;
+	unsigned int count;
+
+	(void)callback;
+	(void)user_data;
+
+	session = ((struct merge_source *)source)->session;
+	g_atomic_int_set(&session->merge_pending, 0);
+
+	for (count = 0; count < MAX_MERGE_BATCH; count++) {
+		if (!merge_one(session))
+			break;
+	}
+	if (count == MAX_MERGE_BATCH)
+		g_atomic_int_inc(&session->merge_pending);
+	else if (!otc_session_dev_threads_busy(session))
+		otc_session_stop_check_later(session);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static struct otc_session_dev_thread *dev_thread_new(
+		struct otc_session *session, struct otc_dev_inst *sdi)
+{
+	struct otc_session_dev_thread *dt;
+
+	dt = g_malloc0(sizeof(*dt));
+	dt->session = session;
+	dt->sdi = sdi;
+	dt->main_context = g_main_context_new();
+	dt->main_loop = g_main_loop_new(dt->main_context, FALSE);
+	dt->event_sources = g_hash_table_new(NULL, NULL);
+	g_mutex_init(&dt->mutex);
+	g_cond_init(&dt->cond);
+	g_queue_init(&dt->packets);
+
+	return dt;
+}
+
+static void dev_thread_free(struct otc_session_dev_thread *dt)
+{
+	struct queued_packet *qp;
+
+	if (dt->thread)
+		g_thread_join(dt->thread);
+	while ((qp = g_queue_pop_head(&dt->packets)))
+		queued_packet_free(qp);
+	if (dt->session->metrics)
+		otc_metrics_queued(dt->session->metrics, dt->sdi, 0);
+	g_hash_table_unref(dt->event_sources);
+	g_main_loop_unref(dt->main_loop);
+	g_main_context_unref(dt->main_context);
+	g_cond_clear(&dt->cond);
+	g_mutex_clear(&dt->mutex);
+	g_free(dt);
+}
+
+/**
+ * Start the acquisition of each device of a session on its own thread.
+ *
+ * Waits until all devices started. If any of them fails, the others get
+ * stopped again.
+ *
+ * @private
+ */
+OTC_PRIV int otc_session_dev_threads_start(struct otc_session *session)
+{
+	static GSourceFuncs merge_source_funcs = {
+		.prepare  = &merge_source_prepare,
+		.check    = &merge_source_check,
+		.dispatch = &merge_source_dispatch,
+	};
+	struct otc_session_dev_thread *dt;
+	GSList *l;
+	char *name;
+	int ret;
+
+	session->merge_pending = 0;
+	session->packet_pool = otc_packet_pool_new(0);
+	session->merge_source = g_source_new(&merge_source_funcs,
+		sizeof(struct merge_source));
+	((struct merge_source *)session->merge_source)->session = session;
+	g_source_set_name(session->merge_source, "session-merge");
+	g_source_attach(session->merge_source, session->main_context);
+
+	for (l = session->devs; l; l = l->next) {
+		dt = dev_thread_new(session, l->data);
+		session->dev_threads = g_slist_append(session->dev_threads, dt);
+		name = g_strdup_printf("otc-%s", dt->sdi->driver->name);
+		dt->thread = g_thread_try_new(name, dev_thread_run, dt, NULL);
+		g_free(name);
+		if (!dt->thread) {
+			otc_err("Failed to start %s device thread.",
+				dt->sdi->driver->name);
+			dt->started = TRUE;
+			dt->start_result = OTC_ERR;
+			dt->finished = TRUE;
+		}
+	}
+
+	ret = OTC_OK;
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		g_mutex_lock(&dt->mutex);
+		while (!dt->started)
+			g_cond_wait(&dt->cond, &dt->mutex);
+		if (dt->start_result != OTC_OK)
+			ret = dt->start_result;
+		g_mutex_unlock(&dt->mutex);
+	}
+	if (ret == OTC_OK)
+		return OTC_OK;
+
+	/* Stop the devices which did start, their packets are of no use. */
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		g_mutex_lock(&dt->mutex);
+		dt->discard = TRUE;
+		g_cond_broadcast(&dt->cond);
+		g_mutex_unlock(&dt->mutex);
+		if (dt->start_result == OTC_OK) {
+			g_main_context_invoke(dt->main_context,
+				&dev_thread_stop_sync, dt);
+		}
+	}
+	otc_session_dev_threads_free(session);
+
+	return ret;
+}
+
+/**
+ * Have each device thread of a session stop its acquisition.
+ *
+ * @private
+ */
+OTC_PRIV void otc_session_dev_threads_stop(struct otc_session *session)
+{
+	struct otc_session_dev_thread *dt;
+	GSList *l;
+
+	for (l = session->dev_threads; l; l = l->next) {
+		dt = l->data;
+		g_main_context_invoke(dt->main_context,
+			&dev_thread_stop_sync, dt);
+	}
+}
+
+/**
+ * Check whether device threads still acquire, or have packets queued.
+ *
+ * @private
+ */
+OTC_PRIV gboolean otc_session_dev_threads_busy(struct otc_session *session)
+{
+	struct otc_session_dev_thread *dt;
+	gboolean busy;
+	GSList *l;
+
+	busy = FALSE;
+	for (l = session->dev_threads; l && !busy; l = l->next) {
+		dt = l->data;
+		g_mutex_lock(&dt->mutex);
+		busy = !dt->finished || dt->packets.length > 0;
+		g_mutex_unlock(&dt->mutex);
+	}
+
+	return busy;
+}
+
+/**
+ * Join the device threads of a session, and free them.
+ *
+ * @private
+ */
+OTC_PRIV void otc_session_dev_threads_free(struct otc_session *session)
+{
+	g_slist_free_full(session->dev_threads, (GDestroyNotify)dev_thread_free);
+	session->dev_threads = NULL;
+
+	if (session->merge_source) {
+		g_source_destroy(session->merge_source);
+		g_source_unref(session->merge_source);
+		session->merge_source = NULL;
+	}
+
+	otc_packet_pool_free(session->packet_pool);
+	session->packet_pool = NULL;
+}
@@ -170,9 +170,7 @@ static gboolean logic_check_match(struct soft_trigger_logic *stl,
 	return result;
 }
 
-/* Returns the offset (in samples) within buf of where the trigger
- * occurred, or -1 if not triggered. */
-OTC_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *stl,
+static int logic_scan(struct soft_trigger_logic *stl,
 		uint8_t *buf, int len, int *pre_trigger_samples)
 {
 	struct otc_trigger_stage *stage;
@@ -241,3 +239,30 @@ OTC_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *stl,
 
 	return offset;
 }
+
+/* Returns the offset (in samples) within buf of where the trigger
+ * occurred, or -1 if not triggered. */
+OTC_PRIV int soft_trigger_logic_check(struct soft_trigger_logic *stl,
+		uint8_t *buf, int len, int *pre_trigger_samples)
+{
+	struct otc_metrics *metrics;
+	uint64_t start_ns, samples;
+	int offset;
+
+	metrics = otc_metrics_get(stl->sdi);
+	if (G_LIKELY(!metrics))
+		return logic_scan(stl, buf, len, pre_trigger_samples);
+
+	start_ns = otc_metrics_now_ns();
+	offset = logic_scan(stl, buf, len, pre_trigger_samples);
+	if (offset >= 0)
+		samples = offset + 1;
+	else if (offset == -1)
+		samples = len / stl->unitsize;
+	else
+		samples = 0;
+	otc_metrics_trigger_scan(metrics, stl->sdi, samples,
+		otc_metrics_now_ns() - start_ns);
+
+	return offset;
+}
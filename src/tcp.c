@@ -33,6 +33,7 @@
 
 #include <errno.h>
 #include <glib.h>
+#include <limits.h>
 #include <string.h>
 #ifndef _MSC_VER
 #include <unistd.h>
@@ -42,8 +43,10 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #endif
 
 #if HAVE_POLL
@@ -65,33 +68,35 @@
 
 #define LOG_PREFIX "tcp"
 
-/**
- * Check whether a file descriptor is readable (without blocking).
- *
- * @param[in] fd The file descriptor to check for readability.
- *
- * @return TRUE when readable, FALSE when read would block or when
- *   readability could not get determined.
- *
- * @since 6.0
- *
- * TODO Move to common code, applies to non-sockets as well.
+/*
+ * Wait up to 'timeout_ms' for a file descriptor to become readable.
+ * Returns TRUE when readable, FALSE upon timeout, or when readability
+ * could not get determined.
  */
-OTC_PRIV gboolean otc_fd_is_readable(int fd)
+static gboolean fd_wait_readable(int fd, unsigned int timeout_ms)
 {
 #if HAVE_POLL
 	struct pollfd fds[1];
+	gint64 deadline_us, now_us;
 	int ret;
 
-	memset(fds, 0, sizeof(fds));
-	fds[0].fd = fd;
-	fds[0].events = POLLIN;
-	ret = poll(fds, ARRAY_SIZE(fds), -1);
+	deadline_us = g_get_monotonic_time() + (gint64)timeout_ms * 1000;
+	do {
+		memset(fds, 0, sizeof(fds));
+		fds[0].fd = fd;
+		fds[0].events = POLLIN;
+		ret = poll(fds, ARRAY_SIZE(fds), timeout_ms);
+		if (ret >= 0 || errno != EINTR)
+			break;
+		now_us = g_get_monotonic_time();
+		timeout_ms = now_us < deadline_us
+			? (deadline_us - now_us + 999) / 1000 : 0;
+	} while (1);
 	if (ret < 0)
 		return FALSE;
 	if (!ret)
 		return FALSE;
-	if (!(fds[0].revents & POLLIN))
+	if (!(fds[0].revents & (POLLIN | POLLHUP)))
 		return FALSE;
 
 	return TRUE;
@@ -103,20 +108,40 @@ OTC_PRIV gboolean otc_fd_is_readable(int fd)
 	FD_ZERO(&rfds);
 	FD_SET(fd, &rfds);
 	memset(&tv, 0, sizeof(tv));
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
 	ret = select(fd + 1, &rfds, NULL, NULL, &tv);
 	if (ret < 0)
 		return FALSE;
 	if (!ret)
 		return FALSE;
-	if (!FD_ISSET(fd, rfds))
+	if (!FD_ISSET(fd, &rfds))
 		return FALSE;
 	return TRUE;
 #else
 	(void)fd;
+	(void)timeout_ms;
 	return FALSE;
 #endif
 }
 
+/**
+ * Check whether a file descriptor is readable (without blocking).
+ *
+ * @param[in] fd The file descriptor to check for readability.
+ *
+ * @return TRUE when readable, FALSE when read would block or when
+ *   readability could not get determined.
+ *
+ * @since 6.0
+ *
+ * TODO Move to common code, applies to non-sockets as well.
+ */
+OTC_PRIV gboolean otc_fd_is_readable(int fd)
+{
+	return fd_wait_readable(fd, 0);
+}
+
 /**
  * Create a TCP communication instance.
  *
@@ -164,6 +189,7 @@ OTC_PRIV void otc_tcp_dev_inst_free(struct otc_tcp_dev_inst *tcp)
 		return;
 
 	(void)otc_tcp_disconnect(tcp);
+	otc_byte_ring_free(tcp->rx_ring);
 	g_free(tcp->host_addr);
 	g_free(tcp->tcp_port);
 	g_free(tcp);
@@ -208,6 +234,58 @@ OTC_PRIV int otc_tcp_get_port_path(struct otc_tcp_dev_inst *tcp,
 	return OTC_OK;
 }
 
+/*
+ * Re-arm delayed ACK suppression. Linux clears TCP_QUICKACK after
+ * some ACKs were sent, so this gets repeated after receive calls.
+ */
+static void tcp_rearm_quickack(struct otc_tcp_dev_inst *tcp)
+{
+#if defined TCP_QUICKACK
+	int val;
+
+	if (!tcp->low_latency || tcp->sock_fd < 0)
+		return;
+	val = 1;
+	(void)setsockopt(tcp->sock_fd, IPPROTO_TCP, TCP_QUICKACK,
+		(const char *)&val, sizeof(val));
+#else
+	(void)tcp;
+#endif
+}
+
+/*
+ * Apply the caller's socket tuning to the connection's socket. The
+ * receive buffer size should be set before connect(2), so that TCP
+ * window scaling can take the larger buffer into account.
+ */
+static void tcp_apply_sockopts(struct otc_tcp_dev_inst *tcp, int fd)
+{
+	int val;
+
+	if (fd < 0)
+		return;
+
+	if (tcp->rcvbuf_size) {
+		val = tcp->rcvbuf_size > INT_MAX ? INT_MAX : (int)tcp->rcvbuf_size;
+		if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF,
+				(const char *)&val, sizeof(val)) != 0)
+			otc_warn("Cannot set receive buffer size %d: %s.",
+				val, g_strerror(errno));
+	}
+
+	if (tcp->low_latency) {
+		val = 1;
+		if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY,
+				(const char *)&val, sizeof(val)) != 0)
+			otc_warn("Cannot set TCP_NODELAY: %s.",
+				g_strerror(errno));
+#if defined TCP_QUICKACK
+		(void)setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK,
+			(const char *)&val, sizeof(val));
+#endif
+	}
+}
+
 /**
  * Connect to a remote TCP communication peer.
  *
@@ -247,6 +325,7 @@ OTC_PRIV int otc_tcp_connect(struct otc_tcp_dev_inst *tcp)
 		fd = socket(r->ai_family, r->ai_socktype, r->ai_protocol);
 		if (fd < 0)
 			continue;
+		tcp_apply_sockopts(tcp, fd);
 		ret = connect(fd, r->ai_addr, r->ai_addrlen);
 		if (ret != 0) {
 			close(fd);
@@ -287,6 +366,8 @@ OTC_PRIV int otc_tcp_disconnect(struct otc_tcp_dev_inst *tcp)
 	shutdown(tcp->sock_fd, SHUT_RDWR);
 	close(tcp->sock_fd);
 	tcp->sock_fd = -1;
+	otc_byte_ring_reset(tcp->rx_ring);
+	tcp->rx_eof = FALSE;
 	return OTC_OK;
 }
 
@@ -416,3 +497,421 @@ OTC_PRIV int otc_tcp_source_remove(struct otc_session *session,
 		return OTC_ERR_ARG;
 	return otc_session_source_remove(session, tcp->sock_fd);
 }
+
+/**
+ * Tune the socket of a TCP connection for bulk receive data.
+ *
+ * The settings are kept with the communication instance. They take
+ * effect immediately when the connection is established, and get
+ * applied again in later otc_tcp_connect() calls. The receive buffer
+ * size is most effective when set before the connection is made.
+ *
+ * @param[in] tcp The TCP communication instance to tune.
+ * @param[in] rcvbuf_size The SO_RCVBUF size in bytes, 0 keeps the
+ *   operating system's default.
+ * @param[in] low_latency Whether to disable Nagle's algorithm and
+ *   delayed ACKs (TCP_NODELAY, and TCP_QUICKACK where available).
+ *
+ * @return OTC_OK on success, OTC_ERR_* otherwise.
+ *
+ * @since 6.0
+ */
+OTC_PRIV int otc_tcp_set_sockopts(struct otc_tcp_dev_inst *tcp,
+	size_t rcvbuf_size, gboolean low_latency)
+{
+	if (!tcp)
+		return OTC_ERR_ARG;
+
+	tcp->rcvbuf_size = rcvbuf_size;
+	tcp->low_latency = low_latency;
+	tcp_apply_sockopts(tcp, tcp->sock_fd);
+
+	return OTC_OK;
+}
+
+/**
+ * Allocate the receive buffer of a TCP connection.
+ *
+ * The receive buffer is a ring of (at least) the given size, which
+ * otc_tcp_rx_fill() drains the socket into. Previously buffered data
+ * gets discarded. A size of zero releases the receive buffer.
+ *
+ * @param[in] tcp The TCP communication instance.
+ * @param[in] size The receive buffer size in bytes, rounded up to the
+ *   next power of two.
+ *
+ * @return OTC_OK on success, OTC_ERR_* otherwise.
+ *
+ * @since 6.0
+ */
+OTC_PRIV int otc_tcp_rx_buffer_alloc(struct otc_tcp_dev_inst *tcp,
+	size_t size)
+{
+	if (!tcp)
+		return OTC_ERR_ARG;
+
+	otc_byte_ring_free(tcp->rx_ring);
+	tcp->rx_ring = NULL;
+	tcp->rx_eof = FALSE;
+	if (!size)
+		return OTC_OK;
+
+	tcp->rx_ring = otc_byte_ring_new(size);
+	if (!tcp->rx_ring)
+		return OTC_ERR_MALLOC;
+
+	return OTC_OK;
+}
+
+/*
+ * Receive into up to two ring buffer segments without blocking. Uses
+ * a single scatter/gather system call where the platform supports it.
+ * Returns the number of received bytes, 0 when the peer has closed
+ * the connection, or -1 with 'would_block' telling temporary absence
+ * of receive data apart from fatal errors.
+ */
+static ssize_t tcp_recv_segments(int fd, uint8_t **seg_ptr,
+	size_t *seg_len, size_t seg_count, gboolean *would_block)
+{
+#if defined _WIN32
+	u_long avail;
+	size_t len;
+	int rc;
+
+	(void)seg_count;
+	*would_block = FALSE;
+	if (ioctlsocket(fd, FIONREAD, &avail) != 0)
+		return -1;
+	if (!avail) {
+		*would_block = TRUE;
+		return -1;
+	}
+	len = MIN(seg_len[0], (size_t)avail);
+	rc = recv(fd, (char *)seg_ptr[0], len, 0);
+	return rc;
+#else
+	struct iovec iov[2];
+	struct msghdr msg;
+	size_t idx;
+	ssize_t rc;
+
+	*would_block = FALSE;
+	memset(&msg, 0, sizeof(msg));
+	for (idx = 0; idx < seg_count; idx++) {
+		iov[idx].iov_base = seg_ptr[idx];
+		iov[idx].iov_len = seg_len[idx];
+	}
+	msg.msg_iov = iov;
+	msg.msg_iovlen = seg_count;
+	do {
+		rc = recvmsg(fd, &msg, MSG_DONTWAIT);
+	} while (rc < 0 && errno == EINTR);
+	if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		*would_block = TRUE;
+	return rc;
+#endif
+}
+
+/**
+ * Drain all currently available receive data into the receive buffer.
+ *
+ * Keeps receiving until the socket has no more data (the receive call
+ * would block), or the receive buffer is full, or the peer has closed
+ * the connection (which sets the instance's 'rx_eof' flag). Never
+ * blocks. The receive buffer must have been allocated before.
+ *
+ * @param[in] tcp The TCP communication instance to receive from.
+ *
+ * @return The number of newly received bytes on success (can be zero),
+ *   OTC_ERR_* otherwise.
+ *
+ * @since 6.0
+ */
+OTC_PRIV int otc_tcp_rx_fill(struct otc_tcp_dev_inst *tcp)
+{
+	uint8_t *seg_ptr[2];
+	size_t seg_len[2], seg_count, total;
+	gboolean would_block;
+	ssize_t rc;
+
+	if (!tcp || !tcp->rx_ring)
+		return OTC_ERR_ARG;
+	if (tcp->sock_fd < 0)
+		return OTC_ERR_IO;
+
+	total = 0;
+	while (!tcp->rx_eof && total < INT_MAX) {
+		seg_count = otc_byte_ring_write_segments(tcp->rx_ring,
+			seg_ptr, seg_len);
+		if (!seg_count)
+			break;
+		rc = tcp_recv_segments(tcp->sock_fd,
+			seg_ptr, seg_len, seg_count, &would_block);
+		if (rc < 0 && would_block)
+			break;
+		if (rc < 0) {
+			otc_err("Receive error: %s.", g_strerror(errno));
+			if (!total)
+				return OTC_ERR_IO;
+			break;
+		}
+		if (rc == 0) {
+			tcp->rx_eof = TRUE;
+			break;
+		}
+		otc_byte_ring_commit(tcp->rx_ring, (size_t)rc);
+		total += (size_t)rc;
+	}
+	if (total)
+		tcp_rearm_quickack(tcp);
+
+	return (int)MIN(total, (size_t)INT_MAX);
+}
+
+/**
+ * Fetch receive data from a TCP connection's receive buffer.
+ *
+ * Serves the request from previously buffered data, and drains the
+ * socket into the receive buffer when more data is needed. Never blocks,
+ * can return with short receive byte counts. Falls back to a single
+ * non-blocking receive call when no receive buffer was allocated.
+ *
+ * @param[in] tcp The TCP communication instance to read from.
+ * @param[in] data Caller provided buffer for receive data.
+ * @param[in] dlen The maximum number of bytes to receive.
+ *
+ * @return Number of received bytes on success, OTC_ERR_* otherwise.
+ *
+ * @since 6.0
+ */
+OTC_PRIV int otc_tcp_rx_read(struct otc_tcp_dev_inst *tcp,
+	uint8_t *data, size_t dlen)
+{
+	int ret;
+
+	if (!tcp)
+		return OTC_ERR_ARG;
+	if (!dlen)
+		return 0;
+	if (!data)
+		return OTC_ERR_ARG;
+
+	if (!tcp->rx_ring)
+		return otc_tcp_read_bytes(tcp, data, dlen, TRUE);
+
+	if (otc_byte_ring_used(tcp->rx_ring) < dlen) {
+		ret = otc_tcp_rx_fill(tcp);
+		if (ret < 0 && !otc_byte_ring_used(tcp->rx_ring))
+			return ret;
+	}
+
+	dlen = MIN(dlen, (size_t)INT_MAX);
+	return (int)otc_byte_ring_read(tcp->rx_ring, data, dlen);
+}
+
+/**
+ * Wait for receive data on a TCP connection with a receive buffer.
+ *
+ * Returns immediately when the receive buffer holds data or the peer
+ * has closed the connection. Otherwise sleeps in poll() until the socket
+ * becomes readable or the timeout expires, and drains the socket into
+ * the receive buffer.
+ *
+ * @param[in] tcp The TCP communication instance to wait for.
+ * @param[in] timeout_ms The maximum time to wait, in milliseconds.
+ *
+ * @return OTC_OK when receive data is buffered or the peer has closed
+ *   the connection, OTC_ERR_TIMEOUT when the timeout expired,
+ *   OTC_ERR_* otherwise.
+ *
+ * @since 6.0
+ */
+OTC_PRIV int otc_tcp_rx_wait(struct otc_tcp_dev_inst *tcp,
+	unsigned int timeout_ms)
+{
+	int ret;
+
+	if (!tcp || !tcp->rx_ring)
+		return OTC_ERR_ARG;
+
+	if (otc_byte_ring_used(tcp->rx_ring) || tcp->rx_eof)
+		return OTC_OK;
+	if (tcp->sock_fd < 0)
+		return OTC_ERR_IO;
+
+	if (!fd_wait_readable(tcp->sock_fd, timeout_ms))
+		return OTC_ERR_TIMEOUT;
+	ret = otc_tcp_rx_fill(tcp);
+	if (ret < 0)
+		return ret;
+
+	return OTC_OK;
+}
+
+/** Custom GLib event source for buffered TCP receive data.
+ * Dispatches while the receive buffer holds data, even when the socket
+ * itself has become empty.
+ */
+struct tcp_rx_source {
+	GSource base;
+
+	int64_t timeout_us;
+	int64_t due_us;
+
+	/* Meta-data needed to keep track of installed sources */
+	struct otc_session *session;
+	void *key;
+
+	struct otc_tcp_dev_inst *tcp;
+	GPollFD pollfd;
+};
+
+static gboolean tcp_rx_source_prepare(GSource *source, int *timeout)
+{
+	struct tcp_rx_source *rsource;
+	int64_t now_us;
+	int remaining_ms;
+
+	rsource = (struct tcp_rx_source *)source;
+
+	if (otc_byte_ring_used(rsource->tcp->rx_ring)) {
+		*timeout = 0;
+		return TRUE;
+	}
+
+	if (rsource->timeout_us >= 0) {
+		now_us = g_source_get_time(source);
+		if (rsource->due_us == 0)
+			rsource->due_us = now_us + rsource->timeout_us;
+		remaining_ms = (MAX(0, rsource->due_us - now_us) + 999) / 1000;
+	} else {
+		remaining_ms = -1;
+	}
+	*timeout = remaining_ms;
+
+	return (remaining_ms == 0);
+}
+
+static gboolean tcp_rx_source_check(GSource *source)
+{
+	struct tcp_rx_source *rsource;
+
+	rsource = (struct tcp_rx_source *)source;
+
+	if (rsource->pollfd.revents)
+		return TRUE;
+	if (otc_byte_ring_used(rsource->tcp->rx_ring))
+		return TRUE;
+	return (rsource->timeout_us >= 0
+		&& rsource->due_us <= g_source_get_time(source));
+}
+
+static gboolean tcp_rx_source_dispatch(GSource *source,
+	GSourceFunc callback, void *user_data)
+{
+	struct tcp_rx_source *rsource;
+	unsigned int revents;
+	gboolean keep;
+
+	rsource = (struct tcp_rx_source *)source;
+	revents = rsource->pollfd.revents;
+
+	if (!callback) {
+		otc_err("Callback not set, cannot dispatch event.");
+		return G_SOURCE_REMOVE;
+	}
+
+	/*
+	 * Drain the socket, then present buffered data as a G_IO_IN event.
+	 * Drivers which consume less than the buffer holds get called
+	 * again without waiting for more data to arrive on the socket.
+	 */
+	if (revents & G_IO_IN)
+		(void)otc_tcp_rx_fill(rsource->tcp);
+	if (otc_byte_ring_used(rsource->tcp->rx_ring))
+		revents |= G_IO_IN;
+	keep = (*OTC_RECEIVE_DATA_CALLBACK(callback))
+			(rsource->pollfd.fd, revents, user_data);
+
+	if (rsource->timeout_us >= 0 && G_LIKELY(keep)
+			&& G_LIKELY(!g_source_is_destroyed(source)))
+		rsource->due_us = g_source_get_time(source)
+				+ rsource->timeout_us;
+	return keep;
+}
+
+static void tcp_rx_source_finalize(GSource *source)
+{
+	struct tcp_rx_source *rsource;
+
+	rsource = (struct tcp_rx_source *)source;
+
+	otc_session_source_destroyed(rsource->session, rsource->key, source);
+}
+
+/**
+ * Register a draining receive callback for a TCP connection.
+ *
+ * Like @ref otc_tcp_source_add() for G_IO_IN events, but each time the
+ * socket becomes readable all available data is drained into the
+ * connection's receive buffer before the caller's callback runs. The
+ * callback then consumes data from the 'rx_ring' in bulk. The callback
+ * keeps getting invoked with G_IO_IN while the receive buffer holds
+ * data, callers need not consume all of it at once. The receive
+ * buffer must have been allocated before. Use @ref otc_tcp_source_remove()
+ * to unregister.
+ *
+ * @param[in] session See @ref otc_session_source_add().
+ * @param[in] tcp The TCP communication instance to read from.
+ * @param[in] timeout See @ref otc_session_source_add().
+ * @param[in] cb See @ref otc_session_source_add().
+ * @param[in] cb_data See @ref otc_session_source_add().
+ *
+ * @return OTC_OK on success, OTC_ERR* otherwise.
+ *
+ * @since 6.0
+ */
+OTC_PRIV int otc_tcp_rx_source_add(struct otc_session *session,
+	struct otc_tcp_dev_inst *tcp, int timeout,
+	otc_receive_data_callback cb, void *cb_data)
+{
+	static GSourceFuncs tcp_rx_source_funcs = {
+		.prepare  = &tcp_rx_source_prepare,
+		.check    = &tcp_rx_source_check,
+		.dispatch = &tcp_rx_source_dispatch,
+		.finalize = &tcp_rx_source_finalize
+	};
+	GSource *source;
+	struct tcp_rx_source *rsource;
+	int ret;
+
+	if (!tcp || tcp->sock_fd < 0 || !tcp->rx_ring || !cb)
+		return OTC_ERR_ARG;
+
+	source = g_source_new(&tcp_rx_source_funcs,
+		sizeof(struct tcp_rx_source));
+	rsource = (struct tcp_rx_source *)source;
+	g_source_set_name(source, "tcp-rx");
+
+	if (timeout >= 0) {
+		rsource->timeout_us = 1000 * (int64_t)timeout;
+		rsource->due_us = 0;
+	} else {
+		rsource->timeout_us = -1;
+		rsource->due_us = INT64_MAX;
+	}
+	/* Same key as plain fd sources, otc_tcp_source_remove() applies. */
+	rsource->session = session;
+	rsource->key = GINT_TO_POINTER(tcp->sock_fd);
+	rsource->tcp = tcp;
+	rsource->pollfd.fd = tcp->sock_fd;
+	rsource->pollfd.events = G_IO_IN;
+	rsource->pollfd.revents = 0;
+	g_source_add_poll(source, &rsource->pollfd);
+	g_source_set_callback(source, G_SOURCE_FUNC(cb), cb_data, NULL);
+
+	ret = otc_session_source_add_internal(session, rsource->key, source);
+	g_source_unref(source);
+
+	return ret;
+}
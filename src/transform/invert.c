@@ -24,18 +24,88 @@
 
 #define LOG_PREFIX "transform/invert"
 
+/* Analog packets with float values, for encodings with an offset. */
+struct context {
+	struct otc_datafeed_packet packet;
+	struct otc_datafeed_analog analog;
+	struct otc_analog_encoding encoding;
+	float *values;
+	size_t values_size;
+};
+
+static int init(struct otc_transform *t, GHashTable *options)
+{
+	(void)options;
+
+	if (!t || !t->sdi)
+		return OTC_ERR_ARG;
+
+	t->priv = g_malloc0(sizeof(struct context));
+
+	return OTC_OK;
+}
+
+/*
+ * The reciprocal of the scale can't take an offset along. Convert the
+ * samples to float values with the encoding applied, as drivers which
+ * sent floats did, and pass them on instead.
+ */
+static int bake_offset(struct context *ctx,
+		struct otc_datafeed_packet **packet,
+		const struct otc_datafeed_analog *analog)
+{
+	size_t count;
+	int ret;
+
+	count = analog->num_samples * g_slist_length(analog->meaning->channels);
+	if (count > ctx->values_size) {
+		g_free(ctx->values);
+		ctx->values = g_malloc(count * sizeof(float));
+		ctx->values_size = count;
+	}
+	ret = otc_analog_to_float(analog, ctx->values);
+	if (ret != OTC_OK)
+		return ret;
+
+	ctx->encoding = *analog->encoding;
+	ctx->encoding.unitsize = sizeof(float);
+	ctx->encoding.is_signed = TRUE;
+	ctx->encoding.is_float = TRUE;
+#ifdef WORDS_BIGENDIAN
+	ctx->encoding.is_bigendian = TRUE;
+#else
+	ctx->encoding.is_bigendian = FALSE;
+#endif
+	otc_rational_set(&ctx->encoding.scale, 1, 1);
+	otc_rational_set(&ctx->encoding.offset, 0, 1);
+	ctx->analog = *analog;
+	ctx->analog.data = ctx->values;
+	ctx->analog.encoding = &ctx->encoding;
+	ctx->packet.type = OTC_DF_ANALOG;
+	ctx->packet.payload = &ctx->analog;
+	*packet = &ctx->packet;
+
+	return OTC_OK;
+}
+
 static int receive(const struct otc_transform *t,
 		struct otc_datafeed_packet *packet_in,
 		struct otc_datafeed_packet **packet_out)
 {
+	struct context *ctx;
 	const struct otc_datafeed_logic *logic;
 	const struct otc_datafeed_analog *analog;
 	uint8_t *b;
 	int64_t p;
 	uint64_t i, j, q;
+	int ret;
 
 	if (!t || !t->sdi || !packet_in || !packet_out)
 		return OTC_ERR_ARG;
+	ctx = t->priv;
+
+	/* Return the in-place-modified packet, or the converted one. */
+	*packet_out = packet_in;
 
 	switch (packet_in->type) {
 	case OTC_DF_LOGIC:
@@ -50,6 +120,12 @@ static int receive(const struct otc_transform *t,
 		break;
 	case OTC_DF_ANALOG:
 		analog = packet_in->payload;
+		if (analog->encoding->offset.p) {
+			ret = bake_offset(ctx, packet_out, analog);
+			if (ret != OTC_OK)
+				return ret;
+			analog = (*packet_out)->payload;
+		}
 		p = analog->encoding->scale.p;
 		q = analog->encoding->scale.q;
 		if (q > INT64_MAX)
@@ -62,8 +138,20 @@ static int receive(const struct otc_transform *t,
 		break;
 	}
 
-	/* Return the in-place-modified packet. */
-	*packet_out = packet_in;
+	return OTC_OK;
+}
+
+static int cleanup(struct otc_transform *t)
+{
+	struct context *ctx;
+
+	if (!t || !t->sdi)
+		return OTC_ERR_ARG;
+	ctx = t->priv;
+
+	g_free(ctx->values);
+	g_free(ctx);
+	t->priv = NULL;
 
 	return OTC_OK;
 }
@@ -73,7 +161,7 @@ OTC_PRIV struct otc_transform_module transform_invert = {
 	.name = "Invert",
 	.desc = "Invert values",
 	.options = NULL,
-	.init = NULL,
+	.init = init,
 	.receive = receive,
-	.cleanup = NULL,
+	.cleanup = cleanup,
 };
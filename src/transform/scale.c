@@ -59,6 +59,13 @@ static int receive(const struct otc_transform *t,
 		analog = packet_in->payload;
 		analog->encoding->scale.p *= ctx->factor.p;
 		analog->encoding->scale.q *= ctx->factor.q;
+		/* The offset adds to the scaled raw value, scale it as well. */
+		if (analog->encoding->offset.p && otc_rational_mult(
+				&analog->encoding->offset,
+				&analog->encoding->offset, &ctx->factor) != OTC_OK) {
+			otc_err("Cannot scale the offset of analog values.");
+			return OTC_ERR;
+		}
 		break;
 	default:
 		otc_spew("Unsupported packet type %d, ignoring.", packet_in->type);
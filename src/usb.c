@@ -24,6 +24,12 @@
 #include <memory.h>
 #include <glib.h>
 #include <libusb.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include <opentracecapture/libopentracecapture.h>
 #include "libopentracecapture-internal.h"
 
@@ -37,6 +43,55 @@
 typedef int libusb_os_handle;
 #endif
 
+/** Dedicated libusb event handling of a context.
+ */
+struct otc_usb_events {
+	GMutex mutex;
+	/* Whether acquisitions should use the event thread. */
+	gboolean enabled;
+	/* Number of completion queues, the thread runs while there are any. */
+	unsigned int users;
+	/*
+	 * Number of reasons to pause the thread: sources of drivers without
+	 * a completion queue, and acquisitions which are being started. The
+	 * sessions handle libusb events meanwhile, for all drivers.
+	 */
+	unsigned int pauses;
+	GThread *thread;
+	int stop;
+	struct libusb_context *usb_ctx;
+};
+
+/** Transfers which completed on the event thread, for the session to
+ * run the driver's callback on.
+ *
+ * libusb invokes transfer callbacks with its event lock held, so there
+ * is at most one producer at a time even when another thread briefly
+ * takes over event handling, e.g. for a synchronous transfer. The
+ * session is the only consumer. Every transfer is in the ring at most
+ * once, and submission is limited to the ring's capacity, so that the
+ * producer never finds it full.
+ */
+struct otc_usb_queue {
+	struct otc_context *ctx;
+	libusb_transfer_cb_fn cb;
+	void *cb_data;
+	struct libusb_transfer **ring;
+	/* Completion times of the transfers in the ring, with statistics. */
+	uint64_t *done_ns;
+	unsigned int mask;
+	int rd_pos;
+	int wr_pos;
+	/* Submitted transfers, which are in flight or in the ring. */
+	int pending;
+	GMainContext *main_context;
+	/* Statistics of the session, NULL when disabled. */
+	struct otc_metrics *metrics;
+	/* The transfer whose callback ran last, and its completion time. */
+	struct libusb_transfer *current;
+	uint64_t current_done_ns;
+};
+
 /** Custom GLib event source for libusb I/O.
  */
 struct usb_source {
@@ -50,8 +105,95 @@ struct usb_source {
 
 	struct libusb_context *usb_ctx;
 	GPtrArray *pollfds;
+
+	/* Completed transfers, when the event thread handles libusb. */
+	struct otc_usb_queue *queue;
+	/* The event handling which this source pauses, if any. */
+	struct otc_usb_events *paused;
 };
 
+static struct otc_usb_events *usb_events_get(struct otc_context *ctx);
+static void usb_events_pause(struct otc_usb_events *events);
+static void usb_events_resume(struct otc_usb_events *events);
+
+/** Get the oldest transfer of a completion queue, or NULL.
+ */
+static struct libusb_transfer *usb_queue_pop(struct otc_usb_queue *queue,
+		uint64_t *done_ns)
+{
+	struct libusb_transfer *transfer;
+	unsigned int rd_pos;
+
+	rd_pos = queue->rd_pos;
+	if (rd_pos == (unsigned int)g_atomic_int_get(&queue->wr_pos))
+		return NULL;
+	transfer = queue->ring[rd_pos & queue->mask];
+	*done_ns = queue->done_ns[rd_pos & queue->mask];
+	g_atomic_int_set(&queue->rd_pos, rd_pos + 1);
+
+	return transfer;
+}
+
+static gboolean usb_queue_empty(struct otc_usb_queue *queue)
+{
+	return g_atomic_int_get(&queue->rd_pos)
+		== g_atomic_int_get(&queue->wr_pos);
+}
+
+/** Transfer callback on the event thread, defers to the session.
+ */
+static void LIBUSB_CALL usb_queue_transfer_done(struct libusb_transfer *transfer)
+{
+	struct otc_usb_queue *queue;
+	GMainContext *main_context;
+	unsigned int wr_pos;
+
+	queue = transfer->user_data;
+
+	wr_pos = g_atomic_int_get(&queue->wr_pos);
+	if (G_UNLIKELY(wr_pos - (unsigned int)g_atomic_int_get(&queue->rd_pos)
+			> queue->mask)) {
+		otc_err("USB completion queue overflow, transfer lost.");
+		return;
+	}
+	queue->ring[wr_pos & queue->mask] = transfer;
+	if (G_UNLIKELY(g_atomic_pointer_get(&queue->metrics)))
+		queue->done_ns[wr_pos & queue->mask] = otc_metrics_now_ns();
+	main_context = g_atomic_pointer_get(&queue->main_context);
+	g_atomic_int_set(&queue->wr_pos, wr_pos + 1);
+
+	if (main_context)
+		g_main_context_wakeup(main_context);
+}
+
+/** Run the driver's callback for the transfers which completed.
+ *
+ * @return FALSE when a callback removed the event source, TRUE otherwise.
+ */
+static gboolean usb_queue_drain(struct otc_usb_queue *queue, GSource *source)
+{
+	struct libusb_transfer *transfer;
+	unsigned int count;
+	uint64_t done_ns;
+
+	/* Bounded, so that a busy device cannot starve other sources. */
+	for (count = 0; count <= queue->mask; count++) {
+		if (!(transfer = usb_queue_pop(queue, &done_ns)))
+			break;
+		g_atomic_int_add(&queue->pending, -1);
+		transfer->callback = queue->cb;
+		transfer->user_data = queue->cb_data;
+		/* Not reset after the callback, which may free the queue. */
+		queue->current = transfer;
+		queue->current_done_ns = done_ns;
+		queue->cb(transfer);
+		if (g_source_is_destroyed(source))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
 /** USB event source prepare() method.
  */
 static gboolean usb_source_prepare(GSource *source, int *timeout)
@@ -64,7 +206,16 @@ static gboolean usb_source_prepare(GSource *source, int *timeout)
 
 	usource = (struct usb_source *)source;
 
-	ret = libusb_get_next_timeout(usource->usb_ctx, &usb_timeout);
+	if (usource->queue && !usb_queue_empty(usource->queue)) {
+		*timeout = 0;
+		return TRUE;
+	}
+
+	/* The event thread takes care of libusb's own timeouts. */
+	if (usource->queue)
+		ret = 0;
+	else
+		ret = libusb_get_next_timeout(usource->usb_ctx, &usb_timeout);
 	if (G_UNLIKELY(ret < 0)) {
 		otc_err("Failed to get libusb timeout: %s",
 			libusb_error_name(ret));
@@ -107,6 +258,9 @@ static gboolean usb_source_check(GSource *source)
 		pollfd = g_ptr_array_index(usource->pollfds, i);
 		revents |= pollfd->revents;
 	}
+	if (usource->queue && !usb_queue_empty(usource->queue))
+		return TRUE;
+
 	return (revents != 0 || (usource->due_us != INT64_MAX
 			&& usource->due_us <= g_source_get_time(source)));
 }
@@ -134,6 +288,13 @@ static gboolean usb_source_dispatch(GSource *source,
 		revents |= pollfd->revents;
 	}
 
+	if (usource->queue) {
+		if (!usb_queue_empty(usource->queue))
+			revents |= G_IO_IN;
+		if (!usb_queue_drain(usource->queue, source))
+			return G_SOURCE_REMOVE;
+	}
+
 	if (!callback) {
 		otc_err("Callback not set, cannot dispatch event.");
 		return G_SOURCE_REMOVE;
@@ -160,11 +321,15 @@ static void usb_source_finalize(GSource *source)
 
 	otc_spew("%s", __func__);
 
-	libusb_set_pollfd_notifiers(usource->usb_ctx, NULL, NULL, NULL);
+	if (!usource->queue)
+		libusb_set_pollfd_notifiers(usource->usb_ctx, NULL, NULL, NULL);
 
 	g_ptr_array_unref(usource->pollfds);
 	usource->pollfds = NULL;
 
+	if (usource->paused)
+		usb_events_resume(usource->paused);
+
 	otc_session_source_destroyed(usource->session,
 			usource->usb_ctx, source);
 }
@@ -245,11 +410,14 @@ static void usb_source_free_pollfd(void *data)
  *
  * @param session The session the event source belongs to.
  * @param usb_ctx The libusb context for which to handle events.
+ * @param queue The queue of transfers which completed on the event
+ *   thread, or NULL to handle libusb events in the session.
  * @param timeout_ms The timeout interval in ms, or -1 to wait indefinitely.
  * @return A new event source object, or NULL on failure.
  */
 static GSource *usb_source_new(struct otc_session *session,
-		struct libusb_context *usb_ctx, int timeout_ms)
+		struct libusb_context *usb_ctx, struct otc_usb_queue *queue,
+		int timeout_ms)
 {
 	static GSourceFuncs usb_source_funcs = {
 		.prepare  = &usb_source_prepare,
@@ -261,8 +429,8 @@ static GSource *usb_source_new(struct otc_session *session,
 	struct usb_source *usource;
 	const struct libusb_pollfd **upollfds, **upfd;
 
-	upollfds = libusb_get_pollfds(usb_ctx);
-	if (!upollfds) {
+	upollfds = NULL;
+	if (!queue && !(upollfds = libusb_get_pollfds(usb_ctx))) {
 		otc_err("Failed to get libusb file descriptors.");
 		return NULL;
 	}
@@ -281,6 +449,10 @@ static GSource *usb_source_new(struct otc_session *session,
 	usource->session = session;
 	usource->usb_ctx = usb_ctx;
 	usource->pollfds = g_ptr_array_new_full(8, &usb_source_free_pollfd);
+	usource->queue = queue;
+
+	if (queue)
+		return source;
 
 	for (upfd = upollfds; *upfd != NULL; upfd++)
 		usb_pollfd_added((*upfd)->fd, (*upfd)->events, usource);
@@ -496,16 +668,67 @@ OTC_PRIV void otc_usb_close(struct otc_usb_dev_inst *usb)
 OTC_PRIV int usb_source_add(struct otc_session *session, struct otc_context *ctx,
 		int timeout, otc_receive_data_callback cb, void *cb_data)
 {
+	return usb_source_add_queue(session, ctx, NULL, timeout, cb, cb_data);
+}
+
+/**
+ * Add an event source which runs the callbacks of queued transfers.
+ *
+ * @param session The session to use. Must not be NULL.
+ * @param ctx The libopentracecapture context. Must not be NULL.
+ * @param queue The completion queue of the driver's transfers. NULL
+ *   handles libusb events in the session, like usb_source_add(). The
+ *   context's event thread would run the driver's callbacks off the
+ *   session, so it pauses until the source is removed. The session then
+ *   handles the events of all drivers, and queued transfers complete
+ *   through it.
+ * @param timeout Max time in ms to wait before the callback is called,
+ *   or -1 to wait indefinitely.
+ * @param cb Callback function to add. Must not be NULL.
+ * @param cb_data Data for the callback function. Can be NULL.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR Other errors.
+ *
+ * @private
+ */
+OTC_PRIV int usb_source_add_queue(struct otc_session *session,
+		struct otc_context *ctx, struct otc_usb_queue *queue,
+		int timeout, otc_receive_data_callback cb, void *cb_data)
+{
+	struct usb_source *usource;
 	GSource *source;
 	int ret;
 
-	source = usb_source_new(session, ctx->libusb_ctx, timeout);
+	/*
+	 * Device threads share the libusb context, whose events the event
+	 * thread has to handle, for callbacks to run on the right thread.
+	 */
+	if (!queue && otc_session_dev_thread_current(session)) {
+		otc_err("USB devices on device threads need the USB event "
+			"thread, and a driver which supports it.");
+		return OTC_ERR;
+	}
+
+	source = usb_source_new(session, ctx->libusb_ctx, queue, timeout);
 	if (!source)
 		return OTC_ERR;
 
 	g_source_set_callback(source, G_SOURCE_FUNC(cb), cb_data, NULL);
 
+	if (!queue) {
+		/* Resumed when the source gets finalized. */
+		usource = (struct usb_source *)source;
+		usource->paused = usb_events_get(ctx);
+		usb_events_pause(usource->paused);
+	}
+
 	ret = otc_session_source_add_internal(session, ctx->libusb_ctx, source);
+	if (ret == OTC_OK && queue && g_source_get_context(source)) {
+		g_atomic_pointer_set(&queue->metrics, session->metrics);
+		g_atomic_pointer_set(&queue->main_context,
+			g_main_context_ref(g_source_get_context(source)));
+	}
 	g_source_unref(source);
 
 	return ret;
@@ -516,6 +739,337 @@ OTC_PRIV int usb_source_remove(struct otc_session *session, struct otc_context *
 	return otc_session_source_remove_internal(session, ctx->libusb_ctx);
 }
 
+/** Raise the event thread's priority, as far as the system permits.
+ */
+static void usb_event_thread_raise_priority(void)
+{
+#ifdef _WIN32
+	if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+		otc_dbg("Cannot raise USB event thread priority.");
+#else
+	struct sched_param param;
+	int ret;
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+	ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	if (ret != 0)
+		otc_dbg("Cannot raise USB event thread priority: %s.",
+			g_strerror(ret));
+#endif
+}
+
+static gpointer usb_event_thread_run(gpointer data)
+{
+	struct otc_usb_events *events;
+	struct timeval tv;
+
+	events = data;
+
+	usb_event_thread_raise_priority();
+
+	while (!g_atomic_int_get(&events->stop)) {
+		/* Bounded, in case the handler cannot be interrupted. */
+		tv.tv_sec = 0;
+		tv.tv_usec = 100 * 1000;
+		libusb_handle_events_timeout_completed(events->usb_ctx,
+			&tv, &events->stop);
+	}
+
+	return NULL;
+}
+
+/* Called with the events' mutex held. */
+static gboolean usb_event_thread_start(struct otc_usb_events *events)
+{
+	events->stop = 0;
+	events->thread = g_thread_try_new("otc-usb-events",
+		usb_event_thread_run, events, NULL);
+	if (!events->thread) {
+		otc_err("Failed to start USB event thread.");
+		return FALSE;
+	}
+	otc_dbg("Started USB event thread.");
+
+	return TRUE;
+}
+
+/* Called with the events' mutex held. */
+static void usb_event_thread_stop(struct otc_usb_events *events)
+{
+	g_atomic_int_set(&events->stop, 1);
+#if (LIBUSB_API_VERSION >= 0x01000105)
+	libusb_interrupt_event_handler(events->usb_ctx);
+#endif
+	g_thread_join(events->thread);
+	events->thread = NULL;
+	otc_dbg("Stopped USB event thread.");
+}
+
+static struct otc_usb_events *usb_events_get(struct otc_context *ctx)
+{
+	struct otc_usb_events *events;
+
+	if (g_once_init_enter(&ctx->usb_events)) {
+		events = g_malloc0(sizeof(*events));
+		g_mutex_init(&events->mutex);
+		events->usb_ctx = ctx->libusb_ctx;
+		g_once_init_leave(&ctx->usb_events, events);
+	}
+
+	return ctx->usb_events;
+}
+
+static void usb_events_pause(struct otc_usb_events *events)
+{
+	g_mutex_lock(&events->mutex);
+	if (events->pauses++ == 0 && events->thread) {
+		usb_event_thread_stop(events);
+		otc_dbg("Paused USB event thread.");
+	}
+	g_mutex_unlock(&events->mutex);
+}
+
+static void usb_events_resume(struct otc_usb_events *events)
+{
+	g_mutex_lock(&events->mutex);
+	if (--events->pauses == 0 && events->users > 0)
+		usb_event_thread_start(events);
+	g_mutex_unlock(&events->mutex);
+}
+
+/**
+ * Pause the context's event thread while an acquisition starts.
+ *
+ * Drivers without a completion queue may submit transfers before they
+ * add their event source, the thread would run those callbacks. Queued
+ * transfers wait for otc_usb_events_resume() meanwhile.
+ *
+ * @param ctx The libopentracecapture context. Must not be NULL.
+ *
+ * @private
+ */
+OTC_PRIV void otc_usb_events_pause(struct otc_context *ctx)
+{
+	usb_events_pause(usb_events_get(ctx));
+}
+
+/** @private */
+OTC_PRIV void otc_usb_events_resume(struct otc_context *ctx)
+{
+	usb_events_resume(ctx->usb_events);
+}
+
+/**
+ * Create a queue for transfers which complete on the event thread.
+ *
+ * Transfers which get submitted with otc_usb_queue_submit() complete on
+ * the context's event thread, which queues them. An event source from
+ * usb_source_add_queue() then runs the driver's callback for them in the
+ * session, just like it would run when the session handles libusb events.
+ * The callback sees the transfer's user_data set to cb_data.
+ *
+ * The event thread runs while there are queues. Drivers which don't use
+ * a queue would get their transfer callbacks on that thread, so it
+ * pauses while they acquire data, and the session handles libusb events
+ * for all drivers again. The queue keeps working, only without the
+ * thread's latency benefit.
+ *
+ * @param ctx The libopentracecapture context. Must not be NULL.
+ * @param max_transfers The largest number of transfers which the driver
+ *   submits at the same time.
+ * @param cb The driver's transfer callback.
+ * @param cb_data The user_data of the driver's transfers.
+ *
+ * @return The queue, or NULL when the context doesn't run an event thread.
+ *   Drivers then handle their transfers as usual, otc_usb_queue_submit()
+ *   and usb_source_add_queue() accept the NULL queue.
+ *
+ * @private
+ */
+OTC_PRIV struct otc_usb_queue *otc_usb_queue_new(struct otc_context *ctx,
+		unsigned int max_transfers, libusb_transfer_cb_fn cb, void *cb_data)
+{
+	struct otc_usb_events *events;
+	struct otc_usb_queue *queue;
+	unsigned int size;
+
+	events = ctx->usb_events;
+	if (!events || !max_transfers)
+		return NULL;
+
+	g_mutex_lock(&events->mutex);
+	if (!events->enabled) {
+		g_mutex_unlock(&events->mutex);
+		return NULL;
+	}
+	if (!events->thread && !events->pauses
+			&& !usb_event_thread_start(events)) {
+		g_mutex_unlock(&events->mutex);
+		return NULL;
+	}
+	events->users++;
+	g_mutex_unlock(&events->mutex);
+
+	for (size = 1; size < max_transfers; size <<= 1)
+		;
+	queue = g_malloc0(sizeof(*queue));
+	queue->ctx = ctx;
+	queue->cb = cb;
+	queue->cb_data = cb_data;
+	queue->ring = g_new0(struct libusb_transfer *, size);
+	queue->done_ns = g_new0(uint64_t, size);
+	queue->mask = size - 1;
+
+	return queue;
+}
+
+/**
+ * Free a completion queue.
+ *
+ * Remove the queue's event source before, and only free the queue when
+ * none of its transfers are in flight any more.
+ *
+ * @param queue The queue to free. Can be NULL.
+ *
+ * @private
+ */
+OTC_PRIV void otc_usb_queue_free(struct otc_usb_queue *queue)
+{
+	struct otc_usb_events *events;
+
+	if (!queue)
+		return;
+
+	if (g_atomic_int_get(&queue->pending) > 0)
+		otc_err("Freeing USB completion queue with pending transfers.");
+
+	events = queue->ctx->usb_events;
+	g_mutex_lock(&events->mutex);
+	if (--events->users == 0 && events->thread)
+		usb_event_thread_stop(events);
+	g_mutex_unlock(&events->mutex);
+
+	/*
+	 * The event thread may still be in the callback which queued the
+	 * last transfer. libusb holds its event lock over callbacks, taking
+	 * it waits for them to return.
+	 */
+	libusb_lock_events(events->usb_ctx);
+	libusb_unlock_events(events->usb_ctx);
+
+	if (queue->main_context)
+		g_main_context_unref(queue->main_context);
+	g_free(queue->ring);
+	g_free(queue->done_ns);
+	g_free(queue);
+}
+
+/**
+ * Submit a transfer, for its callback to run from the completion queue.
+ *
+ * @param queue The completion queue. NULL submits the transfer as is.
+ * @param transfer The transfer, with the driver's callback and user_data
+ *   filled in. Those get restored before the callback runs.
+ *
+ * @return The result of libusb_submit_transfer(), or LIBUSB_ERROR_BUSY
+ *   when there are more transfers than the queue was created for.
+ *
+ * @private
+ */
+OTC_PRIV int otc_usb_queue_submit(struct otc_usb_queue *queue,
+		struct libusb_transfer *transfer)
+{
+	uint64_t now_ns;
+	int ret;
+
+	if (!queue)
+		return libusb_submit_transfer(transfer);
+
+	if ((unsigned int)g_atomic_int_get(&queue->pending) > queue->mask)
+		return LIBUSB_ERROR_BUSY;
+
+	now_ns = 0;
+	if (G_UNLIKELY(queue->metrics) && transfer == queue->current
+			&& queue->current_done_ns)
+		now_ns = otc_metrics_now_ns();
+
+	transfer->callback = usb_queue_transfer_done;
+	transfer->user_data = queue;
+	g_atomic_int_inc(&queue->pending);
+	if ((ret = libusb_submit_transfer(transfer)) != LIBUSB_SUCCESS) {
+		g_atomic_int_add(&queue->pending, -1);
+		transfer->callback = queue->cb;
+		transfer->user_data = queue->cb_data;
+	} else if (now_ns) {
+		/* Resubmitted after its completion, not the first time. */
+		otc_metrics_record(queue->metrics, OTC_METRICS_USB_RESUBMIT,
+			now_ns - queue->current_done_ns);
+		queue->current = NULL;
+	}
+
+	return ret;
+}
+
+/** @private */
+OTC_PRIV void otc_usb_events_free(struct otc_context *ctx)
+{
+	struct otc_usb_events *events;
+
+	if (!(events = ctx->usb_events))
+		return;
+
+	if (events->thread) {
+		otc_err("USB event thread still in use, stopping it.");
+		usb_event_thread_stop(events);
+	}
+	g_mutex_clear(&events->mutex);
+	g_free(events);
+	ctx->usb_events = NULL;
+}
+
+/**
+ * Handle libusb events of a context on a dedicated thread.
+ *
+ * By default, acquisitions handle libusb events in the session's main
+ * loop. Completed transfers then wait for whatever else the loop does,
+ * e.g. a slow output or a GUI sharing the loop, and fast streaming
+ * devices can overrun. With the event thread, libusb events are handled
+ * on a high priority thread while drivers which support it acquire data.
+ * Completed transfers get queued, and the session runs the drivers'
+ * callbacks for them. USB drivers without that support still work: the
+ * thread pauses while they acquire data, and the session handles libusb
+ * events for all drivers meanwhile.
+ *
+ * The setting takes effect with the next acquisition.
+ *
+ * @param ctx The libopentracecapture context. Must not be NULL.
+ * @param enable TRUE to use the event thread, FALSE to handle libusb
+ *   events in the session.
+ *
+ * @retval OTC_OK Success.
+ * @retval OTC_ERR_ARG Invalid argument.
+ *
+ * @since 0.6.0
+ */
+OTC_API int otc_usb_event_thread_set(struct otc_context *ctx, gboolean enable)
+{
+	struct otc_usb_events *events;
+
+	if (!ctx)
+		return OTC_ERR_ARG;
+
+	if (!enable && !ctx->usb_events)
+		return OTC_OK;
+
+	events = usb_events_get(ctx);
+	g_mutex_lock(&events->mutex);
+	events->enabled = enable;
+	g_mutex_unlock(&events->mutex);
+
+	return OTC_OK;
+}
+
 OTC_PRIV int usb_get_port_path(libusb_device *dev, char *path, int path_len)
 {
 	uint8_t port_numbers[8];
@@ -0,0 +1,293 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file
+ * Adaptive sizing of streaming bulk IN transfer queues
+ *
+ * Streaming devices (fx2lafw, DSLogic in continuous mode) have small
+ * FIFOs, and lose data as soon as the host has no transfer pending.
+ * Drivers queue several transfers to bridge the time it takes the host
+ * to process a transfer and resubmit it. How much time that takes
+ * depends on the host's load, which fixed heuristics can't know.
+ *
+ * The tuner watches how long each transfer waited between submission
+ * and completion. Transfers are served in order, so with N transfers
+ * in flight a transfer ideally waits for N "fill times" (the time the
+ * device takes to fill one transfer at its data rate). The host's
+ * latency shortens that wait. When the shortest wait in a round of N
+ * completions drops below half the queue's duration, the tuner grows
+ * the queue: first the number of transfers, then their size. A round
+ * which received clearly less data than the device produced meanwhile
+ * lost data, which gets counted as an overflow, and grows the queue as
+ * well. After many calm rounds the queue shrinks again, unless callback
+ * processing time suggests to keep it.
+ *
+ * Drivers pick initial values from their heuristics, and apply the
+ * tuner's choices when they resubmit transfers.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "libopentracecapture-internal.h"
+
+#define LOG_PREFIX "usb-tune"
+
+/* Rounds with plenty of headroom before the queue shrinks. */
+#define TUNE_CALM_ROUNDS	16
+/* Smallest number of transfers in flight. */
+#define TUNE_MIN_COUNT		2
+/* Factors for the smallest and the largest transfer size. */
+#define TUNE_SIZE_SHRINK	4
+#define TUNE_SIZE_GROW		8
+
+static size_t tune_align_down(const struct otc_usb_tune *tune, size_t size)
+{
+	return size - size % tune->align;
+}
+
+static size_t tune_align_up(const struct otc_usb_tune *tune, size_t size)
+{
+	return tune_align_down(tune, size + tune->align - 1);
+}
+
+/* The time in us it takes the device to send the given number of bytes. */
+static int64_t tune_fill_us(const struct otc_usb_tune *tune, size_t bytes)
+{
+	return (int64_t)bytes * 1000 / tune->bytes_per_ms;
+}
+
+static void tune_round_reset(struct otc_usb_tune *tune)
+{
+	tune->round_left = tune->count;
+	tune->round_min_wait_us = G_MAXINT64;
+	tune->round_max_proc_us = 0;
+	tune->round_bytes = 0;
+}
+
+/**
+ * Prepare a transfer queue tuner for an acquisition.
+ *
+ * @param[out] tune The tuner to initialize.
+ * @param[in] bytes_per_ms The device's data rate.
+ * @param[in] size The initial transfer size in bytes.
+ * @param[in] count The initial number of transfers in flight.
+ * @param[in] align Transfer sizes are multiples of this many bytes.
+ * @param[in] max_count The largest number of transfers in flight.
+ * @param[in] max_total The largest combined size of all transfers.
+ * @param[in] adaptive Whether to adjust the queue. When FALSE, the
+ *   initial values are kept, and only the statistics are updated.
+ */
+OTC_PRIV void otc_usb_tune_init(struct otc_usb_tune *tune,
+	uint64_t bytes_per_ms, size_t size, unsigned int count,
+	size_t align, unsigned int max_count, size_t max_total,
+	gboolean adaptive)
+{
+	g_free(tune->submit_us);
+	memset(tune, 0, sizeof(*tune));
+
+	tune->bytes_per_ms = bytes_per_ms;
+	tune->adaptive = adaptive && bytes_per_ms;
+	tune->align = align ? align : 1;
+	tune->max_total = max_total;
+
+	tune->count = MAX(MIN(count, max_count), 1);
+	tune->size = tune_align_up(tune, MAX(size, 1));
+	tune->min_count = MIN(tune->count, TUNE_MIN_COUNT);
+	tune->max_count = max_count;
+	tune->min_size = tune_align_up(tune, tune->size / TUNE_SIZE_SHRINK);
+	tune->max_size = tune_align_down(tune,
+		MIN(tune->size * TUNE_SIZE_GROW, max_total / tune->min_count));
+	tune->min_size = MIN(tune->min_size, tune->size);
+	tune->max_size = MAX(tune->max_size, tune->size);
+
+	tune->submit_us = g_new0(int64_t, max_count);
+	tune->settling = TRUE;
+	tune_round_reset(tune);
+}
+
+/**
+ * Release the tuner's resources. The chosen values and the statistics
+ * remain available.
+ *
+ * @param[in] tune The tuner.
+ */
+OTC_PRIV void otc_usb_tune_clear(struct otc_usb_tune *tune)
+{
+	g_free(tune->submit_us);
+	tune->submit_us = NULL;
+}
+
+/**
+ * Get the timeout for transfers, the current queue's duration plus
+ * some headroom.
+ *
+ * @param[in] tune The tuner.
+ *
+ * @return The timeout in ms, 0 (no timeout) when the data rate is unknown.
+ */
+OTC_PRIV unsigned int otc_usb_tune_timeout(const struct otc_usb_tune *tune)
+{
+	uint64_t timeout;
+
+	if (!tune->bytes_per_ms)
+		return 0;
+
+	timeout = (uint64_t)tune->size * tune->count / tune->bytes_per_ms;
+
+	return timeout + timeout / 4; /* Leave a headroom of 25% percent. */
+}
+
+/**
+ * Note the submission of a transfer.
+ *
+ * @param[in] tune The tuner.
+ * @param[in] slot The transfer's index in the driver's transfer array.
+ */
+OTC_PRIV void otc_usb_tune_submitted(struct otc_usb_tune *tune,
+	unsigned int slot)
+{
+	if (!tune->submit_us || slot >= tune->max_count)
+		return;
+
+	tune->submit_us[slot] = g_get_monotonic_time();
+}
+
+static gboolean tune_grow(struct otc_usb_tune *tune)
+{
+	unsigned int count;
+	size_t size;
+
+	count = MIN(tune->count * 2, tune->max_count);
+	count = MIN(count, tune->max_total / tune->size);
+	if (count > tune->count) {
+		tune->count = count;
+		otc_dbg("Growing queue to %u transfers.", tune->count);
+		return TRUE;
+	}
+
+	size = MIN(tune->size * 2, tune->max_size);
+	size = MIN(size, tune_align_down(tune, tune->max_total / tune->count));
+	if (size > tune->size) {
+		tune->size = size;
+		otc_dbg("Growing transfers to %zu bytes.", tune->size);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean tune_shrink(struct otc_usb_tune *tune)
+{
+	size_t size;
+
+	if (tune->count > tune->min_count) {
+		tune->count--;
+		otc_dbg("Shrinking queue to %u transfers.", tune->count);
+		return TRUE;
+	}
+
+	size = MAX(tune_align_down(tune, tune->size / 2), tune->min_size);
+	if (size < tune->size) {
+		tune->size = size;
+		otc_dbg("Shrinking transfers to %zu bytes.", tune->size);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * Note the completion of a transfer, after the driver processed its
+ * data. Updates the statistics, and at the end of a round of
+ * completions adjusts the number and size of transfers.
+ *
+ * @param[in] tune The tuner.
+ * @param[in] slot The transfer's index in the driver's transfer array.
+ * @param[in] begin_us The monotonic time when the completion callback
+ *   started to run.
+ * @param[in] length The number of bytes which the transfer received.
+ */
+OTC_PRIV void otc_usb_tune_completed(struct otc_usb_tune *tune,
+	unsigned int slot, int64_t begin_us, size_t length)
+{
+	int64_t wait_us, proc_us, fill_us, queue_us;
+	uint64_t expected, slack;
+	gboolean lost;
+
+	if (!tune->submit_us || slot >= tune->max_count || !length)
+		return;
+	if (!tune->bytes_per_ms)
+		return;
+
+	wait_us = begin_us - tune->submit_us[slot];
+	proc_us = g_get_monotonic_time() - begin_us;
+	tune->round_min_wait_us = MIN(tune->round_min_wait_us, wait_us);
+	tune->round_max_proc_us = MAX(tune->round_max_proc_us, proc_us);
+	tune->round_bytes += length;
+
+	if (--tune->round_left > 0)
+		return;
+
+	/*
+	 * Compare the round's data to what the device produced since the
+	 * previous round ended. Completed transfers which still wait for
+	 * their callback hold up to a queue's worth of that data. Allow for
+	 * some jitter and rate mismatch on top.
+	 */
+	lost = FALSE;
+	if (tune->round_end_us) {
+		expected = (begin_us - tune->round_end_us) * tune->bytes_per_ms / 1000;
+		slack = tune->size * tune->count + expected / 16;
+		if (tune->round_bytes + slack < expected) {
+			otc_dbg("Lost about %" PRIu64 " bytes.",
+				expected - tune->round_bytes);
+			tune->overflows++;
+			lost = TRUE;
+		}
+	}
+	tune->round_end_us = begin_us;
+
+	fill_us = tune_fill_us(tune, tune->size);
+	queue_us = fill_us * tune->count;
+	if (!tune->adaptive) {
+		/* Nothing to adjust. */
+	} else if (lost) {
+		tune->calm_rounds = 0;
+		tune->settling = tune_grow(tune);
+	} else if (tune->settling) {
+		/* Waits don't reflect the current queue yet. */
+		tune->settling = FALSE;
+	} else if (tune->round_min_wait_us * 2 < queue_us) {
+		tune->calm_rounds = 0;
+		tune->settling = tune_grow(tune);
+	} else if (tune->round_min_wait_us * 8 > queue_us * 7
+			&& queue_us - fill_us > 4 * tune->round_max_proc_us) {
+		if (++tune->calm_rounds >= TUNE_CALM_ROUNDS) {
+			tune->calm_rounds = 0;
+			tune->settling = tune_shrink(tune);
+		}
+	} else {
+		tune->calm_rounds = 0;
+	}
+	tune_round_reset(tune);
+}
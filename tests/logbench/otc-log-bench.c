@@ -0,0 +1,348 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Asynchronous logging from a number of threads. Each thread logs spew
+ * messages by setting a demo device's sample limit, and every so often
+ * an error by getting an unknown config key. Both carry the thread's
+ * next sequence number, the log callback checks that each thread's
+ * messages arrive in order. Spew messages may get dropped, but have to
+ * be counted then, errors have to arrive. The callback has to be called
+ * on the background thread only, and never concurrently. Once the
+ * threads finished, setting another callback has to pass on all pending
+ * messages.
+ *
+ * With -w, the log callback takes that many microseconds per message.
+ * The threads then fill their rings, and messages have to get dropped.
+ *
+ *   otc-log-bench [-t threads] [-n messages] [-e interval] [-w us]
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+#define MAX_THREADS	8
+
+/* Sequence numbers of a thread, beyond any valid config key. */
+#define ID_BASE		100000000
+#define ID_STRIDE	10000000
+
+struct worker {
+	struct bench *bench;
+	struct otc_dev_inst *sdi;
+	unsigned int index;
+	GThread *thread;
+	/* Set by the worker. */
+	uint64_t spew_sent;
+	uint64_t errors_sent;
+	/* Set by the log callback. */
+	int64_t last_seq;
+	uint64_t spew_received;
+	uint64_t errors_received;
+	uint64_t order_errors;
+};
+
+struct bench {
+	struct otc_dev_driver *driver;
+	struct worker workers[MAX_THREADS];
+	unsigned int num_threads;
+	unsigned int num_messages;
+	unsigned int error_interval;
+	unsigned int delay_us;
+	/* Set by the log callback. */
+	volatile gint in_callback;
+	GThread *callback_thread;
+	uint64_t calls;
+	uint64_t concurrent;
+	uint64_t wrong_thread;
+};
+
+static GPrivate worker_thread;
+
+static void log_received(struct bench *bench, uint64_t id, gboolean error)
+{
+	struct worker *w;
+	unsigned int index;
+	int64_t seq;
+
+	if (id < ID_BASE)
+		return;
+	index = (id - ID_BASE) / ID_STRIDE;
+	if (index >= bench->num_threads)
+		return;
+	w = &bench->workers[index];
+	seq = (id - ID_BASE) % ID_STRIDE;
+
+	if (seq <= w->last_seq)
+		w->order_errors++;
+	w->last_seq = seq;
+	if (error)
+		w->errors_received++;
+	else
+		w->spew_received++;
+}
+
+static int bench_log(void *cb_data, int loglevel, const char *format,
+	va_list args)
+{
+	struct bench *bench;
+	const char *p;
+	char *text;
+
+	(void)loglevel;
+
+	bench = cb_data;
+	if (g_atomic_int_add(&bench->in_callback, 1) != 0)
+		bench->concurrent++;
+	if (g_private_get(&worker_thread))
+		bench->wrong_thread++;
+	if (!bench->callback_thread)
+		bench->callback_thread = g_thread_self();
+	else if (bench->callback_thread != g_thread_self())
+		bench->wrong_thread++;
+	bench->calls++;
+
+	text = g_strdup_vprintf(format, args);
+	if ((p = strstr(text, "Invalid key ")))
+		log_received(bench, g_ascii_strtoull(p + 12, NULL, 10), TRUE);
+	else if (strstr(text, "(limit_samples)") && (p = strrchr(text, ' ')))
+		log_received(bench, g_ascii_strtoull(p + 1, NULL, 10), FALSE);
+	g_free(text);
+
+	if (bench->delay_us)
+		g_usleep(bench->delay_us);
+	g_atomic_int_add(&bench->in_callback, -1);
+
+	return OTC_OK;
+}
+
+static gpointer worker_run(gpointer data)
+{
+	struct worker *w;
+	struct bench *bench;
+	GVariant *gvar;
+	unsigned int seq;
+	uint64_t id;
+
+	w = data;
+	bench = w->bench;
+	g_private_set(&worker_thread, w);
+
+	for (seq = 0; seq < bench->num_messages; seq++) {
+		id = ID_BASE + (uint64_t)w->index * ID_STRIDE + seq;
+		if (seq % bench->error_interval == 0) {
+			otc_config_get(bench->driver, NULL, NULL, id, &gvar);
+			w->errors_sent++;
+		} else {
+			otc_config_set(w->sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+				g_variant_new_uint64(id));
+			w->spew_sent++;
+		}
+	}
+
+	return NULL;
+}
+
+static struct otc_dev_inst *device_open(struct otc_dev_driver *driver)
+{
+	struct otc_dev_inst *sdi;
+	GSList *devices;
+
+	devices = otc_driver_scan(driver, NULL);
+	if (!devices)
+		return NULL;
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	return otc_dev_open(sdi) == OTC_OK ? sdi : NULL;
+}
+
+static int bench_check(struct bench *bench, uint64_t dropped)
+{
+	struct worker *w;
+	uint64_t spew_sent, spew_received;
+	unsigned int i;
+	int failed;
+
+	failed = 0;
+	if (bench->concurrent) {
+		fprintf(stderr, "%" PRIu64 " concurrent log callbacks.\n",
+			bench->concurrent);
+		failed++;
+	}
+	if (bench->wrong_thread) {
+		fprintf(stderr, "%" PRIu64 " log callbacks on other threads "
+			"than the background thread.\n", bench->wrong_thread);
+		failed++;
+	}
+
+	spew_sent = spew_received = 0;
+	for (i = 0; i < bench->num_threads; i++) {
+		w = &bench->workers[i];
+		if (w->order_errors) {
+			fprintf(stderr, "Thread %u: %" PRIu64 " messages out of "
+				"order.\n", i, w->order_errors);
+			failed++;
+		}
+		if (w->errors_received != w->errors_sent) {
+			fprintf(stderr, "Thread %u: %" PRIu64 " of %" PRIu64
+				" errors arrived.\n", i, w->errors_received,
+				w->errors_sent);
+			failed++;
+		}
+		spew_sent += w->spew_sent;
+		spew_received += w->spew_received;
+	}
+	/* The drop count may include other messages. */
+	if (spew_received + dropped < spew_sent) {
+		fprintf(stderr, "%" PRIu64 " of %" PRIu64 " messages arrived, "
+			"but only %" PRIu64 " got dropped.\n", spew_received,
+			spew_sent, dropped);
+		failed++;
+	}
+	if (bench->delay_us && spew_sent && !dropped) {
+		fprintf(stderr, "No messages dropped with a slow callback.\n");
+		failed++;
+	}
+
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers;
+	struct bench bench;
+	uint64_t dropped, calls;
+	gint64 start_us;
+	double elapsed;
+	unsigned int i;
+	int opt, failed;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.num_threads = 4;
+	bench.num_messages = 100000;
+	bench.error_interval = 16;
+	while ((opt = getopt(argc, argv, "t:n:e:w:")) != -1) {
+		switch (opt) {
+		case 't':
+			bench.num_threads = atoi(optarg);
+			break;
+		case 'n':
+			bench.num_messages = atoi(optarg);
+			break;
+		case 'e':
+			bench.error_interval = atoi(optarg);
+			break;
+		case 'w':
+			bench.delay_us = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !bench.num_threads
+			|| bench.num_threads > MAX_THREADS
+			|| !bench.num_messages || bench.num_messages > ID_STRIDE
+			|| !bench.error_interval)
+		goto usage;
+
+	if (otc_init(&ctx) != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	drivers = otc_driver_list(ctx);
+	for (i = 0; drivers && drivers[i]; i++) {
+		if (!strcmp(drivers[i]->name, "demo"))
+			bench.driver = drivers[i];
+	}
+	if (!bench.driver) {
+		fprintf(stderr, "Driver demo not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, bench.driver) != OTC_OK) {
+		otc_exit(ctx);
+		return 1;
+	}
+	for (i = 0; i < bench.num_threads; i++) {
+		bench.workers[i].bench = &bench;
+		bench.workers[i].index = i;
+		bench.workers[i].last_seq = -1;
+		bench.workers[i].sdi = device_open(bench.driver);
+		if (!bench.workers[i].sdi) {
+			fprintf(stderr, "Cannot open demo device %u.\n", i);
+			otc_exit(ctx);
+			return 1;
+		}
+	}
+
+	otc_log_callback_set(bench_log, &bench);
+	if (otc_log_async_set(TRUE) != OTC_OK) {
+		otc_log_callback_set_default();
+		otc_exit(ctx);
+		return 1;
+	}
+	otc_log_loglevel_set(OTC_LOG_SPEW);
+	dropped = otc_log_dropped_get();
+
+	start_us = g_get_monotonic_time();
+	for (i = 0; i < bench.num_threads; i++) {
+		bench.workers[i].thread = g_thread_new("log-worker",
+			worker_run, &bench.workers[i]);
+	}
+	for (i = 0; i < bench.num_threads; i++)
+		g_thread_join(bench.workers[i].thread);
+	elapsed = (g_get_monotonic_time() - start_us) / 1e6;
+
+	/* Passes on the pending messages, before the next ones get lost. */
+	otc_log_loglevel_set(OTC_LOG_WARN);
+	otc_log_callback_set_default();
+	dropped = otc_log_dropped_get() - dropped;
+	calls = bench.calls;
+	otc_log_async_set(FALSE);
+
+	failed = bench_check(&bench, dropped) ? 1 : 0;
+	if (bench.calls != calls) {
+		fprintf(stderr, "Messages arrived after the callback changed.\n");
+		failed = 1;
+	}
+
+	printf("%u threads %9.1f kmessages/s, %" PRIu64 " dropped\n",
+		bench.num_threads,
+		(double)bench.num_threads * bench.num_messages / elapsed / 1e3,
+		dropped);
+
+	otc_exit(ctx);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-t threads] [-n messages] [-e interval] "
+		"[-w us]\n", argv[0]);
+	return 2;
+}
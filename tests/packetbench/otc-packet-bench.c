@@ -0,0 +1,303 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Sustained packet copy throughput, the way a frontend keeps a window of
+ * recent packets for display: each packet gets copied, and the oldest
+ * copy released. Compares otc_packet_copy() with a packet pool, for logic
+ * and analog packets. With -t, a second thread releases the copies.
+ * Fails when the copies of the two ways differ. Before the release, the
+ * bench scales analog copies the way the scale transform does, in place:
+ * that must not change other copies.
+ *
+ *   otc-packet-bench [-n packets] [-s bytes] [-w window] [-t]
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+
+#define NUM_ANALOG_CHANNELS 4
+
+enum bench_mode {
+	MODE_MALLOC,
+	MODE_POOL,
+};
+
+static const char *mode_names[] = { "malloc", "pool" };
+
+static unsigned int num_packets = 200000;
+static size_t packet_bytes = 4096;
+static unsigned int window = 64;
+static gboolean release_thread;
+
+struct bench {
+	enum bench_mode mode;
+	struct otc_packet_pool *pool;
+	GAsyncQueue *released;
+	uint64_t hash;
+};
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+/* The first and last bytes of the data catch short copies. */
+static uint64_t hash_ends(uint64_t hash, const uint8_t *data, size_t len)
+{
+	hash = hash_bytes(hash, data, MIN(len, 16));
+
+	return hash_bytes(hash, data + len - MIN(len, 16), MIN(len, 16));
+}
+
+/* Checks a copy, before it gets released. */
+static uint64_t hash_packet(uint64_t hash, const struct otc_datafeed_packet *p)
+{
+	const struct otc_datafeed_logic *logic;
+	const struct otc_datafeed_analog *analog;
+	unsigned int num_channels;
+	int64_t scale;
+
+	hash = hash_bytes(hash, &p->type, sizeof(p->type));
+	if (p->type == OTC_DF_LOGIC) {
+		logic = p->payload;
+		hash = hash_ends(hash, logic->data, logic->length);
+	} else if (p->type == OTC_DF_ANALOG) {
+		analog = p->payload;
+		num_channels = g_slist_length(analog->meaning->channels);
+		hash = hash_bytes(hash, &num_channels, sizeof(num_channels));
+		hash = hash_bytes(hash, &analog->meaning->mq,
+			sizeof(analog->meaning->mq));
+		analog->encoding->scale.p *= 2;
+		scale = analog->encoding->scale.p;
+		hash = hash_bytes(hash, &scale, sizeof(scale));
+		hash = hash_ends(hash, analog->data, (size_t)analog->num_samples
+			* num_channels * analog->encoding->unitsize);
+	}
+
+	return hash;
+}
+
+static void release(struct bench *b, struct otc_datafeed_packet *copy)
+{
+	b->hash = hash_packet(b->hash, copy);
+	if (b->mode == MODE_POOL)
+		otc_packet_pool_release(copy);
+	else
+		otc_packet_free(copy);
+}
+
+static gpointer release_run(gpointer data)
+{
+	struct bench *b = data;
+	struct otc_datafeed_packet *copy;
+
+	/* The bench itself is the end marker. */
+	while ((copy = g_async_queue_pop(b->released)) != (gpointer)b)
+		release(b, copy);
+
+	return NULL;
+}
+
+static double run(enum bench_mode mode,
+		const struct otc_datafeed_packet *packets, unsigned int count,
+		uint64_t *hash)
+{
+	struct otc_datafeed_packet **ring, *copy;
+	struct bench b;
+	GThread *thread;
+	int64_t start, end;
+	unsigned int i;
+	int ret;
+
+	memset(&b, 0, sizeof(b));
+	b.mode = mode;
+	b.hash = 0xcbf29ce484222325ull;
+	if (mode == MODE_POOL)
+		b.pool = otc_packet_pool_new(0);
+	thread = NULL;
+	if (release_thread) {
+		b.released = g_async_queue_new();
+		thread = g_thread_new("release", release_run, &b);
+	}
+	ring = g_new0(struct otc_datafeed_packet *, window);
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < num_packets; i++) {
+		if (mode == MODE_POOL)
+			ret = otc_packet_pool_copy(b.pool, &packets[i % count],
+				&copy);
+		else
+			ret = otc_packet_copy(&packets[i % count], &copy);
+		if (ret != OTC_OK) {
+			fprintf(stderr, "Copy failed: %d.\n", ret);
+			exit(1);
+		}
+		if (ring[i % window]) {
+			if (b.released)
+				g_async_queue_push(b.released, ring[i % window]);
+			else
+				release(&b, ring[i % window]);
+		}
+		ring[i % window] = copy;
+	}
+	for (i = num_packets; i < num_packets + window; i++) {
+		if (!ring[i % window])
+			continue;
+		if (b.released)
+			g_async_queue_push(b.released, ring[i % window]);
+		else
+			release(&b, ring[i % window]);
+	}
+	if (thread) {
+		g_async_queue_push(b.released, &b);
+		g_thread_join(thread);
+		g_async_queue_unref(b.released);
+	}
+	end = g_get_monotonic_time();
+
+	otc_packet_pool_free(b.pool);
+	g_free(ring);
+	*hash = b.hash;
+
+	return (end - start) / 1e6;
+}
+
+static int bench_packets(const char *name,
+		const struct otc_datafeed_packet *packets, unsigned int count,
+		size_t bytes)
+{
+	uint64_t hashes[2];
+	double seconds;
+	int mode;
+
+	for (mode = MODE_MALLOC; mode <= MODE_POOL; mode++) {
+		seconds = run(mode, packets, count, &hashes[mode]);
+		printf("%-6s %-6s %8zu bytes %10.0f packets/s %8.1f MB/s\n",
+			name, mode_names[mode], bytes, num_packets / seconds,
+			num_packets * (double)bytes / seconds / 1e6);
+	}
+	if (hashes[MODE_POOL] != hashes[MODE_MALLOC]) {
+		fprintf(stderr, "Mismatch: %s copies differ.\n", name);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n packets] [-s bytes] [-w window] [-t]\n",
+		name);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	static struct otc_channel channels[NUM_ANALOG_CHANNELS];
+	struct otc_datafeed_packet packets[3];
+	struct otc_datafeed_logic logic[3];
+	struct otc_datafeed_analog analog;
+	struct otc_analog_encoding encoding;
+	struct otc_analog_meaning meaning;
+	struct otc_analog_spec spec;
+	uint8_t *data;
+	GSList *channel_list;
+	unsigned int i;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "n:s:w:t")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_packets = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			packet_bytes = strtoull(optarg, NULL, 0);
+			break;
+		case 'w':
+			window = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			release_thread = TRUE;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!num_packets || !window || packet_bytes < 16
+			|| packet_bytes % (NUM_ANALOG_CHANNELS * sizeof(float)))
+		usage(argv[0]);
+
+	data = g_malloc(packet_bytes);
+	for (i = 0; i < packet_bytes; i++)
+		data[i] = g_random_int();
+
+	/* Logic packets of a few sizes, as a driver's transfers end. */
+	for (i = 0; i < 3; i++) {
+		logic[i].length = packet_bytes >> i;
+		logic[i].unitsize = 2;
+		logic[i].data = data;
+		packets[i].type = OTC_DF_LOGIC;
+		packets[i].payload = &logic[i];
+	}
+	ret = bench_packets("logic", packets, 3,
+		(packet_bytes + (packet_bytes >> 1) + (packet_bytes >> 2)) / 3);
+
+	/* Interleaved samples of a few channels, in one description. */
+	channel_list = NULL;
+	for (i = 0; i < NUM_ANALOG_CHANNELS; i++)
+		channel_list = g_slist_append(channel_list, &channels[i]);
+	memset(&encoding, 0, sizeof(encoding));
+	encoding.unitsize = sizeof(float);
+	encoding.is_signed = TRUE;
+	encoding.is_float = TRUE;
+	encoding.digits = 3;
+	encoding.scale.p = encoding.scale.q = 1;
+	encoding.offset.q = 1;
+	memset(&meaning, 0, sizeof(meaning));
+	meaning.mq = OTC_MQ_VOLTAGE;
+	meaning.unit = OTC_UNIT_VOLT;
+	meaning.channels = channel_list;
+	spec.spec_digits = 3;
+	analog.encoding = &encoding;
+	analog.meaning = &meaning;
+	analog.spec = &spec;
+	analog.data = data;
+	analog.num_samples = packet_bytes / sizeof(float) / NUM_ANALOG_CHANNELS;
+	packets[0].type = OTC_DF_ANALOG;
+	packets[0].payload = &analog;
+	ret |= bench_packets("analog", packets, 1, packet_bytes);
+
+	g_slist_free(channel_list);
+	g_free(data);
+
+	return ret;
+}
@@ -0,0 +1,282 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Run expansion throughput of the logic feed queue, for idle-heavy
+ * captures the way RLE hardware reports them: most runs are long idle
+ * periods, in between there are short bursts of activity. Submits the
+ * same runs sample by sample, with one feed_queue_logic_submit_one()
+ * call per run, and with feed_queue_logic_submit_runs(). Fails when the
+ * session receives different data from the three ways.
+ *
+ *   otc-runs-bench [-n runs] [-i idle percent] [-l idle length]
+ *                  [-u unitsize] [-b buffer samples] [-p passes] [-c] [-t]
+ *
+ * With -c, all logic data which the session receives gets hashed. That
+ * is the regression test, benchmarks only count the samples. With -t,
+ * the session inverts logic data with the invert transform, which
+ * changes the queue's buffer in place. Idle runs longer than the buffer
+ * must not send what the transform left behind.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "src/libopentracecapture-internal.h"
+
+enum bench_mode {
+	MODE_PER_SAMPLE,
+	MODE_SUBMIT_ONE,
+	MODE_SUBMIT_RUNS,
+	MODE_COUNT,
+};
+
+static const char *mode_names[] = {
+	"per-sample", "submit_one", "submit_runs",
+};
+
+static size_t num_runs = 1000000;
+static unsigned int idle_percent = 75;
+static size_t idle_length = 200;
+static size_t unit_size = 2;
+static size_t buffer_samples = 4096;
+static unsigned int passes = 1;
+static gboolean check;
+static gboolean invert;
+
+struct bench {
+	uint64_t samples;
+	uint64_t hash;
+};
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static void datafeed_in(const struct otc_dev_inst *sdi,
+		const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	const struct otc_datafeed_logic *logic;
+	struct bench *b = cb_data;
+
+	(void)sdi;
+
+	if (packet->type != OTC_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	b->samples += logic->length / logic->unitsize;
+	if (check)
+		b->hash = hash_bytes(b->hash, logic->data, logic->length);
+}
+
+/* Idle runs of all-low lines, with bursts of short runs in between. */
+static void make_runs(uint8_t *values, size_t *counts, uint64_t *total)
+{
+	GRand *rand;
+	size_t run, idx;
+
+	rand = g_rand_new_with_seed(1);
+	*total = 0;
+	for (run = 0; run < num_runs; run++) {
+		if (g_rand_int_range(rand, 0, 100) < (gint32)idle_percent) {
+			memset(values, 0, unit_size);
+			counts[run] = idle_length;
+		} else {
+			for (idx = 0; idx < unit_size; idx++)
+				values[idx] = g_rand_int(rand);
+			counts[run] = g_rand_int_range(rand, 1, 5);
+		}
+		*total += counts[run];
+		values += unit_size;
+	}
+	g_rand_free(rand);
+}
+
+static int submit(enum bench_mode mode, struct feed_queue_logic *q,
+		const uint8_t *values, const size_t *counts)
+{
+	size_t run, count;
+	int ret;
+
+	if (mode == MODE_SUBMIT_RUNS)
+		return feed_queue_logic_submit_runs(q, values, counts, num_runs);
+
+	for (run = 0; run < num_runs; run++) {
+		if (mode == MODE_SUBMIT_ONE) {
+			ret = feed_queue_logic_submit_one(q, values, counts[run]);
+			if (ret != OTC_OK)
+				return ret;
+		} else {
+			/* Each repetition on its own, as drivers used to. */
+			for (count = counts[run]; count; count--) {
+				ret = feed_queue_logic_submit_many(q, values, 1);
+				if (ret != OTC_OK)
+					return ret;
+			}
+		}
+		values += unit_size;
+	}
+
+	return OTC_OK;
+}
+
+static double run(struct otc_dev_inst *sdi, enum bench_mode mode,
+		const uint8_t *values, const size_t *counts, struct bench *b)
+{
+	struct feed_queue_logic *q;
+	int64_t start, end;
+	unsigned int pass;
+	int ret;
+
+	memset(b, 0, sizeof(*b));
+	b->hash = 0xcbf29ce484222325ull;
+	q = feed_queue_logic_alloc(sdi, buffer_samples, unit_size);
+
+	start = g_get_monotonic_time();
+	ret = OTC_OK;
+	for (pass = 0; pass < passes && ret == OTC_OK; pass++)
+		ret = submit(mode, q, values, counts);
+	if (ret == OTC_OK)
+		ret = feed_queue_logic_flush(q);
+	end = g_get_monotonic_time();
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Submission failed: %d.\n", ret);
+		exit(1);
+	}
+
+	feed_queue_logic_free(q);
+
+	return (end - start) / 1e6;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n runs] [-i idle_percent] "
+		"[-l idle_length] [-u unitsize] [-b buffer_samples] "
+		"[-p passes] [-c] [-t]\n", name);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_session *session;
+	struct otc_dev_inst *sdi;
+	struct bench results[MODE_COUNT], current;
+	uint8_t *values;
+	size_t *counts;
+	uint64_t total;
+	double seconds;
+	int mode, opt, ret;
+
+	while ((opt = getopt(argc, argv, "n:i:l:u:b:p:ct")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_runs = strtoull(optarg, NULL, 0);
+			break;
+		case 'i':
+			idle_percent = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			idle_length = strtoull(optarg, NULL, 0);
+			break;
+		case 'u':
+			unit_size = strtoull(optarg, NULL, 0);
+			break;
+		case 'b':
+			buffer_samples = strtoull(optarg, NULL, 0);
+			break;
+		case 'p':
+			passes = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			check = TRUE;
+			break;
+		case 't':
+			invert = TRUE;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!num_runs || idle_percent > 100 || !idle_length || !unit_size
+			|| unit_size > 8 || !buffer_samples || !passes)
+		usage(argv[0]);
+
+	if (otc_init(&ctx) != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+
+	values = g_malloc(num_runs * unit_size);
+	counts = g_new(size_t, num_runs);
+	make_runs(values, counts, &total);
+	total *= passes;
+
+	otc_session_new(ctx, &session);
+	otc_session_datafeed_callback_add(session, datafeed_in, &current);
+	sdi = otc_dev_inst_user_new("Bench", "Runs", NULL);
+	otc_session_dev_add(session, sdi);
+	if (invert && !otc_transform_new(otc_transform_find("invert"),
+			NULL, sdi)) {
+		fprintf(stderr, "Cannot load the invert transform.\n");
+		return 1;
+	}
+
+	ret = 0;
+	for (mode = 0; mode < MODE_COUNT; mode++) {
+		seconds = run(sdi, mode, values, counts, &current);
+		results[mode] = current;
+		printf("%-11s unit %zu idle %3u%% x %-5zu %8.1f Msamples/s\n",
+			mode_names[mode], unit_size, idle_percent, idle_length,
+			total / seconds / 1e6);
+		if (results[mode].samples != total) {
+			fprintf(stderr, "%s: %" PRIu64 " samples, expected %"
+				PRIu64 ".\n", mode_names[mode],
+				results[mode].samples, total);
+			ret = 1;
+		}
+		if (results[mode].hash != results[MODE_PER_SAMPLE].hash) {
+			fprintf(stderr, "Mismatch: %s data differs.\n",
+				mode_names[mode]);
+			ret = 1;
+		}
+	}
+
+	otc_session_destroy(session);
+	g_free(values);
+	g_free(counts);
+	otc_exit(ctx);
+
+	return ret;
+}
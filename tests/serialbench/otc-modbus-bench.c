@@ -0,0 +1,464 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Register polling of the rdtech-dps driver over Modbus/TCP. A stand-in
+ * DPS5005 answers on a loopback socket, and records the read requests
+ * of the acquisition's polling cycles.
+ *
+ *   otc-modbus-bench [-n <samples>] [-s <cycle>] [-l <loglevel>]
+ *
+ * The driver's polling plan has to coalesce the setpoint, measurement
+ * and status registers into a single request, and put the request for
+ * the protection thresholds in flight before the first response gets
+ * read. The stand-in holds back its response to the first request of
+ * a cycle until the second one arrives, or gives up on it after a
+ * while, and counts the cycle as not pipelined then.
+ *
+ * The -s option stalls the given cycle for longer than the transport's
+ * read timeout. The driver has to give up on it, skip the late
+ * responses, and retry. The wait has to sleep in poll(): the process
+ * must not take more than half of the stall in CPU time.
+ */
+
+#include <errno.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+#define DPS_MODEL		5005
+#define DPS_VERSION		14
+#define NUM_REGISTERS		0x100
+
+/* The blocks which the driver's plan reads per cycle. */
+#define STATE_ADDRESS		0x00
+#define STATE_COUNT		10
+#define THRESHOLD_ADDRESS	0x52
+#define THRESHOLD_COUNT		2
+
+/* How long to hold back a response, waiting for the next request. */
+#define PIPELINE_WAIT_MS	200
+/* Longer than the 1000 ms read timeout of the Modbus transports. */
+#define STALL_MS		1500
+
+struct standin {
+	int listen_fd;
+	char *conn;
+	GThread *thread;
+	volatile gint quit;
+	unsigned int stall_cycle;
+	uint16_t registers[NUM_REGISTERS];
+	/* Only read after the thread was joined. */
+	unsigned int cycles;
+	unsigned int pipelined;
+	unsigned int uncoalesced;
+	unsigned int requests;
+};
+
+struct request {
+	uint8_t header[7];
+	uint8_t pdu[256];
+	size_t pdu_len;
+};
+
+static gboolean standin_io(int fd, void *buf, size_t len, gboolean out)
+{
+	uint8_t *p;
+	ssize_t ret;
+
+	p = buf;
+	while (len) {
+		ret = out ? write(fd, p, len) : read(fd, p, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return FALSE;
+		p += ret;
+		len -= ret;
+	}
+
+	return TRUE;
+}
+
+static gboolean standin_recv(int fd, struct request *req)
+{
+	size_t length;
+
+	if (!standin_io(fd, req->header, sizeof(req->header), FALSE))
+		return FALSE;
+	length = (req->header[4] << 8) | req->header[5];
+	if (length < 2 || length - 1 > sizeof(req->pdu))
+		return FALSE;
+	req->pdu_len = length - 1;
+
+	return standin_io(fd, req->pdu, req->pdu_len, FALSE);
+}
+
+static gboolean standin_readable(int fd, int timeout_ms)
+{
+	struct pollfd pfd;
+	int ret;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	do {
+		ret = poll(&pfd, 1, timeout_ms);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret > 0;
+}
+
+static unsigned int req_u16(const struct request *req, size_t offset)
+{
+	return (req->pdu[offset] << 8) | req->pdu[offset + 1];
+}
+
+static gboolean standin_is_read(const struct request *req,
+	unsigned int address, unsigned int count)
+{
+	return req->pdu_len == 5 && req->pdu[0] == 0x03
+		&& req_u16(req, 1) == address && req_u16(req, 3) == count;
+}
+
+static gboolean standin_reply(struct standin *si, int fd,
+	const struct request *req)
+{
+	uint8_t adu[7 + 256];
+	size_t len, idx;
+	unsigned int address, count;
+
+	memcpy(adu, req->header, 7);
+	len = 7;
+	address = req->pdu_len >= 5 ? req_u16(req, 1) : 0;
+	count = req->pdu_len >= 5 ? req_u16(req, 3) : 0;
+	switch (req->pdu_len >= 5 ? req->pdu[0] : 0) {
+	case 0x03:
+		si->requests++;
+		/* Reads of the state registers which the plan didn't merge. */
+		if (address < STATE_ADDRESS + STATE_COUNT
+				&& (address != STATE_ADDRESS || count != STATE_COUNT))
+			si->uncoalesced++;
+		if (!count || count > 125 || address + count > NUM_REGISTERS)
+			goto exception;
+		adu[len++] = 0x03;
+		adu[len++] = 2 * count;
+		for (idx = 0; idx < count; idx++) {
+			adu[len++] = si->registers[address + idx] >> 8;
+			adu[len++] = si->registers[address + idx] & 0xff;
+		}
+		break;
+	case 0x10:
+		if (!count || count > 123 || address + count > NUM_REGISTERS
+				|| req->pdu_len != 6 + 2 * count)
+			goto exception;
+		for (idx = 0; idx < count; idx++)
+			si->registers[address + idx] =
+				req_u16(req, 6 + 2 * idx);
+		memcpy(adu + len, req->pdu, 5);
+		len += 5;
+		break;
+	default:
+		goto exception;
+	}
+
+send:
+	adu[4] = (len - 6) >> 8;
+	adu[5] = (len - 6) & 0xff;
+
+	return standin_io(fd, adu, len, TRUE);
+
+exception:
+	/* Illegal function (or data), as far as the driver is concerned. */
+	len = 7;
+	adu[len++] = req->pdu[0] | 0x80;
+	adu[len++] = 0x01;
+	goto send;
+}
+
+/* Serve the host until the connection closes. */
+static void standin_serve(struct standin *si, int fd)
+{
+	struct request first, second;
+	gboolean have_second;
+
+	while (!g_atomic_int_get(&si->quit)) {
+		if (!standin_recv(fd, &first))
+			return;
+		if (!standin_is_read(&first, STATE_ADDRESS, STATE_COUNT)) {
+			if (!standin_reply(si, fd, &first))
+				return;
+			continue;
+		}
+
+		/* A polling cycle starts, its second request should follow. */
+		si->cycles++;
+		have_second = standin_readable(fd, PIPELINE_WAIT_MS);
+		if (have_second && !standin_recv(fd, &second))
+			return;
+		if (have_second && standin_is_read(&second,
+				THRESHOLD_ADDRESS, THRESHOLD_COUNT))
+			si->pipelined++;
+		if (si->cycles == si->stall_cycle)
+			g_usleep(STALL_MS * 1000);
+		if (!standin_reply(si, fd, &first))
+			return;
+		if (have_second && !standin_reply(si, fd, &second))
+			return;
+	}
+}
+
+static gpointer standin_thread(gpointer data)
+{
+	struct standin *si;
+	int fd;
+
+	si = data;
+	while (!g_atomic_int_get(&si->quit)) {
+		fd = accept(si->listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		standin_serve(si, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static gboolean standin_start(struct standin *si)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	int fd;
+
+	/* DPS5005 at 5 V and 1 A, delivering 0.25 A. */
+	si->registers[0x00] = 500;
+	si->registers[0x01] = 1000;
+	si->registers[0x02] = 499;
+	si->registers[0x03] = 250;
+	si->registers[0x04] = 124;
+	si->registers[0x05] = 1200;
+	si->registers[0x09] = 1;
+	si->registers[0x0b] = DPS_MODEL;
+	si->registers[0x0c] = DPS_VERSION;
+	si->registers[0x52] = 5200;
+	si->registers[0x53] = 5100;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr_len = sizeof(addr);
+	if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+			|| listen(fd, 1)
+			|| getsockname(fd, (struct sockaddr *)&addr, &addr_len)) {
+		perror("Cannot create socket");
+		return FALSE;
+	}
+	si->listen_fd = fd;
+	si->conn = g_strdup_printf("tcp/127.0.0.1/%u", ntohs(addr.sin_port));
+	si->thread = g_thread_new("modbus-standin", standin_thread, si);
+
+	return TRUE;
+}
+
+static void standin_stop(struct standin *si)
+{
+	g_atomic_int_set(&si->quit, 1);
+	shutdown(si->listen_fd, SHUT_RDWR);
+	close(si->listen_fd);
+	g_thread_join(si->thread);
+	g_free(si->conn);
+}
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	uint64_t *frames;
+
+	(void)sdi;
+
+	frames = cb_data;
+	if (packet->type == OTC_DF_FRAME_BEGIN)
+		(*frames)++;
+}
+
+static int bench_run(struct otc_context *ctx, struct otc_dev_driver *driver,
+	const char *conn, uint64_t limit, uint64_t *frames)
+{
+	struct otc_config src;
+	struct otc_dev_inst *sdi;
+	struct otc_session *session;
+	GSList *options, *devices;
+	int ret;
+
+	src.key = OTC_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, &src);
+	devices = otc_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	if (!devices) {
+		fprintf(stderr, "No device found at %s.\n", conn);
+		return OTC_ERR;
+	}
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = otc_dev_open(sdi);
+	if (ret != OTC_OK)
+		return ret;
+	ret = otc_config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(limit));
+	if (ret != OTC_OK)
+		goto out_close;
+
+	ret = otc_session_new(ctx, &session);
+	if (ret != OTC_OK)
+		goto out_close;
+	otc_session_dev_add(session, sdi);
+	otc_session_datafeed_callback_add(session, bench_datafeed, frames);
+	ret = otc_session_start(session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(session);
+	otc_session_destroy(session);
+
+out_close:
+	otc_dev_close(sdi);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers, *driver;
+	struct standin si;
+	uint64_t limit, frames;
+	clock_t cpu_start;
+	gint64 wall_start;
+	double wall_time, cpu_time;
+	unsigned int idx;
+	int loglevel, opt, ret, failed;
+
+	memset(&si, 0, sizeof(si));
+	limit = 20;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:s:l:")) != -1) {
+		switch (opt) {
+		case 'n':
+			limit = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			si.stall_cycle = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !limit)
+		goto usage;
+	otc_log_loglevel_set(loglevel);
+
+	ret = otc_init(&ctx);
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = NULL;
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, "rdtech-dps"))
+			driver = drivers[idx];
+	}
+	if (!driver) {
+		fprintf(stderr, "Driver rdtech-dps not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, driver) != OTC_OK || !standin_start(&si)) {
+		otc_exit(ctx);
+		return 1;
+	}
+
+	frames = 0;
+	wall_start = g_get_monotonic_time();
+	cpu_start = clock();
+	ret = bench_run(ctx, driver, si.conn, limit, &frames);
+	cpu_time = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+	wall_time = (g_get_monotonic_time() - wall_start) / 1e6;
+
+	/* Closes the device's connection, which ends the stand-in's. */
+	otc_exit(ctx);
+	standin_stop(&si);
+
+	failed = 0;
+	if (ret != OTC_OK || frames < limit) {
+		fprintf(stderr, "Acquisition failed (%" PRIu64 " of %" PRIu64
+			" samples).\n", frames, limit);
+		failed = 1;
+	}
+	if (si.pipelined != si.cycles) {
+		fprintf(stderr, "%u of %u polling cycles not pipelined.\n",
+			si.cycles - si.pipelined, si.cycles);
+		failed = 1;
+	}
+	if (si.uncoalesced) {
+		fprintf(stderr, "%u reads of state registers not coalesced.\n",
+			si.uncoalesced);
+		failed = 1;
+	}
+	if (si.stall_cycle && si.cycles <= si.stall_cycle) {
+		fprintf(stderr, "No retry after the stalled cycle.\n");
+		failed = 1;
+	}
+	if (si.stall_cycle && cpu_time > STALL_MS / 2 / 1e3) {
+		fprintf(stderr, "Used %.3f s CPU time while waiting.\n",
+			cpu_time);
+		failed = 1;
+	}
+
+	printf("modbus-tcp %6" PRIu64 " samples %4u cycles %5u reads "
+		"%8.3f s %8.3f s CPU\n", frames, si.cycles, si.requests,
+		wall_time, cpu_time);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n samples] [-s cycle] [-l loglevel]\n",
+		argv[0]);
+	return 2;
+}
@@ -0,0 +1,715 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Readout benchmark of the openbench-logic-sniffer driver. A thread
+ * plays a SUMP compatible device: it answers the identification and
+ * metadata queries, takes the capture setup, and upon arming sends its
+ * sample memory, newest sample first, as fast as the driver reads it.
+ * The bench reports the rate at which samples arrive in the session
+ * feed, and checks them against the capture which the device sent.
+ *
+ *   otc-ols-bench [-n <samples>] [-c <channels>] [-g <group mask>] [-r]
+ *                 [-p <pattern>] [-P] [-l <loglevel>]
+ *
+ * The device has 8, 16, 24 or 32 channels. -g enables a subset of the
+ * channel groups (8 channels each), the device then leaves out the
+ * disabled groups' bytes. -r enables RLE mode, where runs are sent as
+ * a count followed by the value. Patterns are 'toggle' (a new value on
+ * every sample), 'mixed' (random values and run lengths), and 'slow'
+ * (runs of thousands of samples).
+ *
+ * The device talks through a TCP socket (the 'tcp-raw' serial transport)
+ * by default. The -P option uses a pseudo terminal instead, which needs
+ * a libserialport that accepts them: on Linux it only opens ports with
+ * a sysfs entry.
+ */
+
+/* For posix_openpt() and cfmakeraw(). */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+#define DEFAULT_SAMPLES	(4 * 1000 * 1000)
+#define STREAM_CHUNK	4096
+
+/* The SUMP commands which the device implements. */
+#define CMD_RESET		0x00
+#define CMD_ARM			0x01
+#define CMD_ID			0x02
+#define CMD_METADATA		0x04
+#define CMD_CAPTURE_SIZE	0x81
+#define CMD_SET_FLAGS		0x82
+#define CMD_CAPTURE_READCOUNT	0x84
+
+#define FLAG_RLE		(1 << 8)
+#define FLAG_GROUPS_SHIFT	2
+
+enum fw_pattern {
+	PATTERN_TOGGLE,
+	PATTERN_MIXED,
+	PATTERN_SLOW,
+};
+
+/* The fake device, and the capture which the session should receive. */
+struct ols_fw {
+	unsigned int channels;
+	size_t unitsize;
+	enum fw_pattern pattern;
+	uint64_t limit;
+	uint32_t max_samples;
+	uint32_t flags;
+	uint32_t readcount;
+	GRand *rand;
+	uint32_t value;
+	uint8_t *expect;
+	uint64_t sent_samples;
+	int listen_fd;
+	int pty_fd;
+	GThread *thread;
+	volatile gint quit;
+};
+
+struct bench_result {
+	uint64_t samples;
+	double wall_time;
+	double cpu_time;
+	GChecksum *logic_sum;
+};
+
+static gboolean fw_write(int fd, const void *buf, size_t count)
+{
+	const uint8_t *p;
+	ssize_t ret;
+
+	p = buf;
+	while (count) {
+		ret = write(fd, p, count);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return FALSE;
+		p += ret;
+		count -= ret;
+	}
+
+	return TRUE;
+}
+
+static gboolean fw_read(int fd, void *buf, size_t count)
+{
+	uint8_t *p;
+	ssize_t ret;
+
+	p = buf;
+	while (count) {
+		ret = read(fd, p, count);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return FALSE;
+		p += ret;
+		count -= ret;
+	}
+
+	return TRUE;
+}
+
+static gboolean fw_group_enabled(const struct ols_fw *fw, unsigned int group)
+{
+	if (group >= fw->channels / 8)
+		return FALSE;
+
+	return !(fw->flags & (1 << (FLAG_GROUPS_SHIFT + group)));
+}
+
+/* The bits of a sample which the device captures. */
+static uint32_t fw_value_mask(const struct ols_fw *fw)
+{
+	uint32_t mask;
+	unsigned int group, top;
+
+	mask = 0;
+	top = 0;
+	for (group = 0; group < 4; group++) {
+		if (!fw_group_enabled(fw, group))
+			continue;
+		mask |= 0xffUL << (8 * group);
+		top = group;
+	}
+	/* RLE mode takes the highest bit for the count flag. */
+	if (fw->flags & FLAG_RLE)
+		mask &= ~(0x80UL << (8 * top));
+
+	return mask;
+}
+
+/* Sent bytes per sample, those of the enabled channel groups. */
+static size_t fw_sample_bytes(const struct ols_fw *fw)
+{
+	size_t count;
+	unsigned int group;
+
+	count = 0;
+	for (group = 0; group < 4; group++) {
+		if (fw_group_enabled(fw, group))
+			count++;
+	}
+
+	return count;
+}
+
+/* A value's bytes, enabled groups only, lowest group first. */
+static size_t fw_encode_value(const struct ols_fw *fw, uint8_t *buf,
+	uint32_t value)
+{
+	size_t len;
+	unsigned int group;
+
+	len = 0;
+	for (group = 0; group < 4; group++) {
+		if (fw_group_enabled(fw, group))
+			buf[len++] = value >> (8 * group);
+	}
+
+	return len;
+}
+
+/* A count's bytes, with the count flag in the last byte's high bit. */
+static size_t fw_encode_count(const struct ols_fw *fw, uint8_t *buf,
+	uint32_t count)
+{
+	size_t len, idx;
+
+	len = fw_sample_bytes(fw);
+	for (idx = 0; idx < len; idx++)
+		buf[idx] = count >> (8 * idx);
+	buf[len - 1] |= 0x80;
+
+	return len;
+}
+
+/* Note a run which ends at sample 'end' (exclusive) in the expectation. */
+static void fw_expect(struct ols_fw *fw, uint64_t total, uint64_t end,
+	uint32_t value, uint64_t count)
+{
+	uint64_t first, idx;
+	uint8_t *p;
+	size_t byte;
+
+	/* The session only gets the newest 'limit' samples. */
+	first = total - fw->limit;
+	if (end <= first)
+		return;
+	if (end - count < first)
+		count = end - first;
+	p = fw->expect + (end - count - first) * fw->unitsize;
+	for (idx = 0; idx < count; idx++) {
+		for (byte = 0; byte < fw->unitsize; byte++)
+			*p++ = value >> (8 * byte);
+	}
+}
+
+/* Pick the next run, going back in time. */
+static uint32_t fw_next_run(struct ols_fw *fw, uint64_t *count)
+{
+	uint32_t r;
+
+	switch (fw->pattern) {
+	case PATTERN_TOGGLE:
+		*count = 1;
+		fw->value++;
+		break;
+	case PATTERN_MIXED:
+		r = g_rand_int(fw->rand);
+		*count = (r & 0x300) ? 1 + (r & 7) : 1 + (r & 0x3ff);
+		fw->value = g_rand_int(fw->rand);
+		break;
+	case PATTERN_SLOW:
+		*count = 4000;
+		fw->value++;
+		break;
+	}
+
+	return fw->value & fw_value_mask(fw);
+}
+
+/*
+ * Send the sample memory, newest sample first. In RLE mode a count of
+ * repetitions precedes the value, as seen in reverse order.
+ */
+static void fw_stream(struct ols_fw *fw, int fd)
+{
+	uint8_t buf[STREAM_CHUNK + 16];
+	uint64_t total, remain, count, chunk, max_count;
+	uint32_t value;
+	size_t fill, len;
+
+	total = (uint64_t)fw->readcount * 4;
+	len = fw_sample_bytes(fw);
+	max_count = (1ULL << (8 * len - 1)) - 1;
+	fill = 0;
+	remain = total;
+	while (remain) {
+		value = fw_next_run(fw, &count);
+		count = MIN(count, remain);
+		fw_expect(fw, total, remain, value, count);
+		remain -= count;
+		while (count) {
+			if (fill + 2 * len > STREAM_CHUNK) {
+				if (!fw_write(fd, buf, fill))
+					return;
+				fill = 0;
+			}
+			if ((fw->flags & FLAG_RLE) && count > 1) {
+				chunk = MIN(count, max_count + 1);
+				fill += fw_encode_count(fw, &buf[fill], chunk - 1);
+			} else {
+				chunk = 1;
+			}
+			fill += fw_encode_value(fw, &buf[fill], value);
+			count -= chunk;
+		}
+	}
+	fw_write(fd, buf, fill);
+	fw->sent_samples = total;
+}
+
+/* A metadata token with a 32 bit big endian value. */
+static size_t fw_token_u32(uint8_t *buf, uint8_t key, uint32_t value)
+{
+	buf[0] = key;
+	buf[1] = value >> 24;
+	buf[2] = value >> 16;
+	buf[3] = value >> 8;
+	buf[4] = value;
+
+	return 5;
+}
+
+static void fw_metadata(struct ols_fw *fw, int fd)
+{
+	uint8_t buf[64];
+	size_t len;
+
+	len = 0;
+	buf[len++] = 0x01;
+	memcpy(&buf[len], "Bench OLS", 10);
+	len += 10;
+	len += fw_token_u32(&buf[len], 0x20, fw->channels);
+	len += fw_token_u32(&buf[len], 0x21, fw->max_samples);
+	len += fw_token_u32(&buf[len], 0x23, OTC_MHZ(200));
+	buf[len++] = 0x41;
+	buf[len++] = 2;
+	buf[len++] = 0x00;
+	fw_write(fd, buf, len);
+}
+
+/* Serve the host until the connection closes. */
+static void fw_serve(struct ols_fw *fw, int fd)
+{
+	uint8_t cmd, arg[4];
+	uint32_t data;
+	ssize_t ret;
+
+	while (!g_atomic_int_get(&fw->quit)) {
+		ret = read(fd, &cmd, 1);
+		if (ret == 0)
+			return;
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0 && errno == EIO) {
+			/* Nobody has the pseudo terminal open. */
+			g_usleep(10 * 1000);
+			continue;
+		}
+		if (ret < 0)
+			return;
+
+		/* Long commands carry 4 bytes of little endian data. */
+		if ((cmd & 0x80) && !fw_read(fd, arg, sizeof(arg)))
+			return;
+		data = arg[0] | (arg[1] << 8) | (arg[2] << 16)
+			| ((uint32_t)arg[3] << 24);
+
+		switch (cmd) {
+		case CMD_ID:
+			fw_write(fd, "1ALS", 4);
+			break;
+		case CMD_METADATA:
+			fw_metadata(fw, fd);
+			break;
+		case CMD_CAPTURE_SIZE:
+			fw->readcount = (data & 0xffff) + 1;
+			break;
+		case CMD_CAPTURE_READCOUNT:
+			fw->readcount = data + 1;
+			break;
+		case CMD_SET_FLAGS:
+			fw->flags = data;
+			break;
+		case CMD_ARM:
+			fw_stream(fw, fd);
+			break;
+		default:
+			/* Reset, divider, trigger setup, delay count. */
+			break;
+		}
+	}
+}
+
+static gpointer fw_thread(gpointer data)
+{
+	struct ols_fw *fw;
+	int fd;
+
+	fw = data;
+	if (fw->pty_fd >= 0) {
+		fw_serve(fw, fw->pty_fd);
+		return NULL;
+	}
+
+	/* The driver connects once to scan, and once per acquisition. */
+	while (!g_atomic_int_get(&fw->quit)) {
+		fd = accept(fw->listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		fw_serve(fw, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/* Start the device, and get the driver's connection string. */
+static char *fw_start(struct ols_fw *fw, gboolean use_pty)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	struct termios tio;
+	char *conn;
+	int fd;
+
+	fw->listen_fd = fw->pty_fd = -1;
+	if (use_pty) {
+		fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (fd < 0 || grantpt(fd) || unlockpt(fd)
+				|| tcgetattr(fd, &tio)) {
+			perror("Cannot create pseudo terminal");
+			return NULL;
+		}
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+		fw->pty_fd = fd;
+		conn = g_strdup(ptsname(fd));
+	} else {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr_len = sizeof(addr);
+		if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+				|| listen(fd, 1)
+				|| getsockname(fd, (struct sockaddr *)&addr, &addr_len)) {
+			perror("Cannot create socket");
+			return NULL;
+		}
+		fw->listen_fd = fd;
+		conn = g_strdup_printf("tcp-raw/127.0.0.1/%u",
+			ntohs(addr.sin_port));
+	}
+	fw->thread = g_thread_new("ols-fw", fw_thread, fw);
+
+	return conn;
+}
+
+static void fw_stop(struct ols_fw *fw)
+{
+	g_atomic_int_set(&fw->quit, 1);
+	if (fw->listen_fd >= 0) {
+		shutdown(fw->listen_fd, SHUT_RDWR);
+		close(fw->listen_fd);
+	}
+	if (fw->pty_fd >= 0)
+		close(fw->pty_fd);
+	g_thread_join(fw->thread);
+}
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench_result *result;
+	const struct otc_datafeed_logic *logic;
+
+	(void)sdi;
+
+	result = cb_data;
+	if (packet->type != OTC_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	if (logic->unitsize)
+		result->samples += logic->length / logic->unitsize;
+	g_checksum_update(result->logic_sum, logic->data, logic->length);
+}
+
+static struct otc_dev_driver *bench_driver_find(struct otc_context *ctx,
+	const char *name)
+{
+	struct otc_dev_driver **drivers;
+	size_t idx;
+
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, name))
+			return drivers[idx];
+	}
+
+	return NULL;
+}
+
+/* Disable the channels of the groups which are not in the mask. */
+static void bench_channels_enable(struct otc_dev_inst *sdi,
+	unsigned int group_mask)
+{
+	struct otc_channel *ch;
+	GSList *l;
+
+	for (l = otc_dev_inst_channels_get(sdi); l; l = l->next) {
+		ch = l->data;
+		otc_dev_channel_enable(ch, (group_mask >> (ch->index / 8)) & 1);
+	}
+}
+
+static int bench_run(struct otc_context *ctx, struct otc_dev_driver *driver,
+	const char *conn, uint64_t limit, unsigned int group_mask,
+	gboolean rle, struct bench_result *result)
+{
+	struct otc_dev_inst *sdi;
+	struct otc_session *session;
+	struct otc_config *src;
+	GSList *options, *devices;
+	clock_t cpu_start;
+	gint64 wall_start;
+	int ret;
+
+	src = g_malloc(sizeof(*src));
+	src->key = OTC_CONF_CONN;
+	src->data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, src);
+	devices = otc_driver_scan(driver, options);
+	g_variant_unref(src->data);
+	g_free(src);
+	g_slist_free(options);
+	if (!devices) {
+		fprintf(stderr, "No device found at %s.\n", conn);
+		return OTC_ERR_NA;
+	}
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = otc_dev_open(sdi);
+	if (ret != OTC_OK)
+		return ret;
+	bench_channels_enable(sdi, group_mask);
+	ret = otc_config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(limit));
+	if (ret == OTC_OK)
+		ret = otc_config_set(sdi, NULL, OTC_CONF_RLE,
+			g_variant_new_boolean(rle));
+	if (ret != OTC_OK)
+		goto out_close;
+
+	ret = otc_session_new(ctx, &session);
+	if (ret != OTC_OK)
+		goto out_close;
+	otc_session_dev_add(session, sdi);
+	otc_session_datafeed_callback_add(session, bench_datafeed, result);
+
+	wall_start = g_get_monotonic_time();
+	cpu_start = clock();
+	ret = otc_session_start(session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(session);
+	result->cpu_time = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+	result->wall_time = (g_get_monotonic_time() - wall_start) / 1e6;
+
+	otc_session_destroy(session);
+out_close:
+	otc_dev_close(sdi);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *pattern_names[] = { "toggle", "mixed", "slow" };
+	struct otc_context *ctx;
+	struct otc_dev_driver *driver;
+	struct bench_result result;
+	struct ols_fw fw;
+	GChecksum *expect_sum;
+	const char *expect;
+	char *conn;
+	uint64_t limit;
+	unsigned int group_mask;
+	gboolean use_pty, rle;
+	int loglevel, opt, ret, failed;
+	unsigned int idx;
+
+	memset(&fw, 0, sizeof(fw));
+	fw.channels = 32;
+	fw.pattern = PATTERN_MIXED;
+	limit = DEFAULT_SAMPLES;
+	group_mask = 0;
+	use_pty = rle = FALSE;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:c:g:rp:Pl:")) != -1) {
+		switch (opt) {
+		case 'n':
+			limit = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'c':
+			fw.channels = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'g':
+			group_mask = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'r':
+			rle = TRUE;
+			break;
+		case 'p':
+			for (idx = 0; idx < G_N_ELEMENTS(pattern_names); idx++) {
+				if (!strcmp(optarg, pattern_names[idx]))
+					break;
+			}
+			if (idx == G_N_ELEMENTS(pattern_names))
+				goto usage;
+			fw.pattern = idx;
+			break;
+		case 'P':
+			use_pty = TRUE;
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (!group_mask)
+		group_mask = (1 << (fw.channels / 8)) - 1;
+	/* The device sends whole sample memory lines of 4 samples. */
+	if (optind != argc || !limit || limit % 4 || limit > UINT32_MAX / 4)
+		goto usage;
+	if (fw.channels % 8 || !fw.channels || fw.channels > 32
+			|| !group_mask || group_mask >> (fw.channels / 8))
+		goto usage;
+	fw.unitsize = fw.channels / 8;
+	fw.limit = limit;
+	/* Enough memory to capture 'limit' samples on all channels. */
+	fw.max_samples = MAX(limit * 4, 512 * 1024);
+	fw.rand = g_rand_new_with_seed(1);
+	fw.expect = g_malloc0(limit * fw.unitsize);
+	otc_log_loglevel_set(loglevel);
+
+	ret = otc_init(&ctx);
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = bench_driver_find(ctx, "ols");
+	if (!driver) {
+		fprintf(stderr, "Driver ols not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	conn = NULL;
+	ret = otc_driver_init(ctx, driver);
+	if (ret == OTC_OK) {
+		conn = fw_start(&fw, use_pty);
+		if (!conn)
+			ret = OTC_ERR_IO;
+	}
+
+	memset(&result, 0, sizeof(result));
+	result.logic_sum = g_checksum_new(G_CHECKSUM_SHA256);
+	if (ret == OTC_OK)
+		ret = bench_run(ctx, driver, conn, limit, group_mask, rle,
+			&result);
+	/* Closes the device's connection, which ends the device thread. */
+	otc_exit(ctx);
+	if (conn)
+		fw_stop(&fw);
+
+	failed = 0;
+	expect_sum = g_checksum_new(G_CHECKSUM_SHA256);
+	g_checksum_update(expect_sum, fw.expect, limit * fw.unitsize);
+	expect = g_checksum_get_string(expect_sum);
+	if (ret != OTC_OK || result.samples != limit
+			|| fw.sent_samples != limit) {
+		fprintf(stderr, "Acquisition failed (%" PRIu64 " of %" PRIu64
+			" samples, %" PRIu64 " sent).\n", result.samples, limit,
+			fw.sent_samples);
+		failed = 1;
+	} else if (strcmp(g_checksum_get_string(result.logic_sum), expect)) {
+		fprintf(stderr, "Sample data mismatch, got %s, expected %s.\n",
+			g_checksum_get_string(result.logic_sum), expect);
+		failed = 1;
+	} else {
+		printf("ols %2uch groups 0x%x %-3s %-6s %10" PRIu64 " samples "
+			"%8.3f s %9.2f Msamples/s %8.3f s CPU (%5.1f%%)\n",
+			fw.channels, group_mask, rle ? "rle" : "raw",
+			pattern_names[fw.pattern], result.samples,
+			result.wall_time, result.samples / result.wall_time / 1e6,
+			result.cpu_time,
+			100.0 * result.cpu_time / result.wall_time);
+	}
+
+	g_checksum_free(result.logic_sum);
+	g_checksum_free(expect_sum);
+	g_rand_free(fw.rand);
+	g_free(fw.expect);
+	g_free(conn);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n samples] [-c channels] [-g group_mask] "
+		"[-r] [-p toggle|mixed|slow] [-P] [-l loglevel]\n", argv[0]);
+	return 2;
+}
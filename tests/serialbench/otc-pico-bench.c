@@ -0,0 +1,571 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Decoding benchmark of the raspberrypi-pico driver. A thread plays the
+ * device firmware: it answers the driver's configuration commands, and
+ * streams run-length coded samples as fast as the driver reads them.
+ * The bench reports the rate at which samples arrive in the session
+ * feed, and checks them against the firmware's own expansion of the
+ * stream.
+ *
+ *   otc-pico-bench [-n <samples>] [-c <channels>] [-p <pattern>] [-P]
+ *                  [-l <loglevel>]
+ *
+ * Up to 4 channels use the firmware's D4 encoding, more channels the
+ * generic slice encoding. Patterns are 'toggle' (a new value on every
+ * sample), 'mixed' (random values and run lengths), and 'slow' (runs of
+ * thousands of samples).
+ *
+ * The firmware talks through a TCP socket (the 'tcp-raw' serial
+ * transport) by default. The -P option uses a pseudo terminal instead,
+ * which needs a libserialport that accepts them: on Linux it only opens
+ * ports with a sysfs entry.
+ */
+
+/* For posix_openpt() and cfmakeraw(). */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <opentracecapture/libopentracecapture.h>
+
+#define DEFAULT_SAMPLES	(10 * 1000 * 1000)
+#define STREAM_CHUNK	4096
+
+enum fw_pattern {
+	PATTERN_TOGGLE,
+	PATTERN_MIXED,
+	PATTERN_SLOW,
+};
+
+/* The fake firmware, and its expectation of the session's samples. */
+struct pico_fw {
+	unsigned int channels;
+	size_t unitsize;
+	enum fw_pattern pattern;
+	uint64_t limit;
+	GRand *rand;
+	uint32_t value;
+	uint64_t expect_samples;
+	GChecksum *expect_sum;
+	uint8_t expect_buf[STREAM_CHUNK];
+	int listen_fd;
+	int pty_fd;
+	GThread *thread;
+	volatile gint quit;
+};
+
+struct bench_result {
+	uint64_t samples;
+	double wall_time;
+	double cpu_time;
+	GChecksum *logic_sum;
+};
+
+static gboolean fw_write(int fd, const void *buf, size_t count)
+{
+	const uint8_t *p;
+	ssize_t ret;
+
+	p = buf;
+	while (count) {
+		ret = write(fd, p, count);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return FALSE;
+		p += ret;
+		count -= ret;
+	}
+
+	return TRUE;
+}
+
+/* Expand a run into the expected samples, up to the sample limit. */
+static void fw_expect(struct pico_fw *fw, uint32_t value, uint64_t count)
+{
+	size_t idx, chunk, per_chunk;
+
+	if (count > fw->limit - fw->expect_samples)
+		count = fw->limit - fw->expect_samples;
+	fw->expect_samples += count;
+
+	per_chunk = sizeof(fw->expect_buf) / fw->unitsize;
+	chunk = MIN(count, per_chunk);
+	for (idx = 0; idx < chunk * fw->unitsize; idx++)
+		fw->expect_buf[idx] = value >> (8 * (idx % fw->unitsize));
+	while (count) {
+		chunk = MIN(count, per_chunk);
+		g_checksum_update(fw->expect_sum, fw->expect_buf,
+			chunk * fw->unitsize);
+		count -= chunk;
+	}
+}
+
+/* A run-length only byte, which repeats the previous value. */
+static size_t fw_encode_rle(struct pico_fw *fw, uint8_t *buf, uint8_t code)
+{
+	uint64_t count;
+
+	if (fw->channels <= 4)
+		count = (code - 47) * 8;
+	else if (code <= 79)
+		count = code - 47;
+	else
+		count = (code - 78) * 32;
+	fw_expect(fw, fw->value, count);
+	buf[0] = code;
+
+	return 1;
+}
+
+/* A sample, in D4 mode with up to 7 repetitions of the previous value. */
+static size_t fw_encode_sample(struct pico_fw *fw, uint8_t *buf,
+	uint32_t value, unsigned int repeat)
+{
+	size_t len;
+	unsigned int bit;
+
+	value &= (1ULL << fw->channels) - 1;
+	len = 0;
+	if (fw->channels <= 4) {
+		fw_expect(fw, fw->value, repeat);
+		buf[len++] = 0x80 | (repeat << 4) | value;
+	} else {
+		for (bit = 0; bit < fw->channels; bit += 7)
+			buf[len++] = 0x80 | ((value >> bit) & 0x7f);
+	}
+	fw->value = value;
+	fw_expect(fw, value, 1);
+
+	return len;
+}
+
+/* Encode the next piece of the pattern, at most 8 bytes. */
+static size_t fw_encode(struct pico_fw *fw, uint8_t *buf)
+{
+	uint32_t r;
+	size_t len, idx;
+
+	len = 0;
+	switch (fw->pattern) {
+	case PATTERN_TOGGLE:
+		len += fw_encode_sample(fw, buf, fw->value + 1, 0);
+		break;
+	case PATTERN_MIXED:
+		r = g_rand_int(fw->rand);
+		for (idx = 0; idx < (r & 3); idx++)
+			len += fw_encode_rle(fw, &buf[len],
+				48 + ((r >> (8 + 5 * idx)) & 0x1f));
+		len += fw_encode_sample(fw, &buf[len], g_rand_int(fw->rand),
+			fw->channels <= 4 ? (r >> 2) & 7 : 0);
+		break;
+	case PATTERN_SLOW:
+		for (idx = 0; idx < 4; idx++)
+			len += fw_encode_rle(fw, &buf[len], 127);
+		len += fw_encode_sample(fw, &buf[len], fw->value + 1, 0);
+		break;
+	}
+
+	return len;
+}
+
+/* Stream samples until the limit is reached, or the host sends '+'. */
+static void fw_stream(struct pico_fw *fw, int fd)
+{
+	uint8_t buf[STREAM_CHUNK + 16];
+	struct pollfd pfd;
+	uint64_t byte_cnt;
+	size_t fill;
+	char c, *end;
+
+	byte_cnt = 0;
+	while (fw->expect_samples < fw->limit) {
+		fill = 0;
+		while (fill < STREAM_CHUNK && fw->expect_samples < fw->limit)
+			fill += fw_encode(fw, &buf[fill]);
+		if (!fw_write(fd, buf, fill))
+			return;
+		byte_cnt += fill;
+
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 0) == 1 && read(fd, &c, 1) == 1 && c == '+')
+			break;
+	}
+
+	end = g_strdup_printf("$%" PRIu64 "+", byte_cnt);
+	fw_write(fd, end, strlen(end));
+	g_free(end);
+}
+
+static void fw_command(struct pico_fw *fw, int fd, const char *line)
+{
+	char *id;
+
+	switch (line[0]) {
+	case 'i':
+		/* 0 analog channels, 1 byte each, the digital channels,
+		 * protocol version 2. */
+		id = g_strdup_printf("SRPICO,A001D%02u,02", fw->channels);
+		fw_write(fd, id, strlen(id));
+		g_free(id);
+		break;
+	case 'L':
+		fw->limit = g_ascii_strtoull(&line[1], NULL, 10);
+		fw_write(fd, "*", 1);
+		break;
+	case 'F':
+	case 'C':
+		fw_stream(fw, fd);
+		break;
+	default:
+		/* Channel enables, sample rate, trigger setup. */
+		fw_write(fd, "*", 1);
+		break;
+	}
+}
+
+/* Serve the host until the connection closes. */
+static void fw_serve(struct pico_fw *fw, int fd)
+{
+	char line[64], c;
+	size_t len;
+	ssize_t ret;
+
+	len = 0;
+	while (!g_atomic_int_get(&fw->quit)) {
+		ret = read(fd, &c, 1);
+		if (ret == 0)
+			return;
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0 && errno == EIO) {
+			/* Nobody has the pseudo terminal open. */
+			g_usleep(10 * 1000);
+			continue;
+		}
+		if (ret < 0)
+			return;
+
+		if (c == '*') {
+			/* Reset, which also ends a stream. */
+			len = 0;
+		} else if (c == '+') {
+			/* Stop, when idle there is nothing to stop. */
+		} else if (c != '\n') {
+			if (len < sizeof(line) - 1)
+				line[len++] = c;
+		} else {
+			line[len] = '\0';
+			len = 0;
+			fw_command(fw, fd, line);
+		}
+	}
+}
+
+static gpointer fw_thread(gpointer data)
+{
+	struct pico_fw *fw;
+	int fd;
+
+	fw = data;
+	if (fw->pty_fd >= 0) {
+		fw_serve(fw, fw->pty_fd);
+		return NULL;
+	}
+
+	/* The driver connects once to scan, and once per acquisition. */
+	while (!g_atomic_int_get(&fw->quit)) {
+		fd = accept(fw->listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		fw_serve(fw, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/* Start the firmware, and get the driver's connection string. */
+static char *fw_start(struct pico_fw *fw, gboolean use_pty)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	struct termios tio;
+	char *conn;
+	int fd;
+
+	fw->listen_fd = fw->pty_fd = -1;
+	if (use_pty) {
+		fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (fd < 0 || grantpt(fd) || unlockpt(fd)
+				|| tcgetattr(fd, &tio)) {
+			perror("Cannot create pseudo terminal");
+			return NULL;
+		}
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+		fw->pty_fd = fd;
+		conn = g_strdup(ptsname(fd));
+	} else {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr_len = sizeof(addr);
+		if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+				|| listen(fd, 1)
+				|| getsockname(fd, (struct sockaddr *)&addr, &addr_len)) {
+			perror("Cannot create socket");
+			return NULL;
+		}
+		fw->listen_fd = fd;
+		conn = g_strdup_printf("tcp-raw/127.0.0.1/%u",
+			ntohs(addr.sin_port));
+	}
+	fw->thread = g_thread_new("pico-fw", fw_thread, fw);
+
+	return conn;
+}
+
+static void fw_stop(struct pico_fw *fw)
+{
+	g_atomic_int_set(&fw->quit, 1);
+	if (fw->listen_fd >= 0) {
+		shutdown(fw->listen_fd, SHUT_RDWR);
+		close(fw->listen_fd);
+	}
+	if (fw->pty_fd >= 0)
+		close(fw->pty_fd);
+	g_thread_join(fw->thread);
+}
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench_result *result;
+	const struct otc_datafeed_logic *logic;
+
+	(void)sdi;
+
+	result = cb_data;
+	if (packet->type != OTC_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	if (logic->unitsize)
+		result->samples += logic->length / logic->unitsize;
+	g_checksum_update(result->logic_sum, logic->data, logic->length);
+}
+
+static struct otc_dev_driver *bench_driver_find(struct otc_context *ctx,
+	const char *name)
+{
+	struct otc_dev_driver **drivers;
+	size_t idx;
+
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, name))
+			return drivers[idx];
+	}
+
+	return NULL;
+}
+
+static int bench_run(struct otc_context *ctx, const char *conn,
+	uint64_t limit, struct bench_result *result)
+{
+	struct otc_dev_driver *driver;
+	struct otc_dev_inst *sdi;
+	struct otc_session *session;
+	struct otc_config *src;
+	GSList *options, *devices;
+	clock_t cpu_start;
+	gint64 wall_start;
+	int ret;
+
+	driver = bench_driver_find(ctx, "raspberrypi-pico");
+	if (!driver) {
+		fprintf(stderr, "Driver raspberrypi-pico not found.\n");
+		return OTC_ERR_ARG;
+	}
+	ret = otc_driver_init(ctx, driver);
+	if (ret != OTC_OK)
+		return ret;
+
+	src = g_malloc(sizeof(*src));
+	src->key = OTC_CONF_CONN;
+	src->data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, src);
+	devices = otc_driver_scan(driver, options);
+	g_variant_unref(src->data);
+	g_free(src);
+	g_slist_free(options);
+	if (!devices) {
+		fprintf(stderr, "No device found at %s.\n", conn);
+		return OTC_ERR_NA;
+	}
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = otc_dev_open(sdi);
+	if (ret != OTC_OK)
+		return ret;
+	ret = otc_config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(limit));
+	if (ret != OTC_OK)
+		goto out_close;
+
+	ret = otc_session_new(ctx, &session);
+	if (ret != OTC_OK)
+		goto out_close;
+	otc_session_dev_add(session, sdi);
+	otc_session_datafeed_callback_add(session, bench_datafeed, result);
+
+	wall_start = g_get_monotonic_time();
+	cpu_start = clock();
+	ret = otc_session_start(session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(session);
+	result->cpu_time = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+	result->wall_time = (g_get_monotonic_time() - wall_start) / 1e6;
+
+	otc_session_destroy(session);
+out_close:
+	otc_dev_close(sdi);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *pattern_names[] = { "toggle", "mixed", "slow" };
+	struct otc_context *ctx;
+	struct bench_result result;
+	struct pico_fw fw;
+	const char *expect;
+	char *conn;
+	uint64_t limit;
+	gboolean use_pty;
+	int loglevel, opt, ret, failed;
+	unsigned int idx;
+
+	memset(&fw, 0, sizeof(fw));
+	fw.channels = 4;
+	fw.pattern = PATTERN_MIXED;
+	limit = DEFAULT_SAMPLES;
+	use_pty = FALSE;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:c:p:Pl:")) != -1) {
+		switch (opt) {
+		case 'n':
+			limit = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'c':
+			fw.channels = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'p':
+			for (idx = 0; idx < G_N_ELEMENTS(pattern_names); idx++) {
+				if (!strcmp(optarg, pattern_names[idx]))
+					break;
+			}
+			if (idx == G_N_ELEMENTS(pattern_names))
+				goto usage;
+			fw.pattern = idx;
+			break;
+		case 'P':
+			use_pty = TRUE;
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !limit || !fw.channels || fw.channels > 32)
+		goto usage;
+	fw.unitsize = (fw.channels + 7) / 8;
+	fw.rand = g_rand_new_with_seed(1);
+	fw.expect_sum = g_checksum_new(G_CHECKSUM_SHA256);
+	otc_log_loglevel_set(loglevel);
+
+	conn = fw_start(&fw, use_pty);
+	if (!conn)
+		return 1;
+	ret = otc_init(&ctx);
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+
+	memset(&result, 0, sizeof(result));
+	result.logic_sum = g_checksum_new(G_CHECKSUM_SHA256);
+	ret = bench_run(ctx, conn, limit, &result);
+	otc_exit(ctx);
+	fw_stop(&fw);
+
+	failed = 0;
+	expect = g_checksum_get_string(fw.expect_sum);
+	if (ret != OTC_OK || result.samples != limit) {
+		fprintf(stderr, "Acquisition failed (%" PRIu64 " of %" PRIu64
+			" samples).\n", result.samples, limit);
+		failed = 1;
+	} else if (strcmp(g_checksum_get_string(result.logic_sum), expect)) {
+		fprintf(stderr, "Sample data mismatch, got %s, expected %s.\n",
+			g_checksum_get_string(result.logic_sum), expect);
+		failed = 1;
+	} else {
+		printf("raspberrypi-pico %2uch %-6s %12" PRIu64 " samples %8.3f s "
+			"%9.2f Msamples/s %8.3f s CPU (%5.1f%%)\n",
+			fw.channels, pattern_names[fw.pattern], result.samples,
+			result.wall_time, result.samples / result.wall_time / 1e6,
+			result.cpu_time,
+			100.0 * result.cpu_time / result.wall_time);
+	}
+
+	g_checksum_free(result.logic_sum);
+	g_checksum_free(fw.expect_sum);
+	g_rand_free(fw.rand);
+	g_free(conn);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n samples] [-c channels] "
+		"[-p toggle|mixed|slow] [-P] [-l loglevel]\n", argv[0]);
+	return 2;
+}
@@ -0,0 +1,444 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scan benchmark of the SCPI probe path. Stand-in instruments answer
+ * the identification query of the scpi-dmm driver after a configurable
+ * delay. One scan gets all of the stand-ins as conn= options, and the
+ * bench checks that it finds the present ones, in the order of the
+ * options.
+ *
+ *   otc-scan-bench [-n <present>] [-a <absent>] [-d <delay ms>]
+ *                  [-t <scan timeout ms>] [-e <expected devices>]
+ *                  [-r <max percent of serial>] [-P] [-l <loglevel>]
+ *
+ * Absent stand-ins alternate with the present ones in the option list.
+ * Their TCP ports refuse connections, their pseudo terminals never
+ * answer. With a scan timeout which passes while the first probes are
+ * still waiting for their answers, the stand-ins behind them are not
+ * probed at all: -e then tells how many devices to expect.
+ *
+ * With -r, a scan of a single stand-in runs first. Probing the present
+ * stand-ins one after the other would take that many times as long, and
+ * the scan of all of them may only take the given percentage of this.
+ *
+ * Stand-ins listen on TCP sockets (the 'tcp-raw' SCPI transport) by
+ * default. The -P option uses pseudo terminals instead, which needs a
+ * libserialport that accepts them: on Linux it only opens ports with a
+ * sysfs entry.
+ */
+
+/* For posix_openpt() and cfmakeraw(). */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+/* An instrument behind one conn= option. */
+struct standin {
+	unsigned int index;
+	gboolean present;
+	unsigned int delay_ms;
+	int listen_fd;
+	int pty_fd;
+	char *conn;
+	GThread *thread;
+	volatile gint quit;
+};
+
+static gboolean standin_write(int fd, const char *text)
+{
+	size_t count;
+	ssize_t ret;
+
+	count = strlen(text);
+	while (count) {
+		ret = write(fd, text, count);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return FALSE;
+		text += ret;
+		count -= ret;
+	}
+
+	return TRUE;
+}
+
+/* Serve the host until the connection closes. */
+static void standin_serve(struct standin *si, int fd)
+{
+	char line[64], c, *id;
+	size_t len;
+	ssize_t ret;
+
+	len = 0;
+	while (!g_atomic_int_get(&si->quit)) {
+		ret = read(fd, &c, 1);
+		if (ret == 0)
+			return;
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0 && errno == EIO) {
+			/* Nobody has the pseudo terminal open. */
+			g_usleep(10 * 1000);
+			continue;
+		}
+		if (ret < 0)
+			return;
+
+		if (c == '\r')
+			continue;
+		if (c != '\n') {
+			if (len < sizeof(line) - 1)
+				line[len++] = c;
+			continue;
+		}
+		line[len] = '\0';
+		len = 0;
+		if (!si->present || g_ascii_strcasecmp(line, "*IDN?"))
+			continue;
+		g_usleep(si->delay_ms * 1000);
+		id = g_strdup_printf("Agilent Technologies,34410A,SN%04u,1.0\n",
+			si->index);
+		standin_write(fd, id);
+		g_free(id);
+	}
+}
+
+static gpointer standin_thread(gpointer data)
+{
+	struct standin *si;
+	int fd;
+
+	si = data;
+	if (si->pty_fd >= 0) {
+		standin_serve(si, si->pty_fd);
+		return NULL;
+	}
+
+	while (!g_atomic_int_get(&si->quit)) {
+		fd = accept(si->listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		standin_serve(si, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static gboolean standin_start(struct standin *si, gboolean use_pty)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	struct termios tio;
+	int fd;
+
+	si->listen_fd = si->pty_fd = -1;
+	if (use_pty) {
+		fd = posix_openpt(O_RDWR | O_NOCTTY);
+		if (fd < 0 || grantpt(fd) || unlockpt(fd)
+				|| tcgetattr(fd, &tio)) {
+			perror("Cannot create pseudo terminal");
+			return FALSE;
+		}
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+		si->pty_fd = fd;
+		si->conn = g_strdup(ptsname(fd));
+	} else {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr_len = sizeof(addr);
+		/* A bound socket which doesn't listen refuses connections. */
+		if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+				|| (si->present && listen(fd, 1))
+				|| getsockname(fd, (struct sockaddr *)&addr, &addr_len)) {
+			perror("Cannot create socket");
+			return FALSE;
+		}
+		si->listen_fd = fd;
+		si->conn = g_strdup_printf("tcp-raw/127.0.0.1/%u",
+			ntohs(addr.sin_port));
+		if (!si->present)
+			return TRUE;
+	}
+	si->thread = g_thread_new("scan-standin", standin_thread, si);
+
+	return TRUE;
+}
+
+static void standin_stop(struct standin *si)
+{
+	g_atomic_int_set(&si->quit, 1);
+	if (si->listen_fd >= 0) {
+		shutdown(si->listen_fd, SHUT_RDWR);
+		close(si->listen_fd);
+	}
+	if (si->pty_fd >= 0)
+		close(si->pty_fd);
+	if (si->thread)
+		g_thread_join(si->thread);
+	g_free(si->conn);
+}
+
+static struct otc_config *bench_option_new(uint32_t key, const char *text)
+{
+	struct otc_config *src;
+
+	src = g_malloc(sizeof(*src));
+	src->key = key;
+	src->data = g_variant_ref_sink(g_variant_new_string(text));
+
+	return src;
+}
+
+static void bench_option_free(void *data)
+{
+	struct otc_config *src;
+
+	src = data;
+	g_variant_unref(src->data);
+	g_free(src);
+}
+
+/* Time a scan of a single stand-in, the cost of one sequential probe. */
+static double bench_single_scan(struct otc_dev_driver *driver,
+	struct standin *si, gboolean use_pty)
+{
+	GSList *options, *devices;
+	gint64 start_us;
+	double elapsed_ms;
+
+	options = g_slist_append(NULL,
+		bench_option_new(OTC_CONF_CONN, si->conn));
+	if (use_pty)
+		options = g_slist_append(options,
+			bench_option_new(OTC_CONF_SERIALCOMM, "115200/8n1"));
+
+	start_us = g_get_monotonic_time();
+	devices = otc_driver_scan(driver, options);
+	elapsed_ms = (g_get_monotonic_time() - start_us) / 1e3;
+
+	if (g_slist_length(devices) != 1)
+		elapsed_ms = -1;
+	g_slist_free(devices);
+	g_slist_free_full(options, bench_option_free);
+
+	return elapsed_ms;
+}
+
+/* Check that the devices are the present stand-ins, in option order. */
+static gboolean bench_check(GSList *devices, struct standin *standins,
+	unsigned int count, unsigned int expected)
+{
+	const char *sernum;
+	char *want;
+	unsigned int idx;
+	gboolean ok;
+
+	if (g_slist_length(devices) != expected) {
+		fprintf(stderr, "Found %u devices, expected %u.\n",
+			g_slist_length(devices), expected);
+		return FALSE;
+	}
+
+	ok = TRUE;
+	for (idx = 0; idx < count && devices; idx++) {
+		if (!standins[idx].present)
+			continue;
+		sernum = otc_dev_inst_sernum_get(devices->data);
+		want = g_strdup_printf("SN%04u", idx);
+		if (!sernum || strcmp(sernum, want)) {
+			fprintf(stderr, "Found %s, expected %s.\n",
+				sernum ? sernum : "(none)", want);
+			ok = FALSE;
+		}
+		g_free(want);
+		devices = devices->next;
+	}
+
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers, *driver;
+	struct standin *standins;
+	GSList *options, *devices;
+	unsigned int present, absent, count, delay_ms, expected, idx;
+	uint64_t timeout_ms, max_percent;
+	gboolean use_pty, have_expected;
+	gint64 start_us;
+	double elapsed_ms, serial_ms;
+	int loglevel, opt, ret, failed;
+
+	present = 8;
+	absent = 0;
+	delay_ms = 100;
+	timeout_ms = 0;
+	max_percent = 0;
+	expected = 0;
+	have_expected = FALSE;
+	use_pty = FALSE;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:a:d:t:e:r:Pl:")) != -1) {
+		switch (opt) {
+		case 'n':
+			present = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'a':
+			absent = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'd':
+			delay_ms = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			timeout_ms = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'e':
+			expected = g_ascii_strtoull(optarg, NULL, 0);
+			have_expected = TRUE;
+			break;
+		case 'r':
+			max_percent = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'P':
+			use_pty = TRUE;
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	count = absent + present;
+	if (optind != argc || count < 2)
+		goto usage;
+	if (!have_expected)
+		expected = present;
+	otc_log_loglevel_set(loglevel);
+
+	ret = otc_init(&ctx);
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = NULL;
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, "scpi-dmm"))
+			driver = drivers[idx];
+	}
+	if (!driver) {
+		fprintf(stderr, "Driver scpi-dmm not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, driver) != OTC_OK) {
+		otc_exit(ctx);
+		return 1;
+	}
+	otc_driver_scan_timeout_set(ctx, timeout_ms);
+
+	failed = 0;
+	standins = g_new0(struct standin, count);
+	options = NULL;
+	for (idx = 0; idx < count; idx++) {
+		standins[idx].index = idx;
+		standins[idx].present = idx % 2 == 0 || idx / 2 >= absent;
+		standins[idx].delay_ms = delay_ms;
+		if (!standin_start(&standins[idx], use_pty)) {
+			failed = 1;
+			break;
+		}
+		options = g_slist_append(options,
+			bench_option_new(OTC_CONF_CONN, standins[idx].conn));
+	}
+	if (use_pty)
+		options = g_slist_append(options,
+			bench_option_new(OTC_CONF_SERIALCOMM, "115200/8n1"));
+
+	serial_ms = 0;
+	if (!failed && max_percent) {
+		/* The first stand-in is present. */
+		serial_ms = bench_single_scan(driver, &standins[0], use_pty);
+		if (serial_ms < 0) {
+			fprintf(stderr, "Single stand-in not found.\n");
+			failed = 1;
+		}
+		serial_ms *= present;
+	}
+
+	if (!failed) {
+		start_us = g_get_monotonic_time();
+		devices = otc_driver_scan(driver, options);
+		elapsed_ms = (g_get_monotonic_time() - start_us) / 1e3;
+
+		if (!bench_check(devices, standins, count, expected))
+			failed = 1;
+		if (max_percent && elapsed_ms > serial_ms * max_percent / 100) {
+			fprintf(stderr, "Scan took %.0f ms, limit %" PRIu64
+				"%% of %.0f ms.\n", elapsed_ms, max_percent,
+				serial_ms);
+			failed = 1;
+		}
+		printf("scan %s %3u present %3u absent %3u found %9.1f ms\n",
+			use_pty ? "pty" : "tcp", present, absent,
+			g_slist_length(devices), elapsed_ms);
+		g_slist_free(devices);
+	}
+
+	/* Closes the devices' connections, which ends the stand-ins. */
+	otc_exit(ctx);
+	for (idx = 0; idx < count; idx++)
+		standin_stop(&standins[idx]);
+	g_free(standins);
+	g_slist_free_full(options, bench_option_free);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n present] [-a absent] [-d delay_ms] "
+		"[-t timeout_ms] [-e expected] [-r max_percent] [-P] "
+		"[-l loglevel]\n", argv[0]);
+	return 2;
+}
@@ -0,0 +1,380 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Buffered receive path of the 'tcp-raw' serial transport. A stand-in
+ * Atten PPS3203T-3S answers the atten-pps3203 driver on a loopback
+ * socket. That driver reads a single byte per G_IO_IN event, so most
+ * of each status packet waits in the transport's receive buffer while
+ * the socket has nothing left to signal.
+ *
+ *   otc-tcpraw-bench [-n <packets>] [-b <burst>] [-l <loglevel>]
+ *
+ * The stand-in answers each configuration packet with a status packet,
+ * and the start of the acquisition with a burst of them. Status packets
+ * carry a sequence number as the first channel's voltage, which has to
+ * arrive in the session feed without gaps. The acquisition stops after
+ * the given number of packets. It stalls when the session doesn't
+ * dispatch buffered data, which fails the bench after a while.
+ */
+
+#include <errno.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+#define PACKET_SIZE	24
+#define NUM_CHANNELS	3
+#define STALL_TIMEOUT_S	10
+
+struct standin {
+	int listen_fd;
+	char *conn;
+	GThread *thread;
+	volatile gint quit;
+	unsigned int burst;
+};
+
+struct bench {
+	struct otc_session *session;
+	uint64_t limit;
+	uint64_t packets;
+	uint64_t seq_errors;
+	gboolean stopping;
+	/* The watchdog waits for the session to end. */
+	GMutex mutex;
+	GCond cond;
+	gboolean done;
+};
+
+static gboolean standin_io(int fd, void *buf, size_t len, gboolean out)
+{
+	uint8_t *p;
+	ssize_t ret;
+
+	p = buf;
+	while (len) {
+		ret = out ? write(fd, p, len) : read(fd, p, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return FALSE;
+		p += ret;
+		len -= ret;
+	}
+
+	return TRUE;
+}
+
+static void standin_status(uint8_t *packet, unsigned int seq)
+{
+	unsigned int idx, sum;
+
+	memset(packet, 0, PACKET_SIZE);
+	packet[0] = 0xaa;
+	packet[1] = 0xaa;
+	packet[2] = (seq >> 8) & 0xff;
+	packet[3] = seq & 0xff;
+	for (idx = 1; idx < NUM_CHANNELS; idx++) {
+		packet[2 + idx * 4] = 0x04;
+		packet[3 + idx * 4] = 0xb0;
+	}
+	packet[19] = 1;
+	sum = 0;
+	for (idx = 0; idx < PACKET_SIZE - 1; idx++)
+		sum += packet[idx];
+	packet[PACKET_SIZE - 1] = sum & 0xff;
+}
+
+/* Serve the host until the connection closes. */
+static void standin_serve(struct standin *si, int fd)
+{
+	uint8_t request[PACKET_SIZE], *reply;
+	unsigned int seq, count, idx;
+
+	reply = g_malloc(si->burst * PACKET_SIZE);
+	seq = 0;
+	while (!g_atomic_int_get(&si->quit)) {
+		if (!standin_io(fd, request, sizeof(request), FALSE))
+			break;
+		if (request[0] != 0xaa)
+			continue;
+		/* Probes and acquisition starts get a burst, all in one go. */
+		count = request[1] == 0xaa ? si->burst : 1;
+		for (idx = 0; idx < count; idx++)
+			standin_status(reply + idx * PACKET_SIZE, seq++);
+		if (!standin_io(fd, reply, count * PACKET_SIZE, TRUE))
+			break;
+	}
+	g_free(reply);
+}
+
+static gpointer standin_thread(gpointer data)
+{
+	struct standin *si;
+	int fd;
+
+	si = data;
+	while (!g_atomic_int_get(&si->quit)) {
+		fd = accept(si->listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		standin_serve(si, fd);
+		close(fd);
+	}
+
+	return NULL;
+}
+
+static gboolean standin_start(struct standin *si)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	int fd;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr_len = sizeof(addr);
+	if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr))
+			|| listen(fd, 1)
+			|| getsockname(fd, (struct sockaddr *)&addr, &addr_len)) {
+		perror("Cannot create socket");
+		return FALSE;
+	}
+	si->listen_fd = fd;
+	si->conn = g_strdup_printf("tcp-raw/127.0.0.1/%u", ntohs(addr.sin_port));
+	si->thread = g_thread_new("tcpraw-standin", standin_thread, si);
+
+	return TRUE;
+}
+
+static void standin_stop(struct standin *si)
+{
+	g_atomic_int_set(&si->quit, 1);
+	shutdown(si->listen_fd, SHUT_RDWR);
+	close(si->listen_fd);
+	g_thread_join(si->thread);
+	g_free(si->conn);
+}
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench *bench;
+	const struct otc_datafeed_analog *analog;
+	float values[NUM_CHANNELS];
+
+	(void)sdi;
+
+	bench = cb_data;
+	if (packet->type != OTC_DF_ANALOG)
+		return;
+	analog = packet->payload;
+	if (analog->meaning->mq != OTC_MQ_VOLTAGE)
+		return;
+	if (g_slist_length(analog->meaning->channels) != NUM_CHANNELS
+			|| otc_analog_to_float(analog, values) != OTC_OK)
+		return;
+
+	/* The first channel's voltage is the stand-in's sequence number. */
+	if (lrintf(values[0] * 100) != (long)(bench->packets & 0xffff))
+		bench->seq_errors++;
+	bench->packets++;
+	if (bench->packets >= bench->limit && !bench->stopping) {
+		bench->stopping = TRUE;
+		otc_session_stop(bench->session);
+	}
+}
+
+static gpointer bench_watchdog(gpointer data)
+{
+	struct bench *bench;
+	gint64 deadline;
+
+	bench = data;
+	deadline = g_get_monotonic_time() + STALL_TIMEOUT_S * G_TIME_SPAN_SECOND;
+	g_mutex_lock(&bench->mutex);
+	while (!bench->done) {
+		if (!g_cond_wait_until(&bench->cond, &bench->mutex, deadline)) {
+			/* A stalled driver doesn't respond to stop requests. */
+			fprintf(stderr, "Stalled after %" PRIu64 " of %" PRIu64
+				" packets.\n", bench->packets, bench->limit);
+			exit(1);
+		}
+	}
+	g_mutex_unlock(&bench->mutex);
+
+	return NULL;
+}
+
+static int bench_run(struct otc_context *ctx, struct otc_dev_driver *driver,
+	const char *conn, struct bench *bench)
+{
+	struct otc_config src;
+	struct otc_dev_inst *sdi;
+	GSList *options, *devices;
+	GThread *watchdog;
+	int ret;
+
+	src.key = OTC_CONF_CONN;
+	src.data = g_variant_ref_sink(g_variant_new_string(conn));
+	options = g_slist_append(NULL, &src);
+	devices = otc_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	if (!devices) {
+		fprintf(stderr, "No device found at %s.\n", conn);
+		return OTC_ERR;
+	}
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = otc_dev_open(sdi);
+	if (ret != OTC_OK)
+		return ret;
+	ret = otc_session_new(ctx, &bench->session);
+	if (ret != OTC_OK)
+		goto out_close;
+	otc_session_dev_add(bench->session, sdi);
+	otc_session_datafeed_callback_add(bench->session, bench_datafeed, bench);
+
+	watchdog = g_thread_new("tcpraw-watchdog", bench_watchdog, bench);
+	ret = otc_session_start(bench->session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(bench->session);
+	g_mutex_lock(&bench->mutex);
+	bench->done = TRUE;
+	g_cond_signal(&bench->cond);
+	g_mutex_unlock(&bench->mutex);
+	g_thread_join(watchdog);
+	otc_session_destroy(bench->session);
+
+out_close:
+	otc_dev_close(sdi);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers, *driver;
+	struct standin si;
+	struct bench bench;
+	gint64 start_us;
+	double elapsed;
+	unsigned int idx;
+	int loglevel, opt, ret, failed;
+
+	memset(&si, 0, sizeof(si));
+	memset(&bench, 0, sizeof(bench));
+	si.burst = 1;
+	bench.limit = 1000;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:b:l:")) != -1) {
+		switch (opt) {
+		case 'n':
+			bench.limit = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'b':
+			si.burst = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !bench.limit || !si.burst)
+		goto usage;
+	otc_log_loglevel_set(loglevel);
+	g_mutex_init(&bench.mutex);
+	g_cond_init(&bench.cond);
+
+	ret = otc_init(&ctx);
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = NULL;
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, "atten-pps3203"))
+			driver = drivers[idx];
+	}
+	if (!driver) {
+		fprintf(stderr, "Driver atten-pps3203 not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, driver) != OTC_OK || !standin_start(&si)) {
+		otc_exit(ctx);
+		return 1;
+	}
+
+	start_us = g_get_monotonic_time();
+	ret = bench_run(ctx, driver, si.conn, &bench);
+	elapsed = (g_get_monotonic_time() - start_us) / 1e6;
+
+	/* Closes the device's connection, which ends the stand-in's. */
+	otc_exit(ctx);
+	standin_stop(&si);
+
+	failed = 0;
+	if (ret != OTC_OK || bench.packets < bench.limit) {
+		fprintf(stderr, "Acquisition failed (%" PRIu64 " of %" PRIu64
+			" packets).\n", bench.packets, bench.limit);
+		failed = 1;
+	}
+	if (bench.seq_errors) {
+		fprintf(stderr, "%" PRIu64 " packets out of sequence.\n",
+			bench.seq_errors);
+		failed = 1;
+	}
+	printf("tcp-raw burst %3u %8" PRIu64 " packets %8.3f s %9.1f "
+		"packets/s\n", si.burst, bench.packets, elapsed,
+		bench.packets / elapsed);
+
+	g_mutex_clear(&bench.mutex);
+	g_cond_clear(&bench.cond);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n packets] [-b burst] [-l loglevel]\n",
+		argv[0]);
+	return 2;
+}
@@ -0,0 +1,284 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Throughput of a demo device in flood mode, with the incremental
+ * pattern on a number of logic channels. With -j above 1, that many
+ * generator threads fill the chunks, otherwise the session thread
+ * generates them. Either way, the bytes have to arrive in order and
+ * without gaps.
+ *
+ * The device runs at 1 kHz, flood mode has to ignore this: the samples
+ * have to arrive in less than half of the time they would take paced.
+ *
+ * With -s, the datafeed callback stops the session after that many logic
+ * packets, while the generator threads are still busy. The feed then has
+ * to end all the same.
+ *
+ *   otc-flood-bench [-n samples] [-c channels] [-j threads] [-s packets]
+ *                   [-l loglevel]
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+#define SAMPLERATE	OTC_KHZ(1)
+
+struct bench {
+	struct otc_session *session;
+	uint64_t stop_packets;
+	gboolean header;
+	gboolean ended;
+	uint64_t bytes;
+	uint64_t packets;
+	uint64_t errors;
+};
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench *bench;
+	const struct otc_datafeed_logic *logic;
+	const uint8_t *data;
+	uint64_t idx;
+
+	(void)sdi;
+
+	bench = cb_data;
+	switch (packet->type) {
+	case OTC_DF_HEADER:
+		if (bench->header || bench->ended)
+			bench->errors++;
+		bench->header = TRUE;
+		break;
+	case OTC_DF_END:
+		if (!bench->header || bench->ended)
+			bench->errors++;
+		bench->ended = TRUE;
+		break;
+	case OTC_DF_LOGIC:
+		if (!bench->header || bench->ended)
+			bench->errors++;
+		logic = packet->payload;
+		data = logic->data;
+		/* The incremental pattern counts bytes, not samples. */
+		for (idx = 0; idx < logic->length; idx++) {
+			if (data[idx] != (uint8_t)(bench->bytes + idx)) {
+				bench->errors++;
+				break;
+			}
+		}
+		bench->bytes += logic->length;
+		bench->packets++;
+		if (bench->packets == bench->stop_packets)
+			otc_session_stop(bench->session);
+		break;
+	default:
+		break;
+	}
+}
+
+static int config_set(const struct otc_dev_inst *sdi,
+	const struct otc_channel_group *cg, uint32_t key, GVariant *data)
+{
+	int ret;
+
+	g_variant_ref_sink(data);
+	ret = otc_config_set(sdi, cg, key, data);
+	g_variant_unref(data);
+
+	return ret;
+}
+
+static struct otc_dev_inst *device_open(struct otc_dev_driver *driver,
+	int channels, uint64_t threads, uint64_t samples)
+{
+	struct otc_config src[2];
+	struct otc_dev_inst *sdi;
+	struct otc_channel_group *cg;
+	GSList *options, *devices, *l;
+
+	src[0].key = OTC_CONF_NUM_LOGIC_CHANNELS;
+	src[0].data = g_variant_ref_sink(g_variant_new_int32(channels));
+	src[1].key = OTC_CONF_NUM_ANALOG_CHANNELS;
+	src[1].data = g_variant_ref_sink(g_variant_new_int32(0));
+	options = g_slist_append(NULL, &src[0]);
+	options = g_slist_append(options, &src[1]);
+	devices = otc_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src[0].data);
+	g_variant_unref(src[1].data);
+	if (!devices)
+		return NULL;
+	sdi = devices->data;
+	g_slist_free(devices);
+	if (otc_dev_open(sdi) != OTC_OK)
+		return NULL;
+
+	cg = NULL;
+	for (l = otc_dev_inst_channel_groups_get(sdi); l; l = l->next) {
+		cg = l->data;
+		if (!strcmp(cg->name, "Logic"))
+			break;
+	}
+	if (!l || config_set(sdi, cg, OTC_CONF_PATTERN_MODE,
+				g_variant_new_string("incremental")) != OTC_OK
+			|| config_set(sdi, NULL, OTC_CONF_FLOOD,
+				g_variant_new_uint64(threads)) != OTC_OK
+			|| config_set(sdi, NULL, OTC_CONF_SAMPLERATE,
+				g_variant_new_uint64(SAMPLERATE)) != OTC_OK
+			|| config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+				g_variant_new_uint64(samples)) != OTC_OK)
+		return NULL;
+
+	return sdi;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers, *driver;
+	struct otc_dev_inst *sdi;
+	struct bench bench;
+	uint64_t samples, threads, expected;
+	gint64 start_us;
+	double elapsed;
+	unsigned int idx;
+	int channels, unitsize, loglevel, opt, ret, failed;
+
+	memset(&bench, 0, sizeof(bench));
+	samples = 100000000;
+	channels = 8;
+	threads = 1;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:c:j:s:l:")) != -1) {
+		switch (opt) {
+		case 'n':
+			samples = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'c':
+			channels = atoi(optarg);
+			break;
+		case 'j':
+			threads = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			bench.stop_packets = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !samples || channels < 1 || channels > 64
+			|| !threads)
+		goto usage;
+	otc_log_loglevel_set(loglevel);
+	unitsize = (channels + 7) / 8;
+
+	if (otc_init(&ctx) != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = NULL;
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, "demo"))
+			driver = drivers[idx];
+	}
+	if (!driver) {
+		fprintf(stderr, "Driver demo not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, driver) != OTC_OK
+			|| otc_session_new(ctx, &bench.session) != OTC_OK) {
+		otc_exit(ctx);
+		return 1;
+	}
+	otc_session_datafeed_callback_add(bench.session, bench_datafeed, &bench);
+
+	failed = 0;
+	sdi = device_open(driver, channels, threads, samples);
+	if (!sdi) {
+		fprintf(stderr, "Cannot set up a demo device in flood mode.\n");
+		failed = 1;
+		goto out;
+	}
+	otc_session_dev_add(bench.session, sdi);
+
+	start_us = g_get_monotonic_time();
+	ret = otc_session_start(bench.session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(bench.session);
+	elapsed = (g_get_monotonic_time() - start_us) / 1e6;
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Acquisition failed.\n");
+		failed = 1;
+		goto out;
+	}
+
+	if (bench.errors) {
+		fprintf(stderr, "%" PRIu64 " packets out of order.\n",
+			bench.errors);
+		failed = 1;
+	}
+	if (!bench.ended) {
+		fprintf(stderr, "No end of feed.\n");
+		failed = 1;
+	}
+	expected = samples * unitsize;
+	if (bench.stop_packets ? bench.bytes > expected
+			: bench.bytes != expected) {
+		fprintf(stderr, "%" PRIu64 " bytes, expected %" PRIu64 ".\n",
+			bench.bytes, expected);
+		failed = 1;
+	}
+	if (!bench.stop_packets && elapsed > samples / 2.0 / SAMPLERATE) {
+		fprintf(stderr, "Took %.3f s, the samples got paced.\n",
+			elapsed);
+		failed = 1;
+	}
+
+	printf("%2" PRIu64 " threads %2d channels %8" PRIu64 " packets "
+		"%8.3f s %8.1f Msamples/s %8.1f MB/s\n", threads, channels,
+		bench.packets, elapsed, bench.bytes / unitsize / elapsed / 1e6,
+		bench.bytes / elapsed / 1e6);
+
+out:
+	otc_session_destroy(bench.session);
+	otc_exit(ctx);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n samples] [-c channels] [-j threads] "
+		"[-s packets] [-l loglevel]\n", argv[0]);
+	return 2;
+}
@@ -0,0 +1,421 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Session statistics. otc_stats_histogram_percentile() has to follow the
+ * bucket layout which struct otc_stats_histogram documents, on histograms
+ * built here. Then a session with statistics runs a demo device, and its
+ * counts have to match what the datafeed callback received: in a snapshot
+ * from within the callback, and at the end. The callback durations have
+ * to go into the buckets of their minimum and maximum.
+ *
+ * With -w, the callback takes that many microseconds per logic packet,
+ * which the median callback duration has to reflect. With -t, the device
+ * runs on a device thread.
+ *
+ *   otc-stats-bench [-n samples] [-w us] [-t]
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+/* Take a snapshot from within the callback at this packet. */
+#define SNAPSHOT_PACKET	10
+
+struct bucket {
+	uint64_t lowest;
+	uint64_t highest;
+};
+
+struct bench {
+	struct otc_session *session;
+	unsigned int delay_us;
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t logic_packets;
+	gboolean snapshot_taken;
+	int snapshot_errors;
+};
+
+static struct bucket layout[OTC_STATS_HISTOGRAM_BUCKETS];
+
+/*
+ * The layout as documented: durations below 16 ns get a bucket each,
+ * then each power of two gets 8 buckets of equal width. The last bucket
+ * takes everything from its start on.
+ */
+static void layout_init(void)
+{
+	unsigned int idx, power, sub;
+	uint64_t width;
+
+	for (idx = 0; idx < 16; idx++)
+		layout[idx].lowest = layout[idx].highest = idx;
+	for (power = 4; idx < OTC_STATS_HISTOGRAM_BUCKETS; power++) {
+		width = (UINT64_C(1) << power) / 8;
+		for (sub = 0; sub < 8; sub++, idx++) {
+			layout[idx].lowest = (UINT64_C(1) << power) + sub * width;
+			layout[idx].highest = layout[idx].lowest + width - 1;
+		}
+	}
+	layout[OTC_STATS_HISTOGRAM_BUCKETS - 1].highest = UINT64_MAX;
+}
+
+static int check_percentile(const struct otc_stats_histogram *hist,
+	double percentile, uint64_t expected)
+{
+	uint64_t value;
+
+	value = otc_stats_histogram_percentile(hist, percentile);
+	if (value == expected)
+		return 0;
+	fprintf(stderr, "Percentile %.1f is %" PRIu64 ", expected %" PRIu64
+		".\n", percentile, value, expected);
+
+	return 1;
+}
+
+/* Percentiles of histograms with known contents. */
+static int check_histograms(void)
+{
+	struct otc_stats_histogram hist;
+	unsigned int idx, last;
+	int failed;
+
+	failed = 0;
+	memset(&hist, 0, sizeof(hist));
+	failed += check_percentile(&hist, 50, 0);
+
+	/* A single duration per bucket, without limits. */
+	last = OTC_STATS_HISTOGRAM_BUCKETS - 1;
+	for (idx = 0; idx < OTC_STATS_HISTOGRAM_BUCKETS; idx++) {
+		memset(&hist, 0, sizeof(hist));
+		hist.count = 1;
+		hist.min = 0;
+		hist.max = UINT64_MAX - 1;
+		hist.buckets[idx] = 1;
+		failed += check_percentile(&hist, 50,
+			idx == last ? hist.max : layout[idx].highest);
+	}
+
+	/* Three buckets, with the limits of their durations. */
+	memset(&hist, 0, sizeof(hist));
+	hist.buckets[20] = 50;
+	hist.buckets[40] = 30;
+	hist.buckets[60] = 20;
+	hist.count = 100;
+	hist.min = layout[20].lowest + 1;
+	hist.max = layout[60].lowest + 1;
+	failed += check_percentile(&hist, 0, layout[20].highest);
+	failed += check_percentile(&hist, 50, layout[20].highest);
+	failed += check_percentile(&hist, 51, layout[40].highest);
+	failed += check_percentile(&hist, 80, layout[40].highest);
+	failed += check_percentile(&hist, 81, hist.max);
+	failed += check_percentile(&hist, 100, hist.max);
+	failed += check_percentile(&hist, 150, hist.max);
+	failed += check_percentile(&hist, -5, layout[20].highest);
+
+	/* Everything in one bucket, limited by the durations. */
+	memset(&hist, 0, sizeof(hist));
+	hist.buckets[100] = 4;
+	hist.count = 4;
+	hist.min = layout[100].lowest + 2;
+	hist.max = layout[100].lowest + 3;
+	failed += check_percentile(&hist, 0, hist.max);
+	failed += check_percentile(&hist, 100, hist.max);
+
+	/* Durations beyond the last bucket's start. */
+	memset(&hist, 0, sizeof(hist));
+	hist.buckets[last] = 2;
+	hist.count = 2;
+	hist.min = UINT64_C(1) << 36;
+	hist.max = UINT64_C(100) << 36;
+	failed += check_percentile(&hist, 100, hist.max);
+
+	return failed;
+}
+
+/* Recorded durations have to lie in their buckets. */
+static int check_buckets(const char *name,
+	const struct otc_stats_histogram *hist)
+{
+	unsigned int first, last, idx;
+	uint64_t count;
+	int failed;
+
+	count = 0;
+	first = last = OTC_STATS_HISTOGRAM_BUCKETS;
+	for (idx = 0; idx < OTC_STATS_HISTOGRAM_BUCKETS; idx++) {
+		if (!hist->buckets[idx])
+			continue;
+		if (first == OTC_STATS_HISTOGRAM_BUCKETS)
+			first = idx;
+		last = idx;
+		count += hist->buckets[idx];
+	}
+	if (count != hist->count) {
+		fprintf(stderr, "%s: %" PRIu64 " durations in buckets, count "
+			"%" PRIu64 ".\n", name, count, hist->count);
+		return 1;
+	}
+	if (!count)
+		return 0;
+
+	failed = 0;
+	if (hist->min < layout[first].lowest
+			|| hist->min > layout[first].highest) {
+		fprintf(stderr, "%s: minimum %" PRIu64 " not in bucket %u.\n",
+			name, hist->min, first);
+		failed++;
+	}
+	if (hist->max < layout[last].lowest
+			|| hist->max > layout[last].highest) {
+		fprintf(stderr, "%s: maximum %" PRIu64 " not in bucket %u.\n",
+			name, hist->max, last);
+		failed++;
+	}
+	if (hist->sum < hist->min * hist->count
+			|| hist->sum / hist->count > hist->max) {
+		fprintf(stderr, "%s: sum %" PRIu64 " out of range.\n",
+			name, hist->sum);
+		failed++;
+	}
+
+	return failed;
+}
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench *bench;
+	const struct otc_datafeed_logic *logic;
+	struct otc_session_stats *stats;
+
+	(void)sdi;
+
+	bench = cb_data;
+	/* The statistics count a packet once the callbacks returned. */
+	if (bench->packets == SNAPSHOT_PACKET) {
+		stats = NULL;
+		if (otc_session_stats_get(bench->session, &stats) != OTC_OK
+				|| stats->num_devices != 1
+				|| stats->devices[0].packets != bench->packets
+				|| stats->devices[0].bytes != bench->bytes
+				|| stats->callbacks.count != bench->packets)
+			bench->snapshot_errors++;
+		otc_session_stats_free(stats);
+		bench->snapshot_taken = TRUE;
+	}
+
+	bench->packets++;
+	if (packet->type != OTC_DF_LOGIC)
+		return;
+	logic = packet->payload;
+	bench->bytes += logic->length;
+	bench->logic_packets++;
+	if (bench->delay_us)
+		g_usleep(bench->delay_us);
+}
+
+static struct otc_dev_inst *device_open(struct otc_dev_driver *driver,
+	uint64_t samples)
+{
+	struct otc_config src;
+	struct otc_dev_inst *sdi;
+	GSList *options, *devices;
+	GVariant *gvar;
+	int ret;
+
+	src.key = OTC_CONF_NUM_ANALOG_CHANNELS;
+	src.data = g_variant_ref_sink(g_variant_new_int32(0));
+	options = g_slist_append(NULL, &src);
+	devices = otc_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	if (!devices)
+		return NULL;
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	if (otc_dev_open(sdi) != OTC_OK)
+		return NULL;
+	gvar = g_variant_ref_sink(g_variant_new_uint64(samples));
+	ret = otc_config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES, gvar);
+	g_variant_unref(gvar);
+	if (ret == OTC_OK) {
+		gvar = g_variant_ref_sink(g_variant_new_uint64(1));
+		ret = otc_config_set(sdi, NULL, OTC_CONF_FLOOD, gvar);
+		g_variant_unref(gvar);
+	}
+
+	return ret == OTC_OK ? sdi : NULL;
+}
+
+static int check_session(struct bench *bench, uint64_t samples)
+{
+	struct otc_session_stats *stats;
+	struct otc_stats_device *dev;
+	uint64_t median;
+	int failed;
+
+	if (otc_session_stats_get(bench->session, &stats) != OTC_OK) {
+		fprintf(stderr, "No statistics after the session.\n");
+		return 1;
+	}
+
+	failed = 0;
+	if (!bench->snapshot_taken) {
+		fprintf(stderr, "Too few packets for a snapshot.\n");
+		failed++;
+	} else if (bench->snapshot_errors) {
+		fprintf(stderr, "Snapshot within the callback doesn't match.\n");
+		failed++;
+	}
+	if (bench->bytes != samples) {
+		fprintf(stderr, "Received %" PRIu64 " bytes, expected %" PRIu64
+			".\n", bench->bytes, samples);
+		failed++;
+	}
+	dev = stats->num_devices == 1 ? &stats->devices[0] : NULL;
+	if (!dev || dev->packets != bench->packets
+			|| dev->bytes != bench->bytes) {
+		fprintf(stderr, "Statistics count %" PRIu64 " packets, %" PRIu64
+			" bytes, received %" PRIu64 " packets, %" PRIu64
+			" bytes.\n", dev ? dev->packets : 0,
+			dev ? dev->bytes : 0, bench->packets, bench->bytes);
+		failed++;
+	}
+	if (stats->callbacks.count != bench->packets) {
+		fprintf(stderr, "%" PRIu64 " callback durations for %" PRIu64
+			" packets.\n", stats->callbacks.count, bench->packets);
+		failed++;
+	}
+	if (stats->transform.count) {
+		fprintf(stderr, "Transform durations without transforms.\n");
+		failed++;
+	}
+	failed += check_buckets("callbacks", &stats->callbacks);
+
+	/* Most packets are logic packets, which take the delay. */
+	median = otc_stats_histogram_percentile(&stats->callbacks, 50);
+	if (bench->logic_packets * 2 > bench->packets
+			&& median < (uint64_t)bench->delay_us * 1000) {
+		fprintf(stderr, "Median callback duration %" PRIu64 " ns, "
+			"below the delay.\n", median);
+		failed++;
+	}
+
+	printf("%8" PRIu64 " packets, callbacks median %8" PRIu64 " ns, "
+		"p99 %8" PRIu64 " ns\n", bench->packets, median,
+		otc_stats_histogram_percentile(&stats->callbacks, 99));
+
+	otc_session_stats_free(stats);
+
+	return failed;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers, *driver;
+	struct otc_dev_inst *sdi;
+	struct bench bench;
+	uint64_t samples;
+	unsigned int idx;
+	int opt, ret, failed;
+	gboolean threads;
+
+	memset(&bench, 0, sizeof(bench));
+	samples = 10000000;
+	threads = FALSE;
+	while ((opt = getopt(argc, argv, "n:w:t")) != -1) {
+		switch (opt) {
+		case 'n':
+			samples = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'w':
+			bench.delay_us = atoi(optarg);
+			break;
+		case 't':
+			threads = TRUE;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !samples)
+		goto usage;
+
+	layout_init();
+	failed = check_histograms() ? 1 : 0;
+
+	if (otc_init(&ctx) != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = NULL;
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, "demo"))
+			driver = drivers[idx];
+	}
+	if (!driver) {
+		fprintf(stderr, "Driver demo not available.\n");
+		otc_exit(ctx);
+		return failed ? 1 : EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, driver) != OTC_OK
+			|| !(sdi = device_open(driver, samples))
+			|| otc_session_new(ctx, &bench.session) != OTC_OK) {
+		fprintf(stderr, "Cannot set up the demo device.\n");
+		otc_exit(ctx);
+		return 1;
+	}
+	otc_session_dev_add(bench.session, sdi);
+	otc_session_datafeed_callback_add(bench.session, bench_datafeed, &bench);
+	otc_session_device_threads_set(bench.session, threads);
+	otc_session_stats_set(bench.session, TRUE);
+
+	ret = otc_session_start(bench.session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(bench.session);
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Acquisition failed.\n");
+		failed = 1;
+	} else if (check_session(&bench, samples)) {
+		failed = 1;
+	}
+
+	otc_session_destroy(bench.session);
+	otc_exit(ctx);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n samples] [-w us] [-t]\n", argv[0]);
+	return 2;
+}
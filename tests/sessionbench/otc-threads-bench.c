@@ -0,0 +1,387 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Sessions with device threads, on a number of demo devices in flood
+ * mode with the incremental pattern. Each device's packets have to arrive in order:
+ * the header first, then its samples without gaps, the end last.
+ *
+ * With -s, the datafeed callback stops the session after that many logic
+ * packets, and each device still has to end its feed. With -f, one of
+ * the devices isn't opened, so it can't start: the session start has to
+ * fail without passing on packets of the other devices, and succeed
+ * once that device is open.
+ *
+ *   otc-threads-bench [-d devices] [-n samples] [-s packets] [-f]
+ *                     [-l loglevel]
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+
+/* The meson test harness treats this exit code as a skipped test. */
+#define EXIT_SKIP	77
+
+#define MAX_DEVICES	16
+
+/*
+ * Logic packets a device may send after the session stopped: the ones
+ * its thread queued ahead of the session, and those of a last dispatch.
+ */
+#define MAX_STOP_LAG	(256 + 8)
+
+struct device {
+	struct otc_dev_inst *sdi;
+	gboolean header;
+	gboolean ended;
+	uint64_t samples;
+	uint64_t packets;
+	uint64_t stop_packets;
+	uint64_t errors;
+};
+
+struct bench {
+	struct otc_session *session;
+	struct device devices[MAX_DEVICES];
+	unsigned int num_devices;
+	uint64_t packets;
+	uint64_t stop_packets;
+	uint64_t unknown;
+};
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench *bench;
+	struct device *dev;
+	const struct otc_datafeed_logic *logic;
+	const uint8_t *data;
+	uint64_t idx;
+	unsigned int i;
+
+	bench = cb_data;
+	dev = NULL;
+	for (i = 0; i < bench->num_devices; i++) {
+		if (bench->devices[i].sdi == sdi)
+			dev = &bench->devices[i];
+	}
+	if (!dev) {
+		bench->unknown++;
+		return;
+	}
+
+	switch (packet->type) {
+	case OTC_DF_HEADER:
+		if (dev->header || dev->ended)
+			dev->errors++;
+		dev->header = TRUE;
+		break;
+	case OTC_DF_END:
+		if (!dev->header || dev->ended)
+			dev->errors++;
+		dev->ended = TRUE;
+		break;
+	case OTC_DF_LOGIC:
+		if (!dev->header || dev->ended)
+			dev->errors++;
+		logic = packet->payload;
+		data = logic->data;
+		/* The incremental pattern of a single byte per sample. */
+		for (idx = 0; idx < logic->length; idx++) {
+			if (data[idx] != (uint8_t)(dev->samples + idx)) {
+				dev->errors++;
+				break;
+			}
+		}
+		dev->samples += logic->length;
+		dev->packets++;
+		bench->packets++;
+		if (bench->stop_packets && bench->packets == bench->stop_packets) {
+			for (i = 0; i < bench->num_devices; i++) {
+				bench->devices[i].stop_packets =
+					bench->devices[i].packets;
+			}
+			otc_session_stop(bench->session);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static int config_set(const struct otc_dev_inst *sdi,
+	const struct otc_channel_group *cg, uint32_t key, GVariant *data)
+{
+	int ret;
+
+	g_variant_ref_sink(data);
+	ret = otc_config_set(sdi, cg, key, data);
+	g_variant_unref(data);
+
+	return ret;
+}
+
+static struct otc_dev_inst *device_new(struct otc_dev_driver *driver)
+{
+	struct otc_config src;
+	struct otc_dev_inst *sdi;
+	GSList *options, *devices;
+
+	src.key = OTC_CONF_NUM_ANALOG_CHANNELS;
+	src.data = g_variant_ref_sink(g_variant_new_int32(0));
+	options = g_slist_append(NULL, &src);
+	devices = otc_driver_scan(driver, options);
+	g_slist_free(options);
+	g_variant_unref(src.data);
+	if (!devices)
+		return NULL;
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	return sdi;
+}
+
+static int device_open(struct otc_dev_inst *sdi, uint64_t samples)
+{
+	struct otc_channel_group *cg;
+	GSList *l;
+	int ret;
+
+	ret = otc_dev_open(sdi);
+	if (ret != OTC_OK)
+		return ret;
+
+	cg = NULL;
+	for (l = otc_dev_inst_channel_groups_get(sdi); l; l = l->next) {
+		cg = l->data;
+		if (!strcmp(cg->name, "Logic"))
+			break;
+	}
+	if (!l || config_set(sdi, cg, OTC_CONF_PATTERN_MODE,
+				g_variant_new_string("incremental")) != OTC_OK
+			|| config_set(sdi, NULL, OTC_CONF_FLOOD,
+				g_variant_new_uint64(1)) != OTC_OK
+			|| config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+				g_variant_new_uint64(samples)) != OTC_OK)
+		return OTC_ERR;
+
+	return OTC_OK;
+}
+
+/* Check the feed of each device, return the number of failed checks. */
+static int bench_check(struct bench *bench, uint64_t samples)
+{
+	struct device *dev;
+	unsigned int i;
+	int failed;
+
+	failed = 0;
+	if (bench->unknown) {
+		fprintf(stderr, "%" PRIu64 " packets of unknown devices.\n",
+			bench->unknown);
+		failed++;
+	}
+	for (i = 0; i < bench->num_devices; i++) {
+		dev = &bench->devices[i];
+		if (dev->errors) {
+			fprintf(stderr, "Device %u: %" PRIu64 " packets out of "
+				"order.\n", i, dev->errors);
+			failed++;
+		}
+		if (!dev->ended) {
+			fprintf(stderr, "Device %u: no end of feed.\n", i);
+			failed++;
+		}
+		/* Devices may have finished before the session stopped. */
+		if (bench->stop_packets ? dev->samples > samples
+				: dev->samples != samples) {
+			fprintf(stderr, "Device %u: %" PRIu64 " samples, "
+				"expected %" PRIu64 ".\n", i, dev->samples,
+				samples);
+			failed++;
+		}
+		if (bench->stop_packets
+				&& dev->packets - dev->stop_packets > MAX_STOP_LAG) {
+			fprintf(stderr, "Device %u: %" PRIu64 " packets after "
+				"the stop.\n", i, dev->packets - dev->stop_packets);
+			failed++;
+		}
+	}
+
+	return failed;
+}
+
+static void bench_reset(struct bench *bench)
+{
+	unsigned int i;
+
+	bench->packets = 0;
+	bench->unknown = 0;
+	for (i = 0; i < bench->num_devices; i++) {
+		bench->devices[i].header = FALSE;
+		bench->devices[i].ended = FALSE;
+		bench->devices[i].samples = 0;
+		bench->devices[i].packets = 0;
+		bench->devices[i].stop_packets = 0;
+		bench->devices[i].errors = 0;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct otc_dev_driver **drivers, *driver;
+	struct otc_dev_inst *closed;
+	struct bench bench;
+	uint64_t samples, total;
+	gint64 start_us;
+	double elapsed;
+	unsigned int idx;
+	int loglevel, opt, ret, failed;
+	gboolean fail_start;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.num_devices = 4;
+	samples = 10000000;
+	fail_start = FALSE;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "d:n:s:fl:")) != -1) {
+		switch (opt) {
+		case 'd':
+			bench.num_devices = atoi(optarg);
+			break;
+		case 'n':
+			samples = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			bench.stop_packets = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'f':
+			fail_start = TRUE;
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind != argc || !samples || !bench.num_devices
+			|| bench.num_devices > MAX_DEVICES)
+		goto usage;
+	otc_log_loglevel_set(loglevel);
+
+	if (otc_init(&ctx) != OTC_OK) {
+		fprintf(stderr, "Initialization failed.\n");
+		return 1;
+	}
+	driver = NULL;
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, "demo"))
+			driver = drivers[idx];
+	}
+	if (!driver) {
+		fprintf(stderr, "Driver demo not available.\n");
+		otc_exit(ctx);
+		return EXIT_SKIP;
+	}
+	if (otc_driver_init(ctx, driver) != OTC_OK
+			|| otc_session_new(ctx, &bench.session) != OTC_OK) {
+		otc_exit(ctx);
+		return 1;
+	}
+	otc_session_device_threads_set(bench.session, TRUE);
+	otc_session_datafeed_callback_add(bench.session, bench_datafeed, &bench);
+
+	/* The device in the middle stays closed for a failed start. */
+	closed = NULL;
+	failed = 0;
+	for (idx = 0; idx < bench.num_devices; idx++) {
+		bench.devices[idx].sdi = device_new(driver);
+		if (!bench.devices[idx].sdi) {
+			failed = 1;
+			break;
+		}
+		if (fail_start && idx == bench.num_devices / 2)
+			closed = bench.devices[idx].sdi;
+		else if (device_open(bench.devices[idx].sdi, samples) != OTC_OK)
+			failed = 1;
+		otc_session_dev_add(bench.session, bench.devices[idx].sdi);
+	}
+	if (failed) {
+		fprintf(stderr, "Cannot set up demo devices.\n");
+		goto out;
+	}
+
+	if (closed) {
+		if (otc_session_start(bench.session) == OTC_OK) {
+			fprintf(stderr, "Session started with a closed device.\n");
+			otc_session_run(bench.session);
+			failed = 1;
+			goto out;
+		}
+		if (bench.packets || bench.unknown) {
+			fprintf(stderr, "Packets of a failed start got passed "
+				"on.\n");
+			failed = 1;
+		}
+		bench_reset(&bench);
+		if (device_open(closed, samples) != OTC_OK) {
+			failed = 1;
+			goto out;
+		}
+	}
+
+	start_us = g_get_monotonic_time();
+	ret = otc_session_start(bench.session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(bench.session);
+	elapsed = (g_get_monotonic_time() - start_us) / 1e6;
+	if (ret != OTC_OK) {
+		fprintf(stderr, "Acquisition failed.\n");
+		failed = 1;
+		goto out;
+	}
+	if (bench_check(&bench, samples))
+		failed = 1;
+
+	total = 0;
+	for (idx = 0; idx < bench.num_devices; idx++)
+		total += bench.devices[idx].samples;
+	printf("%2u devices %8" PRIu64 " packets %8.3f s %8.1f MB/s\n",
+		bench.num_devices, bench.packets, elapsed,
+		total / elapsed / 1e6);
+
+out:
+	otc_session_destroy(bench.session);
+	otc_exit(ctx);
+
+	return failed;
+
+usage:
+	fprintf(stderr, "Usage: %s [-d devices] [-n samples] [-s packets] "
+		"[-f] [-l loglevel]\n", argv[0]);
+	return 2;
+}
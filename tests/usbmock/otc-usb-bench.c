@@ -0,0 +1,411 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Driver throughput benchmark. Runs acquisitions against devices which
+ * the USB mock emulates (see usbmock.c), and reports the rate at which
+ * samples arrive in the session feed, and the CPU time that was spent.
+ *
+ *   otc-usb-bench [-n <samples>] [-r <samplerate>] [-s <ms>] [-g] [-t]
+ *                 [-l <loglevel>] <scenario>...
+ *
+ * Each scenario file names the driver to exercise in a 'driver' line.
+ * The -s option stalls the session feed for the given time four times
+ * a second, like a busy host would do. Drivers which tune their USB
+ * transfers report the transfer size, count, and overflows they saw.
+ *
+ * The -t option handles libusb events on the context's event thread
+ * (see otc_usb_event_thread_set()). Drivers without a completion queue
+ * have to fall back to the session's event handling meanwhile.
+ *
+ * The -g option compares the feed's content against the SHA-256 digests
+ * in the scenario's .golden file, with 'logic' and 'analog' lines. Logic
+ * digests cover the data bytes, analog digests cover the values as
+ * little endian floats (after otc_analog_to_float()). Mismatches print
+ * the actual digests.
+ */
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+
+#define DEFAULT_SAMPLES	(10 * 1000 * 1000)
+#define STALL_INTERVAL_US	(250 * 1000)
+
+struct bench_result {
+	uint64_t samples;
+	uint64_t bytes;
+	double wall_time;
+	double cpu_time;
+	unsigned int stall_ms;
+	gint64 next_stall_us;
+	uint64_t transfer_size;
+	uint64_t transfer_count;
+	uint64_t overflow_count;
+	gboolean have_transfers;
+	GChecksum *logic_sum;
+	GChecksum *analog_sum;
+};
+
+static void bench_digest_analog(GChecksum *sum,
+	const struct otc_datafeed_analog *analog)
+{
+	float *values;
+	uint32_t bits;
+	size_t count, idx;
+
+	count = analog->num_samples * g_slist_length(analog->meaning->channels);
+	values = g_malloc(count * sizeof(values[0]));
+	if (otc_analog_to_float(analog, values) == OTC_OK) {
+		for (idx = 0; idx < count; idx++) {
+			memcpy(&bits, &values[idx], sizeof(bits));
+			bits = GUINT32_TO_LE(bits);
+			g_checksum_update(sum, (const guchar *)&bits, sizeof(bits));
+		}
+	}
+	g_free(values);
+}
+
+static void bench_datafeed(const struct otc_dev_inst *sdi,
+	const struct otc_datafeed_packet *packet, void *cb_data)
+{
+	struct bench_result *result;
+	const struct otc_datafeed_logic *logic;
+	const struct otc_datafeed_analog *analog;
+
+	(void)sdi;
+
+	result = cb_data;
+	switch (packet->type) {
+	case OTC_DF_LOGIC:
+		logic = packet->payload;
+		if (logic->unitsize)
+			result->samples += logic->length / logic->unitsize;
+		result->bytes += logic->length;
+		if (result->logic_sum)
+			g_checksum_update(result->logic_sum,
+				logic->data, logic->length);
+		break;
+	case OTC_DF_ANALOG:
+		analog = packet->payload;
+		result->samples += analog->num_samples;
+		if (result->analog_sum)
+			bench_digest_analog(result->analog_sum, analog);
+		break;
+	default:
+		break;
+	}
+
+	if (result->stall_ms && g_get_monotonic_time() >= result->next_stall_us) {
+		g_usleep(result->stall_ms * 1000);
+		result->next_stall_us = g_get_monotonic_time() + STALL_INTERVAL_US;
+	}
+}
+
+/* Compare the feed's digests against the scenario's golden file. */
+static gboolean bench_golden_check(const char *scenario,
+	struct bench_result *result)
+{
+	char *base, *filename, *contents, **lines, **fields;
+	const char *actual;
+	size_t idx;
+	gboolean ok;
+
+	base = g_str_has_suffix(scenario, ".scn") ?
+		g_strndup(scenario, strlen(scenario) - 4) : g_strdup(scenario);
+	filename = g_strconcat(base, ".golden", NULL);
+	g_free(base);
+	if (!g_file_get_contents(filename, &contents, NULL, NULL)) {
+		fprintf(stderr, "Cannot read %s.\n", filename);
+		g_free(filename);
+		return FALSE;
+	}
+	lines = g_strsplit(contents, "\n", 0);
+	g_free(contents);
+
+	ok = TRUE;
+	for (idx = 0; lines[idx]; idx++) {
+		fields = g_strsplit_set(g_strstrip(lines[idx]), " \t", 2);
+		if (!fields[0] || !*fields[0] || fields[0][0] == '#') {
+			g_strfreev(fields);
+			continue;
+		}
+		if (!strcmp(fields[0], "logic")) {
+			actual = g_checksum_get_string(result->logic_sum);
+		} else if (!strcmp(fields[0], "analog")) {
+			actual = g_checksum_get_string(result->analog_sum);
+		} else {
+			fprintf(stderr, "%s: Unknown line '%s'.\n",
+				filename, lines[idx]);
+			g_strfreev(fields);
+			ok = FALSE;
+			continue;
+		}
+		if (!fields[1] || strcmp(g_strstrip(fields[1]), actual)) {
+			fprintf(stderr, "%s: %s digest mismatch, got %s.\n",
+				filename, fields[0], actual);
+			ok = FALSE;
+		}
+		g_strfreev(fields);
+	}
+	g_strfreev(lines);
+	g_free(filename);
+
+	return ok;
+}
+
+static gboolean bench_config_uint64(const struct otc_dev_driver *driver,
+	const struct otc_dev_inst *sdi, uint32_t key, uint64_t *value)
+{
+	GVariant *gvar;
+
+	/* Not all drivers tune their transfers, don't log errors for them. */
+	if (!(otc_dev_config_capabilities_list(sdi, NULL, key) & OTC_CONF_GET))
+		return FALSE;
+	if (otc_config_get(driver, sdi, NULL, key, &gvar) != OTC_OK)
+		return FALSE;
+	*value = g_variant_get_uint64(gvar);
+	g_variant_unref(gvar);
+
+	return TRUE;
+}
+
+/* Get the driver name from the scenario's 'driver' line. */
+static char *bench_scenario_driver(const char *filename)
+{
+	char *contents, **lines, *name;
+	char **args;
+	size_t idx;
+
+	if (!g_file_get_contents(filename, &contents, NULL, NULL))
+		return NULL;
+	lines = g_strsplit(contents, "\n", 0);
+	g_free(contents);
+
+	name = NULL;
+	for (idx = 0; lines[idx] && !name; idx++) {
+		if (!g_shell_parse_argv(lines[idx], NULL, &args, NULL))
+			continue;
+		if (!strcmp(args[0], "driver") && args[1])
+			name = g_strdup(args[1]);
+		g_strfreev(args);
+	}
+	g_strfreev(lines);
+
+	return name;
+}
+
+static struct otc_dev_driver *bench_driver_find(struct otc_context *ctx,
+	const char *name)
+{
+	struct otc_dev_driver **drivers;
+	size_t idx;
+
+	drivers = otc_driver_list(ctx);
+	for (idx = 0; drivers && drivers[idx]; idx++) {
+		if (!strcmp(drivers[idx]->name, name))
+			return drivers[idx];
+	}
+
+	return NULL;
+}
+
+static int bench_run(struct otc_context *ctx, const char *driver_name,
+	uint64_t samplerate, uint64_t limit, struct bench_result *result)
+{
+	struct otc_dev_driver *driver;
+	struct otc_dev_inst *sdi;
+	struct otc_session *session;
+	GSList *devices;
+	clock_t cpu_start;
+	gint64 wall_start;
+	int ret;
+
+	driver = bench_driver_find(ctx, driver_name);
+	if (!driver) {
+		fprintf(stderr, "Driver %s not found.\n", driver_name);
+		return OTC_ERR_ARG;
+	}
+	ret = otc_driver_init(ctx, driver);
+	if (ret != OTC_OK)
+		return ret;
+	devices = otc_driver_scan(driver, NULL);
+	if (!devices) {
+		fprintf(stderr, "%s: No device found.\n", driver_name);
+		return OTC_ERR_NA;
+	}
+	sdi = devices->data;
+	g_slist_free(devices);
+
+	ret = otc_dev_open(sdi);
+	if (ret != OTC_OK)
+		return ret;
+	if (samplerate) {
+		ret = otc_config_set(sdi, NULL, OTC_CONF_SAMPLERATE,
+			g_variant_new_uint64(samplerate));
+		if (ret != OTC_OK)
+			goto out_close;
+	}
+	ret = otc_config_set(sdi, NULL, OTC_CONF_LIMIT_SAMPLES,
+		g_variant_new_uint64(limit));
+	if (ret != OTC_OK)
+		goto out_close;
+
+	ret = otc_session_new(ctx, &session);
+	if (ret != OTC_OK)
+		goto out_close;
+	otc_session_dev_add(session, sdi);
+	otc_session_datafeed_callback_add(session, bench_datafeed, result);
+
+	wall_start = g_get_monotonic_time();
+	cpu_start = clock();
+	ret = otc_session_start(session);
+	if (ret == OTC_OK)
+		ret = otc_session_run(session);
+	result->cpu_time = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+	result->wall_time = (g_get_monotonic_time() - wall_start) / 1e6;
+
+	result->have_transfers = bench_config_uint64(driver, sdi,
+			OTC_CONF_TRANSFER_SIZE, &result->transfer_size)
+		&& bench_config_uint64(driver, sdi,
+			OTC_CONF_TRANSFER_COUNT, &result->transfer_count)
+		&& bench_config_uint64(driver, sdi,
+			OTC_CONF_OVERFLOW_COUNT, &result->overflow_count);
+
+	otc_session_destroy(session);
+out_close:
+	otc_dev_close(sdi);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	struct otc_context *ctx;
+	struct bench_result result;
+	char *driver_name;
+	uint64_t samplerate, limit;
+	unsigned int stall_ms;
+	gboolean golden, event_thread;
+	int loglevel, opt, idx, failed, ret;
+
+	samplerate = 0;
+	stall_ms = 0;
+	golden = FALSE;
+	event_thread = FALSE;
+	limit = DEFAULT_SAMPLES;
+	loglevel = OTC_LOG_WARN;
+	while ((opt = getopt(argc, argv, "n:r:s:gtl:")) != -1) {
+		switch (opt) {
+		case 'n':
+			limit = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'r':
+			samplerate = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			stall_ms = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 'g':
+			golden = TRUE;
+			break;
+		case 't':
+			event_thread = TRUE;
+			break;
+		case 'l':
+			loglevel = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n samples] [-r samplerate] "
+				"[-s stall_ms] [-g] [-t] [-l loglevel] scenario...\n", argv[0]);
+			return 2;
+		}
+	}
+	if (optind >= argc || !limit) {
+		fprintf(stderr, "Usage: %s [-n samples] [-r samplerate] "
+			"[-s stall_ms] [-g] [-t] [-l loglevel] scenario...\n", argv[0]);
+		return 2;
+	}
+	otc_log_loglevel_set(loglevel);
+
+	failed = 0;
+	for (idx = optind; idx < argc; idx++) {
+		driver_name = bench_scenario_driver(argv[idx]);
+		if (!driver_name) {
+			fprintf(stderr, "%s: No driver specified.\n", argv[idx]);
+			failed++;
+			continue;
+		}
+
+		/* The USB mock picks up the scenario in libusb_init(). */
+		g_setenv("OTC_USBMOCK_SCENARIO", argv[idx], TRUE);
+		ret = otc_init(&ctx);
+		if (ret != OTC_OK) {
+			fprintf(stderr, "%s: Initialization failed.\n", argv[idx]);
+			g_free(driver_name);
+			failed++;
+			continue;
+		}
+		if (event_thread)
+			otc_usb_event_thread_set(ctx, TRUE);
+
+		memset(&result, 0, sizeof(result));
+		result.stall_ms = stall_ms;
+		if (golden) {
+			result.logic_sum = g_checksum_new(G_CHECKSUM_SHA256);
+			result.analog_sum = g_checksum_new(G_CHECKSUM_SHA256);
+		}
+		ret = bench_run(ctx, driver_name, samplerate, limit, &result);
+		if (ret != OTC_OK || result.samples < limit) {
+			fprintf(stderr, "%s: Acquisition failed (%" PRIu64
+				" of %" PRIu64 " samples).\n", driver_name,
+				result.samples, limit);
+			failed++;
+		} else if (golden && !bench_golden_check(argv[idx], &result)) {
+			failed++;
+		} else {
+			printf("%-24s %12" PRIu64 " samples %8.3f s "
+				"%9.2f Msamples/s %8.3f s CPU (%5.1f%%)\n",
+				driver_name, result.samples, result.wall_time,
+				result.samples / result.wall_time / 1e6,
+				result.cpu_time,
+				100.0 * result.cpu_time / result.wall_time);
+			if (result.have_transfers)
+				printf("%-24s %" PRIu64 " transfers of %" PRIu64
+					" bytes, %" PRIu64 " overflows\n", "",
+					result.transfer_count,
+					result.transfer_size,
+					result.overflow_count);
+		}
+
+		if (golden) {
+			g_checksum_free(result.logic_sum);
+			g_checksum_free(result.analog_sum);
+		}
+		otc_exit(ctx);
+		g_free(driver_name);
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,1487 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replacement for the libusb library, for tests and benchmarks only.
+ * Gets compiled into the library when the 'usb_mock' build option is
+ * enabled, and implements the subset of the libusb API which drivers
+ * use. No USB hardware gets accessed.
+ *
+ * The OTC_USBMOCK_SCENARIO environment variable names a text file which
+ * describes the emulated devices. Without it, no devices are found.
+ * Lines hold a keyword and its arguments, '#' starts a comment, quoting
+ * works like in the shell. Numbers take a 0x prefix for hex notation.
+ *
+ *   driver <name>
+ *     Driver to exercise, used by the benchmark runner, ignored here.
+ *
+ *   device <vid>:<pid> [bus <n>] [address <n>] [port <n>[.<n>...]]
+ *          [manufacturer <s>] [product <s>] [serial <s>] [class <n>]
+ *     Start the description of another device. VID and PID are hex.
+ *     Subsequent lines apply to the most recent device.
+ *
+ *   control <type> <request> <value|*> <index|*> [in <hex>] [stall] [once]
+ *     Respond to control transfers which match the setup fields. IN
+ *     requests return the 'in' data, OUT requests accept any data.
+ *     'once' rules get used up, and take precedence as long as they
+ *     exist, which allows to replay recorded sequences of responses.
+ *     IN requests without a matching rule stall.
+ *
+ *   endpoint <address> [bulk|interrupt] [maxpacket <n>] [rate <bytes/s>]
+ *            [fifo <bytes>] [pattern zero|counter|random] [file <path>]
+ *     Configure a data endpoint. IN endpoints synthesize data from the
+ *     pattern, or replay the content of a file in a loop (paths are
+ *     relative to the scenario file). The rate paces transfers like a
+ *     link of that throughput would do. Without a rate, transfers
+ *     complete as fast as they get handled. With a FIFO size, the
+ *     endpoint behaves like a streaming device instead: it keeps
+ *     producing data at the rate while no transfer is pending, and
+ *     drops what doesn't fit into its FIFO (which gets reported).
+ *
+ * There are no file descriptors to poll. The library's USB event source
+ * gets woken up by libusb_get_next_timeout() instead, which reports when
+ * the next transfer completes.
+ *
+ * The libusb functions here have hidden visibility. They replace libusb
+ * for the library's own code only, and don't interpose the real libusb
+ * for other libraries in the process. The build disables libftdi and
+ * hidapi with the mock, their drivers would mix up both.
+ */
+
+#include <config.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__GNUC__) && !defined(_WIN32)
+#pragma GCC visibility push(hidden)
+#include <libusb.h>
+#pragma GCC visibility pop
+#else
+#include <libusb.h>
+#endif
+#include <opentracecapture/libopentracecapture.h>
+#include "src/libopentracecapture-internal.h"
+
+#define LOG_PREFIX "usbmock"
+
+#define USBMOCK_SCENARIO_ENV	"OTC_USBMOCK_SCENARIO"
+#define USBMOCK_MAX_PORTS	7
+
+enum usbmock_pattern {
+	USBMOCK_PATTERN_ZERO,
+	USBMOCK_PATTERN_COUNTER,
+	USBMOCK_PATTERN_RANDOM,
+};
+
+struct usbmock_control {
+	uint8_t request_type;
+	uint8_t request;
+	int value;	/* -1 matches any value. */
+	int index;	/* -1 matches any index. */
+	GByteArray *data;
+	gboolean stall;
+	gboolean once;
+};
+
+struct usbmock_endpoint {
+	uint8_t address;
+	uint8_t attributes;
+	uint16_t max_packet;
+	uint64_t rate;
+	uint64_t fifo;
+	enum usbmock_pattern pattern;
+	GByteArray *payload;
+	size_t payload_pos;
+	uint8_t counter;
+	uint64_t rng;
+	int64_t busy_until;
+	uint64_t bytes;
+	uint64_t dropped;
+};
+
+struct libusb_context {
+	GSList *devices;
+	/*
+	 * Drivers submit and cancel transfers from acquisition threads
+	 * while the event thread handles events, the mutex protects the
+	 * pending list and the submit sequence. Callbacks run unlocked.
+	 */
+	GMutex mutex;
+	GList *pending;
+	uint64_t submit_seq;
+	/* Wakes up event handling on submissions and interruptions. */
+	GCond cond;
+	gboolean interrupted;
+	/* The event lock, held while handling events and running callbacks. */
+	GMutex events;
+};
+
+struct libusb_device {
+	struct libusb_context *ctx;
+	struct libusb_device_descriptor desc;
+	uint8_t bus;
+	uint8_t address;
+	uint8_t ports[USBMOCK_MAX_PORTS];
+	int port_count;
+	uint8_t interface_class;
+	char *strings[4];
+	GSList *controls;
+	GSList *endpoints;
+};
+
+struct libusb_device_handle {
+	struct libusb_device *dev;
+};
+
+struct usbmock_transfer {
+	int64_t due_us;
+	uint64_t seq;
+	gboolean pending;
+	gboolean cancelled;
+	enum libusb_transfer_status status;
+	/* Must be last, libusb transfers end in a flexible array. */
+	struct libusb_transfer xfer;
+};
+
+static struct libusb_context *default_ctx;
+
+static struct usbmock_transfer *usbmock_transfer_get(struct libusb_transfer *xfer)
+{
+	return (void *)((char *)xfer - offsetof(struct usbmock_transfer, xfer));
+}
+
+static struct libusb_context *usbmock_ctx(struct libusb_context *ctx)
+{
+	return ctx ? ctx : default_ctx;
+}
+
+static void usbmock_control_free(void *data)
+{
+	struct usbmock_control *ctrl;
+
+	ctrl = data;
+	if (ctrl->data)
+		g_byte_array_unref(ctrl->data);
+	g_free(ctrl);
+}
+
+static void usbmock_endpoint_free(void *data)
+{
+	struct usbmock_endpoint *ep;
+
+	ep = data;
+	if (ep->payload)
+		g_byte_array_unref(ep->payload);
+	g_free(ep);
+}
+
+static void usbmock_device_free(void *data)
+{
+	struct libusb_device *dev;
+	size_t idx;
+
+	dev = data;
+	for (idx = 0; idx < ARRAY_SIZE(dev->strings); idx++)
+		g_free(dev->strings[idx]);
+	g_slist_free_full(dev->controls, usbmock_control_free);
+	g_slist_free_full(dev->endpoints, usbmock_endpoint_free);
+	g_free(dev);
+}
+
+static gboolean usbmock_parse_uint(const char *text, int base,
+	unsigned long max, unsigned long *value)
+{
+	char *end;
+
+	if (!text || !*text)
+		return FALSE;
+	*value = strtoul(text, &end, base);
+	if (*end || *value > max)
+		return FALSE;
+
+	return TRUE;
+}
+
+static GByteArray *usbmock_parse_hex(const char *text)
+{
+	GByteArray *data;
+	char digits[3];
+	uint8_t byte;
+
+	data = g_byte_array_new();
+	digits[2] = '\0';
+	while (*text) {
+		if (!g_ascii_isxdigit(text[0]) || !g_ascii_isxdigit(text[1])) {
+			g_byte_array_unref(data);
+			return NULL;
+		}
+		digits[0] = text[0];
+		digits[1] = text[1];
+		byte = strtoul(digits, NULL, 16);
+		g_byte_array_append(data, &byte, sizeof(byte));
+		text += 2;
+	}
+
+	return data;
+}
+
+static int usbmock_parse_device(struct libusb_context *ctx, char **args)
+{
+	struct libusb_device *dev;
+	unsigned long vid, pid, num;
+	char **ports;
+	size_t idx;
+	const char *key, *val;
+
+	if (!args[1] || sscanf(args[1], "%lx:%lx", &vid, &pid) != 2)
+		return OTC_ERR_DATA;
+
+	dev = g_malloc0(sizeof(*dev));
+	dev->ctx = ctx;
+	dev->desc.bLength = LIBUSB_DT_DEVICE_SIZE;
+	dev->desc.bDescriptorType = LIBUSB_DT_DEVICE;
+	dev->desc.bcdUSB = 0x0200;
+	dev->desc.bMaxPacketSize0 = 64;
+	dev->desc.idVendor = vid;
+	dev->desc.idProduct = pid;
+	dev->desc.bNumConfigurations = 1;
+	dev->bus = 1;
+	dev->address = g_slist_length(ctx->devices) + 2;
+	dev->interface_class = LIBUSB_CLASS_VENDOR_SPEC;
+	ctx->devices = g_slist_append(ctx->devices, dev);
+
+	for (idx = 2; args[idx]; idx += 2) {
+		key = args[idx];
+		val = args[idx + 1];
+		if (!val)
+			return OTC_ERR_DATA;
+		if (!strcmp(key, "manufacturer")) {
+			dev->strings[1] = g_strdup(val);
+			dev->desc.iManufacturer = 1;
+		} else if (!strcmp(key, "product")) {
+			dev->strings[2] = g_strdup(val);
+			dev->desc.iProduct = 2;
+		} else if (!strcmp(key, "serial")) {
+			dev->strings[3] = g_strdup(val);
+			dev->desc.iSerialNumber = 3;
+		} else if (!strcmp(key, "bus")) {
+			if (!usbmock_parse_uint(val, 0, UINT8_MAX, &num))
+				return OTC_ERR_DATA;
+			dev->bus = num;
+		} else if (!strcmp(key, "address")) {
+			if (!usbmock_parse_uint(val, 0, UINT8_MAX, &num))
+				return OTC_ERR_DATA;
+			dev->address = num;
+		} else if (!strcmp(key, "class")) {
+			if (!usbmock_parse_uint(val, 0, UINT8_MAX, &num))
+				return OTC_ERR_DATA;
+			dev->interface_class = num;
+		} else if (!strcmp(key, "port")) {
+			ports = g_strsplit(val, ".", USBMOCK_MAX_PORTS);
+			dev->port_count = 0;
+			while (ports[dev->port_count]) {
+				if (!usbmock_parse_uint(ports[dev->port_count],
+						0, UINT8_MAX, &num)) {
+					g_strfreev(ports);
+					return OTC_ERR_DATA;
+				}
+				dev->ports[dev->port_count++] = num;
+			}
+			g_strfreev(ports);
+		} else {
+			return OTC_ERR_DATA;
+		}
+	}
+	if (!dev->port_count) {
+		dev->ports[0] = dev->address;
+		dev->port_count = 1;
+	}
+
+	return OTC_OK;
+}
+
+static int usbmock_parse_control(struct libusb_device *dev, char **args)
+{
+	struct usbmock_control *ctrl;
+	unsigned long num;
+	size_t idx;
+
+	if (!args[1] || !args[2] || !args[3] || !args[4])
+		return OTC_ERR_DATA;
+
+	ctrl = g_malloc0(sizeof(*ctrl));
+	dev->controls = g_slist_append(dev->controls, ctrl);
+
+	if (!usbmock_parse_uint(args[1], 0, UINT8_MAX, &num))
+		return OTC_ERR_DATA;
+	ctrl->request_type = num;
+	if (!usbmock_parse_uint(args[2], 0, UINT8_MAX, &num))
+		return OTC_ERR_DATA;
+	ctrl->request = num;
+	ctrl->value = -1;
+	if (strcmp(args[3], "*")) {
+		if (!usbmock_parse_uint(args[3], 0, UINT16_MAX, &num))
+			return OTC_ERR_DATA;
+		ctrl->value = num;
+	}
+	ctrl->index = -1;
+	if (strcmp(args[4], "*")) {
+		if (!usbmock_parse_uint(args[4], 0, UINT16_MAX, &num))
+			return OTC_ERR_DATA;
+		ctrl->index = num;
+	}
+
+	for (idx = 5; args[idx]; idx++) {
+		if (!strcmp(args[idx], "stall")) {
+			ctrl->stall = TRUE;
+		} else if (!strcmp(args[idx], "once")) {
+			ctrl->once = TRUE;
+		} else if (!strcmp(args[idx], "in") && args[idx + 1]) {
+			if (ctrl->data)
+				g_byte_array_unref(ctrl->data);
+			ctrl->data = usbmock_parse_hex(args[++idx]);
+			if (!ctrl->data)
+				return OTC_ERR_DATA;
+		} else {
+			return OTC_ERR_DATA;
+		}
+	}
+
+	return OTC_OK;
+}
+
+static int usbmock_parse_endpoint(struct libusb_device *dev, char **args,
+	const char *dirname)
+{
+	struct usbmock_endpoint *ep;
+	unsigned long num;
+	size_t idx;
+	char *path, *contents;
+	gsize length;
+	const char *val;
+
+	if (!usbmock_parse_uint(args[1], 0, UINT8_MAX, &num))
+		return OTC_ERR_DATA;
+
+	ep = g_malloc0(sizeof(*ep));
+	dev->endpoints = g_slist_append(dev->endpoints, ep);
+	ep->address = num;
+	ep->attributes = LIBUSB_TRANSFER_TYPE_BULK;
+	ep->max_packet = 512;
+	ep->pattern = USBMOCK_PATTERN_COUNTER;
+	ep->rng = 0x9e3779b97f4a7c15ULL ^ ep->address;
+
+	for (idx = 2; args[idx]; idx++) {
+		if (!strcmp(args[idx], "bulk")) {
+			ep->attributes = LIBUSB_TRANSFER_TYPE_BULK;
+			continue;
+		}
+		if (!strcmp(args[idx], "interrupt")) {
+			ep->attributes = LIBUSB_TRANSFER_TYPE_INTERRUPT;
+			continue;
+		}
+		val = args[idx + 1];
+		if (!val)
+			return OTC_ERR_DATA;
+		if (!strcmp(args[idx], "maxpacket")) {
+			if (!usbmock_parse_uint(val, 0, UINT16_MAX, &num))
+				return OTC_ERR_DATA;
+			ep->max_packet = num;
+		} else if (!strcmp(args[idx], "rate")) {
+			if (!usbmock_parse_uint(val, 0, ULONG_MAX, &num))
+				return OTC_ERR_DATA;
+			ep->rate = num;
+		} else if (!strcmp(args[idx], "fifo")) {
+			if (!usbmock_parse_uint(val, 0, ULONG_MAX, &num))
+				return OTC_ERR_DATA;
+			ep->fifo = num;
+		} else if (!strcmp(args[idx], "pattern")) {
+			if (!strcmp(val, "zero"))
+				ep->pattern = USBMOCK_PATTERN_ZERO;
+			else if (!strcmp(val, "counter"))
+				ep->pattern = USBMOCK_PATTERN_COUNTER;
+			else if (!strcmp(val, "random"))
+				ep->pattern = USBMOCK_PATTERN_RANDOM;
+			else
+				return OTC_ERR_DATA;
+		} else if (!strcmp(args[idx], "file")) {
+			path = g_path_is_absolute(val) ? g_strdup(val) :
+				g_build_filename(dirname, val, NULL);
+			if (!g_file_get_contents(path, &contents, &length, NULL)) {
+				otc_err("Cannot read endpoint data file %s.", path);
+				g_free(path);
+				return OTC_ERR_IO;
+			}
+			g_free(path);
+			if (!length) {
+				g_free(contents);
+				return OTC_ERR_DATA;
+			}
+			if (ep->payload)
+				g_byte_array_unref(ep->payload);
+			ep->payload = g_byte_array_new_take((guint8 *)contents, length);
+		} else {
+			return OTC_ERR_DATA;
+		}
+		idx++;
+	}
+
+	return OTC_OK;
+}
+
+static int usbmock_load_scenario(struct libusb_context *ctx, const char *filename)
+{
+	char *contents, **lines, **args, *dirname;
+	struct libusb_device *dev;
+	size_t line;
+	GError *error;
+	int ret;
+
+	if (!g_file_get_contents(filename, &contents, NULL, NULL)) {
+		otc_err("Cannot read scenario file %s.", filename);
+		return OTC_ERR_IO;
+	}
+	lines = g_strsplit(contents, "\n", 0);
+	g_free(contents);
+	dirname = g_path_get_dirname(filename);
+
+	ret = OTC_OK;
+	dev = NULL;
+	for (line = 0; lines[line] && ret == OTC_OK; line++) {
+		error = NULL;
+		if (!g_shell_parse_argv(lines[line], NULL, &args, &error)) {
+			if (error->code != G_SHELL_ERROR_EMPTY_STRING)
+				ret = OTC_ERR_DATA;
+			g_error_free(error);
+			if (ret == OTC_OK)
+				continue;
+			break;
+		}
+		if (!strcmp(args[0], "driver")) {
+			/* Meta information for the benchmark runner. */
+		} else if (!strcmp(args[0], "device")) {
+			ret = usbmock_parse_device(ctx, args);
+			dev = g_slist_last(ctx->devices)->data;
+		} else if (!dev) {
+			ret = OTC_ERR_DATA;
+		} else if (!strcmp(args[0], "control")) {
+			ret = usbmock_parse_control(dev, args);
+		} else if (!strcmp(args[0], "endpoint")) {
+			ret = usbmock_parse_endpoint(dev, args, dirname);
+		} else {
+			ret = OTC_ERR_DATA;
+		}
+		g_strfreev(args);
+	}
+	if (ret != OTC_OK)
+		otc_err("%s:%zu: Invalid scenario line.", filename, line + 1);
+
+	g_free(dirname);
+	g_strfreev(lines);
+
+	return ret;
+}
+
+static struct usbmock_endpoint *usbmock_endpoint_find(struct libusb_device *dev,
+	uint8_t address)
+{
+	struct usbmock_endpoint *ep;
+	GSList *l;
+
+	for (l = dev->endpoints; l; l = l->next) {
+		ep = l->data;
+		if (ep->address == address)
+			return ep;
+	}
+
+	return NULL;
+}
+
+/* Produce another chunk of an IN endpoint's data stream. */
+static void usbmock_endpoint_fill(struct usbmock_endpoint *ep,
+	uint8_t *buf, size_t len)
+{
+	size_t copy_len;
+	uint64_t x;
+
+	ep->bytes += len;
+	if (ep->payload) {
+		while (len) {
+			copy_len = ep->payload->len - ep->payload_pos;
+			copy_len = MIN(copy_len, len);
+			memcpy(buf, ep->payload->data + ep->payload_pos, copy_len);
+			buf += copy_len;
+			len -= copy_len;
+			ep->payload_pos += copy_len;
+			if (ep->payload_pos == ep->payload->len)
+				ep->payload_pos = 0;
+		}
+		return;
+	}
+
+	switch (ep->pattern) {
+	case USBMOCK_PATTERN_ZERO:
+		memset(buf, 0, len);
+		break;
+	case USBMOCK_PATTERN_COUNTER:
+		while (len--)
+			*buf++ = ep->counter++;
+		break;
+	case USBMOCK_PATTERN_RANDOM:
+		x = ep->rng;
+		while (len--) {
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+			*buf++ = x >> 56;
+		}
+		ep->rng = x;
+		break;
+	}
+}
+
+/* Determine when a transfer of 'len' bytes completes on the endpoint. */
+static int64_t usbmock_endpoint_schedule(struct usbmock_endpoint *ep, size_t len)
+{
+	int64_t now, start, oldest;
+	uint64_t lost;
+
+	now = g_get_monotonic_time();
+	if (!ep->rate)
+		return now;
+
+	if (!ep->fifo || !ep->busy_until) {
+		start = MAX(now, ep->busy_until);
+		ep->busy_until = start + len * G_USEC_PER_SEC / ep->rate;
+		return ep->busy_until;
+	}
+
+	/*
+	 * A streaming device. Data which it produced since the previous
+	 * transfer waits in the FIFO, older data is lost.
+	 */
+	oldest = now - (int64_t)(ep->fifo * G_USEC_PER_SEC / ep->rate);
+	if (ep->busy_until < oldest) {
+		lost = (oldest - ep->busy_until) * ep->rate / G_USEC_PER_SEC;
+		otc_warn("Endpoint 0x%02x: FIFO overrun, %" PRIu64
+			" bytes lost.", ep->address, lost);
+		ep->dropped += lost;
+		ep->busy_until = oldest;
+	}
+	ep->busy_until += len * G_USEC_PER_SEC / ep->rate;
+
+	return MAX(now, ep->busy_until);
+}
+
+static void usbmock_sleep_until(int64_t due_us)
+{
+	int64_t now;
+
+	now = g_get_monotonic_time();
+	if (due_us > now)
+		g_usleep(due_us - now);
+}
+
+/* Build a string descriptor for a standard GET_DESCRIPTOR request. */
+static int usbmock_string_descriptor(struct libusb_device *dev, uint8_t index,
+	uint8_t *data, uint16_t length)
+{
+	uint8_t desc[2 + 2 * 126];
+	size_t desc_len, idx;
+	const char *text;
+
+	if (!index) {
+		/* Language ID list, US English only. */
+		desc_len = 4;
+		desc[2] = 0x09;
+		desc[3] = 0x04;
+	} else {
+		if (index >= ARRAY_SIZE(dev->strings) || !dev->strings[index])
+			return LIBUSB_ERROR_PIPE;
+		text = dev->strings[index];
+		desc_len = 2;
+		for (idx = 0; text[idx] && desc_len < sizeof(desc); idx++) {
+			desc[desc_len++] = text[idx];
+			desc[desc_len++] = 0;
+		}
+	}
+	desc[0] = desc_len;
+	desc[1] = LIBUSB_DT_STRING;
+
+	desc_len = MIN(desc_len, length);
+	memcpy(data, desc, desc_len);
+
+	return desc_len;
+}
+
+static gboolean usbmock_control_matches(const struct usbmock_control *ctrl,
+	uint8_t request_type, uint8_t request, uint16_t value, uint16_t index)
+{
+	if (ctrl->request_type != request_type || ctrl->request != request)
+		return FALSE;
+	if (ctrl->value >= 0 && ctrl->value != value)
+		return FALSE;
+	if (ctrl->index >= 0 && ctrl->index != index)
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Execute a control request, return the data length or an error code. */
+static int usbmock_control(struct libusb_device *dev, uint8_t request_type,
+	uint8_t request, uint16_t value, uint16_t index,
+	uint8_t *data, uint16_t length)
+{
+	struct usbmock_control *ctrl, *match;
+	GSList *l;
+	int ret;
+
+	if (request_type == LIBUSB_ENDPOINT_IN &&
+			request == LIBUSB_REQUEST_GET_DESCRIPTOR &&
+			(value >> 8) == LIBUSB_DT_STRING)
+		return usbmock_string_descriptor(dev, value & 0xff, data, length);
+
+	/* Consumable rules replay a sequence, and take precedence. */
+	match = NULL;
+	for (l = dev->controls; l && !match; l = l->next) {
+		ctrl = l->data;
+		if (ctrl->once && usbmock_control_matches(ctrl,
+				request_type, request, value, index))
+			match = ctrl;
+	}
+	for (l = dev->controls; l && !match; l = l->next) {
+		ctrl = l->data;
+		if (usbmock_control_matches(ctrl,
+				request_type, request, value, index))
+			match = ctrl;
+	}
+
+	if (!match) {
+		if (request_type & LIBUSB_ENDPOINT_IN) {
+			otc_dbg("No response for control request %02x/%02x "
+				"(value %04x, index %04x).",
+				request_type, request, value, index);
+			return LIBUSB_ERROR_PIPE;
+		}
+		return length;
+	}
+
+	ret = length;
+	if (match->stall) {
+		ret = LIBUSB_ERROR_PIPE;
+	} else if (request_type & LIBUSB_ENDPOINT_IN) {
+		ret = match->data ? MIN(match->data->len, length) : 0;
+		if (ret)
+			memcpy(data, match->data->data, ret);
+	}
+	if (match->once) {
+		dev->controls = g_slist_remove(dev->controls, match);
+		usbmock_control_free(match);
+	}
+
+	return ret;
+}
+
+static void usbmock_pending_insert(struct libusb_context *ctx,
+	struct usbmock_transfer *mt)
+{
+	GList *l;
+
+	/* Keep the list sorted by due time, FIFO for equal due times. */
+	for (l = g_list_last(ctx->pending); l; l = l->prev) {
+		if (((struct usbmock_transfer *)l->data)->due_us <= mt->due_us)
+			break;
+	}
+	if (l)
+		ctx->pending = g_list_insert_before(ctx->pending, l->next, mt);
+	else
+		ctx->pending = g_list_prepend(ctx->pending, mt);
+	mt->pending = TRUE;
+}
+
+static void usbmock_pending_remove(struct libusb_context *ctx,
+	struct usbmock_transfer *mt)
+{
+	ctx->pending = g_list_remove(ctx->pending, mt);
+	mt->pending = FALSE;
+}
+
+static void usbmock_transfer_complete(struct usbmock_transfer *mt)
+{
+	struct libusb_transfer *xfer;
+	struct libusb_device *dev;
+	struct usbmock_endpoint *ep;
+	struct libusb_control_setup *setup;
+	uint8_t flags;
+	int ret;
+
+	xfer = &mt->xfer;
+	dev = xfer->dev_handle->dev;
+
+	if (mt->cancelled) {
+		xfer->status = LIBUSB_TRANSFER_CANCELLED;
+		xfer->actual_length = 0;
+	} else if (xfer->type == LIBUSB_TRANSFER_TYPE_CONTROL) {
+		setup = (void *)xfer->buffer;
+		ret = usbmock_control(dev, setup->bmRequestType,
+			setup->bRequest, libusb_le16_to_cpu(setup->wValue),
+			libusb_le16_to_cpu(setup->wIndex),
+			xfer->buffer + LIBUSB_CONTROL_SETUP_SIZE,
+			libusb_le16_to_cpu(setup->wLength));
+		xfer->status = LIBUSB_TRANSFER_COMPLETED;
+		xfer->actual_length = ret;
+		if (ret < 0) {
+			xfer->status = LIBUSB_TRANSFER_STALL;
+			xfer->actual_length = 0;
+		}
+	} else {
+		xfer->status = mt->status;
+		xfer->actual_length = 0;
+		ep = usbmock_endpoint_find(dev, xfer->endpoint);
+		if (mt->status == LIBUSB_TRANSFER_COMPLETED) {
+			xfer->actual_length = xfer->length;
+			if (ep && (xfer->endpoint & LIBUSB_ENDPOINT_IN))
+				usbmock_endpoint_fill(ep,
+					xfer->buffer, xfer->length);
+			else if (ep)
+				ep->bytes += xfer->length;
+		}
+	}
+
+	/* Like libusb: Don't touch the transfer after its callback returned. */
+	flags = xfer->flags;
+	if (xfer->callback)
+		xfer->callback(xfer);
+	if (flags & LIBUSB_TRANSFER_FREE_TRANSFER)
+		libusb_free_transfer(xfer);
+}
+
+int LIBUSB_CALL libusb_init(libusb_context **ctx)
+{
+	struct libusb_context *context;
+	const char *scenario;
+	int ret;
+
+	if (!ctx && default_ctx)
+		return LIBUSB_SUCCESS;
+
+	context = g_malloc0(sizeof(*context));
+	g_mutex_init(&context->mutex);
+	g_cond_init(&context->cond);
+	g_mutex_init(&context->events);
+	scenario = g_getenv(USBMOCK_SCENARIO_ENV);
+	if (scenario && *scenario) {
+		otc_info("Emulating USB devices from %s.", scenario);
+		ret = usbmock_load_scenario(context, scenario);
+		if (ret != OTC_OK) {
+			g_slist_free_full(context->devices, usbmock_device_free);
+			g_mutex_clear(&context->mutex);
+			g_cond_clear(&context->cond);
+			g_mutex_clear(&context->events);
+			g_free(context);
+			return LIBUSB_ERROR_OTHER;
+		}
+	}
+
+	if (ctx)
+		*ctx = context;
+	else
+		default_ctx = context;
+
+	return LIBUSB_SUCCESS;
+}
+
+void LIBUSB_CALL libusb_exit(libusb_context *ctx)
+{
+	struct libusb_device *dev;
+	struct usbmock_endpoint *ep;
+	GSList *l, *m;
+
+	ctx = usbmock_ctx(ctx);
+	if (!ctx)
+		return;
+
+	for (l = ctx->devices; l; l = l->next) {
+		dev = l->data;
+		for (m = dev->endpoints; m; m = m->next) {
+			ep = m->data;
+			otc_dbg("Device %04x:%04x endpoint 0x%02x: "
+				"%" PRIu64 " bytes transferred, %" PRIu64
+				" bytes dropped.",
+				dev->desc.idVendor, dev->desc.idProduct,
+				ep->address, ep->bytes, ep->dropped);
+		}
+	}
+	if (ctx->pending)
+		otc_warn("%u transfer(s) still pending at exit.",
+			g_list_length(ctx->pending));
+	g_list_free(ctx->pending);
+	g_slist_free_full(ctx->devices, usbmock_device_free);
+	if (ctx == default_ctx)
+		default_ctx = NULL;
+	g_mutex_clear(&ctx->mutex);
+	g_cond_clear(&ctx->cond);
+	g_mutex_clear(&ctx->events);
+	g_free(ctx);
+}
+
+const struct libusb_version * LIBUSB_CALL libusb_get_version(void)
+{
+	static const struct libusb_version version = {
+		1, 0, 0, 0, "-usbmock", "",
+	};
+
+	return &version;
+}
+
+int LIBUSB_CALL libusb_has_capability(uint32_t capability)
+{
+	return capability == LIBUSB_CAP_HAS_CAPABILITY ||
+		capability == LIBUSB_CAP_SUPPORTS_DETACH_KERNEL_DRIVER;
+}
+
+const char * LIBUSB_CALL libusb_error_name(int errcode)
+{
+	switch (errcode) {
+	case LIBUSB_SUCCESS:
+		return "LIBUSB_SUCCESS";
+	case LIBUSB_ERROR_IO:
+		return "LIBUSB_ERROR_IO";
+	case LIBUSB_ERROR_INVALID_PARAM:
+		return "LIBUSB_ERROR_INVALID_PARAM";
+	case LIBUSB_ERROR_ACCESS:
+		return "LIBUSB_ERROR_ACCESS";
+	case LIBUSB_ERROR_NO_DEVICE:
+		return "LIBUSB_ERROR_NO_DEVICE";
+	case LIBUSB_ERROR_NOT_FOUND:
+		return "LIBUSB_ERROR_NOT_FOUND";
+	case LIBUSB_ERROR_BUSY:
+		return "LIBUSB_ERROR_BUSY";
+	case LIBUSB_ERROR_TIMEOUT:
+		return "LIBUSB_ERROR_TIMEOUT";
+	case LIBUSB_ERROR_OVERFLOW:
+		return "LIBUSB_ERROR_OVERFLOW";
+	case LIBUSB_ERROR_PIPE:
+		return "LIBUSB_ERROR_PIPE";
+	case LIBUSB_ERROR_INTERRUPTED:
+		return "LIBUSB_ERROR_INTERRUPTED";
+	case LIBUSB_ERROR_NO_MEM:
+		return "LIBUSB_ERROR_NO_MEM";
+	case LIBUSB_ERROR_NOT_SUPPORTED:
+		return "LIBUSB_ERROR_NOT_SUPPORTED";
+	default:
+		return "LIBUSB_ERROR_OTHER";
+	}
+}
+
+ssize_t LIBUSB_CALL libusb_get_device_list(libusb_context *ctx,
+	libusb_device ***list)
+{
+	libusb_device **devs;
+	GSList *l;
+	size_t count;
+
+	ctx = usbmock_ctx(ctx);
+	if (!list)
+		return LIBUSB_ERROR_INVALID_PARAM;
+
+	count = ctx ? g_slist_length(ctx->devices) : 0;
+	devs = g_malloc0((count + 1) * sizeof(devs[0]));
+	count = 0;
+	for (l = ctx ? ctx->devices : NULL; l; l = l->next)
+		devs[count++] = l->data;
+	*list = devs;
+
+	return count;
+}
+
+void LIBUSB_CALL libusb_free_device_list(libusb_device **list, int unref_devices)
+{
+	/* Devices live as long as the context does. */
+	(void)unref_devices;
+
+	g_free(list);
+}
+
+libusb_device * LIBUSB_CALL libusb_ref_device(libusb_device *dev)
+{
+	return dev;
+}
+
+void LIBUSB_CALL libusb_unref_device(libusb_device *dev)
+{
+	(void)dev;
+}
+
+uint8_t LIBUSB_CALL libusb_get_bus_number(libusb_device *dev)
+{
+	return dev->bus;
+}
+
+uint8_t LIBUSB_CALL libusb_get_device_address(libusb_device *dev)
+{
+	return dev->address;
+}
+
+int LIBUSB_CALL libusb_get_port_numbers(libusb_device *dev,
+	uint8_t *port_numbers, int port_numbers_len)
+{
+	if (port_numbers_len < dev->port_count)
+		return LIBUSB_ERROR_OVERFLOW;
+	memcpy(port_numbers, dev->ports, dev->port_count);
+
+	return dev->port_count;
+}
+
+int LIBUSB_CALL libusb_get_device_descriptor(libusb_device *dev,
+	struct libusb_device_descriptor *desc)
+{
+	*desc = dev->desc;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_get_config_descriptor(libusb_device *dev,
+	uint8_t config_index, struct libusb_config_descriptor **config)
+{
+	struct libusb_config_descriptor *cfg;
+	struct libusb_interface *intf;
+	struct libusb_interface_descriptor *alt;
+	struct libusb_endpoint_descriptor *eps;
+	struct usbmock_endpoint *ep;
+	GSList *l;
+	size_t idx;
+
+	if (config_index)
+		return LIBUSB_ERROR_NOT_FOUND;
+
+	/* One configuration, with one interface holding all endpoints. */
+	eps = g_new0(struct libusb_endpoint_descriptor,
+		g_slist_length(dev->endpoints));
+	for (l = dev->endpoints, idx = 0; l; l = l->next, idx++) {
+		ep = l->data;
+		eps[idx].bLength = LIBUSB_DT_ENDPOINT_SIZE;
+		eps[idx].bDescriptorType = LIBUSB_DT_ENDPOINT;
+		eps[idx].bEndpointAddress = ep->address;
+		eps[idx].bmAttributes = ep->attributes;
+		eps[idx].wMaxPacketSize = ep->max_packet;
+	}
+
+	alt = g_malloc0(sizeof(*alt));
+	alt->bLength = LIBUSB_DT_INTERFACE_SIZE;
+	alt->bDescriptorType = LIBUSB_DT_INTERFACE;
+	alt->bNumEndpoints = idx;
+	alt->bInterfaceClass = dev->interface_class;
+	alt->endpoint = eps;
+
+	intf = g_malloc0(sizeof(*intf));
+	intf->altsetting = alt;
+	intf->num_altsetting = 1;
+
+	cfg = g_malloc0(sizeof(*cfg));
+	cfg->bLength = LIBUSB_DT_CONFIG_SIZE;
+	cfg->bDescriptorType = LIBUSB_DT_CONFIG;
+	cfg->bNumInterfaces = 1;
+	cfg->bConfigurationValue = 1;
+	cfg->interface = intf;
+	*config = cfg;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_get_active_config_descriptor(libusb_device *dev,
+	struct libusb_config_descriptor **config)
+{
+	return libusb_get_config_descriptor(dev, 0, config);
+}
+
+void LIBUSB_CALL libusb_free_config_descriptor(struct libusb_config_descriptor *config)
+{
+	if (!config)
+		return;
+
+	g_free((void *)config->interface->altsetting->endpoint);
+	g_free((void *)config->interface->altsetting);
+	g_free((void *)config->interface);
+	g_free(config);
+}
+
+int LIBUSB_CALL libusb_open(libusb_device *dev, libusb_device_handle **dev_handle)
+{
+	struct libusb_device_handle *hdl;
+
+	hdl = g_malloc0(sizeof(*hdl));
+	hdl->dev = dev;
+	*dev_handle = hdl;
+
+	return LIBUSB_SUCCESS;
+}
+
+void LIBUSB_CALL libusb_close(libusb_device_handle *dev_handle)
+{
+	struct libusb_context *ctx;
+	struct usbmock_transfer *mt;
+	GList *l, *next;
+
+	if (!dev_handle)
+		return;
+
+	/* Transfers of a closed handle never complete. */
+	ctx = dev_handle->dev->ctx;
+	g_mutex_lock(&ctx->mutex);
+	for (l = ctx->pending; l; l = next) {
+		next = l->next;
+		mt = l->data;
+		if (mt->xfer.dev_handle == dev_handle)
+			usbmock_pending_remove(ctx, mt);
+	}
+	g_mutex_unlock(&ctx->mutex);
+	g_free(dev_handle);
+}
+
+libusb_device * LIBUSB_CALL libusb_get_device(libusb_device_handle *dev_handle)
+{
+	return dev_handle->dev;
+}
+
+int LIBUSB_CALL libusb_get_configuration(libusb_device_handle *dev_handle,
+	int *config)
+{
+	(void)dev_handle;
+
+	*config = 1;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_set_configuration(libusb_device_handle *dev_handle,
+	int configuration)
+{
+	(void)dev_handle;
+
+	return configuration == 1 ? LIBUSB_SUCCESS : LIBUSB_ERROR_NOT_FOUND;
+}
+
+int LIBUSB_CALL libusb_claim_interface(libusb_device_handle *dev_handle,
+	int interface_number)
+{
+	(void)dev_handle;
+	(void)interface_number;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_release_interface(libusb_device_handle *dev_handle,
+	int interface_number)
+{
+	(void)dev_handle;
+	(void)interface_number;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_set_interface_alt_setting(libusb_device_handle *dev_handle,
+	int interface_number, int alternate_setting)
+{
+	(void)dev_handle;
+	(void)interface_number;
+	(void)alternate_setting;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_clear_halt(libusb_device_handle *dev_handle,
+	unsigned char endpoint)
+{
+	(void)dev_handle;
+	(void)endpoint;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_reset_device(libusb_device_handle *dev_handle)
+{
+	(void)dev_handle;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_kernel_driver_active(libusb_device_handle *dev_handle,
+	int interface_number)
+{
+	(void)dev_handle;
+	(void)interface_number;
+
+	return 0;
+}
+
+int LIBUSB_CALL libusb_detach_kernel_driver(libusb_device_handle *dev_handle,
+	int interface_number)
+{
+	(void)dev_handle;
+	(void)interface_number;
+
+	return LIBUSB_ERROR_NOT_FOUND;
+}
+
+int LIBUSB_CALL libusb_attach_kernel_driver(libusb_device_handle *dev_handle,
+	int interface_number)
+{
+	(void)dev_handle;
+	(void)interface_number;
+
+	return LIBUSB_ERROR_NOT_FOUND;
+}
+
+int LIBUSB_CALL libusb_get_string_descriptor_ascii(libusb_device_handle *dev_handle,
+	uint8_t desc_index, unsigned char *data, int length)
+{
+	struct libusb_device *dev;
+	size_t len;
+
+	dev = dev_handle->dev;
+	if (!desc_index || desc_index >= ARRAY_SIZE(dev->strings))
+		return LIBUSB_ERROR_INVALID_PARAM;
+	if (!dev->strings[desc_index])
+		return LIBUSB_ERROR_PIPE;
+	if (length < 1)
+		return LIBUSB_ERROR_INVALID_PARAM;
+
+	len = MIN(strlen(dev->strings[desc_index]), (size_t)length - 1);
+	memcpy(data, dev->strings[desc_index], len);
+	data[len] = '\0';
+
+	return len;
+}
+
+int LIBUSB_CALL libusb_control_transfer(libusb_device_handle *dev_handle,
+	uint8_t request_type, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+	unsigned char *data, uint16_t wLength, unsigned int timeout)
+{
+	(void)timeout;
+
+	return usbmock_control(dev_handle->dev, request_type, bRequest,
+		wValue, wIndex, data, wLength);
+}
+
+static int usbmock_sync_transfer(libusb_device_handle *dev_handle,
+	unsigned char endpoint, unsigned char *data, int length,
+	int *actual_length, unsigned int timeout)
+{
+	struct libusb_context *ctx;
+	struct usbmock_endpoint *ep;
+	int64_t due;
+
+	if (actual_length)
+		*actual_length = 0;
+
+	ep = usbmock_endpoint_find(dev_handle->dev, endpoint);
+	if (!ep) {
+		if (!(endpoint & LIBUSB_ENDPOINT_IN)) {
+			if (actual_length)
+				*actual_length = length;
+			return LIBUSB_SUCCESS;
+		}
+		usbmock_sleep_until(g_get_monotonic_time() + timeout * 1000);
+		return LIBUSB_ERROR_TIMEOUT;
+	}
+
+	/* Endpoints are shared with transfers submitted meanwhile. */
+	ctx = dev_handle->dev->ctx;
+	g_mutex_lock(&ctx->mutex);
+	due = usbmock_endpoint_schedule(ep, length);
+	g_mutex_unlock(&ctx->mutex);
+	usbmock_sleep_until(due);
+	if (endpoint & LIBUSB_ENDPOINT_IN)
+		usbmock_endpoint_fill(ep, data, length);
+	else
+		ep->bytes += length;
+	if (actual_length)
+		*actual_length = length;
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_bulk_transfer(libusb_device_handle *dev_handle,
+	unsigned char endpoint, unsigned char *data, int length,
+	int *actual_length, unsigned int timeout)
+{
+	return usbmock_sync_transfer(dev_handle, endpoint, data, length,
+		actual_length, timeout);
+}
+
+int LIBUSB_CALL libusb_interrupt_transfer(libusb_device_handle *dev_handle,
+	unsigned char endpoint, unsigned char *data, int length,
+	int *actual_length, unsigned int timeout)
+{
+	return usbmock_sync_transfer(dev_handle, endpoint, data, length,
+		actual_length, timeout);
+}
+
+struct libusb_transfer * LIBUSB_CALL libusb_alloc_transfer(int iso_packets)
+{
+	struct usbmock_transfer *mt;
+	size_t alloc_size;
+
+	alloc_size = sizeof(*mt);
+	alloc_size += iso_packets * sizeof(struct libusb_iso_packet_descriptor);
+	mt = g_malloc0(alloc_size);
+	mt->xfer.num_iso_packets = iso_packets;
+
+	return &mt->xfer;
+}
+
+void LIBUSB_CALL libusb_free_transfer(struct libusb_transfer *transfer)
+{
+	struct usbmock_transfer *mt;
+	struct libusb_context *ctx;
+
+	if (!transfer)
+		return;
+
+	mt = usbmock_transfer_get(transfer);
+	if (transfer->dev_handle) {
+		ctx = transfer->dev_handle->dev->ctx;
+		g_mutex_lock(&ctx->mutex);
+		if (mt->pending)
+			usbmock_pending_remove(ctx, mt);
+		g_mutex_unlock(&ctx->mutex);
+	}
+	if (transfer->flags & LIBUSB_TRANSFER_FREE_BUFFER)
+		free(transfer->buffer);
+	g_free(mt);
+}
+
+int LIBUSB_CALL libusb_submit_transfer(struct libusb_transfer *transfer)
+{
+	struct usbmock_transfer *mt;
+	struct libusb_context *ctx;
+	struct usbmock_endpoint *ep;
+
+	mt = usbmock_transfer_get(transfer);
+	if (!transfer->dev_handle)
+		return LIBUSB_ERROR_INVALID_PARAM;
+	ctx = transfer->dev_handle->dev->ctx;
+
+	g_mutex_lock(&ctx->mutex);
+	if (mt->pending) {
+		g_mutex_unlock(&ctx->mutex);
+		return LIBUSB_ERROR_BUSY;
+	}
+	mt->cancelled = FALSE;
+	mt->status = LIBUSB_TRANSFER_COMPLETED;
+	mt->seq = ctx->submit_seq++;
+	mt->due_us = g_get_monotonic_time();
+	if (transfer->type != LIBUSB_TRANSFER_TYPE_CONTROL) {
+		ep = usbmock_endpoint_find(transfer->dev_handle->dev,
+			transfer->endpoint);
+		if (ep) {
+			mt->due_us = usbmock_endpoint_schedule(ep,
+				transfer->length);
+		} else if (transfer->endpoint & LIBUSB_ENDPOINT_IN) {
+			/* Nothing ever arrives on unknown endpoints. */
+			mt->status = LIBUSB_TRANSFER_TIMED_OUT;
+			mt->due_us = transfer->timeout ?
+				mt->due_us + transfer->timeout * 1000 : INT64_MAX;
+		}
+	}
+	usbmock_pending_insert(ctx, mt);
+	g_cond_broadcast(&ctx->cond);
+	g_mutex_unlock(&ctx->mutex);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_cancel_transfer(struct libusb_transfer *transfer)
+{
+	struct usbmock_transfer *mt;
+	struct libusb_context *ctx;
+
+	mt = usbmock_transfer_get(transfer);
+	if (!transfer->dev_handle)
+		return LIBUSB_ERROR_NOT_FOUND;
+	ctx = transfer->dev_handle->dev->ctx;
+
+	g_mutex_lock(&ctx->mutex);
+	if (!mt->pending || mt->cancelled) {
+		g_mutex_unlock(&ctx->mutex);
+		return LIBUSB_ERROR_NOT_FOUND;
+	}
+
+	/* Complete with cancelled status upon the next event handling. */
+	usbmock_pending_remove(ctx, mt);
+	mt->cancelled = TRUE;
+	mt->due_us = g_get_monotonic_time();
+	usbmock_pending_insert(ctx, mt);
+	g_cond_broadcast(&ctx->cond);
+	g_mutex_unlock(&ctx->mutex);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_handle_events_timeout_completed(libusb_context *ctx,
+	struct timeval *tv, int *completed)
+{
+	struct usbmock_transfer *mt;
+	int64_t deadline, now, due;
+	uint64_t seq_limit;
+
+	ctx = usbmock_ctx(ctx);
+	if (!ctx)
+		return LIBUSB_ERROR_INVALID_PARAM;
+	if (completed && *completed)
+		return LIBUSB_SUCCESS;
+
+	deadline = g_get_monotonic_time();
+	if (tv)
+		deadline += (int64_t)tv->tv_sec * G_USEC_PER_SEC + tv->tv_usec;
+
+	g_mutex_lock(&ctx->events);
+	g_mutex_lock(&ctx->mutex);
+	/* Wait for the first transfer, submissions may bring it forward. */
+	for (;;) {
+		now = g_get_monotonic_time();
+		mt = ctx->pending ? ctx->pending->data : NULL;
+		due = mt ? mt->due_us : INT64_MAX;
+		if (ctx->interrupted || due <= now || deadline <= now)
+			break;
+		g_cond_wait_until(&ctx->cond, &ctx->mutex, MIN(due, deadline));
+	}
+	if (ctx->interrupted) {
+		ctx->interrupted = FALSE;
+		g_mutex_unlock(&ctx->mutex);
+		g_mutex_unlock(&ctx->events);
+		return LIBUSB_SUCCESS;
+	}
+
+	/*
+	 * Complete all transfers which are due. Don't pick up transfers
+	 * which callbacks resubmit, those complete in later calls.
+	 */
+	seq_limit = ctx->submit_seq;
+	while (ctx->pending) {
+		mt = ctx->pending->data;
+		if (mt->due_us > now || mt->seq >= seq_limit)
+			break;
+		usbmock_pending_remove(ctx, mt);
+		g_mutex_unlock(&ctx->mutex);
+		usbmock_transfer_complete(mt);
+		if (completed && *completed) {
+			g_mutex_unlock(&ctx->events);
+			return LIBUSB_SUCCESS;
+		}
+		g_mutex_lock(&ctx->mutex);
+	}
+	g_mutex_unlock(&ctx->mutex);
+	g_mutex_unlock(&ctx->events);
+
+	return LIBUSB_SUCCESS;
+}
+
+int LIBUSB_CALL libusb_handle_events_timeout(libusb_context *ctx,
+	struct timeval *tv)
+{
+	return libusb_handle_events_timeout_completed(ctx, tv, NULL);
+}
+
+int LIBUSB_CALL libusb_handle_events_completed(libusb_context *ctx,
+	int *completed)
+{
+	struct timeval tv;
+
+	tv.tv_sec = 60;
+	tv.tv_usec = 0;
+
+	return libusb_handle_events_timeout_completed(ctx, &tv, completed);
+}
+
+int LIBUSB_CALL libusb_handle_events(libusb_context *ctx)
+{
+	return libusb_handle_events_completed(ctx, NULL);
+}
+
+void LIBUSB_CALL libusb_lock_events(libusb_context *ctx)
+{
+	if ((ctx = usbmock_ctx(ctx)))
+		g_mutex_lock(&ctx->events);
+}
+
+void LIBUSB_CALL libusb_unlock_events(libusb_context *ctx)
+{
+	if ((ctx = usbmock_ctx(ctx)))
+		g_mutex_unlock(&ctx->events);
+}
+
+void LIBUSB_CALL libusb_interrupt_event_handler(libusb_context *ctx)
+{
+	if (!(ctx = usbmock_ctx(ctx)))
+		return;
+
+	g_mutex_lock(&ctx->mutex);
+	ctx->interrupted = TRUE;
+	g_cond_broadcast(&ctx->cond);
+	g_mutex_unlock(&ctx->mutex);
+}
+
+int LIBUSB_CALL libusb_get_next_timeout(libusb_context *ctx, struct timeval *tv)
+{
+	struct usbmock_transfer *mt;
+	int64_t due, remain;
+
+	ctx = usbmock_ctx(ctx);
+	if (!ctx)
+		return 0;
+
+	g_mutex_lock(&ctx->mutex);
+	mt = ctx->pending ? ctx->pending->data : NULL;
+	due = mt ? mt->due_us : INT64_MAX;
+	g_mutex_unlock(&ctx->mutex);
+	if (due == INT64_MAX)
+		return 0;
+	remain = MAX(0, due - g_get_monotonic_time());
+	tv->tv_sec = remain / G_USEC_PER_SEC;
+	tv->tv_usec = remain % G_USEC_PER_SEC;
+
+	return 1;
+}
+
+const struct libusb_pollfd ** LIBUSB_CALL libusb_get_pollfds(libusb_context *ctx)
+{
+	(void)ctx;
+
+	/* An empty list, callers free() it or use libusb_free_pollfds(). */
+	return calloc(1, sizeof(struct libusb_pollfd *));
+}
+
+void LIBUSB_CALL libusb_free_pollfds(const struct libusb_pollfd **pollfds)
+{
+	free((void *)pollfds);
+}
+
+void LIBUSB_CALL libusb_set_pollfd_notifiers(libusb_context *ctx,
+	libusb_pollfd_added_cb added_cb, libusb_pollfd_removed_cb removed_cb,
+	void *user_data)
+{
+	(void)ctx;
+	(void)added_cb;
+	(void)removed_cb;
+	(void)user_data;
+}
@@ -0,0 +1,386 @@
+/*
+ * This file is part of the libopentracecapture project.
+ *
+ * Copyright (C) 2026 OpenTraceLab contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Golden vectors and throughput of the channel-major bit transposer.
+ * The transposer is private to the library, so this executable is
+ * built from its source (src/bit_transpose.c).
+ *
+ *   otc-xpose-bench [-n <samples>] [-s <seed>]
+ *
+ * Always checks the transposer's output against fixed vectors, and
+ * against a bit-by-bit reference for random channel subsets, word
+ * layouts and transfer splits. The kernel under test is the one the
+ * compiler flags select (AVX2, SSE2, or portable). With -n, compares
+ * the throughput of the transposer and the reference for the formats
+ * of saleae-logic16, saleae-logic-pro and kingst-la2016.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <opentracecapture/libopentracecapture.h>
+#include "src/libopentracecapture-internal.h"
+
+#define MAX_CHANNELS	32
+#define RANDOM_ROUNDS	3000
+
+/* The transposer logs through these, the library isn't linked in. */
+OTC_PRIV int otc_cur_loglevel = OTC_LOG_WARN;
+
+OTC_PRIV int (otc_log)(int loglevel, const char *format, ...)
+{
+	va_list args;
+
+	(void)loglevel;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+
+	return OTC_OK;
+}
+
+struct layout {
+	const char *name;
+	size_t word_bits;
+	gboolean msb_first;
+	size_t unitsize;
+	size_t channel_count;
+	uint32_t masks[MAX_CHANNELS];
+};
+
+/* The bit-by-bit conversion which the drivers used to have. */
+static size_t reference_run(const struct layout *lo,
+	const uint8_t *src, size_t src_len, uint8_t *dst)
+{
+	size_t word_bytes, batch_bytes, batches, batch, ch, bit, idx, sample;
+	uint32_t word, logic[32];
+	uint8_t *out;
+
+	word_bytes = lo->word_bits / 8;
+	batch_bytes = lo->channel_count * word_bytes;
+	batches = src_len / batch_bytes;
+	out = dst;
+	for (batch = 0; batch < batches; batch++) {
+		memset(logic, 0, sizeof(logic));
+		for (ch = 0; ch < lo->channel_count; ch++) {
+			word = 0;
+			for (idx = 0; idx < word_bytes; idx++)
+				word |= (uint32_t)src[ch * word_bytes + idx] << (8 * idx);
+			for (bit = 0; bit < lo->word_bits; bit++) {
+				if (!(word & (1UL << bit)))
+					continue;
+				sample = lo->msb_first
+					? lo->word_bits - 1 - bit : bit;
+				logic[sample] |= lo->masks[ch];
+			}
+		}
+		for (sample = 0; sample < lo->word_bits; sample++) {
+			for (idx = 0; idx < lo->unitsize; idx++)
+				*out++ = logic[sample] >> (8 * idx);
+		}
+		src += batch_bytes;
+	}
+
+	return batches * lo->word_bits;
+}
+
+/* Feed the input in the given pieces, return the number of samples. */
+static size_t xpose_run(const struct layout *lo, const uint8_t *src,
+	size_t src_len, const size_t *splits, size_t split_count,
+	uint8_t *dst, size_t dst_len)
+{
+	struct otc_bit_transpose *xp;
+	size_t idx, len, total, samples;
+
+	xp = otc_bit_transpose_new(lo->word_bits, lo->msb_first,
+		lo->unitsize, lo->masks, lo->channel_count);
+	if (!xp)
+		return 0;
+
+	total = 0;
+	for (idx = 0; idx <= split_count && src_len; idx++) {
+		len = idx < split_count ? MIN(splits[idx], src_len) : src_len;
+		samples = otc_bit_transpose_run(xp, src, len, dst, dst_len);
+		src += len;
+		src_len -= len;
+		dst += samples * lo->unitsize;
+		dst_len -= samples * lo->unitsize;
+		total += samples;
+	}
+	otc_bit_transpose_free(xp);
+
+	return total;
+}
+
+static void dump(const char *what, const uint8_t *buf, size_t len)
+{
+	size_t idx;
+
+	fprintf(stderr, "  %s:", what);
+	for (idx = 0; idx < len; idx++)
+		fprintf(stderr, " %02x", buf[idx]);
+	fprintf(stderr, "\n");
+}
+
+struct golden {
+	struct layout layout;
+	size_t src_len;
+	uint8_t src[16];
+	size_t out_len;
+	uint8_t out[64];
+};
+
+/* Vectors worked out by hand, independent of the reference. */
+static const struct golden goldens[] = {
+	/* Two 8bit words, LSB first: channel 0 in sample 0, 1 in 7. */
+	{ { "8bit-lsb", 8, FALSE, 1, 2, { 0x01, 0x02 } },
+		2, { 0x01, 0x80 },
+		8, { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 } },
+	/* The same, MSB first, with channels swapped. */
+	{ { "8bit-msb-swapped", 8, TRUE, 1, 2, { 0x02, 0x01 } },
+		2, { 0x01, 0x80 },
+		8, { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 } },
+	/* Contiguous channels 8 and 9, 16bit words in little endian. */
+	{ { "16bit-shifted", 16, FALSE, 2, 2, { 0x100, 0x200 } },
+		4, { 0x03, 0x80, 0x00, 0x01 },
+		32, { 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 } },
+	/* A gap in the channel subset: channels 0 and 5. */
+	{ { "8bit-gap", 8, FALSE, 1, 2, { 0x01, 0x20 } },
+		2, { 0xf0, 0x3c },
+		8, { 0x00, 0x00, 0x20, 0x20, 0x21, 0x21, 0x01, 0x01 } },
+	/* 32bit words, MSB first, channel 0 only, into 3 byte units. */
+	{ { "32bit-msb", 32, TRUE, 3, 1, { 0x800000 } },
+		4, { 0x01, 0x00, 0x00, 0x80 },
+		12, { 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00 } },
+};
+
+static int check_goldens(void)
+{
+	const struct golden *g;
+	uint8_t out[128];
+	size_t idx, samples, out_len, check_len;
+	int failed;
+
+	failed = 0;
+	for (idx = 0; idx < ARRAY_SIZE(goldens); idx++) {
+		g = &goldens[idx];
+		memset(out, 0xaa, sizeof(out));
+		samples = xpose_run(&g->layout, g->src, g->src_len,
+			NULL, 0, out, sizeof(out));
+		out_len = samples * g->layout.unitsize;
+		/* Vectors list the leading bytes of longer outputs. */
+		check_len = MIN(g->out_len, sizeof(g->out));
+		if (samples != g->layout.word_bits
+				|| memcmp(out, g->out, check_len)) {
+			fprintf(stderr, "Golden vector %s mismatch.\n",
+				g->layout.name);
+			dump("expected", g->out, check_len);
+			dump("got", out, MIN(out_len, check_len));
+			failed = 1;
+		}
+	}
+
+	return failed;
+}
+
+/* Pick distinct logic bits within the unit, in random order. */
+static void random_masks(GRand *rand, struct layout *lo)
+{
+	uint32_t used, mask;
+	size_t ch, bits;
+
+	bits = lo->unitsize * 8;
+	used = 0;
+	for (ch = 0; ch < lo->channel_count; ch++) {
+		do {
+			mask = 1UL << g_rand_int_range(rand, 0, bits);
+		} while (used & mask);
+		used |= mask;
+		lo->masks[ch] = mask;
+	}
+}
+
+static int check_random(GRand *rand)
+{
+	static const size_t word_bits[] = { 8, 16, 32 };
+	struct layout lo;
+	uint8_t *src, *want, *got;
+	size_t round, src_len, dst_len, batches, idx, shift, word_bytes;
+	size_t splits[8], split_count, want_samples, got_samples;
+
+	src_len = 64 * MAX_CHANNELS * sizeof(uint32_t) + sizeof(uint32_t);
+	dst_len = 64 * 32 * sizeof(uint32_t);
+	src = g_malloc(src_len);
+	want = g_malloc(dst_len);
+	got = g_malloc(dst_len);
+
+	for (round = 0; round < RANDOM_ROUNDS; round++) {
+		memset(&lo, 0, sizeof(lo));
+		lo.name = "random";
+		lo.word_bits = word_bits[g_rand_int_range(rand, 0, 3)];
+		lo.msb_first = g_rand_boolean(rand);
+		lo.unitsize = g_rand_int_range(rand, 1, 5);
+		lo.channel_count = g_rand_int_range(rand, 1,
+			lo.unitsize * 8 + 1);
+		if (round % 4) {
+			random_masks(rand, &lo);
+		} else {
+			/* Every 4th round checks the contiguous shortcut. */
+			shift = g_rand_int_range(rand, 0,
+				lo.unitsize * 8 - lo.channel_count + 1);
+			for (idx = 0; idx < lo.channel_count; idx++)
+				lo.masks[idx] = 1UL << (shift + idx);
+		}
+
+		batches = g_rand_int_range(rand, 1, 65);
+		for (idx = 0; idx < src_len; idx++)
+			src[idx] = g_rand_int(rand);
+		/* Don't end on a word boundary, trailing bytes get ignored. */
+		word_bytes = lo.word_bits / 8;
+		idx = batches * lo.channel_count * word_bytes;
+		idx += g_rand_int_range(rand, 0, word_bytes);
+		/* Transfers split batches, but hold complete words. */
+		split_count = g_rand_int_range(rand, 0, ARRAY_SIZE(splits) + 1);
+		for (shift = 0; shift < split_count; shift++)
+			splits[shift] = word_bytes * g_rand_int_range(rand, 0,
+				idx / word_bytes / 2 + 2);
+
+		want_samples = reference_run(&lo, src, idx, want);
+		got_samples = xpose_run(&lo, src, idx, splits, split_count,
+			got, dst_len);
+		if (got_samples != want_samples
+				|| memcmp(got, want, want_samples * lo.unitsize)) {
+			fprintf(stderr, "Random vector %zu mismatch: %zu bits, "
+				"%s first, unit %zu, %zu channels, %zu splits.\n",
+				round, lo.word_bits, lo.msb_first ? "MSB" : "LSB",
+				lo.unitsize, lo.channel_count, split_count);
+			g_free(src);
+			g_free(want);
+			g_free(got);
+			return 1;
+		}
+	}
+
+	g_free(src);
+	g_free(want);
+	g_free(got);
+
+	return 0;
+}
+
+/* 16 channels in the formats of the converted drivers. */
+static const struct layout bench_layouts[] = {
+	{ "saleae-logic16", 16, TRUE, 2, 16, { 0 } },
+	{ "saleae-logic-pro", 32, TRUE, 2, 16, { 0 } },
+	{ "kingst-la2016", 16, FALSE, 2, 16, { 0 } },
+};
+
+static void bench(const struct layout *bench_lo, uint64_t samples)
+{
+	struct layout lo;
+	struct otc_bit_transpose *xp;
+	uint8_t *src, *dst;
+	size_t src_len, dst_len, idx;
+	uint64_t done;
+	gint64 start_us;
+	double xpose_s, ref_s;
+
+	lo = *bench_lo;
+	for (idx = 0; idx < lo.channel_count; idx++)
+		lo.masks[idx] = 1UL << idx;
+	/* One USB transfer's worth of data per call. */
+	src_len = 16 * 1024;
+	src_len -= src_len % (lo.channel_count * lo.word_bits / 8);
+	dst_len = src_len * 8 / lo.channel_count * lo.unitsize;
+	src = g_malloc(src_len);
+	dst = g_malloc(dst_len);
+	for (idx = 0; idx < src_len; idx++)
+		src[idx] = g_random_int();
+
+	xp = otc_bit_transpose_new(lo.word_bits, lo.msb_first,
+		lo.unitsize, lo.masks, lo.channel_count);
+	start_us = g_get_monotonic_time();
+	for (done = 0; done < samples; )
+		done += otc_bit_transpose_run(xp, src, src_len, dst, dst_len);
+	xpose_s = (g_get_monotonic_time() - start_us) / 1e6;
+	otc_bit_transpose_free(xp);
+
+	start_us = g_get_monotonic_time();
+	for (done = 0; done < samples; )
+		done += reference_run(&lo, src, src_len, dst);
+	ref_s = (g_get_monotonic_time() - start_us) / 1e6;
+
+	printf("%-18s %9.1f Msps  bit-by-bit %8.1f Msps  %5.1fx\n",
+		lo.name, samples / xpose_s / 1e6, samples / ref_s / 1e6,
+		ref_s / xpose_s);
+	g_free(src);
+	g_free(dst);
+}
+
+int main(int argc, char **argv)
+{
+	GRand *rand;
+	uint64_t samples;
+	uint32_t seed;
+	size_t idx;
+	int opt, failed;
+
+	samples = 0;
+	seed = 1;
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			samples = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = g_ascii_strtoull(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n samples] [-s seed]\n",
+				argv[0]);
+			return 2;
+		}
+	}
+
+	failed = check_goldens();
+	rand = g_rand_new_with_seed(seed);
+	failed |= check_random(rand);
+	g_rand_free(rand);
+	if (failed)
+		return 1;
+	printf("%zu golden and %d random vectors match.\n",
+		ARRAY_SIZE(goldens), RANDOM_ROUNDS);
+
+	for (idx = 0; samples && idx < ARRAY_SIZE(bench_layouts); idx++)
+		bench(&bench_layouts[idx], samples);
+
+	return 0;
+}